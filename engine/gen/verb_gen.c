@@ -0,0 +1,166 @@
+/*
+ * verb_gen.c - Generate the parser's perfect hash verb table
+ *
+ * Run by the build. Reads the vocabulary in core/verbs.def and searches
+ * for a hash seed under which every word lands in a slot of its own, so
+ * the parser resolves a verb with one hash, one slot read and one
+ * strcmp(). The table is written out as C source.
+ *
+ * Usage: verb_gen <output.c>
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/verb_hash.h"
+
+
+#define VERB_GEN_MAX_SEEDS     1000000u  /* Seeds tried per table size */
+#define VERB_GEN_LOAD_FACTOR   4         /* Slots per word to start with */
+
+
+/**
+ * struct GenVerb - One vocabulary entry, as source text
+ * @word: The word
+ * @command: CommandType enumerator it maps to
+ * @direction: Direction enumerator it maps to
+ * @word_class: WordClass enumerator it maps to
+ */
+
+typedef struct {
+	const char *word;
+	const char *command;
+	const char *direction;
+	const char *word_class;
+} GenVerb;
+
+
+#define WORD(word, command, direction, word_class) \
+	{ word, #command, #direction, #word_class },
+
+static const GenVerb gen_verbs[] = {
+#include "core/verbs.def"
+};
+
+#undef WORD
+
+#define GEN_VERB_COUNT (sizeof(gen_verbs) / sizeof(gen_verbs[0]))
+
+
+/**
+ * gen_try_seed() - Place every word under one seed
+ * @seed: Hash seed
+ * @mask: Table size - 1 (a power of two - 1)
+ * @slots: Slot -> word number + 1, 0 when empty; filled in
+ *
+ * Return: True if no two words share a slot
+ */
+
+static int gen_try_seed(uint32_t seed, uint32_t mask, uint32_t *slots)
+{
+	size_t i;
+
+	memset(slots, 0, ((size_t)mask + 1) * sizeof(*slots));
+	for (i = 0; i < GEN_VERB_COUNT; i++) {
+		uint32_t slot = verb_hash(gen_verbs[i].word, seed) & mask;
+
+		if (slots[slot])
+			return 0;
+		slots[slot] = (uint32_t)i + 1;
+	}
+	return 1;
+}
+
+
+static int gen_write(const char *path, uint32_t seed, uint32_t mask,
+		     const uint32_t *slots)
+{
+	FILE *fp = fopen(path, "w");
+	uint32_t slot;
+
+	if (!fp) {
+		perror(path);
+		return 1;
+	}
+
+	fprintf(fp, "/*\n"
+		" * verb_table.c - Perfect hash table of the built-in verbs\n"
+		" *\n"
+		" * Generated by verb_gen from core/verbs.def. Do not edit.\n"
+		" */\n\n"
+		"#include \"core/verbs.h\"\n\n"
+		"const uint32_t verb_table_seed = 0x%08xu;\n"
+		"const uint32_t verb_table_mask = %uu;\n\n"
+		"const VerbEntry verb_table[%u] = {\n",
+		(unsigned)seed, (unsigned)mask, (unsigned)mask + 1);
+
+	for (slot = 0; slot <= mask; slot++) {
+		const GenVerb *verb;
+
+		if (!slots[slot])
+			continue;
+		verb = &gen_verbs[slots[slot] - 1];
+		fprintf(fp, "\t[%u] = { \"%s\", %s, %s, %s },\n", (unsigned)slot,
+			verb->word, verb->command, verb->direction,
+			verb->word_class);
+	}
+	fprintf(fp, "};\n");
+
+	if (fclose(fp) != 0) {
+		perror(path);
+		return 1;
+	}
+	return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	uint32_t size = 1;
+	uint32_t *slots;
+	size_t i, j;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s <output.c>\n", argv[0]);
+		return 2;
+	}
+
+	for (i = 0; i < GEN_VERB_COUNT; i++) {
+		for (j = i + 1; j < GEN_VERB_COUNT; j++) {
+			if (strcmp(gen_verbs[i].word, gen_verbs[j].word) == 0) {
+				fprintf(stderr, "verb_gen: '%s' is listed twice\n",
+					gen_verbs[i].word);
+				return 1;
+			}
+		}
+	}
+
+	while (size < GEN_VERB_COUNT * VERB_GEN_LOAD_FACTOR)
+		size <<= 1;
+
+	for (;;) {
+		slots = malloc(size * sizeof(*slots));
+		if (!slots) {
+			fprintf(stderr, "verb_gen: out of memory\n");
+			return 1;
+		}
+
+		for (uint32_t seed = 1; seed <= VERB_GEN_MAX_SEEDS; seed++) {
+			if (gen_try_seed(seed, size - 1, slots)) {
+				int ret = gen_write(argv[1], seed, size - 1, slots);
+
+				free(slots);
+				return ret;
+			}
+		}
+
+		/* No seed fits; a sparser table will */
+		free(slots);
+		size <<= 1;
+	}
+}
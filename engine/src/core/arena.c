@@ -0,0 +1,351 @@
+/*
+ * arena.c - Region allocator for memory that lives as long as a story
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "constants.h"
+
+
+#define ARENA_ALIGN	alignof(max_align_t)
+
+
+/**
+ * struct ArenaBlock - One chunk of arena memory
+ * @next: Next block in the chain
+ * @size: Usable bytes in @data
+ * @used: Bytes already handed out
+ * @data: The memory itself
+ */
+
+typedef struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size;
+	size_t used;
+	alignas(max_align_t) unsigned char data[];
+} ArenaBlock;
+
+
+/**
+ * struct ArenaAdopted - A malloc() allocation the arena will free
+ * @next: Next adopted allocation
+ * @ptr: The allocation
+ * @size: Size of @ptr in bytes
+ */
+
+typedef struct ArenaAdopted {
+	struct ArenaAdopted *next;
+	void *ptr;
+	size_t size;
+} ArenaAdopted;
+
+
+static size_t arena_round(size_t size)
+{
+	return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+
+static ArenaBlock *arena_new_block(size_t size)
+{
+	ArenaBlock *block;
+
+	if (size > SIZE_MAX - sizeof(ArenaBlock))
+		return NULL;
+
+	block = malloc(sizeof(ArenaBlock) + size);
+	if (!block)
+		return NULL;
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+
+/**
+ * arena_init() - Prepare an empty arena
+ * @arena: Arena to initialise
+ * @block_size: Size of each block, 0 for ARENA_BLOCK_SIZE
+ *
+ * Return: void
+ */
+
+void arena_init(Arena *arena, size_t block_size)
+{
+	arena->blocks = NULL;
+	arena->adopted = NULL;
+	arena->block_size = block_size;
+}
+
+
+/**
+ * arena_alloc() - Carve uninitialised memory from an arena
+ * @arena: Arena to allocate from
+ * @size: Bytes wanted
+ *
+ * Return: Pointer to @size bytes, NULL on failure
+ */
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+	size_t block_size = arena->block_size ? arena->block_size : ARENA_BLOCK_SIZE;
+	ArenaBlock *block = arena->blocks;
+	size_t next_size;
+	void *ptr;
+
+	if (size > SIZE_MAX - ARENA_ALIGN)
+		return NULL;
+	size = arena_round(size ? size : 1);
+
+	if (block && block->size - block->used >= size) {
+		ptr = block->data + block->used;
+		block->used += size;
+		return ptr;
+	}
+
+	/* Big requests get a block of their own behind the current one */
+	if (size > block_size / 4) {
+		block = arena_new_block(size);
+		if (!block)
+			return NULL;
+		block->used = size;
+		if (arena->blocks) {
+			block->next = arena->blocks->next;
+			arena->blocks->next = block;
+		} else {
+			arena->blocks = block;
+		}
+		return block->data;
+	}
+
+	/* Start small and double, so a tiny story does not pin a full block */
+	next_size = arena->blocks ? arena->blocks->size * 2 : ARENA_FIRST_BLOCK_SIZE;
+	if (next_size > block_size)
+		next_size = block_size;
+	while (next_size < size)
+		next_size *= 2;
+
+	block = arena_new_block(next_size);
+	if (!block)
+		return NULL;
+	block->next = arena->blocks;
+	arena->blocks = block;
+
+	block->used = size;
+	return block->data;
+}
+
+
+/**
+ * arena_calloc() - Carve zeroed memory for an array from an arena
+ * @arena: Arena to allocate from
+ * @count: Number of elements
+ * @size: Size of one element
+ *
+ * Return: Pointer to zeroed memory, NULL on failure or overflow
+ */
+
+void *arena_calloc(Arena *arena, size_t count, size_t size)
+{
+	void *ptr;
+
+	if (size && count > SIZE_MAX / size)
+		return NULL;
+
+	ptr = arena_alloc(arena, count * size);
+	if (ptr)
+		memset(ptr, 0, count * size);
+	return ptr;
+}
+
+
+/**
+ * arena_strndup() - Copy a string into an arena
+ * @arena: Arena to allocate from
+ * @str: Characters to copy
+ * @len: Number of characters
+ *
+ * Return: NUL terminated copy, NULL on failure
+ */
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+	char *copy = arena_alloc(arena, len + 1);
+
+	if (!copy)
+		return NULL;
+
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+
+/**
+ * arena_grow() - Make room for one more element in an arena array
+ * @arena: Arena the array was carved from
+ * @array: Current array (may be NULL)
+ * @count: Number of elements in use
+ * @capacity: Pointer to allocated element count, updated on growth
+ * @elem_size: Size of one element in bytes
+ *
+ * Return: Array with room for @count + 1 elements, NULL on failure
+ */
+
+void *arena_grow(Arena *arena, void *array, int count, int *capacity,
+		 size_t elem_size)
+{
+	int new_capacity;
+	void *grown;
+
+	if (count < *capacity)
+		return array;
+
+	new_capacity = *capacity > 0 ? *capacity * 2 : ARRAY_INITIAL_CAPACITY;
+
+	grown = arena_calloc(arena, (size_t)new_capacity, elem_size);
+	if (!grown)
+		return NULL;
+
+	if (array && count > 0)
+		memcpy(grown, array, (size_t)count * elem_size);
+
+	*capacity = new_capacity;
+	return grown;
+}
+
+
+/**
+ * arena_adopt() - Make an arena responsible for a malloc() allocation
+ * @arena: Arena taking ownership
+ * @ptr: Allocation to free with the arena
+ * @size: Size of @ptr in bytes
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+int arena_adopt(Arena *arena, void *ptr, size_t size)
+{
+	ArenaAdopted *adopted;
+
+	if (!ptr)
+		return 0;
+
+	adopted = arena_alloc(arena, sizeof(*adopted));
+	if (!adopted)
+		return -ENOMEM;
+
+	adopted->ptr = ptr;
+	adopted->size = size;
+	adopted->next = arena->adopted;
+	arena->adopted = adopted;
+	return 0;
+}
+
+
+/**
+ * arena_merge() - Move everything one arena owns into another
+ * @dst: Arena receiving the memory
+ * @src: Arena to empty
+ *
+ * @src's blocks go behind @dst's current block so @dst keeps carving
+ * where it was.
+ *
+ * Return: void
+ */
+
+void arena_merge(Arena *dst, Arena *src)
+{
+	if (src->blocks) {
+		ArenaBlock *tail = src->blocks;
+
+		while (tail->next)
+			tail = tail->next;
+
+		if (dst->blocks) {
+			tail->next = dst->blocks->next;
+			dst->blocks->next = src->blocks;
+		} else {
+			dst->blocks = src->blocks;
+		}
+	}
+
+	if (src->adopted) {
+		ArenaAdopted *tail = src->adopted;
+
+		while (tail->next)
+			tail = tail->next;
+		tail->next = dst->adopted;
+		dst->adopted = src->adopted;
+	}
+
+	src->blocks = NULL;
+	src->adopted = NULL;
+}
+
+
+/**
+ * arena_usage() - Report how much memory an arena holds
+ * @arena: Arena to measure
+ * @usage: Filled in with the totals
+ *
+ * Return: void
+ */
+
+void arena_usage(const Arena *arena, ArenaUsage *usage)
+{
+	const ArenaAdopted *adopted;
+	const ArenaBlock *block;
+
+	memset(usage, 0, sizeof(*usage));
+
+	for (block = arena->blocks; block; block = block->next) {
+		usage->used += block->used;
+		usage->reserved += sizeof(*block) + block->size;
+		usage->block_count++;
+	}
+
+	for (adopted = arena->adopted; adopted; adopted = adopted->next) {
+		usage->used += adopted->size;
+		usage->reserved += adopted->size;
+		usage->adopted_count++;
+	}
+}
+
+
+/**
+ * arena_free() - Release every block and adopted allocation
+ * @arena: Arena to empty
+ *
+ * Return: void
+ */
+
+void arena_free(Arena *arena)
+{
+	ArenaAdopted *adopted;
+	ArenaBlock *block;
+
+	if (!arena)
+		return;
+
+	/* Adopted records live in the blocks, so walk them first */
+	for (adopted = arena->adopted; adopted; adopted = adopted->next)
+		free(adopted->ptr);
+	arena->adopted = NULL;
+
+	while (arena->blocks) {
+		block = arena->blocks;
+		arena->blocks = block->next;
+		free(block);
+	}
+}
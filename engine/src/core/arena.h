@@ -0,0 +1,179 @@
+/*
+ * arena.h - Region allocator for memory that lives as long as a story
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef CORE_ARENA_H
+#define CORE_ARENA_H
+
+#include <stddef.h>
+
+
+struct ArenaBlock;
+struct ArenaAdopted;
+
+
+/**
+ * struct Arena - Bump allocator over a chain of large blocks
+ * @blocks: Blocks owned by the arena, the one being carved first
+ * @adopted: malloc() allocations handed over with arena_adopt()
+ * @block_size: Size of each ordinary block
+ *
+ * Nothing carved from an arena is freed on its own; arena_free()
+ * releases everything at once. A zeroed Arena is ready to use and
+ * gets ARENA_BLOCK_SIZE blocks.
+ */
+
+typedef struct Arena {
+	struct ArenaBlock *blocks;
+	struct ArenaAdopted *adopted;
+	size_t block_size;
+} Arena;
+
+
+/**
+ * struct ArenaUsage - Memory held by an arena
+ * @used: Bytes handed out, adopted allocations included
+ * @reserved: Bytes taken from malloc(): @used plus block headers and
+ *            the unused tails of blocks
+ * @block_count: Number of blocks
+ * @adopted_count: Number of adopted allocations
+ */
+
+typedef struct ArenaUsage {
+	size_t used;
+	size_t reserved;
+	int block_count;
+	int adopted_count;
+} ArenaUsage;
+
+
+/**
+ * arena_init() - Prepare an empty arena
+ * @arena: Arena to initialise
+ * @block_size: Size of each block, 0 for ARENA_BLOCK_SIZE
+ *
+ * No memory is allocated until the first request.
+ *
+ * Return: void
+ */
+
+void arena_init(Arena *arena, size_t block_size);
+
+
+/**
+ * arena_alloc() - Carve uninitialised memory from an arena
+ * @arena: Arena to allocate from
+ * @size: Bytes wanted
+ *
+ * The result is aligned for any type. Requests larger than a quarter
+ * of the block size get a block of their own so they do not strand
+ * the tail of the current one. Ordinary blocks start at
+ * ARENA_FIRST_BLOCK_SIZE and double up to the arena's block size.
+ *
+ * Return: Pointer to @size bytes, NULL on failure
+ */
+
+void *arena_alloc(Arena *arena, size_t size);
+
+
+/**
+ * arena_calloc() - Carve zeroed memory for an array from an arena
+ * @arena: Arena to allocate from
+ * @count: Number of elements
+ * @size: Size of one element
+ *
+ * Return: Pointer to zeroed memory, NULL on failure or overflow
+ */
+
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+
+
+/**
+ * arena_strndup() - Copy a string into an arena
+ * @arena: Arena to allocate from
+ * @str: Characters to copy (need not be NUL terminated)
+ * @len: Number of characters
+ *
+ * Return: NUL terminated copy, NULL on failure
+ */
+
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+
+/**
+ * arena_grow() - Make room for one more element in an arena array
+ * @arena: Arena the array was carved from
+ * @array: Current array (may be NULL)
+ * @count: Number of elements in use
+ * @capacity: Pointer to allocated element count, updated on growth
+ * @elem_size: Size of one element in bytes
+ *
+ * The arena counterpart of array_grow(). Growth doubles the capacity
+ * and copies into fresh arena memory; the old copy is only reclaimed
+ * with the arena, so keep this to small lists.
+ *
+ * Return: Array with room for @count + 1 elements, NULL on failure
+ */
+
+void *arena_grow(Arena *arena, void *array, int count, int *capacity,
+		 size_t elem_size);
+
+
+/**
+ * arena_adopt() - Make an arena responsible for a malloc() allocation
+ * @arena: Arena taking ownership
+ * @ptr: Allocation to free with the arena (NULL is ignored)
+ * @size: Size of @ptr in bytes, for arena_usage()
+ *
+ * For large arrays that are cheaper to build with realloc() than to
+ * copy into the arena once their final size is known.
+ *
+ * Return: 0 on success, -ENOMEM if the arena could not record @ptr
+ * (@ptr is still owned by the caller then)
+ */
+
+int arena_adopt(Arena *arena, void *ptr, size_t size);
+
+
+/**
+ * arena_merge() - Move everything one arena owns into another
+ * @dst: Arena receiving the memory
+ * @src: Arena to empty; left ready for reuse
+ *
+ * Lets worker threads fill private arenas and hand the result to a
+ * shared one without copying.
+ *
+ * Return: void
+ */
+
+void arena_merge(Arena *dst, Arena *src);
+
+
+/**
+ * arena_usage() - Report how much memory an arena holds
+ * @arena: Arena to measure
+ * @usage: Filled in with the totals
+ *
+ * Walks the block and adoption chains, so the cost grows with the
+ * number of blocks rather than the number of allocations.
+ *
+ * Return: void
+ */
+
+void arena_usage(const Arena *arena, ArenaUsage *usage);
+
+
+/**
+ * arena_free() - Release every block and adopted allocation
+ * @arena: Arena to empty; left ready for reuse
+ *
+ * Return: void
+ */
+
+void arena_free(Arena *arena);
+
+
+#endif /* CORE_ARENA_H */
@@ -6,28 +6,30 @@
  */
 
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <strings.h>
 #include <time.h>
 
 
 #include "commands.h"
 #include "constants.h"
 #include "core/logger.h"
-#include "core/utils.h"
 #include "game.h"
+#include "gameplay/dialog.h"
 #include "gameplay/quests.h"
 #include "system/save.h"
 #include "ui/colors.h"
+#include "ui/output.h"
 #include "world/items.h"
+#include "world/nouns.h"
 #include "world/npcs.h"
+#include "world/rooms.h"
 
 
 
 /* Static function declarations */
-static const char* find_exit(Room* room, const char* direction);
 
 
  /**
@@ -36,12 +38,22 @@ static const char* find_exit(Room* room, const char* direction);
   * @cmd: Pointer to parsed command structure
   *
   * Dispatches the command to the appropriate handler based on command type. 
-  * Handles both implemented and stub commands.
+  * Handles both implemented and stub commands. While an NPC waits for an
+  * answer a number picks one; anything else ends the conversation first.
   *
   * Return: CommandResult indicating success, error or quit.
   */
  
 CommandResult execute_command(GameState* game, Command* cmd) {
+    if (game->talk_npc) {
+        if (cmd->type == CMD_UNKNOWN &&
+            isdigit((unsigned char)cmd->verb[0])) {
+            dialog_respond(game, atoi(cmd->verb));
+            return RESULT_OK;
+        }
+        dialog_leave(game);
+    }
+
     switch (cmd->type) {
         case CMD_GO:
             return cmd_go(game, cmd);
@@ -78,55 +90,14 @@ CommandResult execute_command(GameState* game, Command* cmd) {
 }
 
 
- /**
-  * find_exit() - Find exit destination from current room
-  * @room: Pointer to current room
-  * @direction: Direction string to search for
-  *
-  * Searches the room's exit list for a matching direction (case-insensitive)
-  * and returns the destination room ID.
-  *
-  * Return: Room ID string if exit exists, NULL otherwise
-  */
- 
-static const char* find_exit(Room* room, const char* direction) {
-    if (!room || !direction) {
-        return NULL;
-    }
-
-    // Search through exits for atching direction
-    for (int i = 0; i < room->exit_count; i++) {
-        // Parse "direction:room_id" format
-        char exit_copy[PARSER_EXIT_BUFFER_SIZE];
-        strncpy(exit_copy, room->exits[i], sizeof(exit_copy) - 1);
-        exit_copy[sizeof(exit_copy) - 1] = '\0';
-
-        char* colon = strchr(exit_copy, ':');
-        if (colon) {
-            *colon = '\0';
-            char* exit_direction = exit_copy; // Split string at colon
-
-            // Compare direction (case-insensitive)
-            if (strcasecmp(exit_direction, direction) == 0) {
-                // Found it! Return the room_id from the original string
-                char* original_colon = strchr(room->exits[i], ':');
-                return original_colon + 1; // Return room_id part
-            }
-        }
-    }
-
-    return NULL; // Exit not found
-}
-
-
 /**
  * cmd_go() - Handle movement commands
  * @game: Pointer to current game state
  * @cmd: Pointer to parsed command
  *
  * Processes GO command and direction shortcuts to move the player between
- * rooms. Handles abbreviations (n/s/e/w), validates exits, and updates game 
- * state on successful movement.
+ * rooms. The direction word (or abbreviation) picks the exit straight out
+ * of the room's exit table, then game state is updated on success.
  *
  * Return: RESULT_OK on successful movement, RESULT_ERROR if direction invalid
  */
@@ -138,43 +109,42 @@ CommandResult cmd_go(GameState* game, Command* cmd) {
         return RESULT_ERROR;
     }
 
-    const char* direction = cmd->noun;
-
-    // Handle abbreviations
-    if (strcmp(direction, "n") == 0) direction = "north";
-    else if (strcmp(direction, "s") == 0) direction = "south";
-    else if (strcmp(direction, "e") == 0) direction = "east";
-    else if (strcmp(direction, "w") == 0) direction = "west";
+    Room* room = game->current_room;
+    Direction dir = direction_from_string(cmd->noun);
 
     // Find the exit
-    const char* destination_id = find_exit(game->current_room, direction);
-
-    if (!destination_id) {
-        printf_colored(COLOR_ERROR, "You can't go %s from here.\n", direction);
+    if (dir == DIR_NONE || !room->exit_ids[dir]) {
+        printf_colored(COLOR_ERROR, "You can't go %s from here.\n",
+                       dir == DIR_NONE ? cmd->noun : direction_name(dir));
         return RESULT_ERROR;
     }
 
+    const char* direction = direction_name(dir);
+
     /* Check if exit is locked */
-    if (game->current_room->locked && strcmp(direction, game->current_room->locked_exit) == 0) {
+    if (room->locked && dir == room->locked_exit) {
         printf_colored(COLOR_INFO, "The %s exit is locked. You need to unlock it first.\n", direction);
         add_log_entry("Player tried locked exit: %s at %s", direction, log_timestamp());
         return RESULT_ERROR;
     }
 
-    // Find the destination room
-    Room* destination = find_room_by_id(game->story, destination_id);
+    // Destination was resolved when the story was linked (or its region
+    // is loaded now, for a streamed story)
+    Room* destination = room_exit(game->story, room, dir);
 
     if (!destination) {
-        printf_colored(COLOR_ERROR, "ERROR: Exit leads to non-existent room '%s'!\n", destination_id);
+        printf_colored(COLOR_ERROR, "ERROR: Exit leads to non-existent room '%s'!\n",
+                       room->exit_ids[dir]);
         return RESULT_ERROR;
     }
 
     // Move to the new room
     game->current_room = destination;
+    room_stream_enter(game->story, destination);
     game->turn_count++;
 
     // Check for quest completion (entering room)
-    check_and_complete_quests(game, NULL, NULL, destination->id);
+    check_and_complete_quests(game, NULL, NULL, destination);
 
     // Describe the new room;
     look_at_current_room(game);
@@ -223,59 +193,88 @@ CommandResult cmd_examine(GameState* game, Command* cmd) {
     room = game->current_room;
 
     /* First check inventory */
-    for (i = 0; i < game->inventory_count; i++) {
+    i = noun_find_item(game->inventory, game->inventory_count, cmd->noun,
+                       true);
+    if (i >= 0) {
         item = game->inventory[i];
+        output_printf("\n%s\n", item_description(game->story, item));
+        output_printf("Weight: %d kg\n", item->weight);
+        if (item->useable) {
+            output_printf("You can use this item.\n");
+        }
 
-        if (strcasecmp(item->name, cmd->noun) == 0 ||
-            strcasecmp(item->id, cmd->noun) == 0 ||
-            contains_ignore_case(item->name, cmd->noun)) {
-                printf("\n%s\n", item->description);
-                printf("Weight: %d kg\n", item->weight);
-                if (item->useable) {
-                    printf("You can use this item.\n");
-                }
-
-                add_log_entry("Player examined inveotory item: %s at %s", 
-                                item->name, log_timestamp());
-                log_function_exit(__func__, RESULT_OK);
-                return RESULT_OK;
-                
-            }
+        add_log_entry("Player examined inveotory item: %s at %s", 
+                        item->name, log_timestamp());
+        log_function_exit(__func__, RESULT_OK);
+        return RESULT_OK;
     }
 
     /* Then check room */
-    for (i = 0; i < room->item_count; i++) {
-        item = find_item_by_id(game->story->items,
-                               game->story->item_count,
-                               room->items[i]);
-        
-        if (!item)
-            continue;
-
-        if (strcasecmp(item->name, cmd->noun) == 0 ||
-            strcasecmp(item->id, cmd->noun) == 0 ||
-            contains_ignore_case(item->name, cmd->noun)) {
-                printf("\n%s\n", item->description);
-                printf("Weight: %d kg\n", item->weight);
-                if (item->takeable) {
-                    printf("You could take this.\n");
-                } else {
-                    printf("You can't take this.\n");
-                }
-                add_log_entry(__func__,"Player examined room item: %s at %s",
-                              item->name, log_timestamp());
-                log_function_exit(__func__, RESULT_OK);
-                return RESULT_OK;
-            }
+    i = noun_find_item(room->items, room->item_count, cmd->noun, true);
+    if (i >= 0) {
+        item = room->items[i];
+        output_printf("\n%s\n", item_description(game->story, item));
+        output_printf("Weight: %d kg\n", item->weight);
+        if (item->takeable) {
+            output_printf("You could take this.\n");
+        } else {
+            output_printf("You can't take this.\n");
+        }
+        add_log_entry(__func__,"Player examined room item: %s at %s",
+                      item->name, log_timestamp());
+        log_function_exit(__func__, RESULT_OK);
+        return RESULT_OK;
     }
 
-    printf("You dont see any %s here.\n", cmd->noun);
+    output_printf("You dont see any %s here.\n", cmd->noun);
     add_log_entry("Player tried to examine non-existent item %s at %s", cmd->noun, log_timestamp());
     log_function_exit(__func__, RESULT_ERROR);
     return RESULT_ERROR;
 }
 
 
+/**
+ * cmd_take_all() - Pick up every takeable item in the room
+ * @game: Pointer to current game state
+ *
+ * Takes each item in turn as if the player had named it, so weight
+ * limits and quests apply to every one.
+ *
+ * Return: RESULT_OK if anything was taken, RESULT_ERROR otherwise
+ */
+
+static CommandResult cmd_take_all(GameState* game) {
+    Room *room = game->current_room;
+    Command each = { CMD_TAKE, "take", "", "", "", false };
+    int taken = 0;
+    int i = 0;
+
+    log_function_entry(__func__, "room=%s", room->id);
+
+    while (i < room->item_count) {
+        Item *item = room->items[i];
+
+        if (item->takeable) {
+            each.noun = item->key.id;
+            if (cmd_take(game, &each) == RESULT_OK) {
+                taken++;
+                continue;
+            }
+        }
+        i++;
+    }
+
+    if (taken == 0) {
+        output_printf("There is nothing here you can take.\n");
+        log_function_exit(__func__, RESULT_ERROR);
+        return RESULT_ERROR;
+    }
+
+    log_function_exit(__func__, RESULT_OK);
+    return RESULT_OK;
+}
+
+
 /**
  * cmd_take() - Pick up an item
  * @game: Pointer to current game state
@@ -299,65 +298,63 @@ CommandResult cmd_take(GameState* game, Command* cmd) {
         return RESULT_ERROR;
     }
 
+    if (cmd->all) {
+        log_function_exit(__func__, RESULT_OK);
+        return cmd_take_all(game);
+    }
+
     room = game->current_room;
 
     /* Search for item in current room by name or ID */
-    for (i = 0; i < room->item_count; i++) {
-        item = find_item_by_id(game->story->items,
-                               game->story->item_count,
-                               room->items[i]);
-        
-        if (!item)
-            continue;
-
-        /* Match by name (case-insensitive) or ID */
-        if (strcasecmp(item->name, cmd->noun) == 0 ||
-            strcasecmp(item->id, cmd->noun) == 0) {
-            
-            /* Check if item is takeable */
-            if (!item->takeable) {
-                printf("You can't take the %s.\n", item->name);
-                add_log_entry("Player attempted to take non-takeable item: %s at %s", item->name, log_timestamp());
-                log_function_exit(__func__, RESULT_ERROR);
-                return RESULT_ERROR;
-            }
+    i = noun_find_item(room->items, room->item_count, cmd->noun, false);
+    if (i >= 0) {
+        item = room->items[i];
+
+        /* Check if item is takeable */
+        if (!item->takeable) {
+            output_printf("You can't take the %s.\n", item->name);
+            add_log_entry("Player attempted to take non-takeable item: %s at %s", item->name, log_timestamp());
+            log_function_exit(__func__, RESULT_ERROR);
+            return RESULT_ERROR;
+        }
 
-            /* Check inventory weight limit */
-            if (game->inventory_weight + item->weight > 
-                game->story->metadata.max_inventory_weight) {
-                printf("The %s is too heavy. You're carrying too much.\n", 
-                       item->name);
-                add_log_entry("Player inventory full: tried %s at %s",
-                item->name, log_timestamp());
-                log_function_exit(__func__, RESULT_ERROR);
-                return RESULT_ERROR;
-            }
+        /* Check inventory weight limit */
+        if (game->inventory_weight + item->weight > 
+            game->story->metadata.max_inventory_weight) {
+            output_printf("The %s is too heavy. You're carrying too much.\n", 
+                          item->name);
+            add_log_entry("Player inventory full: tried %s at %s",
+            item->name, log_timestamp());
+            log_function_exit(__func__, RESULT_ERROR);
+            return RESULT_ERROR;
+        }
 
-            /* Add to inventory */
-            game->inventory = realloc(game->inventory, 
-                                     (game->inventory_count + 1) * sizeof(Item*));
-            game->inventory[game->inventory_count] = item;
-            game->inventory_count++;
-            game->inventory_weight += item->weight;
+        /* Add to inventory */
+        game->inventory = realloc(game->inventory, 
+                                 (game->inventory_count + 1) * sizeof(Item*));
+        game->inventory[game->inventory_count] = item;
+        game->inventory_count++;
+        game->inventory_weight += item->weight;
 
-            /* Remove from room */
-            for (int j = i; j < room->item_count - 1; j++) {
-                room->items[j] = room->items[j + 1];
-            }
-            room->item_count--;
+        /* Remove from room */
+        for (int j = i; j < room->item_count - 1; j++) {
+            room->items[j] = room->items[j + 1];
+        }
+        room->item_count--;
+        room->changed = true;
+        room_view_invalidate(room);
 
-            printf_colored(COLOR_SUCCESS, "You take the %s.\n", item->name);
+        printf_colored(COLOR_SUCCESS, "You take the %s.\n", item->name);
 
-            /* Check for quest completion (taking item) */
-            check_and_complete_quests(game, item->id, NULL, NULL);
+        /* Check for quest completion (taking item) */
+        check_and_complete_quests(game, item, NULL, NULL);
 
-            add_log_entry("Player took item: %s (weight=%d, total_weight=%d) at %s", item->name, item->weight, game->inventory_weight,      log_timestamp());
-            log_function_exit(__func__, RESULT_OK);
-            return RESULT_OK;
-        }
+        add_log_entry("Player took item: %s (weight=%d, total_weight=%d) at %s", item->name, item->weight, game->inventory_weight,      log_timestamp());
+        log_function_exit(__func__, RESULT_OK);
+        return RESULT_OK;
     }
 
-    printf("You don't see any '%s' here.\n", cmd->noun);
+    output_printf("You don't see any '%s' here.\n", cmd->noun);
     add_log_entry("Player tried to take non-existent item: %s at %s",
                  cmd->noun, log_timestamp());
     log_function_exit(__func__, RESULT_ERROR);
@@ -365,6 +362,38 @@ CommandResult cmd_take(GameState* game, Command* cmd) {
 }
 
 
+/**
+ * cmd_drop_all() - Drop everything the player carries
+ * @game: Pointer to current game state
+ *
+ * Return: RESULT_OK if anything was dropped, RESULT_ERROR otherwise
+ */
+
+static CommandResult cmd_drop_all(GameState* game) {
+    Command each = { CMD_DROP, "drop", "", "", "", false };
+    int dropped = 0;
+
+    log_function_entry(__func__, "count=%d", game->inventory_count);
+
+    if (game->inventory_count == 0) {
+        output_printf("You aren't carrying anything.\n");
+        log_function_exit(__func__, RESULT_ERROR);
+        return RESULT_ERROR;
+    }
+
+    /* Drop from the end so a failure cannot loop forever */
+    for (int i = game->inventory_count - 1; i >= 0; i--) {
+        each.noun = game->inventory[i]->key.id;
+        if (cmd_drop(game, &each) == RESULT_OK) {
+            dropped++;
+        }
+    }
+
+    log_function_exit(__func__, dropped > 0 ? RESULT_OK : RESULT_ERROR);
+    return dropped > 0 ? RESULT_OK : RESULT_ERROR;
+}
+
+
 /**
  * cmd_drop() - Dropan item from inventory
  * @game: Pointer to current game state
@@ -389,40 +418,50 @@ CommandResult cmd_drop(GameState* game, Command* cmd) {
         return RESULT_ERROR;
     }
 
-    /* Search inventory for item */
-    for (i = 0; i < game->inventory_count; i++) {
-        item = game->inventory[i];
-
-        /* Match by name or ID */
-        if (strcasecmp(item->name, cmd->noun) == 0 ||
-            strcasecmp(item->id, cmd->noun) == 0) {
-
-            room = game->current_room;
+    if (cmd->all) {
+        log_function_exit(__func__, RESULT_OK);
+        return cmd_drop_all(game);
+    }
 
-            /* Add item ID to room */
-            /* Note: room->items is char** (array of item IDs) */
-            room->items = realloc(room->items, 
-                                 (room->item_count + 1) * sizeof(char*));
-            room->items[room->item_count] = item->id;
-            room->item_count++;
+    /* Search inventory for item by name or ID */
+    i = noun_find_item(game->inventory, game->inventory_count, cmd->noun,
+                       false);
+    if (i >= 0) {
+        item = game->inventory[i];
 
-            /* Remove from inventory */
-            game->inventory_weight -= item->weight;
-            for (int j = i; j < game->inventory_count - 1; j++) {
-                game->inventory[j] = game->inventory[j + 1];
-            }
-            game->inventory_count--;
+        room = game->current_room;
 
-            printf_colored(COLOR_INFO, "You drop the %s.\n", item->name);
-            add_log_entry("Player dropped item: %s (weight=%d, total_weight=%d) at %s",
-                         item->name, item->weight, game->inventory_weight,
-                         log_timestamp());
-            log_function_exit(__func__, RESULT_OK);
-            return RESULT_OK;
+        /* Add item to room */
+        Item **grown = arena_grow(&game->story->arena, room->items,
+                                  room->item_count, &room->item_capacity,
+                                  sizeof(Item*));
+        if (!grown) {
+            log_function_error(__func__, "Failed to grow room item list");
+            log_function_exit(__func__, RESULT_ERROR);
+            return RESULT_ERROR;
+        }
+        room->items = grown;
+        room->items[room->item_count] = item;
+        room->item_count++;
+        room->changed = true;
+        room_view_invalidate(room);
+
+        /* Remove from inventory */
+        game->inventory_weight -= item->weight;
+        for (int j = i; j < game->inventory_count - 1; j++) {
+            game->inventory[j] = game->inventory[j + 1];
         }
+        game->inventory_count--;
+
+        printf_colored(COLOR_INFO, "You drop the %s.\n", item->name);
+        add_log_entry("Player dropped item: %s (weight=%d, total_weight=%d) at %s",
+                     item->name, item->weight, game->inventory_weight,
+                     log_timestamp());
+        log_function_exit(__func__, RESULT_OK);
+        return RESULT_OK;
     }
 
-    printf("You're not carrying any '%s'.\n", cmd->noun);
+    output_printf("You're not carrying any '%s'.\n", cmd->noun);
     add_log_entry("Player tried to drop item not in inventory: %s at %s",
                  cmd->noun, log_timestamp());
     log_function_exit(__func__, RESULT_ERROR);
@@ -448,20 +487,20 @@ CommandResult cmd_inventory(GameState* game, Command* cmd) {
                       game->inventory_weight,
                       game->story->metadata.max_inventory_weight);
 
-    printf("\n");
+    output_printf("\n");
     printf_colored(COLOR_BOLD, "=== INVENTORY ===\n");
 
     if (game->inventory_count == 0) {
         printf_colored(COLOR_GRAY, "You are not carrying anything.\n");
     } else {
-        printf("You are carrying:\n");
+        output_printf("You are carrying:\n");
         for (int i = 0; i < game->inventory_count; i++) {
             Item *item = game->inventory[i];
-            printf("  - ");
+            output_printf("  - ");
             printf_colored(COLOR_ITEM, "%s", item->name);
-            printf(" (%d kg)\n", item->weight);
+            output_printf(" (%d kg)\n", item->weight);
         }
-        printf("\nTotal weight:"); 
+        output_printf("\nTotal weight:"); 
 
         /* Color code based on how full inventory is */
 		float percent = (float)game->inventory_weight / (float)game->story->metadata.max_inventory_weight;
@@ -470,7 +509,7 @@ CommandResult cmd_inventory(GameState* game, Command* cmd) {
 		else if (percent > 0.6) weight_color = COLOR_YELLOW;
 		
 		printf_colored(weight_color, "%d", game->inventory_weight);
-		printf(" / %d kg\n", game->story->metadata.max_inventory_weight);
+		output_printf(" / %d kg\n", game->story->metadata.max_inventory_weight);
        
     }
 
@@ -503,75 +542,75 @@ CommandResult cmd_use(GameState* game, Command* cmd) {
 		return RESULT_ERROR;
 	}
 
-	/* Search inventory for item */
-	for (i = 0; i < game->inventory_count; i++) {
+	/* Search inventory for item by name, ID, or substring */
+	i = noun_find_item(game->inventory, game->inventory_count, cmd->noun,
+			   true);
+	if (i >= 0) {
 		item = game->inventory[i];
 
-		/* Match by name, ID, or substring */
-		if (strcasecmp(item->name, cmd->noun) == 0 ||
-		    strcasecmp(item->id, cmd->noun) == 0 ||
-		    contains_ignore_case(item->name, cmd->noun)) {
-
-			if (!item->useable) {
-				printf("You can't use the %s.\n", item->name);
-				add_log_entry("Player tried to use non-useable item: %s at %s",
-				             item->name, log_timestamp());
-				log_function_exit(__func__, RESULT_ERROR);
-				return RESULT_ERROR;
+		if (!item->useable) {
+			output_printf("You can't use the %s.\n", item->name);
+			add_log_entry("Player tried to use non-useable item: %s at %s",
+			             item->name, log_timestamp());
+			log_function_exit(__func__, RESULT_ERROR);
+			return RESULT_ERROR;
+		}
+
+		/* ILLUMINATION EFFECT */
+		if (item->illuminates) {
+			if (game->current_room->dark) {
+				printf_colored(COLOR_MAGIC, "The %s illuminates the area!\n", item->name);
+				output_printf("\n");
+				look_at_current_room(game);
+				add_log_entry("Player used illumination in dark room at %s",
+				             log_timestamp());
+			} else {
+				output_printf("The %s provides light, but you can already see clearly.\n",
+					      item->name);
+				add_log_entry("Player used illumination in lit room at %s",
+				             log_timestamp());
 			}
+			log_function_exit(__func__, RESULT_OK);
+			return RESULT_OK;
+		}
 
-			/* ILLUMINATION EFFECT */
-			if (item->illuminates) {
-				if (game->current_room->dark) {
-					printf_colored(COLOR_MAGIC, "The %s illuminates the area!\n", item->name);
-					printf("\n");
-					look_at_current_room(game);
-					add_log_entry("Player used illumination in dark room at %s",
-					             log_timestamp());
-				} else {
-					printf("The %s provides light, but you can already see clearly.\n",
-					       item->name);
-					add_log_entry("Player used illumination in lit room at %s",
-					             log_timestamp());
-				}
+		/* UNLOCKING EFFECT */
+		if (item->unlocks) {
+			if (game->current_room->locked) {
+				const char *exit_name =
+					direction_name(game->current_room->locked_exit);
+
+				printf_colored(COLOR_SUCCESS, "You use the %s to unlock the %s exit!\n",
+				       item->name, exit_name);
+				
+				/* Unlock the exit */
+				game->current_room->locked = false;
+				game->current_room->locked_exit = DIR_NONE;
+				game->current_room->changed = true;
+				room_view_invalidate(game->current_room);
+				
+				add_log_entry("Player unlocked exit: %s at %s",
+				             exit_name, log_timestamp());
+				log_function_exit(__func__, RESULT_OK);
+				return RESULT_OK;
+			} else {
+				output_printf("There's nothing to unlock here.\n");
+				add_log_entry("Player tried to unlock in unlocked room at %s",
+				             log_timestamp());
 				log_function_exit(__func__, RESULT_OK);
 				return RESULT_OK;
 			}
-
-			/* UNLOCKING EFFECT */
-			if (item->unlocks) {
-				if (game->current_room->locked) {
-					printf_colored(COLOR_SUCCESS, "You use the %s to unlock the %s exit!\n",
-					       item->name, game->current_room->locked_exit);
-					
-					/* Unlock the exit */
-					game->current_room->locked = false;
-					game->current_room->locked_exit[0] = '\0';
-					
-					add_log_entry("Player unlocked exit: %s at %s",
-					             game->current_room->locked_exit,
-					             log_timestamp());
-					log_function_exit(__func__, RESULT_OK);
-					return RESULT_OK;
-				} else {
-					printf("There's nothing to unlock here.\n");
-					add_log_entry("Player tried to unlock in unlocked room at %s",
-					             log_timestamp());
-					log_function_exit(__func__, RESULT_OK);
-					return RESULT_OK;
-				}
-			}
-
-			/* Generic useable item (no special effect) */
-			printf("You use the %s. Nothing special happens.\n", item->name);
-			add_log_entry("Player used generic item: %s at %s",
-			             item->name, log_timestamp());
-			log_function_exit(__func__, RESULT_OK);
-			return RESULT_OK;
 		}
+
+		/* Generic useable item (no special effect) */
+		output_printf("You use the %s. Nothing special happens.\n", item->name);
+		add_log_entry("Player used generic item: %s at %s",
+		             item->name, log_timestamp());
+		log_function_exit(__func__, RESULT_OK);
+		return RESULT_OK;
 	}
 
-	printf("You're not carrying any '%s'.\n", cmd->noun);
+	output_printf("You're not carrying any '%s'.\n", cmd->noun);
 	add_log_entry("Player tried to use item not in inventory: %s at %s",
 	             cmd->noun, log_timestamp());
 
@@ -607,50 +646,47 @@ CommandResult cmd_talk(GameState* game, Command* cmd) {
 
     room = game->current_room;
 
-    /* Search for NPC in current room */
-    for (i = 0; i < room->npc_count; i++) {
-        npc = find_npc_by_id(game->story->npcs,
-                            game->story->npc_count,
-                            room->npcs[i]);
-        
-        if (!npc)
-            continue;
-
-        /* Match by name or ID (with fuzzy matching) */
-        if (strcasecmp(npc->name, cmd->noun) == 0 ||
-            strcasecmp(npc->id, cmd->noun) == 0 ||
-            contains_ignore_case(npc->name, cmd->noun)) {
-
-            /* Check if NPC has dialog */
-            if (npc->dialog_count == 0) {
-                printf("%s has nothing to say.\n", npc->name);
-                log_function_exit(__func__, RESULT_OK);
-                return RESULT_OK;
-            }
-
-            /* Display current dialog line */
-            printf("\n");
-            printf_colored(COLOR_NPC, "%s", npc->name);
-            printf(" says:\n");
-            printf_colored(COLOR_CYAN, "\"%s\"\n", 
-                   npc->dialog[npc->dialog_index]);
+    /* Search for NPC in current room by name or ID (with fuzzy matching) */
+    i = noun_find_npc(room->npcs, room->npc_count, cmd->noun);
+    if (i >= 0) {
+        npc = room->npcs[i];
 
-            /* Advance to next dialog line (cycle) */
-            npc->dialog_index = (npc->dialog_index + 1) % npc->dialog_count;
-
-            add_log_entry("Player talked to NPC: %s (line %d/%d) at %s",
-                         npc->name, npc->dialog_index, 
-                         npc->dialog_count, log_timestamp());
-
-            /* Check for quest completion (talking to NPC) */
-            check_and_complete_quests(game, NULL, npc->id, NULL);
+        /* A dialog tree takes over from the dialog lines */
+        if (dialog_talk(game, npc)) {
+            check_and_complete_quests(game, NULL, npc, NULL);
+            log_function_exit(__func__, RESULT_OK);
+            return RESULT_OK;
+        }
 
+        /* Check if NPC has dialog */
+        if (npc->dialog_count == 0) {
+            output_printf("%s has nothing to say.\n", npc->name);
             log_function_exit(__func__, RESULT_OK);
             return RESULT_OK;
         }
+
+        /* Display current dialog line */
+        output_printf("\n");
+        printf_colored(COLOR_NPC, "%s", npc->name);
+        output_printf(" says:\n");
+        printf_colored(COLOR_CYAN, "\"%s\"\n", 
+               npc_dialog_line(game->story, npc, npc->dialog_index));
+
+        /* Advance to next dialog line (cycle) */
+        npc->dialog_index = (npc->dialog_index + 1) % npc->dialog_count;
+
+        add_log_entry("Player talked to NPC: %s (line %d/%d) at %s",
+                     npc->name, npc->dialog_index, 
+                     npc->dialog_count, log_timestamp());
+
+        /* Check for quest completion (talking to NPC) */
+        check_and_complete_quests(game, NULL, npc, NULL);
+
+        log_function_exit(__func__, RESULT_OK);
+        return RESULT_OK;
     }
 
-    printf("There's no '%s' here to talk to.\n", cmd->noun);
+    output_printf("There's no '%s' here to talk to.\n", cmd->noun);
     add_log_entry("Player tried to talk to non-existent NPC: %s at %s",
                  cmd->noun, log_timestamp());
     log_function_exit(__func__, RESULT_ERROR);
@@ -669,6 +705,7 @@ CommandResult cmd_talk(GameState* game, Command* cmd) {
  * Return: RESULT_OK, RESULT_ERROR, or RESULT_QUIT on death
  */
 CommandResult cmd_attack(GameState* game, Command* cmd) {
+	const char *description;
 	Room *room;
 	NPC *npc;
 	int i;
@@ -687,197 +724,177 @@ CommandResult cmd_attack(GameState* game, Command* cmd) {
 
 	room = game->current_room;
 
-	/* Search for NPC in current room */
-	for (i = 0; i < room->npc_count; i++) {
-		npc = find_npc_by_id(game->story->npcs,
-		                    game->story->npc_count,
-		                    room->npcs[i]);
-		
-		if (!npc)
-			continue;
-
-		/* Match by name or ID (with fuzzy matching) */
-		if (strcasecmp(npc->name, cmd->noun) == 0 ||
-		    strcasecmp(npc->id, cmd->noun) == 0 ||
-		    contains_ignore_case(npc->name, cmd->noun)) {
-
-			/* Check if NPC can be fought */
-			if (!npc->hostile) {
-				printf("You can't attack %s!\n", npc->name);
-				log_function_exit(__func__, RESULT_ERROR);
-				return RESULT_ERROR;
-			}
+	/* Search for NPC in current room by name or ID (with fuzzy matching) */
+	i = noun_find_npc(room->npcs, room->npc_count, cmd->noun);
+	if (i >= 0) {
+		npc = room->npcs[i];
 
-			/* Check if already defeated */
-			if (npc->defeated) {
-				printf("%s has already been defeated.\n", npc->name);
-				log_function_exit(__func__, RESULT_OK);
-				return RESULT_OK;
-			}
+		/* Check if NPC can be fought */
+		if (!npc->hostile) {
+			output_printf("You can't attack %s!\n", npc->name);
+			log_function_exit(__func__, RESULT_ERROR);
+			return RESULT_ERROR;
+		}
 
-			/* Initialize combat if not already fighting */
-			if (game->combat_npc == NULL) {
-				game->combat_npc = npc;
-				game->player_combat_hp = COMBAT_MAX_HP;
-				
-				printf("\nYou engage %s in combat!\n", npc->name);
-				if (strlen(npc->description) > 0) {
-					printf("%s\n", npc->description);
-				}
-				printf("\n");
-				
-				add_log_entry("Combat started with: %s at %s",
-				             npc->name, log_timestamp());
+		/* Check if already defeated */
+		if (npc->defeated) {
+			output_printf("%s has already been defeated.\n", npc->name);
+			log_function_exit(__func__, RESULT_OK);
+			return RESULT_OK;
+		}
+
+		/* Initialize combat if not already fighting */
+		if (game->combat_npc == NULL) {
+			game->combat_npc = npc;
+			game->player_combat_hp = COMBAT_MAX_HP;
+			
+			output_printf("\nYou engage %s in combat!\n", npc->name);
+			description = npc_description(game->story, npc);
+			if (strlen(description) > 0) {
+				output_printf("%s\n", description);
 			}
+			output_printf("\n");
+			
+			add_log_entry("Combat started with: %s at %s",
+			             npc->name, log_timestamp());
+		}
 
-			/* Check if player has required item */
-			has_item = false;
-			if (strlen(npc->required_item) > 0) {
-				for (int j = 0; j < game->inventory_count; j++) {
-					if (strcmp(game->inventory[j]->id, npc->required_item) == 0) {
-						has_item = true;
-						break;
-					}
+		/* Check if player has required item */
+		has_item = false;
+		if (npc->required_item_ref) {
+			for (int j = 0; j < game->inventory_count; j++) {
+				if (game->inventory[j] == npc->required_item_ref) {
+					has_item = true;
+					break;
 				}
 			}
+		}
 
-			/* Determine win chance */
-			win_chance = has_item ? npc->item_win_chance : npc->base_win_chance;
+		/* Determine win chance */
+		win_chance = has_item ? npc->item_win_chance : npc->base_win_chance;
 
-			/* Roll for outcome */
-			roll = (float)rand() / (float)RAND_MAX;
+		/* Roll for outcome */
+		roll = (float)rand() / (float)RAND_MAX;
 
-			add_log_entry("Combat turn: roll=%.2f, win_chance=%.2f, has_item=%d at %s",
-			             roll, win_chance, has_item, log_timestamp());
+		add_log_entry("Combat turn: roll=%.2f, win_chance=%.2f, has_item=%d at %s",
+		             roll, win_chance, has_item, log_timestamp());
 
-			/* 5% chance to flee */
-			if (roll < COMBAT_FLEE_CHANCE) {
-				printf("\n");
+		/* 5% chance to flee */
+		if (roll < COMBAT_FLEE_CHANCE) {
+			output_printf("\n");
                 printf_colored(COLOR_BRIGHT_YELLOW, "\"RUN AWAY! RUN AWAY!\"\n");
-				printf_colored(COLOR_WARNING, "Having soiled your armor, you flee in terror!\n\n");
-
-				/* Select random unlocked exit */
-				if (room->exit_count > 0) {
-					int exit_idx = rand() % room->exit_count;
-					
-					/* Parse exit to get direction and room_id */
-					char exit_copy[PARSER_EXIT_BUFFER_SIZE];
-					strncpy(exit_copy, room->exits[exit_idx], sizeof(exit_copy) - 1);
-					exit_copy[sizeof(exit_copy) - 1] = '\0';
-					
-					char *colon = strchr(exit_copy, ':');
-					if (colon) {
-						*colon = '\0';
-						char *direction = exit_copy;
-						char *dest_id = colon + 1;
-						
-						/* Check if exit is locked */
-						if (room->locked && strcmp(direction, room->locked_exit) == 0) {
-							/* Try another exit */
-							exit_idx = (exit_idx + 1) % room->exit_count;
-							strncpy(exit_copy, room->exits[exit_idx], sizeof(exit_copy) - 1);
-							exit_copy[sizeof(exit_copy) - 1] = '\0';
-							colon = strchr(exit_copy, ':');
-							if (colon) {
-								*colon = '\0';
-								dest_id = colon + 1;
-							}
-						}
-						
-						/* Move to destination */
-						Room *dest = find_room_by_id(game->story, dest_id);
-						if (dest) {
-							game->current_room = dest;
-							game->combat_npc = NULL;
-							game->player_combat_hp = COMBAT_MAX_HP;
-							
-							look_at_current_room(game);
-							
-							add_log_entry("Player fled combat to: %s at %s",
-							             dest->id, log_timestamp());
-							log_function_exit(__func__, RESULT_OK);
-							return RESULT_OK;
-						}
-					}
-				}
-				
-				/* Fallback if no valid exit */
-				printf("You can't find a way out! (You soil your armor (again...))\n");
+			printf_colored(COLOR_WARNING, "Having soiled your armor, you flee in terror!\n\n");
+
+			/* Select random unlocked exit */
+			Direction open_exits[DIR_COUNT];
+			int open_count = 0;
+			Room *dest = NULL;
+
+			for (int d = 0; d < DIR_COUNT; d++) {
+				if (!room->exit_ids[d])
+					continue;
+				if (room->locked && d == (int)room->locked_exit)
+					continue;
+				open_exits[open_count++] = (Direction)d;
+			}
+
+			if (open_count > 0)
+				dest = room_exit(game->story, room,
+						 open_exits[rand() % open_count]);
+
+			if (dest) {
+				game->current_room = dest;
+				room_stream_enter(game->story, dest);
 				game->combat_npc = NULL;
 				game->player_combat_hp = COMBAT_MAX_HP;
+				
+				look_at_current_room(game);
+				
+				add_log_entry("Player fled combat to: %s at %s",
+				             dest->id, log_timestamp());
 				log_function_exit(__func__, RESULT_OK);
 				return RESULT_OK;
 			}
+			
+			/* Fallback if no valid exit */
+			output_printf("You can't find a way out! (You soil your armor (again...))\n");
+			game->combat_npc = NULL;
+			game->player_combat_hp = COMBAT_MAX_HP;
+			log_function_exit(__func__, RESULT_OK);
+			return RESULT_OK;
+		}
 
-			/* Player hits */
-			if (roll < win_chance) {
-				npc->combat_hp--;
-				
-				/* Show combat text if available */
-				if (npc->combat_text_count > 0) {
-					int text_idx = rand() % npc->combat_text_count;
-					printf_colored(COLOR_NPC, "%s says: \"%s\"\n", npc->name, npc->combat_text[text_idx]);
-				} else {
-					printf_colored(COLOR_COMBAT_HIT, "You hit %s!\n", npc->name);
-				}
+		/* Player hits */
+		if (roll < win_chance) {
+			npc->combat_hp--;
+			
+			/* Show combat text if available */
+			if (npc->combat_text_count > 0) {
+				int text_idx = rand() % npc->combat_text_count;
+				printf_colored(COLOR_NPC, "%s says: \"%s\"\n", npc->name,
+				               npc_combat_text(game->story, npc, text_idx));
+			} else {
+				printf_colored(COLOR_COMBAT_HIT, "You hit %s!\n", npc->name);
+			}
+			
+			output_printf("Enemy HP: ");
+			printf_colored(COLOR_GREEN, "%d", npc->combat_hp > 0 ? npc->combat_hp : 0);
+			output_printf("/%d\n\n", npc->combat_hp + 1);
+
+			/* Check if NPC defeated */
+			if (npc->combat_hp <= 0) {
+				printf_colored(COLOR_SUCCESS, "*** %s has been defeated! ***\n\n", npc->name);
+				npc->defeated = true;
+				room_view_invalidate(game->current_room);
+				game->combat_npc = NULL;
+				game->player_combat_hp = COMBAT_MAX_HP;
 				
-				printf("Enemy HP: ");
-				printf_colored(COLOR_GREEN, "%d", npc->combat_hp > 0 ? npc->combat_hp : 0);
-				printf("/%d\n\n", npc->combat_hp + 1);
-
-				/* Check if NPC defeated */
-				if (npc->combat_hp <= 0) {
-					printf_colored(COLOR_SUCCESS, "*** %s has been defeated! ***\n\n", npc->name);
-					npc->defeated = true;
-					game->combat_npc = NULL;
-					game->player_combat_hp = COMBAT_MAX_HP;
-					
-					add_log_entry("Combat victory: defeated %s at %s",
-					             npc->name, log_timestamp());
-					log_function_exit(__func__, RESULT_OK);
-					return RESULT_OK;
-				}
+				add_log_entry("Combat victory: defeated %s at %s",
+				             npc->name, log_timestamp());
+				log_function_exit(__func__, RESULT_OK);
+				return RESULT_OK;
 			}
-			/* NPC hits player */
-			else {
-				game->player_combat_hp -= npc->combat_damage;
+		}
+		/* NPC hits player */
+		else {
+			game->player_combat_hp -= npc->combat_damage;
+			
+			printf_colored(COLOR_COMBAT_MISS, "%s strikes you!\n", npc->name);
+			output_printf("Your HP: ");
+			printf_colored(game->player_combat_hp > 3 ? COLOR_GREEN : COLOR_RED, 
+			              "%d", game->player_combat_hp > 0 ? game->player_combat_hp : 0);
+			output_printf("/%d\n\n", COMBAT_MAX_HP);
+
+			/* Check if player died */
+			if (game->player_combat_hp <= 0) {
+				printf_colored(COLOR_DEATH, "\n*** YOU HAVE DIED ***\n");
+				printf_colored(COLOR_DANGER, "Cause of death: %s\n\n", npc->name);
+				
+				game->death_count++;
+				game->combat_npc = NULL;
+				game->player_combat_hp = COMBAT_MAX_HP;
 				
-				printf_colored(COLOR_COMBAT_MISS, "%s strikes you!\n", npc->name);
-				printf("Your HP: ");
-				printf_colored(game->player_combat_hp > 3 ? COLOR_GREEN : COLOR_RED, 
-				              "%d", game->player_combat_hp > 0 ? game->player_combat_hp : 0);
-				printf("/%d\n\n", COMBAT_MAX_HP);
-
-				/* Check if player died */
-				if (game->player_combat_hp <= 0) {
-					printf_colored(COLOR_DEATH, "\n*** YOU HAVE DIED ***\n");
-					printf_colored(COLOR_DANGER, "Cause of death: %s\n\n", npc->name);
-					
-					game->death_count++;
-					game->combat_npc = NULL;
-					game->player_combat_hp = COMBAT_MAX_HP;
-					
-					/* Respawn at starting room */
-					Room *respawn = find_room_by_id(game->story, game->respawn_room);
-					if (respawn) {
-						game->current_room = respawn;
-						printf("You respawn at %s...\n\n", respawn->name);
-						look_at_current_room(game);
-					}
-					
-					add_log_entry("Player died to: %s, deaths=%d at %s",
-					             npc->name, game->death_count, log_timestamp());
-					log_function_exit(__func__, RESULT_OK);
-					return RESULT_OK;
+				/* Respawn at starting room */
+				Room *respawn = game->respawn_room;
+				if (respawn) {
+					game->current_room = respawn;
+					room_stream_enter(game->story, respawn);
+					output_printf("You respawn at %s...\n\n", respawn->name);
+					look_at_current_room(game);
 				}
+				
+				add_log_entry("Player died to: %s, deaths=%d at %s",
+				             npc->name, game->death_count, log_timestamp());
+				log_function_exit(__func__, RESULT_OK);
+				return RESULT_OK;
 			}
-
-			log_function_exit(__func__, RESULT_OK);
-			return RESULT_OK;
 		}
+
+		log_function_exit(__func__, RESULT_OK);
+		return RESULT_OK;
 	}
 
-	printf("There's no '%s' here to attack.\n", cmd->noun);
+	output_printf("There's no '%s' here to attack.\n", cmd->noun);
 	log_function_exit(__func__, RESULT_ERROR);
 	return RESULT_ERROR;
 }
@@ -903,7 +920,7 @@ CommandResult cmd_quests(GameState* game, Command* cmd) {
 	log_function_entry(__func__, "quest_count=%d", 
 	                  game->story->quest_count);
 
-	printf("\n");
+	output_printf("\n");
     printf_colored(COLOR_BOLD, "=== QUESTS ===\n");
 
 	if (game->story->quest_count == 0) {
@@ -926,7 +943,7 @@ CommandResult cmd_quests(GameState* game, Command* cmd) {
 		}
 	}
 
-	printf("\n");
+	output_printf("\n");
 
 	/* Display each quest */
 	for (int i = 0; i < game->story->quest_count; i++) {
@@ -934,28 +951,32 @@ CommandResult cmd_quests(GameState* game, Command* cmd) {
 		
 		if (quest->completed) {
             printf_colored(COLOR_SUCCESS, "[X] ");
+        } else if (quest->failed) {
+            printf_colored(COLOR_ERROR, "[-] ");
+        } else if (quest->started) {
+            printf_colored(COLOR_QUEST, "[~] ");
         } else { 
             printf_colored(COLOR_GRAY, "[ ] ");
         }
         
         printf_colored(quest->completed ? COLOR_GREEN : COLOR_WHITE, "%s\n", quest->name);
-        printf("    %s\n", quest->description);
+        output_printf("    %s\n", quest->description);
 		
 		if (quest->required) {
-			printf("    (Required)\n");
+			output_printf("    (Required)\n");
 		}
 		
-		printf("\n");
+		output_printf("\n");
     }
 
 	/* Show summary */
-	printf("Progress:");
+	output_printf("Progress:");
     printf_colored(COLOR_INFO, "%d/%d", completed_count, game->story->quest_count);
-    printf(" quests completed\n");
+    output_printf(" quests completed\n");
 	
 	if (required_count > 0) {
-		printf("Required: %d/%d completed\n", 
-		       required_completed, required_count);
+		output_printf("Required: %d/%d completed\n", 
+			      required_completed, required_count);
 	}
 
 	add_log_entry("Player viewed quests: %d/%d complete at %s",
@@ -983,27 +1004,27 @@ CommandResult cmd_quests(GameState* game, Command* cmd) {
 CommandResult cmd_help(GameState* game, Command* cmd) {
     (void)game; // TODO
     (void)cmd; // TODO
-    printf("\n");
+    output_printf("\n");
     printf_colored(COLOR_BOLD COLOR_CYAN, "=== AVAILABLE COMMANDS ===\n\n");
 
     printf_colored(COLOR_BOLD, "Movement:\n");
-    printf("  ");
+    output_printf("  ");
     printf_colored(COLOR_GREEN, "  go <direction>");
-    printf(", ");
-    printf_colored(COLOR_GREEN, "north, south, east, west, n, s, e, w");
-    printf("\n\n");
+    output_printf(", ");
+    printf_colored(COLOR_GREEN, "north, south, east, west, ne, nw, se, sw, up, down, in, out");
+    output_printf("\n\n");
 
     printf_colored(COLOR_BOLD, "Interaction:\n");
-    printf("  ");
+    output_printf("  ");
     printf_colored(COLOR_YELLOW, "look (or l), examine (or x) <object>, take <item>, drop <item>");
-    printf("\n  ");
+    output_printf("\n  ");
     printf_colored(COLOR_BOLD, "use <item>, talk <npc>, attack <npc>, inventory (or i), quests (or q)");
-    printf("\n\n");
+    output_printf("\n\n");
 
     printf_colored(COLOR_BOLD,"System:\n");
-    printf("  ");
+    output_printf("  ");
     printf_colored(COLOR_CYAN, "help, save, load, quit");
-    printf("\n\n");
+    output_printf("\n\n");
 
     return RESULT_OK;
 }
@@ -1020,17 +1041,17 @@ CommandResult cmd_help(GameState* game, Command* cmd) {
  */
 
 CommandResult cmd_quit(GameState* game, Command* cmd) {
-    (void)game; // TODO
     (void)cmd; // TODO
-    printf("\nAre you sure you want to quit? (y/n): ");
+    output_printf("\nAre you sure you want to quit? (y/n): ");
+    output_flush(&game->output);
     char response[PARSER_RESPONSE_BUFFER_SIZE];
     if (fgets(response, sizeof(response), stdin)) {
         if (response[0] == 'y' || response[0] == 'Y') {
-            printf("Thanks for playing!\n");
+            output_printf("Thanks for playing!\n");
             return RESULT_QUIT;
         }
     }
-    printf("Continuing game...\n");
+    output_printf("Continuing game...\n");
     return RESULT_OK;
 }
 
@@ -1056,7 +1077,7 @@ CommandResult cmd_save(GameState* game, Command* cmd) {
     if (strlen(cmd->noun) > 0) {
         slot = atoi(cmd->noun);
         if (slot < 1 || slot > 3) {
-            printf("Save slot must be between 1, and %d.\n", SAVE_MAX_SLOTS);
+            output_printf("Save slot must be between 1, and %d.\n", SAVE_MAX_SLOTS);
             log_function_exit(__func__, RESULT_ERROR);
             return RESULT_ERROR;
         }
@@ -1097,7 +1118,7 @@ CommandResult cmd_load(GameState* game, Command* cmd) {
     if (strlen(cmd->noun) > 0) {
         slot = atoi(cmd->noun);
         if (slot < 1 || slot > 3) {
-            printf("Load slot must be between 1 and %d.\n", SAVE_MAX_SLOTS);
+            output_printf("Load slot must be between 1 and %d.\n", SAVE_MAX_SLOTS);
             log_function_exit(__func__, RESULT_ERROR);
             return RESULT_ERROR;
         }
@@ -13,27 +13,18 @@
 
 /* Parser buffer sizes */
 
-#define PARSER_EXIT_BUFFER_SIZE       128 /* Room exit parsing */
 #define PARSER_INPUT_BUFFER_SIZE      256 /* Player command input */
-#define PARSER_NOUN_SIZE              64  /* Command noun/noun2 */
-#define PARSER_PREPOSITION_SIZE       16  /* Command preposition */
 #define PARSER_RESPONSE_BUFFER_SIZE   10  /* Quit confirmation response */
 #define PARSER_VERB_SIZE              32  /* Command verb */
 
 
-/* Item field sizes */
-
-#define ITEM_ID_SIZE                  64  /* Item identifier */
-#define ITEM_NAME_SIZE                64  /* Item display name */
-#define ITEM_DESCRIPTION_SIZE         256 /* Item description */
-
-
 /* INI file parsing */
 
 #define INI_LINE_BUFFER_SIZE          512 /* INI file line buffer */
 #define INI_SECTION_SIZE              128 /* INI section name */
 #define INI_KEY_SIZE                  64  /* INI key name */
 #define INI_VALUE_SIZE                256 /* INI value string */
+#define INI_NUMBER_SIZE               32  /* Numeric value staging buffer */
 
 
 /* Logging */
@@ -46,6 +37,9 @@
 /* String utilities */
 
 #define STRING_MATCH_BUFFER_SIZE      256 /* String match buffer size */
+#define ARRAY_INITIAL_CAPACITY        16  /* First allocation of a growable array */
+#define ARENA_BLOCK_SIZE              (64 * 1024) /* Default arena block */
+#define ARENA_FIRST_BLOCK_SIZE        (4 * 1024)  /* Blocks double up to ARENA_BLOCK_SIZE */
 
 /* Load/Save funcitons */
 
@@ -53,28 +47,72 @@
 #define SAVE_DIRECTORY                 "saves"
 #define SAVE_FILENAME_FORMAT           "saves/save_slot_%d.sav"
 
-/* Story data field sizes */
+/* Compiled story images */
+
+#define STORY_IMAGE_FILENAME           "story.img" /* Default image in story dir */
+#define STORY_IMAGE_MAGIC              "TAESTORY"  /* First 8 bytes of an image */
+#define STORY_IMAGE_VERSION            5           /* Bump on any layout change */
+
+/* Lazy story text */
+
+#define TEXT_CACHE_SLOTS               32  /* Strings kept after reading them back */
+
+/* Room streaming */
+
+#define STREAM_REGION_ROOMS            256 /* Rooms per region when rooms.ini names none */
+#define STREAM_RESIDENT_REGIONS        16  /* Regions kept loaded before evicting */
+#define STREAM_MIN_RESIDENT_REGIONS    2   /* The player's region and one more */
+
+/* Story file watching */
+
+#define WATCH_SETTLE_MS                50  /* Quiet time before reading an edited file */
+
+/* Story linking */
+
+#define LINK_MAX_REPORTED              10  /* Dangling references printed (all are logged) */
+
+/* Story validation */
+
+#define VALIDATE_MAX_REPORTED          10  /* Problems printed (all are logged) */
+
+/* Story menu and path sizes (loaded stories hold exact-length strings) */
 #define STORY_TITLE_SIZE           128
 #define STORY_AUTHOR_SIZE          64
 #define STORY_VERSION_SIZE         16
 #define STORY_DESCRIPTION_SIZE     512
 #define STORY_DIRECTORY_SIZE       256
 
-#define ROOM_ID_SIZE               64
-#define ROOM_NAME_SIZE             128
-#define ROOM_DESCRIPTION_SIZE      512
-#define ROOM_LOCKED_EXIT_SIZE      64   /* ID of locked exit direction */
+/* Story catalog */
+
+#define STORY_CATALOG_FILENAME         ".catalog"   /* Metadata cache in the stories directory */
+#define STORY_CATALOG_MAGIC            "TAECATALOG" /* First word of the cache */
+#define STORY_CATALOG_VERSION          1            /* Bump on any format change */
+#define STORY_MENU_PAGE_SIZE           10  /* Stories listed per menu page */
+#define STORY_FILTER_SIZE              64  /* Longest menu filter */
+
+/* Dialog trees */
+
+#define DIALOG_FILENAME                "dialogs.ini"
+#define DIALOG_STATE_ANY               -1  /* state_required / set_state unset */
+#define DIALOG_MAX_CHAIN               32  /* auto_continue steps shown per turn */
+
+/* Scripts and condition expressions */
+
+#define SCRIPTS_FILENAME               "scripts.ini"
+#define SCRIPT_NONE                    -1  /* No expression: always true */
+#define SCRIPT_MAX_STACK               32  /* Evaluation stack slots */
+#define SCRIPT_MAX_NESTING             8   /* script(name) calls inside calls */
+#define SCRIPT_NAME_SIZE               64  /* Longest identifier in an expression */
+
+/* Command grammar */
+
+#define GRAMMAR_MAX_PATTERN_WORDS      16  /* Words and slots in one pattern */
+
+/* Turn output */
 
-#define NPC_ID_SIZE                64
-#define NPC_NAME_SIZE              128
-#define NPC_DESCRIPTION_SIZE       256
-#define NPC_LOCATION_SIZE          64
+#define OUTPUT_INITIAL_CAPACITY        4096 /* Bytes; a turn rarely needs more */
 
 /* Quest constants */
-#define QUEST_ID_SIZE              64
-#define QUEST_NAME_SIZE            128
-#define QUEST_DESCRIPTION_SIZE     512
-#define QUEST_COMPLETION_ID_SIZE   64
 #define COMBAT_MSG_SIZE            512
 #define COMBAT_MAX_HP              10
 #define COMBAT_BASE_WIN_CHANCE     0.75f
@@ -7,17 +7,22 @@
 
 
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "ui/colors.h"
+#include "ui/output.h"
 #include "constants.h"
 #include "core/logger.h"
 #include "game.h"
 #include "gameplay/quests.h"
+#include "story/reload.h"
+#include "story/scripts.h"
 #include "world/items.h"
 #include "world/npcs.h"
+#include "world/rooms.h"
 
 
 
@@ -26,25 +31,26 @@
  * @story: Pointer to story data
  * @room_id: String identifier of room to find
  *
- * Searches the story's room array for a matching room ID using string
- *  comparison.
+ * Looks the ID up in the story's perfect hash room index: one hash and
+ * one string comparison however many rooms the story has. In a
+ * streamed story the room's region may have to be loaded, and the
+ * pointer is only good until another region loads unless the room is
+ * the player's (see room_stream_enter()).
  *
  * Return: Pointer to room if found, NULL otherwise
  */
 
 Room* find_room_by_id(Story* story, const char* room_id) {
-    
-    add_log_entry("Searching for room: %s at %s", room_id, log_timestamp());
+    int i;
 
-    for (int i = 0; i < story->room_count; i++) {
-        if (strcmp(story->rooms[i].id, room_id) == 0) {
-            add_log_entry("Found room: %s at %s", room_id, log_timestamp());
-            return &story->rooms[i]; /* Return pointer to this room */
-        }
+    i = story_index_find(&story->room_index, room_id);
+    if (i < 0) {
+        add_log_entry("Room not found: %s at %s", room_id, log_timestamp());
+        return NULL; /* Not found */
     }
-    
-    add_log_entry("Room not found: %s at %s", room_id, log_timestamp());
-    return NULL; /* Not found */
+
+    /* Loads the room's region first if the story streams its rooms */
+    return story_room(story, i);
 }
 
 
@@ -77,7 +83,7 @@ GameState* init_game_state(Story* story) {
     /* Find the starting room */
     game->current_room = find_room_by_id(story, story->metadata.start_room); 
     if (!game->current_room) {
-        printf(COLOR_RED "ERROR: Starting room '%s' not found!\n" COLOR_RESET, story->metadata.start_room);
+        output_printf(COLOR_RED "ERROR: Starting room '%s' not found!\n" COLOR_RESET, story->metadata.start_room);
         free(game);
         log_function_error(__func__, "ERROR: Starting room not found!");
         log_function_exit(__func__, 0);
@@ -92,13 +98,21 @@ GameState* init_game_state(Story* story) {
     game->death_count = 0;
     game->turn_count = 0;
     game->score = 0;
-    strncpy(game->respawn_room, story->metadata.start_room, ROOM_ID_SIZE - 1);
+    game->respawn_room = game->current_room;
+    room_stream_enter(story, game->current_room);
     
     /* Initialize combat state */
     game->combat_npc = NULL;
     game->player_combat_hp = COMBAT_MAX_HP;
+
+    /* No conversation yet */
+    game->talk_npc = NULL;
+    game->talk_node = DIALOG_NONE;
     
     game->game_won = false;
+
+    /* Each turn's text is written in one go */
+    output_init(&game->output, fileno(stdout));
     
     add_log_entry("Game initialized: room=%s, inventory_slots=%d at %s",
                   game->current_room->id, 
@@ -115,14 +129,14 @@ GameState* init_game_state(Story* story) {
   * free_game_state() - Free game state and associated resources
   * @game: Pointer to game state to free
   *
-  * Frees inventory array, quest flags array, and the game state structure
-  * itself. Handles NULL pointers safely.
+  * Frees inventory array, quest flags array, output buffer, and the game
+  * state structure itself. Handles NULL pointers safely.
   *
   * Return: void
   */
  
 void free_game_state(GameState* game) {
-    printf("[STUB] free_game_state()\n");
+    output_printf("[STUB] free_game_state()\n");
     
     if (game) {
         // Free inventory if allocated
@@ -134,6 +148,8 @@ void free_game_state(GameState* game) {
         if (game->quest_flags) {
             free(game->quest_flags);
         }
+
+        output_free(&game->output);
         
         free(game);
     }
@@ -184,126 +200,152 @@ bool check_victory_condition(GameState* game) {
 }
 
  /**
-  * look_at_current_room() - Display current room description
-  * @game: Pointer to current game state
-  * Prints room name, description, available exits with directions, and visible 
-  * items in the room
+  * render_room() - Print what looking at a room shows
+  * @story: Story holding the room
+  * @room: Room to show
+  * @lit: The player can see in the room
+  *
+  * Prints room name, description, available exits with directions, and
+  * visible items and NPCs, or only the name and description in the dark.
   *
   * Return: void
   */
- 
-void look_at_current_room(GameState* game) {
-    Room *room;
-    bool has_light = false;
-    int i;
-
-
-    add_log_entry("Player looking at room: %s at %s", 
-                  game->current_room->id, 
-                  log_timestamp());
-
-    if (!game->current_room) {
-        printf("ERROR: No current room!\n");
-        log_function_error(__func__, "ERROR: No current room!");
-        log_function_exit(__func__, 0);
-        return;
-    }
-
-    room = game->current_room;
-
-    /* Check if player has a light source in inventory */
-    if (room->dark) {
-        for (i = 0; i < game->inventory_count; i++) {
-            if (game->inventory[i]->illuminates) {
-                has_light = true;
-                break;
-            }
-        }
-    }
 
+static void render_room(Story *story, Room *room, bool lit) {
     /* Print room name */
     printf_colored(COLOR_BOLD COLOR_CYAN, "%s\n", room->name);
 
     /* Print room description */
-    printf("%s\n", room->description);
+    output_printf("%s\n", room_description(story, room));
 
     /* If dark and no light, hide details */
-    if (room->dark && !has_light) {
-        printf("\n");
+    if (!lit) {
+        output_printf("\n");
         printf_colored(COLOR_WARNING,"It's too dark to see anything!\n");
-        add_log_entry("Room is dark, player has no light at %s", log_timestamp());
-        log_function_exit(__func__,0);
         return;
     }
 
 
     /* Print exits */
     if (room->exit_count > 0) {
-        printf("\n");
+        output_printf("\n");
         printf_colored(COLOR_BOLD,"Exits:");
-        for (int i = 0; i < room->exit_count; i++) {
-            /* Parse "direction:room_id" format */
-            char exit_copy[PARSER_EXIT_BUFFER_SIZE];
-            strncpy(exit_copy, room->exits[i], sizeof(exit_copy) - 1);
-            exit_copy[sizeof(exit_copy) - 1] = '\0';
-
-            char* colon = strchr(exit_copy, ':');
-            if (colon) {
-                *colon = '\0'; /* Split at colon */
-                char* direction = exit_copy;
-                
-                /* Show if exit is locked */
-                if (room->locked && strcmp(direction, room->locked_exit) == 0) {
-                    printf(" ");
-                    printf_colored(COLOR_RED, "%s (locked)", direction);
-                } else {
-                    printf(" ");
-                    printf_colored(COLOR_GREEN, "%s", direction);
-                }
+        for (int d = 0; d < DIR_COUNT; d++) {
+            if (!room->exit_ids[d])
+                continue;
+
+            /* Show if exit is locked */
+            output_printf(" ");
+            if (room->locked && d == (int)room->locked_exit) {
+                printf_colored(COLOR_RED, "%s (locked)", direction_name(d));
+            } else {
+                printf_colored(COLOR_GREEN, "%s", direction_name(d));
             }
         }
-        printf("\n");
+        output_printf("\n");
     } else {
         printf_colored(COLOR_GRAY, "No obvious exits.\n");
     }
 
-    /* Print items (if any) */
+    /* Print items (if any) - unknown IDs were reported at link time */
     if (room->item_count > 0) {
-        printf("\n");
+        output_printf("\n");
         printf_colored(COLOR_BOLD,"You see:");
         for (int i = 0; i < room->item_count; i++) {
-            /* Find the item by ID */
-            Item *item = find_item_by_id(game->story->items,
-                                         game->story->item_count,
-                                         room->items[i]);
-            if (item) {
-                printf(" ");
-                printf_colored(COLOR_ITEM, "%s", item->name);
-            } else {
-                printf(" [unknown item: %s]", room->items[i]);
-            }
+            output_printf(" ");
+            printf_colored(COLOR_ITEM, "%s", room->items[i]->name);
         }
-        printf("\n");
+        output_printf("\n");
     }
 
     /* Print NPCs (if any) */
     if (room->npc_count > 0) {
-        printf("\n");
+        output_printf("\n");
         printf_colored(COLOR_BOLD, "Present:");
         for (int i = 0; i < room->npc_count; i++) {
-            NPC *npc = find_npc_by_id(game->story->npcs,
-                                      game->story->npc_count,
-                                      room->npcs[i]);
-            if (npc) {
-                printf(" ");
-                printf_colored(COLOR_NPC, "%s", npc->name);
-            } else {
-                printf(" [unknown NPC: %s]", room->npcs[i]);
+            output_printf(" ");
+            printf_colored(COLOR_NPC, "%s", room->npcs[i]->name);
+        }
+        output_printf("\n");
+    }
+}
+
+
+ /**
+  * look_at_current_room() - Display current room description
+  * @game: Pointer to current game state
+  *
+  * The room is rendered once into its view buffer, which later looks
+  * and revisits print with one copy. Taking, dropping, unlocking and
+  * defeating invalidate the view (see room_view_invalidate()), as does
+  * carrying a light into or out of a dark room.
+  *
+  * Return: void
+  */
+ 
+void look_at_current_room(GameState* game) {
+    Room *room;
+    Output view;
+    Output *previous;
+    bool lit = true;
+    int i;
+
+
+    if (!game->current_room) {
+        output_printf("ERROR: No current room!\n");
+        log_function_error(__func__, "ERROR: No current room!");
+        log_function_exit(__func__, 0);
+        return;
+    }
+
+    add_log_entry("Player looking at room: %s at %s", 
+                  game->current_room->id, 
+                  log_timestamp());
+
+    room = game->current_room;
+
+    /* Check if player has a light source in inventory */
+    if (room->dark) {
+        lit = false;
+        for (i = 0; i < game->inventory_count; i++) {
+            if (game->inventory[i]->illuminates) {
+                lit = true;
+                break;
             }
         }
-        printf("\n");
+        if (!lit)
+            add_log_entry("Room is dark, player has no light at %s", log_timestamp());
+    }
+
+    /* Nothing shown here has changed since it was last rendered */
+    if (room_view_valid(game->story, room, lit)) {
+        output_write(room->view, room->view_length);
+        log_function_exit(__func__, 0);
+        return;
     }
 
+    /* Render into the room's buffer, reusing its allocation */
+    output_init(&view, -1);
+    view.data = room->view;
+    view.capacity = room->view_capacity;
+    previous = output_select(&view);
+    render_room(game->story, room, lit);
+    output_select(previous);
+
+    room->view = view.data;
+    room->view_capacity = view.capacity;
+    if (view.truncated) {
+        /* Out of memory: show it uncached, as before */
+        room_view_invalidate(room);
+        render_room(game->story, room, lit);
+        log_function_exit(__func__, 0);
+        return;
+    }
+    room->view_length = view.length;
+    room->view_generation = game->story->view_generation;
+    room->view_lit = lit;
+    output_write(room->view, room->view_length);
+
     log_function_exit(__func__, 0);
 }
 
@@ -311,17 +353,19 @@ void look_at_current_room(GameState* game) {
 /**
  * check_and_complete_quests() - Check if any quests completed
  * @game: Pointer to current game state
- * @item_id: Item just acquired (or NULL)
- * @npc_id: NPC just talked to (or NULL)
- * @room_id: Room just entered (or NULL)
+ * @item: Item just acquired (or NULL)
+ * @npc: NPC just talked to (or NULL)
+ * @room: Room just entered (or NULL)
  *
  * Checks all incomplete quests to see if completion conditions are met.
+ * A quest with a completion_check also needs its check to hold; one
+ * with no target at all is left to check_quest_scripts().
  * Displays completion message and updates quest status.
  *
  * Return: void
  */
-void check_and_complete_quests(GameState* game, const char* item_id,
-                               const char* npc_id, const char* room_id) {
+void check_and_complete_quests(GameState* game, const Item* item,
+                               const NPC* npc, const Room* room) {
 	int i;
 	Quest *quest;
 
@@ -331,31 +375,170 @@ void check_and_complete_quests(GameState* game, const char* item_id,
 	for (i = 0; i < game->story->quest_count; i++) {
 		quest = &game->story->quests[i];
 
-		if (quest->completed)
+		if (quest->completed || quest->failed)
 			continue;
 
-		if (check_quest_completion(quest, item_id, npc_id, room_id)) {
-			quest->completed = true;
-
-			printf("\n");
-            printf_colored(COLOR_QUEST, "*** QUEST COMPLETED: %s ***\n", quest->name);
-			
-			if (strlen(quest->completion_message) > 0) {
-				printf_colored(COLOR_SUCCESS, "%s\n", quest->completion_message);
-			}
-			
-			printf("\n");
+		if (quest->completion_item[0] == '\0' &&
+		    quest->completion_npc[0] == '\0' &&
+		    quest->completion_room[0] == '\0')
+			continue;
 
-			add_log_entry("Quest completed: %s (item=%s, npc=%s, room=%s) at %s",
+		if (check_quest_completion(quest, item, npc, room) &&
+		    script_test(game, quest->completion_code)) {
+			add_log_entry("Quest target reached: %s (item=%s, npc=%s, room=%s) at %s",
 			             quest->id,
-			             item_id ? item_id : "none",
-			             npc_id ? npc_id : "none",
-			             room_id ? room_id : "none",
+			             item ? item->id : "none",
+			             npc ? npc->id : "none",
+			             room ? room->id : "none",
 			             log_timestamp());
-            
-            /* Check if this completed all requried quests */
-            check_victory_condition(game);
+			complete_quest(game, quest);
+		}
+	}
+}
+
+
+/**
+ * complete_quest() - Mark a quest completed and announce it
+ * @game: Pointer to current game state
+ * @quest: Quest the player has just completed
+ *
+ * Shared by quest targets and dialog quest actions.
+ *
+ * Return: void
+ */
+void complete_quest(GameState* game, Quest* quest) {
+	if (quest->completed || quest->failed)
+		return;
+
+	quest->completed = true;
+
+	output_printf("\n");
+	printf_colored(COLOR_QUEST, "*** QUEST COMPLETED: %s ***\n", quest->name);
+
+	if (strlen(quest->completion_message) > 0) {
+		printf_colored(COLOR_SUCCESS, "%s\n", quest->completion_message);
+	}
+
+	output_printf("\n");
+
+	add_log_entry("Quest completed: %s at %s", quest->id, log_timestamp());
+
+	/* Check if this completed all requried quests */
+	check_victory_condition(game);
+}
+
+
+/**
+ * fail_quest() - Mark a quest failed and announce it
+ * @game: Pointer to current game state
+ * @quest: Quest the player has just failed
+ *
+ * Shared by failure conditions and dialog quest actions.
+ *
+ * Return: void
+ */
+void fail_quest(GameState* game, Quest* quest) {
+	(void) game;
+
+	if (quest->completed || quest->failed)
+		return;
+
+	quest->failed = true;
+
+	output_printf("\n");
+	printf_colored(COLOR_ERROR, "*** QUEST FAILED: %s ***\n", quest->name);
+
+	add_log_entry("Quest failed: %s at %s", quest->id, log_timestamp());
+}
+
+
+/**
+ * check_quest_scripts() - Evaluate quest conditions after a turn
+ * @game: Pointer to current game state
+ *
+ * Fails quests whose failure_condition holds, then completes quests
+ * that have a completion_check but no item, NPC or room target, since
+ * no event will check them. Each test is a run of compiled bytecode.
+ *
+ * Return: void
+ */
+void check_quest_scripts(GameState* game) {
+	int i;
+	Quest *quest;
+
+	for (i = 0; i < game->story->quest_count; i++) {
+		quest = &game->story->quests[i];
+
+		if (quest->completed || quest->failed)
+			continue;
+
+		if (quest->failure_code != SCRIPT_NONE &&
+		    script_eval(game, quest->failure_code)) {
+			fail_quest(game, quest);
+		} else if (quest->completion_code != SCRIPT_NONE &&
+		           quest->completion_item[0] == '\0' &&
+		           quest->completion_npc[0] == '\0' &&
+		           quest->completion_room[0] == '\0' &&
+		           script_eval(game, quest->completion_code)) {
+			complete_quest(game, quest);
 		}
 	}
 }
 
+
+
+/**
+ * game_reload_story() - Pick up story files edited during play
+ * @game: Pointer to current game state
+ * @files: Bit (1u << TextFile) per file that changed
+ *
+ * Return: void
+ */
+
+void game_reload_story(GameState* game, unsigned int files) {
+	StoryReload reload;
+	int combat_hp = game->combat_npc ? game->combat_npc->combat_hp : 0;
+	int file;
+	int ret;
+
+	log_function_entry(__func__, "files=0x%x", files);
+
+	for (file = 0; file < TEXT_FILE_COUNT; file++) {
+		if (!(files & (1u << file)))
+			continue;
+
+		ret = story_reload_file(game->story, (TextFile)file, &reload);
+		if (ret == -ENOTSUP) {
+			printf_colored(COLOR_WARNING,
+			               "[%s changed; restart to reload a streamed story]\n",
+			               text_file_name((TextFile)file));
+			continue;
+		}
+		if (ret == -ENOENT) {
+			/* Caught mid-save, or emptied; the next write reloads it */
+			continue;
+		}
+		if (ret < 0) {
+			printf_colored(COLOR_ERROR, "[Reloading %s failed]\n",
+			               text_file_name((TextFile)file));
+			continue;
+		}
+
+		printf_colored(COLOR_INFO, "[Reloaded %s: %d changed in %.1f ms]\n",
+		               text_file_name((TextFile)file), reload.changed,
+		               reload.elapsed_ms);
+		if (reload.added > 0 || reload.removed > 0)
+			printf_colored(COLOR_WARNING,
+			               "[%d added and %d removed take effect on restart]\n",
+			               reload.added, reload.removed);
+	}
+
+	if (game->combat_npc)
+		game->combat_npc->combat_hp = combat_hp;
+
+	game->inventory_weight = 0;
+	for (int i = 0; i < game->inventory_count; i++)
+		game->inventory_weight += game->inventory[i]->weight;
+
+	log_function_exit(__func__, 0);
+}
@@ -13,6 +13,7 @@
 
 #include "core/logger.h"
 #include "story/story.h"
+#include "ui/output.h"
 
 
 /**
@@ -27,10 +28,13 @@
  * @death_count: Number of times player has died
  * @turn_count: Number of turns elapsed
  * @score: Current player score
- * @respawn_room: Room to respawn after death
+ * @respawn_room: Room to respawn in after death
  * @combat_npc: Currently fighting this NPC (NULL if not in combat)
  * @player_combat_hp: Player HP in current combat
+ * @talk_npc: NPC waiting for the player's answer (NULL if none)
+ * @talk_node: Dialog node waiting for the answer, DIALOG_NONE if none
  * @game_won: True if player has achieved victory
+ * @output: Text of the turn in progress, written to stdout once per turn
  *
  * Contains all mutable game state including player position, inventory, 
  * progress tracking, and statistics.
@@ -47,12 +51,19 @@ typedef struct {
     int death_count;         
     int turn_count;         
     int score;               
-    char respawn_room[ROOM_ID_SIZE];
+    Room *respawn_room;
 
     /* Combat state */
     NPC *combat_npc;
     int player_combat_hp;
+
+    /* Conversation state */
+    NPC *talk_npc;
+    int talk_node;
     bool game_won;            
+
+    /* Session output */
+    Output output;
 } GameState;
 
 
@@ -109,9 +120,9 @@ void look_at_current_room(GameState* game);
 /**
  * check_and_complete_quests() - Check if any quests completed
  * @game: Pointer to current game state
- * @item_id: Item just acquired (or NULL)
- * @npc_id: NPC just talked to (or NULL)
- * @room_id: Room just entered (or NULL)
+ * @item: Item just acquired (or NULL)
+ * @npc: NPC just talked to (or NULL)
+ * @room: Room just entered (or NULL)
  *
  * Checks all incomplete quests to see if completion conditions are met.
  * Displays completion message and updates quest status.
@@ -119,8 +130,44 @@ void look_at_current_room(GameState* game);
  * Return: void
  */
 
-void check_and_complete_quests(GameState* game, const char* item_id, 
-                               const char* npc_id, const char* room_id);
+void check_and_complete_quests(GameState* game, const Item* item, 
+                               const NPC* npc, const Room* room);
+
+
+/**
+ * complete_quest() - Mark a quest completed and announce it
+ * @game: Pointer to current game state
+ * @quest: Quest the player has just completed
+ *
+ * Does nothing if the quest is already completed or has failed.
+ *
+ * Return: void
+ */
+void complete_quest(GameState* game, Quest* quest);
+
+
+/**
+ * fail_quest() - Mark a quest failed and announce it
+ * @game: Pointer to current game state
+ * @quest: Quest the player has just failed
+ *
+ * Does nothing if the quest is already completed or has failed.
+ *
+ * Return: void
+ */
+void fail_quest(GameState* game, Quest* quest);
+
+
+/**
+ * check_quest_scripts() - Evaluate quest conditions after a turn
+ * @game: Pointer to current game state
+ *
+ * Applies failure_condition, and completion_check for quests that
+ * have no other target. Called once per command.
+ *
+ * Return: void
+ */
+void check_quest_scripts(GameState* game);
 
 
 /**
@@ -135,4 +182,20 @@ void check_and_complete_quests(GameState* game, const char* item_id,
 
 Room* find_room_by_id(Story* story, const char* room_id);
 
+
+/**
+ * game_reload_story() - Pick up story files edited during play
+ * @game: Pointer to current game state
+ * @files: Bit (1u << TextFile) per file that changed
+ *
+ * Patches the loaded story in place (see story_reload_file()), so the
+ * player stays where they are with what they carry. A fight in progress
+ * keeps its NPC's remaining health, and the carried weight is worked
+ * out again in case item weights changed. Prints one line per file.
+ *
+ * Return: void
+ */
+
+void game_reload_story(GameState* game, unsigned int files);
+
 #endif /* GAME_H */
\ No newline at end of file
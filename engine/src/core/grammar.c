@@ -0,0 +1,1167 @@
+/*
+ * grammar.c - Command grammar: verb patterns compiled into a DFA
+ *
+ * A command is a verb and then words read by class: articles are
+ * dropped, "all" is marked, and a preposition ends the first noun and
+ * starts the second. That plain grammar is the fixed table below.
+ * Patterns such as "pick {noun} up", and whatever a story declares,
+ * are merged on top of it into one DFA per story. The words a pattern
+ * uses get columns of their own and win over being read by class, and
+ * each state records the pattern that input ending there completes.
+ * Parsing is one table read per word, left to right, never looking
+ * back.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grammar.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "story/ini_parser.h"
+#include "ui/colors.h"
+
+
+/* What a word does to the command being built */
+enum {
+	GRAMMAR_SKIP,		/* Nothing: an article or a pattern's own word */
+	GRAMMAR_NOUN_NEW,	/* Starts the noun */
+	GRAMMAR_NOUN,		/* Joins the noun */
+	GRAMMAR_ALL,		/* Starts the noun as "all" */
+	GRAMMAR_PARTICLE,	/* Preposition right after the verb ("go in") */
+	GRAMMAR_PREP,		/* Is the preposition */
+	GRAMMAR_NOUN2_NEW,	/* Starts the second noun */
+	GRAMMAR_NOUN2,		/* Joins the second noun */
+};
+
+/* States of the plain grammar; every compiled grammar begins with them */
+enum {
+	GRAMMAR_DEAD,		/* Nothing can match any more */
+	GRAMMAR_AT_VERB,	/* After the verb */
+	GRAMMAR_AT_PARTICLE,	/* After "verb prep" */
+	GRAMMAR_AT_ARTICLE,	/* After an article, before the noun */
+	GRAMMAR_IN_NOUN,	/* In the noun */
+	GRAMMAR_AT_PREP,	/* After the preposition */
+	GRAMMAR_IN_NOUN2,	/* In the second noun */
+	GRAMMAR_PLAIN_STATES
+};
+
+/* Kinds of pattern element */
+enum {
+	GRAMMAR_LITERAL,
+	GRAMMAR_SLOT_NOUN,
+	GRAMMAR_SLOT_NOUN2,
+};
+
+
+#define E(next, action) { GRAMMAR_##next, GRAMMAR_##action }
+
+/* Columns: WORD_PLAIN, WORD_ARTICLE, WORD_ALL, WORD_PREP */
+static const GrammarEdge grammar_plain_edges[GRAMMAR_PLAIN_STATES * WORD_CLASS_COUNT] = {
+	/* DEAD */
+	E(DEAD, SKIP),		E(DEAD, SKIP),		E(DEAD, SKIP),		E(DEAD, SKIP),
+	/* AT_VERB */
+	E(IN_NOUN, NOUN_NEW),	E(AT_ARTICLE, SKIP),	E(IN_NOUN, ALL),	E(AT_PARTICLE, PARTICLE),
+	/* AT_PARTICLE */
+	E(IN_NOUN, NOUN_NEW),	E(AT_ARTICLE, SKIP),	E(IN_NOUN, ALL),	E(IN_NOUN, NOUN_NEW),
+	/* AT_ARTICLE */
+	E(IN_NOUN, NOUN_NEW),	E(AT_ARTICLE, SKIP),	E(IN_NOUN, ALL),	E(IN_NOUN, NOUN_NEW),
+	/* IN_NOUN */
+	E(IN_NOUN, NOUN),	E(IN_NOUN, NOUN),	E(IN_NOUN, NOUN),	E(AT_PREP, PREP),
+	/* AT_PREP */
+	E(IN_NOUN2, NOUN2_NEW),	E(AT_PREP, SKIP),	E(IN_NOUN2, NOUN2_NEW),	E(IN_NOUN2, NOUN2_NEW),
+	/* IN_NOUN2 */
+	E(IN_NOUN2, NOUN2),	E(IN_NOUN2, NOUN2),	E(IN_NOUN2, NOUN2),	E(IN_NOUN2, NOUN2),
+};
+
+#undef E
+
+static const int16_t grammar_plain_accept[GRAMMAR_PLAIN_STATES] = {
+	GRAMMAR_REJECT,
+	GRAMMAR_ACCEPT_VERB, GRAMMAR_ACCEPT_VERB, GRAMMAR_ACCEPT_VERB,
+	GRAMMAR_ACCEPT_VERB, GRAMMAR_ACCEPT_VERB, GRAMMAR_ACCEPT_VERB,
+};
+
+/* Used when there is no story, or its grammar has not been compiled */
+static const Grammar grammar_plain = {
+	.edges = grammar_plain_edges,
+	.accept = grammar_plain_accept,
+	.state_count = GRAMMAR_PLAIN_STATES,
+	.symbol_count = WORD_CLASS_COUNT,
+};
+
+/* Patterns every story has; a story's own rules are tried first */
+static const GrammarRule grammar_builtin[] = {
+	{ "look at {noun}",	"examine" },
+	{ "look in {noun}",	"examine" },
+	{ "pick up {noun}",	"take" },
+	{ "pick {noun} up",	"take" },
+	{ "put down {noun}",	"drop" },
+	{ "put {noun} down",	"drop" },
+};
+
+#define GRAMMAR_BUILTIN_COUNT \
+	((int)(sizeof(grammar_builtin) / sizeof(grammar_builtin[0])))
+
+
+/**
+ * struct GrammarPattern - A rule split into its elements
+ * @rule: Rule it came from
+ * @meaning: Built-in word the rule means
+ * @words: Literal words (arena copies), NULL for a slot
+ * @kinds: GRAMMAR_LITERAL or the slot each element is
+ * @count: Number of elements
+ */
+
+typedef struct {
+	const GrammarRule *rule;
+	const VerbEntry *meaning;
+	const char *words[GRAMMAR_MAX_PATTERN_WORDS];
+	int kinds[GRAMMAR_MAX_PATTERN_WORDS];
+	int count;
+} GrammarPattern;
+
+
+/**
+ * struct GrammarNode - What compilation knows about one state
+ * @accept: Rule completed here, or GRAMMAR_ACCEPT_VERB / GRAMMAR_REJECT
+ * @merged: The state also plays the plain grammar's part, so a slot
+ *          for the noun hung off it keeps the plain continuations
+ * @slot_kind: Slot that follows this state, 0 for none
+ * @slot_start: State waiting for the slot's first word
+ * @slot_filled: State inside the slot
+ */
+
+typedef struct {
+	int16_t accept;
+	bool merged;
+	int slot_kind;
+	int slot_start;
+	int slot_filled;
+} GrammarNode;
+
+
+/**
+ * struct GrammarBuild - A grammar being compiled
+ * @story: Story the grammar is for
+ * @edges: Transition rows, one per state
+ * @owned: Per cell, set when a pattern word put it there
+ * @nodes: Per state compile information
+ * @state_count: Number of states
+ * @state_capacity: States allocated
+ * @symbol_count: Columns per row
+ * @words: Words with a column of their own
+ * @word_classes: Class each of @words has when no pattern expects it
+ * @word_count: Number of entries in @words
+ * @heads: Words that start a pattern
+ * @head_count: Number of entries in @heads
+ * @head_capacity: Entries allocated in @heads
+ */
+
+typedef struct {
+	const Story *story;
+	GrammarEdge *edges;
+	bool *owned;
+	GrammarNode *nodes;
+	int state_count;
+	int state_capacity;
+	int symbol_count;
+	GrammarWord *words;
+	WordClass *word_classes;
+	int word_count;
+	GrammarHead *heads;
+	int head_count;
+	int head_capacity;
+} GrammarBuild;
+
+
+/**
+ * grammar_invalid() - Report a pattern that cannot be compiled
+ * @rule: The rule
+ * @reason: What is wrong with it
+ *
+ * Return: -EINVAL
+ */
+
+static int grammar_invalid(const GrammarRule *rule, const char *reason)
+{
+	printf_colored(COLOR_WARNING, "WARNING: grammar pattern '%s' %s\n",
+		       rule->pattern, reason);
+	add_log_entry("Grammar pattern '%s' skipped: %s", rule->pattern, reason);
+	return -EINVAL;
+}
+
+
+/**
+ * grammar_split() - Split a rule into literal words and slots
+ * @story: Story the rule belongs to
+ * @rule: The rule
+ * @pattern: Filled in
+ *
+ * Return: 0 on success, -EINVAL for a pattern that makes no sense,
+ * -ENOMEM on failure
+ */
+
+static int grammar_split(Story *story, const GrammarRule *rule,
+			 GrammarPattern *pattern)
+{
+	const char *p = rule->pattern;
+	bool seen[GRAMMAR_SLOT_NOUN2 + 1] = { false };
+	int i;
+
+	pattern->rule = rule;
+	pattern->count = 0;
+
+	while (*p) {
+		size_t len;
+		int kind;
+
+		while (isspace((unsigned char)*p))
+			p++;
+		if (!*p)
+			break;
+		for (len = 0; p[len] && !isspace((unsigned char)p[len]); len++)
+			;
+
+		if (pattern->count == GRAMMAR_MAX_PATTERN_WORDS)
+			return grammar_invalid(rule, "has too many words");
+
+		if (len == 6 && strncmp(p, "{noun}", len) == 0)
+			kind = GRAMMAR_SLOT_NOUN;
+		else if (len == 7 && strncmp(p, "{noun2}", len) == 0)
+			kind = GRAMMAR_SLOT_NOUN2;
+		else if (*p == '{')
+			return grammar_invalid(rule, "has a slot other than "
+					       "{noun} or {noun2}");
+		else
+			kind = GRAMMAR_LITERAL;
+
+		pattern->kinds[pattern->count] = kind;
+		pattern->words[pattern->count] = NULL;
+		if (kind == GRAMMAR_LITERAL) {
+			char *word = arena_strndup(&story->arena, p, len);
+
+			if (!word)
+				return -ENOMEM;
+			for (char *c = word; *c; c++)
+				*c = (char)tolower((unsigned char)*c);
+			pattern->words[pattern->count] = word;
+		} else if (seen[kind]) {
+			return grammar_invalid(rule, "uses a slot twice");
+		} else {
+			seen[kind] = true;
+		}
+		pattern->count++;
+		p += len;
+	}
+
+	if (pattern->count == 0 || pattern->kinds[0] != GRAMMAR_LITERAL)
+		return grammar_invalid(rule, "does not start with a word");
+	for (i = 1; i < pattern->count; i++) {
+		if (pattern->kinds[i] != GRAMMAR_LITERAL &&
+		    pattern->kinds[i - 1] != GRAMMAR_LITERAL)
+			return grammar_invalid(rule, "has two slots with no "
+					       "word between them");
+	}
+
+	pattern->meaning = verb_lookup(story, rule->command);
+	if (!pattern->meaning || pattern->meaning->type == CMD_UNKNOWN)
+		return grammar_invalid(rule, "means an unknown command word");
+
+	return 0;
+}
+
+
+/**
+ * grammar_add_word() - Give a pattern word a column of its own
+ * @b: Grammar being compiled
+ * @word: The word
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+static int grammar_add_word(GrammarBuild *b, const char *word)
+{
+	const VerbEntry *entry;
+	int i;
+
+	for (i = 0; i < b->word_count; i++) {
+		if (strcmp(b->words[i].word, word) == 0)
+			return 0;
+	}
+
+	entry = verb_builtin(word);
+	b->words[b->word_count].word = word;
+	b->words[b->word_count].symbol = WORD_CLASS_COUNT + b->word_count;
+	b->word_classes[b->word_count] = entry ? entry->word_class : WORD_PLAIN;
+	b->word_count++;
+	return 0;
+}
+
+
+/**
+ * grammar_symbol_of() - Column of a word a pattern uses
+ * @b: Grammar being compiled
+ * @word: The word, already given a column
+ *
+ * Return: The column
+ */
+
+static int grammar_symbol_of(const GrammarBuild *b, const char *word)
+{
+	int i;
+
+	for (i = 0; i < b->word_count; i++) {
+		if (strcmp(b->words[i].word, word) == 0)
+			return b->words[i].symbol;
+	}
+	return WORD_PLAIN;
+}
+
+
+/**
+ * grammar_class_of() - Class a column is read as when nothing expects it
+ * @b: Grammar being compiled
+ * @symbol: The column
+ *
+ * Return: The class
+ */
+
+static WordClass grammar_class_of(const GrammarBuild *b, int symbol)
+{
+	if (symbol < WORD_CLASS_COUNT)
+		return (WordClass)symbol;
+	return b->word_classes[symbol - WORD_CLASS_COUNT];
+}
+
+
+static inline GrammarEdge *grammar_cell(GrammarBuild *b, int state,
+					int symbol)
+{
+	return &b->edges[(size_t)state * (size_t)b->symbol_count + (size_t)symbol];
+}
+
+
+static inline bool *grammar_owned(GrammarBuild *b, int state, int symbol)
+{
+	return &b->owned[(size_t)state * (size_t)b->symbol_count + (size_t)symbol];
+}
+
+
+/**
+ * grammar_add_state() - Add a state that starts as a copy of another
+ * @b: Grammar being compiled
+ * @base: State to copy, -1 for none (the plain states)
+ *
+ * Return: The new state, negative errno on failure
+ */
+
+static int grammar_add_state(GrammarBuild *b, int base)
+{
+	size_t row = (size_t)b->symbol_count;
+	int state;
+
+	if (b->state_count >= INT16_MAX)
+		return -E2BIG;
+
+	if (b->state_count == b->state_capacity) {
+		int capacity = b->state_capacity > 0 ?
+			       b->state_capacity * 2 : ARRAY_INITIAL_CAPACITY;
+		GrammarEdge *edges;
+		GrammarNode *nodes;
+		bool *owned;
+
+		edges = realloc(b->edges, (size_t)capacity * row * sizeof(*edges));
+		if (!edges)
+			return -ENOMEM;
+		b->edges = edges;
+		owned = realloc(b->owned, (size_t)capacity * row * sizeof(*owned));
+		if (!owned)
+			return -ENOMEM;
+		b->owned = owned;
+		nodes = realloc(b->nodes, (size_t)capacity * sizeof(*nodes));
+		if (!nodes)
+			return -ENOMEM;
+		b->nodes = nodes;
+		b->state_capacity = capacity;
+	}
+
+	state = b->state_count++;
+	memset(grammar_owned(b, state, 0), 0, row * sizeof(bool));
+	memset(&b->nodes[state], 0, sizeof(b->nodes[state]));
+	b->nodes[state].accept = GRAMMAR_REJECT;
+	if (base >= 0) {
+		memcpy(grammar_cell(b, state, 0), grammar_cell(b, base, 0),
+		       row * sizeof(GrammarEdge));
+		b->nodes[state].accept = b->nodes[base].accept;
+	}
+	return state;
+}
+
+
+/**
+ * grammar_head_state() - State after a pattern's first word
+ * @b: Grammar being compiled
+ * @word: The word
+ * @create: Add the state if the word starts no pattern yet
+ *
+ * A word that is also a verb starts in a copy of the plain grammar's
+ * state after a verb, so "pick" keeps meaning "take" on its own.
+ *
+ * Return: The state, -1 if there is none and @create is false,
+ * negative errno on failure
+ */
+
+static int grammar_head_state(GrammarBuild *b, const char *word, bool create)
+{
+	const VerbEntry *verb;
+	GrammarHead *grown;
+	int state;
+	int i;
+
+	for (i = 0; i < b->head_count; i++) {
+		if (strcmp(b->heads[i].word, word) == 0)
+			return b->heads[i].state;
+	}
+	if (!create)
+		return -1;
+
+	verb = verb_lookup(b->story, word);
+	if (verb && verb->type != CMD_UNKNOWN) {
+		state = grammar_add_state(b, GRAMMAR_AT_VERB);
+		if (state >= 0)
+			b->nodes[state].merged = true;
+	} else {
+		state = grammar_add_state(b, GRAMMAR_DEAD);
+	}
+	if (state < 0)
+		return state;
+
+	grown = array_grow(b->heads, b->head_count, &b->head_capacity,
+			   sizeof(GrammarHead));
+	if (!grown)
+		return -ENOMEM;
+	b->heads = grown;
+	b->heads[b->head_count].word = word;
+	b->heads[b->head_count].state = state;
+	b->head_count++;
+	return state;
+}
+
+
+/**
+ * grammar_literal() - Follow or add a pattern word's transition
+ * @b: Grammar being compiled
+ * @state: State the word is read in
+ * @symbol: The word's column
+ *
+ * A preposition is kept as the command's preposition; any other
+ * pattern word is dropped. A preposition right after a verb leaves
+ * the plain grammar's state after a particle, so "look at" on its own
+ * still means "look".
+ *
+ * Return: State after the word, negative errno on failure
+ */
+
+static int grammar_literal(GrammarBuild *b, int state, int symbol)
+{
+	bool particle;
+	int next;
+
+	if (*grammar_owned(b, state, symbol))
+		return grammar_cell(b, state, symbol)->next;
+
+	particle = b->nodes[state].merged &&
+		   grammar_cell(b, state, symbol)->next == GRAMMAR_AT_PARTICLE;
+	next = grammar_add_state(b, particle ? GRAMMAR_AT_PARTICLE :
+				 GRAMMAR_DEAD);
+	if (next < 0)
+		return next;
+	b->nodes[next].merged = particle;
+
+	grammar_cell(b, state, symbol)->next = (int16_t)next;
+	grammar_cell(b, state, symbol)->action =
+		grammar_class_of(b, symbol) == WORD_PREP ?
+		GRAMMAR_PREP : GRAMMAR_SKIP;
+	*grammar_owned(b, state, symbol) = true;
+	return next;
+}
+
+
+/**
+ * grammar_slot() - Follow or add the slot after a state
+ * @b: Grammar being compiled
+ * @state: State the slot follows
+ * @kind: GRAMMAR_SLOT_NOUN or GRAMMAR_SLOT_NOUN2
+ *
+ * A slot is two states: one waiting for its first word, skipping
+ * articles, and one reading words into it until a word the pattern
+ * expects next. Hung off a verb, the noun slot also keeps the plain
+ * grammar's way on to a preposition and a second noun.
+ *
+ * Return: State inside the slot, -EINVAL if another slot already
+ * follows @state, negative errno on failure
+ */
+
+static int grammar_slot(GrammarBuild *b, int state, int kind)
+{
+	bool merged;
+	int start;
+	int filled;
+	int y;
+
+	if (b->nodes[state].slot_kind)
+		return b->nodes[state].slot_kind == kind ?
+		       b->nodes[state].slot_filled : -EINVAL;
+
+	merged = b->nodes[state].merged && kind == GRAMMAR_SLOT_NOUN;
+	start = grammar_add_state(b, merged ? GRAMMAR_AT_ARTICLE : GRAMMAR_DEAD);
+	if (start < 0)
+		return start;
+	filled = grammar_add_state(b, merged ? GRAMMAR_IN_NOUN : GRAMMAR_DEAD);
+	if (filled < 0)
+		return filled;
+
+	for (y = 0; y < b->symbol_count; y++) {
+		GrammarEdge *edge;
+
+		if (merged) {
+			/* Point the plain noun states' copies at each other */
+			int from[3] = { state, start, filled };
+
+			for (int i = 0; i < 3; i++) {
+				if (*grammar_owned(b, from[i], y))
+					continue;
+				edge = grammar_cell(b, from[i], y);
+				if (edge->next == GRAMMAR_AT_ARTICLE)
+					edge->next = (int16_t)start;
+				else if (edge->next == GRAMMAR_IN_NOUN)
+					edge->next = (int16_t)filled;
+			}
+			continue;
+		}
+
+		edge = grammar_cell(b, start, y);
+		switch (grammar_class_of(b, y)) {
+		case WORD_ARTICLE:
+			edge->next = (int16_t)start;
+			edge->action = GRAMMAR_SKIP;
+			break;
+		case WORD_ALL:
+			edge->next = (int16_t)filled;
+			edge->action = kind == GRAMMAR_SLOT_NOUN ?
+				       GRAMMAR_ALL : GRAMMAR_NOUN2_NEW;
+			break;
+		default:
+			edge->next = (int16_t)filled;
+			edge->action = kind == GRAMMAR_SLOT_NOUN ?
+				       GRAMMAR_NOUN_NEW : GRAMMAR_NOUN2_NEW;
+			break;
+		}
+		if (!*grammar_owned(b, state, y))
+			*grammar_cell(b, state, y) = *edge;
+
+		edge = grammar_cell(b, filled, y);
+		edge->next = (int16_t)filled;
+		edge->action = kind == GRAMMAR_SLOT_NOUN ?
+			       GRAMMAR_NOUN : GRAMMAR_NOUN2;
+	}
+
+	b->nodes[state].slot_kind = kind;
+	b->nodes[state].slot_start = start;
+	b->nodes[state].slot_filled = filled;
+	return filled;
+}
+
+
+/**
+ * grammar_tail() - Let a preposition end the noun a pattern ends in
+ * @b: Grammar being compiled
+ * @state: Accepting state inside the pattern's {noun} slot
+ * @rule: Number the pattern's accepting state records
+ * @noun2: The pattern has a {noun2} slot too
+ *
+ * Read as a slot word, the preposition in "look at key with lens"
+ * would end up in the noun. It starts the preposition and a second
+ * noun instead, as after a plain verb, and the command keeps the
+ * pattern's meaning. A pattern with a {noun2} of its own has nowhere
+ * to put another, so there the preposition fails the match.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int grammar_tail(GrammarBuild *b, int state, int rule, bool noun2)
+{
+	int prep = GRAMMAR_DEAD;
+	int filled;
+	int y;
+
+	if (!noun2) {
+		prep = grammar_add_state(b, GRAMMAR_AT_PREP);
+		if (prep < 0)
+			return prep;
+		filled = grammar_add_state(b, GRAMMAR_IN_NOUN2);
+		if (filled < 0)
+			return filled;
+		b->nodes[prep].accept = (int16_t)rule;
+		b->nodes[filled].accept = (int16_t)rule;
+
+		/* Point the plain second noun states' copies at each other */
+		for (y = 0; y < b->symbol_count; y++) {
+			int from[2] = { prep, filled };
+
+			for (int i = 0; i < 2; i++) {
+				GrammarEdge *edge = grammar_cell(b, from[i], y);
+
+				if (edge->next == GRAMMAR_AT_PREP)
+					edge->next = (int16_t)prep;
+				else if (edge->next == GRAMMAR_IN_NOUN2)
+					edge->next = (int16_t)filled;
+			}
+		}
+	}
+
+	/* A later pattern's own word after the slot still wins */
+	for (y = 0; y < b->symbol_count; y++) {
+		GrammarEdge *edge = grammar_cell(b, state, y);
+
+		if (*grammar_owned(b, state, y) ||
+		    grammar_class_of(b, y) != WORD_PREP)
+			continue;
+		edge->next = (int16_t)prep;
+		edge->action = noun2 ? GRAMMAR_SKIP : GRAMMAR_PREP;
+	}
+	return 0;
+}
+
+
+/**
+ * grammar_fits() - Check a pattern against what is compiled so far
+ * @b: Grammar being compiled
+ * @pattern: The pattern
+ *
+ * Walks the states the pattern shares with earlier ones without adding
+ * any, so a pattern that clashes leaves the grammar as it was. A
+ * built-in pattern a story rule replaces is dropped without a warning.
+ *
+ * Return: 0 if it can be added, -EINVAL if it clashes
+ */
+
+static int grammar_fits(GrammarBuild *b, const GrammarPattern *pattern)
+{
+	int state = grammar_head_state(b, pattern->words[0], false);
+	int i;
+
+	for (i = 1; i < pattern->count && state >= 0; i++) {
+		GrammarNode *node = &b->nodes[state];
+
+		if (pattern->kinds[i] == GRAMMAR_LITERAL) {
+			int symbol = grammar_symbol_of(b, pattern->words[i]);
+
+			state = *grammar_owned(b, state, symbol) ?
+				grammar_cell(b, state, symbol)->next : -1;
+		} else if (node->slot_kind) {
+			if (node->slot_kind != pattern->kinds[i])
+				return grammar_invalid(pattern->rule,
+						       "puts a different slot "
+						       "where an earlier "
+						       "pattern has one");
+			state = node->slot_filled;
+		} else {
+			state = -1;
+		}
+	}
+
+	if (state >= 0 && b->nodes[state].accept >= 0) {
+		if (pattern->rule >= grammar_builtin &&
+		    pattern->rule < grammar_builtin + GRAMMAR_BUILTIN_COUNT)
+			return -EINVAL;
+		return grammar_invalid(pattern->rule, "repeats an earlier "
+				       "pattern");
+	}
+	return 0;
+}
+
+
+/**
+ * grammar_insert() - Merge one pattern into the grammar
+ * @b: Grammar being compiled
+ * @pattern: The pattern
+ * @rule: Number the pattern's accepting state records
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int grammar_insert(GrammarBuild *b, const GrammarPattern *pattern,
+			  int rule)
+{
+	int state = grammar_head_state(b, pattern->words[0], true);
+	bool noun2 = false;
+	int i;
+
+	for (i = 1; i < pattern->count && state >= 0; i++) {
+		if (pattern->kinds[i] == GRAMMAR_LITERAL)
+			state = grammar_literal(b, state,
+					grammar_symbol_of(b, pattern->words[i]));
+		else
+			state = grammar_slot(b, state, pattern->kinds[i]);
+		noun2 |= pattern->kinds[i] == GRAMMAR_SLOT_NOUN2;
+	}
+	if (state < 0)
+		return state;
+
+	b->nodes[state].accept = (int16_t)rule;
+	if (pattern->kinds[pattern->count - 1] == GRAMMAR_SLOT_NOUN)
+		return grammar_tail(b, state, rule, noun2);
+	return 0;
+}
+
+
+/**
+ * grammar_copy() - Copy a compile-time array into the story's arena
+ * @story: Story that owns the copy
+ * @array: Array to copy
+ * @size: Size in bytes
+ *
+ * Return: The copy, NULL on failure
+ */
+
+static void *grammar_copy(Story *story, const void *array, size_t size)
+{
+	void *copy = arena_alloc(&story->arena, size > 0 ? size : 1);
+
+	if (copy && size > 0)
+		memcpy(copy, array, size);
+	return copy;
+}
+
+
+/**
+ * grammar_finish() - Move a compiled grammar into the story's arena
+ * @b: Grammar compiled
+ * @meanings: Per rule meaning
+ * @rule_count: Number of entries in @meanings
+ * @story: Story to attach the grammar to
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int grammar_finish(GrammarBuild *b, const VerbEntry **meanings,
+			  int rule_count, Story *story)
+{
+	size_t cells = (size_t)b->state_count * (size_t)b->symbol_count;
+	Grammar *grammar;
+	int16_t *accept;
+	int ret;
+	int i;
+
+	grammar = arena_calloc(&story->arena, 1, sizeof(*grammar));
+	accept = arena_alloc(&story->arena,
+			     (size_t)b->state_count * sizeof(*accept));
+	if (!grammar || !accept)
+		return -ENOMEM;
+	for (i = 0; i < b->state_count; i++)
+		accept[i] = b->nodes[i].accept;
+
+	grammar->edges = grammar_copy(story, b->edges,
+				      cells * sizeof(GrammarEdge));
+	grammar->accept = accept;
+	grammar->meanings = grammar_copy(story, meanings,
+					 (size_t)rule_count * sizeof(*meanings));
+	grammar->state_count = b->state_count;
+	grammar->symbol_count = b->symbol_count;
+	grammar->words = grammar_copy(story, b->words,
+				      (size_t)b->word_count * sizeof(GrammarWord));
+	grammar->word_count = b->word_count;
+	grammar->heads = grammar_copy(story, b->heads,
+				      (size_t)b->head_count * sizeof(GrammarHead));
+	grammar->head_count = b->head_count;
+	if (!grammar->edges || !grammar->meanings || !grammar->words ||
+	    !grammar->heads)
+		return -ENOMEM;
+
+	ret = story_index_build(&grammar->word_index, &story->arena,
+				grammar->words, grammar->word_count,
+				sizeof(GrammarWord),
+				offsetof(GrammarWord, word), "grammar word");
+	if (ret == 0)
+		ret = story_index_build(&grammar->head_index, &story->arena,
+					grammar->heads, grammar->head_count,
+					sizeof(GrammarHead),
+					offsetof(GrammarHead, word),
+					"grammar verb");
+	if (ret == 0)
+		story->grammar = grammar;
+	return ret;
+}
+
+
+/**
+ * compile_grammar() - Compile a story's verb patterns into a DFA
+ * @story: Story with its synonym index built
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int compile_grammar(Story *story)
+{
+	GrammarBuild b = { .story = story };
+	GrammarPattern *patterns;
+	const VerbEntry **meanings = NULL;
+	int total = story->grammar_rule_count + GRAMMAR_BUILTIN_COUNT;
+	int count = 0;
+	int words = 0;
+	int ret = 0;
+	int i, j;
+
+	log_function_entry(__func__, "rules=%d", story->grammar_rule_count);
+
+	patterns = malloc((size_t)total * sizeof(*patterns));
+	if (!patterns) {
+		log_function_exit(__func__, -ENOMEM);
+		return -ENOMEM;
+	}
+
+	/* Split every rule, the story's first */
+	for (i = 0; i < total && ret != -ENOMEM; i++) {
+		const GrammarRule *rule = i < story->grammar_rule_count ?
+			&story->grammar_rules[i] :
+			&grammar_builtin[i - story->grammar_rule_count];
+
+		ret = grammar_split(story, rule, &patterns[count]);
+		if (ret == 0) {
+			words += patterns[count].count - 1;
+			count++;
+		}
+	}
+	if (ret == -ENOMEM)
+		goto out;
+	ret = 0;
+
+	/* Every word after a verb gets a column */
+	b.words = malloc((size_t)(words > 0 ? words : 1) * sizeof(*b.words));
+	b.word_classes = malloc((size_t)(words > 0 ? words : 1) *
+				sizeof(*b.word_classes));
+	meanings = malloc((size_t)(count > 0 ? count : 1) * sizeof(*meanings));
+	if (!b.words || !b.word_classes || !meanings) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < count; i++) {
+		for (j = 1; j < patterns[i].count; j++) {
+			if (patterns[i].kinds[j] == GRAMMAR_LITERAL)
+				grammar_add_word(&b, patterns[i].words[j]);
+		}
+	}
+	b.symbol_count = WORD_CLASS_COUNT + b.word_count;
+
+	/* The plain grammar, reading pattern words by their class */
+	for (i = 0; i < GRAMMAR_PLAIN_STATES; i++) {
+		ret = grammar_add_state(&b, -1);
+		if (ret < 0)
+			goto out;
+		for (j = 0; j < b.symbol_count; j++)
+			*grammar_cell(&b, i, j) = grammar_plain_edges[
+				i * WORD_CLASS_COUNT + grammar_class_of(&b, j)];
+		b.nodes[i].accept = grammar_plain_accept[i];
+	}
+	ret = 0;
+
+	/* Merge the patterns in, keeping the first of any that clash */
+	for (i = 0, j = 0; i < count; i++) {
+		if (grammar_fits(&b, &patterns[i]) != 0)
+			continue;
+		ret = grammar_insert(&b, &patterns[i], j);
+		if (ret < 0)
+			goto out;
+		meanings[j++] = patterns[i].meaning;
+	}
+
+	ret = grammar_finish(&b, meanings, j, story);
+
+out:
+	if (ret == 0)
+		add_log_entry("Compiled %d grammar patterns into %d states",
+			      count, b.state_count);
+	else
+		log_function_error(__func__, "Failed to compile grammar");
+	free(meanings);
+	free(patterns);
+	free(b.edges);
+	free(b.owned);
+	free(b.nodes);
+	free(b.words);
+	free(b.word_classes);
+	free(b.heads);
+	log_function_exit(__func__, ret);
+	return ret;
+}
+
+
+/**
+ * load_grammar_rules() - Load the [GRAMMAR] section of story.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena for the rule array and its text
+ * @rules_out: Pointer to store the rule array
+ *
+ * Return: Number of rules loaded, 0 if there are none or on error
+ */
+
+int load_grammar_rules(const char *story_dir, Arena *arena,
+		       GrammarRule **rules_out)
+{
+	IniFile ini;
+	IniToken token;
+	IniView section = { "", 0 };
+	char filepath[INI_VALUE_SIZE];
+	GrammarRule *rules = NULL;
+	GrammarRule *grown;
+	int count = 0;
+	int capacity = 0;
+
+	log_function_entry(__func__, "story_dir=%s", story_dir);
+
+	*rules_out = NULL;
+
+	snprintf(filepath, sizeof(filepath), "%s/story.ini", story_dir);
+	if (ini_open(&ini, filepath) != 0) {
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	while (ini_next(&ini, &token)) {
+		char *pattern;
+		char *command;
+
+		if (token.type == INI_TOKEN_SECTION) {
+			section = token.section;
+			continue;
+		}
+		if (!ini_view_equals(section, "GRAMMAR"))
+			continue;
+
+		pattern = ini_view_strdup(arena, token.key);
+		command = ini_view_strdup(arena, token.value);
+		if (!pattern || !command)
+			break;
+		for (char *p = pattern; *p; p++)
+			*p = (char)tolower((unsigned char)*p);
+		for (char *p = command; *p; p++)
+			*p = (char)tolower((unsigned char)*p);
+
+		grown = array_grow(rules, count, &capacity, sizeof(GrammarRule));
+		if (!grown) {
+			log_function_error(__func__,
+					   "Failed to allocate grammar rule array");
+			break;
+		}
+		rules = grown;
+		rules[count].pattern = pattern;
+		rules[count].command = command;
+		count++;
+	}
+
+	ini_close(&ini);
+
+	/* Finalise array at end of file; the arena frees it with the story */
+	rules = array_shrink(rules, count, sizeof(GrammarRule));
+	if (arena_adopt(arena, rules, (size_t)count * sizeof(GrammarRule)) != 0) {
+		free(rules);
+		rules = NULL;
+		count = 0;
+	}
+
+	*rules_out = rules;
+	if (count > 0)
+		add_log_entry("Loaded %d grammar rules from %s", count, filepath);
+	log_function_exit(__func__, count);
+	return count;
+}
+
+
+/**
+ * struct GrammarSpan - Words of the line one part of a command covers
+ * @start: First character, NULL while the part is empty
+ * @end: One past the last character
+ */
+
+typedef struct {
+	char *start;
+	char *end;
+} GrammarSpan;
+
+
+static inline void grammar_span_start(GrammarSpan *span, char *word, char *end)
+{
+	span->start = word;
+	span->end = end;
+}
+
+
+static inline void grammar_span_extend(GrammarSpan *span, char *word,
+				       char *end)
+{
+	if (!span->start)
+		span->start = word;
+	span->end = end;
+}
+
+
+/**
+ * grammar_span_text() - Terminate a span where it ends
+ * @span: The span
+ *
+ * Return: The span as a C string, "" if it is empty
+ */
+
+static const char *grammar_span_text(const GrammarSpan *span)
+{
+	if (!span->start)
+		return "";
+	*span->end = '\0';
+	return span->start;
+}
+
+
+/**
+ * grammar_word_end() - Find where a word of a normalised line ends
+ * @word: Start of the word
+ *
+ * Return: The space after @word, or its terminating NUL
+ */
+
+static inline char *grammar_word_end(char *word)
+{
+	while (*word && *word != ' ')
+		word++;
+	return word;
+}
+
+
+/**
+ * grammar_symbol() - Column a word is read in
+ * @grammar: Grammar in use
+ * @word: Lowercase word
+ *
+ * Return: The word's own column if a pattern uses it, else its class
+ */
+
+static int grammar_symbol(const Grammar *grammar, const char *word)
+{
+	const VerbEntry *entry;
+	int i;
+
+	i = story_index_find(&grammar->word_index, word);
+	if (i >= 0)
+		return grammar->words[i].symbol;
+
+	entry = verb_builtin(word);
+	return entry ? (int)entry->word_class : WORD_PLAIN;
+}
+
+
+/**
+ * grammar_parse() - Run a command line through a grammar
+ * @grammar: Compiled grammar, NULL for the built-in one
+ * @story: Story whose verb synonyms apply, NULL for built-in verbs only
+ * @line: Lowercase words separated by single spaces; split in place
+ * @cmd: Command whose verb, nouns, preposition and @all are filled in
+ *
+ * Each word is looked up with its end briefly turned into a NUL, then
+ * moves the DFA along one transition. A part of the command is a span
+ * of whole words, so it is cut out of @line only once the line has
+ * been read.
+ *
+ * Return: The word the command means, NULL if it means nothing known
+ */
+
+const VerbEntry *grammar_parse(const Grammar *grammar, const Story *story,
+			       char *line, Command *cmd)
+{
+	GrammarSpan noun = { NULL, NULL };
+	GrammarSpan prep = { NULL, NULL };
+	GrammarSpan noun2 = { NULL, NULL };
+	const VerbEntry *verb;
+	const GrammarEdge *edge;
+	char *word = line;
+	char *end;
+	char next;
+	bool all = false;
+	int state;
+	int accept;
+	int i;
+
+	if (!grammar)
+		grammar = &grammar_plain;
+	if (*line == '\0')
+		return NULL;
+
+	/* The verb picks the start state: a pattern's or the plain one */
+	end = grammar_word_end(word);
+	next = *end;
+	*end = '\0';
+	cmd->verb = word;
+	verb = verb_lookup(story, word);
+	i = story_index_find(&grammar->head_index, word);
+	state = i >= 0 ? grammar->heads[i].state : GRAMMAR_AT_VERB;
+
+	while (next) {
+		word = end + 1;
+		end = grammar_word_end(word);
+		next = *end;
+		*end = '\0';
+		edge = &grammar->edges[state * grammar->symbol_count +
+				       grammar_symbol(grammar, word)];
+		*end = next;
+
+		switch (edge->action) {
+		case GRAMMAR_NOUN_NEW:
+			grammar_span_start(&noun, word, end);
+			all = false;
+			break;
+		case GRAMMAR_NOUN:
+			grammar_span_extend(&noun, word, end);
+			all = false;
+			break;
+		case GRAMMAR_ALL:
+			grammar_span_start(&noun, word, end);
+			all = true;
+			break;
+		case GRAMMAR_PARTICLE:
+			grammar_span_start(&prep, word, end);
+			grammar_span_start(&noun, word, end);
+			break;
+		case GRAMMAR_PREP:
+			grammar_span_start(&prep, word, end);
+			break;
+		case GRAMMAR_NOUN2_NEW:
+			grammar_span_start(&noun2, word, end);
+			break;
+		case GRAMMAR_NOUN2:
+			grammar_span_extend(&noun2, word, end);
+			break;
+		default:
+			break;
+		}
+		state = edge->next;
+	}
+
+	cmd->noun = grammar_span_text(&noun);
+	cmd->preposition = grammar_span_text(&prep);
+	cmd->noun2 = grammar_span_text(&noun2);
+	cmd->all = all;
+
+	accept = grammar->accept[state];
+	if (accept >= 0)
+		return grammar->meanings[accept];
+	return accept == GRAMMAR_ACCEPT_VERB ? verb : NULL;
+}
@@ -0,0 +1,155 @@
+/*
+ * grammar.h - Command grammar: verb patterns compiled into a DFA
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+#include <stdint.h>
+
+#include "core/arena.h"
+#include "core/parser.h"
+#include "core/verbs.h"
+#include "story/index.h"
+#include "story/story.h"
+
+
+#define GRAMMAR_REJECT       -1  /* Input ended where no pattern ends */
+#define GRAMMAR_ACCEPT_VERB  -2  /* Plain "verb noun prep noun2": the verb decides */
+
+
+/**
+ * struct GrammarRule - A verb pattern
+ * @pattern: Words and slots, e.g. "unlock {noun2} with {noun}". The
+ *           first word is the verb; {noun} and {noun2} each take one or
+ *           more words and must be followed by a word or the end.
+ * @command: Built-in command word the pattern means ("use", "north"...)
+ */
+
+typedef struct GrammarRule {
+	const char *pattern;
+	const char *command;
+} GrammarRule;
+
+
+/**
+ * struct GrammarEdge - One transition of the DFA
+ * @next: State the token leads to
+ * @action: What the token does to the command being built
+ */
+
+typedef struct {
+	int16_t next;
+	uint8_t action;
+} GrammarEdge;
+
+
+/**
+ * struct GrammarWord - A word with a column of its own in the DFA
+ * @word: Lowercase word a pattern uses after its verb
+ * @symbol: Its column in the transition table
+ */
+
+typedef struct {
+	const char *word;
+	int symbol;
+} GrammarWord;
+
+
+/**
+ * struct GrammarHead - A word that starts one or more patterns
+ * @word: Lowercase word
+ * @state: State the DFA is in after it
+ */
+
+typedef struct {
+	const char *word;
+	int state;
+} GrammarHead;
+
+
+/**
+ * struct Grammar - Verb patterns compiled into a DFA over token classes
+ * @edges: @state_count rows of @symbol_count transitions
+ * @accept: Per state, the rule input ending there completes, or
+ *          GRAMMAR_ACCEPT_VERB or GRAMMAR_REJECT
+ * @meanings: Per rule, the built-in word it means
+ * @state_count: Number of states
+ * @symbol_count: Number of symbols: the WordClass values, then @words
+ * @words: Words patterns use after their verb
+ * @word_count: Number of entries in @words
+ * @word_index: Word -> @words index
+ * @heads: Words that start a pattern
+ * @head_count: Number of entries in @heads
+ * @head_index: Word -> @heads index
+ *
+ * Every token after the verb is one symbol: its own column if a
+ * pattern names it, else its WordClass. Parsing is then one row read
+ * per token, with no lookahead and no backtracking.
+ */
+
+typedef struct Grammar {
+	const GrammarEdge *edges;
+	const int16_t *accept;
+	const VerbEntry **meanings;
+	int state_count;
+	int symbol_count;
+	GrammarWord *words;
+	int word_count;
+	StoryIndex word_index;
+	GrammarHead *heads;
+	int head_count;
+	StoryIndex head_index;
+} Grammar;
+
+
+/**
+ * load_grammar_rules() - Load the [GRAMMAR] section of story.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena for the rule array and its text
+ * @rules_out: Pointer to store the rule array
+ *
+ * Each "pattern = command" line declares a verb pattern. Patterns are
+ * checked when the grammar is compiled.
+ *
+ * Return: Number of rules loaded, 0 if there are none or on error
+ */
+
+int load_grammar_rules(const char *story_dir, Arena *arena,
+		       GrammarRule **rules_out);
+
+
+/**
+ * compile_grammar() - Compile a story's verb patterns into a DFA
+ * @story: Story with its synonym index built
+ *
+ * Merges the story's [GRAMMAR] rules with the built-in ones ("look at",
+ * "pick up"...) and the plain "verb [the] noun [prep [the] noun2]"
+ * grammar into story->grammar. A story rule wins over a built-in one
+ * for the same input; a pattern that does not make sense is reported
+ * and skipped.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int compile_grammar(Story *story);
+
+
+/**
+ * grammar_parse() - Run a command line through a grammar
+ * @grammar: Compiled grammar, NULL for the built-in one
+ * @story: Story whose verb synonyms apply, NULL for built-in verbs only
+ * @line: Lowercase words separated by single spaces; split in place
+ * @cmd: Command whose verb, nouns, preposition and @all are filled in
+ *
+ * Return: The word the command means, NULL if it means nothing known
+ */
+
+const VerbEntry *grammar_parse(const Grammar *grammar, const Story *story,
+			       char *line, Command *cmd);
+
+
+#endif /* GRAMMAR_H */
@@ -70,9 +70,11 @@ void add_log_entry(const char *fmt, ...)
 		return;
 
 	va_start(args, fmt);
+	flockfile(log_file);  /* Keep lines whole when loader threads log */
 	vfprintf(log_file, fmt, args);
 	fprintf(log_file, "\n");
 	fflush(log_file);  /* Write immediately for crash safety */
+	funlockfile(log_file);
 	va_end(args);
 }
 
@@ -80,21 +82,23 @@ void add_log_entry(const char *fmt, ...)
  * log_timestamp() - Get current timestamp string
  *
  * Returns formatted timestamp in "YYYY-MM-DD HH:MM:SS" format.
- * Uses static buffer, not thread-safe.
+ * Uses a per-thread static buffer, so the parallel story loader can
+ * log safely.
  *
- * Return: Pointer to static timestamp string
+ * Return: Pointer to this thread's timestamp string
  */
 const char *log_timestamp(void)
 {
-	static char buf[LOG_TIMESTAMP_SIZE];
+	static _Thread_local char buf[LOG_TIMESTAMP_SIZE];
 	struct timeval tv;
 	time_t now;
+	struct tm tm_buf;
 	struct tm *t;
 	int len;
 
 	gettimeofday(&tv, NULL);
 	now = tv.tv_sec;
-	t = localtime(&now);
+	t = localtime_r(&now, &tm_buf);
 
 	if (!t) {
 		strcpy(buf, "localtime-failed");
@@ -6,12 +6,17 @@
  */
 
 
+#include <stdbool.h>
+
 #include "constants.h" 
 
 #ifndef PARSER_H
 #define PARSER_H
 
 
+struct Story;
+
+
 /**
  * enum CommandType - Types of commands the parser recognises
  * @CMD_UNKNOWN: Unrecognised command   
@@ -55,43 +60,53 @@ typedef enum {
  * @noun: Direct object (item, direction, or NPC name)
  * @preposition: Preposiiton word (on, with, to, etc...)
  * @noun2: Indirect object for complex commands
+ * @all: The noun is "all" or "everything"
  *
- * Represets a tokenised player input broken into grammatical components for command execution
+ * Represets a tokenised player input broken into grammatical
+ * components for command execution. Every word points into the input
+ * line it was parsed from, or at a string constant; a missing word is
+ * "", never NULL.
  */
 
 typedef struct {
     CommandType type;      
-    char verb[PARSER_VERB_SIZE];         
-    char noun[PARSER_NOUN_SIZE];         
-    char preposition[PARSER_PREPOSITION_SIZE];  
-    char noun2[PARSER_NOUN_SIZE];        
+    const char *verb;
+    const char *noun;
+    const char *preposition;
+    const char *noun2;
+    bool all;
 } Command;
 
 
 
 /**
  * parse_command() - Parse player input into command structure
- * @input: Raw player input string
+ * @story: Story whose verb synonyms and grammar apply, NULL for the
+ *         built-in ones only
+ * @input: Raw player input string, lowercased and split in place
  *
- * Tokenizes the input string and identifies command type, verb, nouns, 
- * and prepositions.
+ * Tokenizes the input string and identifies command type, verb, nouns,
+ * and prepositions through the story's grammar. Nothing is copied or
+ * allocated: the command's words are views into @input, which must
+ * outlive the command. There is no hidden state, so sessions on
+ * different threads can parse at once.
  *
  * Return: Populated Command structure
  */
 
-Command parse_command(const char* input);
+Command parse_command(const struct Story *story, char *input);
 
 
 /**
  * get_command_type() - Determine command type from verb string
+ * @story: Story whose verb synonyms apply, NULL for built-in verbs only
  * @verb: Verb string  (lowercase)
- * @param2: Description of second parameter
  *
  * Maps verb strings and synonyms to CommandType enum values.
  *
  * Return: CommandType enum value, or CMD_UNKNOWN if not recognized
  */
 
-CommandType get_command_type(const char* verb);
+CommandType get_command_type(const struct Story *story, const char* verb);
 
 #endif /* PARSER_H */
\ No newline at end of file
@@ -108,3 +108,56 @@ void safe_strcpy(char* dest, const char* src, size_t dest_size) {
 
     return strstr(hay_lower, needle_lower) != NULL;
  }
+
+
+/**
+ * array_grow() - Make room for one more element in a growable array
+ * @array: Current array (may be NULL)
+ * @count: Number of elements in use
+ * @capacity: Pointer to allocated element count, updated on growth
+ * @elem_size: Size of one element in bytes
+ *
+ * Return: Array with room for @count + 1 elements, NULL on failure
+ */
+
+void *array_grow(void *array, int count, int *capacity, size_t elem_size) {
+    int new_capacity;
+    char *grown;
+
+    if (count < *capacity)
+        return array;
+
+    new_capacity = *capacity > 0 ? *capacity * 2 : ARRAY_INITIAL_CAPACITY;
+
+    grown = realloc(array, (size_t)new_capacity * elem_size);
+    if (!grown)
+        return NULL;
+
+    memset(grown + (size_t)*capacity * elem_size, 0,
+           (size_t)(new_capacity - *capacity) * elem_size);
+
+    *capacity = new_capacity;
+    return grown;
+}
+
+
+/**
+ * array_shrink() - Trim a growable array to its final size
+ * @array: Array built with array_grow()
+ * @count: Number of elements in use
+ * @elem_size: Size of one element in bytes
+ *
+ * Return: Trimmed array, or NULL if @count is zero (array is freed)
+ */
+
+void *array_shrink(void *array, int count, size_t elem_size) {
+    void *trimmed;
+
+    if (count == 0) {
+        free(array);
+        return NULL;
+    }
+
+    trimmed = realloc(array, (size_t)count * elem_size);
+    return trimmed ? trimmed : array;
+}
@@ -66,4 +66,36 @@ void safe_strcpy(char* dest, const char* src, size_t dest_size);
  int contains_ignore_case(const char *haystack, const char *needle);
 
 
+/**
+ * array_grow() - Make room for one more element in a growable array
+ * @array: Current array (may be NULL)
+ * @count: Number of elements in use
+ * @capacity: Pointer to allocated element count, updated on growth
+ * @elem_size: Size of one element in bytes
+ *
+ * Doubles the capacity whenever @count has reached it, so appending n
+ * elements costs O(n) copies overall. New slots are zeroed to match
+ * calloc(). The original array is left untouched if growth fails.
+ *
+ * Return: Array with room for @count + 1 elements, NULL on failure
+ */
+
+void *array_grow(void *array, int count, int *capacity, size_t elem_size);
+
+
+/**
+ * array_shrink() - Trim a growable array to its final size
+ * @array: Array built with array_grow()
+ * @count: Number of elements in use
+ * @elem_size: Size of one element in bytes
+ *
+ * Releases the unused tail once loading is complete. Falls back to the
+ * original array if the allocator declines to shrink it.
+ *
+ * Return: Trimmed array, or NULL if @count is zero (array is freed)
+ */
+
+void *array_shrink(void *array, int count, size_t elem_size);
+
+
 #endif /* UTILS_H */
\ No newline at end of file
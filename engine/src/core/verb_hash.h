@@ -0,0 +1,41 @@
+/*
+ * verb_hash.h - Hash shared by the verb table generator and the parser
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef VERB_HASH_H
+#define VERB_HASH_H
+
+#include <stdint.h>
+
+
+/**
+ * verb_hash() - Hash a lowercase word for the verb table
+ * @word: NUL-terminated word
+ * @seed: Seed the generator found to be collision free
+ *
+ * Seeded FNV-1a with a final mix. verb_gen and the engine must agree
+ * on it bit for bit, so it lives in this header only.
+ *
+ * Return: 32-bit hash
+ */
+
+static inline uint32_t verb_hash(const char *word, uint32_t seed)
+{
+	uint32_t h = 2166136261u ^ seed;
+
+	while (*word) {
+		h ^= (unsigned char)*word++;
+		h *= 16777619u;
+	}
+
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	return h;
+}
+
+
+#endif /* VERB_HASH_H */
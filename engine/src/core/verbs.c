@@ -0,0 +1,166 @@
+/*
+ * verbs.c - Verb vocabulary: built-in table and story synonyms
+ *
+ * The built-in words are a perfect hash table generated at build time
+ * from verbs.def (see engine/gen/verb_gen.c). Words a story adds live
+ * in a StoryIndex over the story's synonym array, so either way a verb
+ * costs one probe rather than a chain of string compares.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "verbs.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "core/verb_hash.h"
+#include "story/ini_parser.h"
+#include "ui/colors.h"
+
+
+/**
+ * verb_builtin() - Resolve a word in the built-in vocabulary only
+ * @word: Lowercase word
+ *
+ * Return: The entry, NULL if the word is not built in
+ */
+
+const VerbEntry *verb_builtin(const char *word)
+{
+	const VerbEntry *entry;
+
+	entry = &verb_table[verb_hash(word, verb_table_seed) & verb_table_mask];
+	if (entry->word && strcmp(entry->word, word) == 0)
+		return entry;
+	return NULL;
+}
+
+
+/**
+ * verb_lookup() - Resolve a word to the command it means
+ * @story: Story whose synonyms also count, NULL for built-in words only
+ * @word: Lowercase word
+ *
+ * Return: The entry, NULL if the word is not known
+ */
+
+const VerbEntry *verb_lookup(const Story *story, const char *word)
+{
+	const VerbEntry *entry = verb_builtin(word);
+	int i;
+
+	if (entry || !story || story->synonym_count == 0)
+		return entry;
+
+	i = story_index_find(&story->synonym_index, word);
+	return i >= 0 ? &story->synonyms[i] : NULL;
+}
+
+
+/**
+ * load_verb_synonyms() - Load the [SYNONYMS] section of story.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena for the synonym array and words
+ * @synonyms_out: Pointer to store the synonym array
+ *
+ * Return: Number of synonyms loaded, 0 if there are none or on error
+ */
+
+int load_verb_synonyms(const char *story_dir, Arena *arena,
+		       VerbEntry **synonyms_out)
+{
+	IniFile ini;
+	IniToken token;
+	IniView section = { "", 0 };
+	char filepath[INI_VALUE_SIZE];
+	char target[PARSER_VERB_SIZE];
+	VerbEntry *synonyms = NULL;
+	VerbEntry *grown;
+	int count = 0;
+	int capacity = 0;
+
+	log_function_entry(__func__, "story_dir=%s", story_dir);
+
+	*synonyms_out = NULL;
+
+	snprintf(filepath, sizeof(filepath), "%s/story.ini", story_dir);
+	if (ini_open(&ini, filepath) != 0) {
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	while (ini_next(&ini, &token)) {
+		const VerbEntry *meaning;
+		char *word;
+
+		if (token.type == INI_TOKEN_SECTION) {
+			section = token.section;
+			continue;
+		}
+		if (!ini_view_equals(section, "SYNONYMS"))
+			continue;
+
+		word = ini_view_strdup(arena, token.key);
+		ini_view_copy(token.value, target, sizeof(target));
+		if (!word)
+			break;
+		for (char *p = word; *p; p++)
+			*p = (char)tolower((unsigned char)*p);
+		for (char *p = target; *p; p++)
+			*p = (char)tolower((unsigned char)*p);
+
+		/* Built-in words keep their meaning */
+		if (verb_builtin(word)) {
+			printf_colored(COLOR_WARNING,
+				       "WARNING: synonym '%s' is already a "
+				       "command word\n", word);
+			add_log_entry("Synonym %s ignored: built-in word", word);
+			continue;
+		}
+
+		meaning = verb_builtin(target);
+		if (!meaning || meaning->type == CMD_UNKNOWN) {
+			printf_colored(COLOR_WARNING,
+				       "WARNING: synonym '%s' names unknown "
+				       "command word '%s'\n", word, target);
+			add_log_entry("Synonym %s ignored: unknown word %s", word,
+				      target);
+			continue;
+		}
+
+		grown = array_grow(synonyms, count, &capacity, sizeof(VerbEntry));
+		if (!grown) {
+			log_function_error(__func__,
+					   "Failed to allocate synonym array");
+			break;
+		}
+		synonyms = grown;
+		synonyms[count].word = word;
+		synonyms[count].type = meaning->type;
+		synonyms[count].dir = meaning->dir;
+		synonyms[count].word_class = WORD_PLAIN;
+		count++;
+	}
+
+	ini_close(&ini);
+
+	/* Finalise array at end of file; the arena frees it with the story */
+	synonyms = array_shrink(synonyms, count, sizeof(VerbEntry));
+	if (arena_adopt(arena, synonyms, (size_t)count * sizeof(VerbEntry)) != 0) {
+		free(synonyms);
+		synonyms = NULL;
+		count = 0;
+	}
+
+	*synonyms_out = synonyms;
+	if (count > 0)
+		add_log_entry("Loaded %d synonyms from %s", count, filepath);
+	log_function_exit(__func__, count);
+	return count;
+}
@@ -0,0 +1,103 @@
+/*
+ * verbs.h - Verb vocabulary: built-in table and story synonyms
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef VERBS_H
+#define VERBS_H
+
+#include <stdint.h>
+
+#include "core/arena.h"
+#include "core/parser.h"
+#include "story/story.h"
+
+
+/**
+ * enum WordClass - What a word is after the verb
+ * @WORD_PLAIN: Part of a noun
+ * @WORD_ARTICLE: "the", "a", "an"; dropped in front of a noun
+ * @WORD_ALL: "all", "everything"
+ * @WORD_PREP: Preposition; ends one noun and introduces the next
+ * @WORD_CLASS_COUNT: Number of classes
+ *
+ * The classes are the first symbols of every grammar's alphabet.
+ */
+
+typedef enum {
+	WORD_PLAIN,
+	WORD_ARTICLE,
+	WORD_ALL,
+	WORD_PREP,
+	WORD_CLASS_COUNT
+} WordClass;
+
+
+/**
+ * struct VerbEntry - One word the parser understands
+ * @word: Lowercase word (NULL for an empty table slot)
+ * @type: Command it means, CMD_UNKNOWN for a function word
+ * @dir: Direction it names, DIR_NONE if it is not a direction
+ * @word_class: What it is after the verb
+ */
+
+typedef struct VerbEntry {
+	const char *word;
+	CommandType type;
+	Direction dir;
+	WordClass word_class;
+} VerbEntry;
+
+
+/* Built-in vocabulary, generated from verbs.def by verb_gen */
+extern const VerbEntry verb_table[];
+extern const uint32_t verb_table_seed;
+extern const uint32_t verb_table_mask;
+
+
+/**
+ * verb_lookup() - Resolve a word to the command it means
+ * @story: Story whose synonyms also count, NULL for built-in words only
+ * @word: Lowercase word
+ *
+ * One probe of the built-in table, then one of @story's synonym index
+ * if the word is not built in. Reads nothing but its arguments, so any
+ * number of sessions can look words up at once.
+ *
+ * Return: The entry, NULL if the word is not known
+ */
+
+const VerbEntry *verb_lookup(const Story *story, const char *word);
+
+
+/**
+ * verb_builtin() - Resolve a word in the built-in vocabulary only
+ * @word: Lowercase word
+ *
+ * Return: The entry, NULL if the word is not built in
+ */
+
+const VerbEntry *verb_builtin(const char *word);
+
+
+/**
+ * load_verb_synonyms() - Load the [SYNONYMS] section of story.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena for the synonym array and words
+ * @synonyms_out: Pointer to store the synonym array
+ *
+ * Each "word=existing_word" line teaches the parser a new word that
+ * means what a built-in word means. A synonym for a built-in word, or
+ * for a word the engine does not know, is reported and skipped.
+ *
+ * Return: Number of synonyms loaded, 0 if there are none or on error
+ */
+
+int load_verb_synonyms(const char *story_dir, Arena *arena,
+		       VerbEntry **synonyms_out);
+
+
+
+#endif /* VERBS_H */
@@ -1,13 +1,568 @@
 /*
- * dialog.c - Dialog between players and NPCs
+ * dialog.c - Dialog trees between the player and NPCs
  *
- * STUB: Not implemented yet
+ * dialogs.ini is compiled into a transition table when the story loads:
+ * nodes are numbered, every response and auto_continue holds the number
+ * of the node it leads to, and quest actions hold a quest index. A
+ * conversation is then a walk over integers, however large the graph.
  *
  * Copyright (C) 2025 Marty
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "dialog.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "story/ini_parser.h"
+#include "story/scripts.h"
+#include "ui/colors.h"
+#include "ui/output.h"
 
-// Prevent empty translation unit warning
-typedef int prevent_empty_translation_unit_warning_dialog;
\ No newline at end of file
+
+/**
+ * struct DialogLoad - Responses being built while dialogs.ini is read
+ * @responses: Every node's responses so far
+ * @count: Entries used in @responses
+ * @capacity: Entries allocated for @responses
+ * @pending_responses: responses= of the node being read
+ * @pending_next: next= of the node being read
+ *
+ * The two lists may come in either order, so they are kept as views
+ * into the mapped file until the node ends.
+ */
+
+typedef struct {
+	DialogResponse *responses;
+	int count;
+	int capacity;
+	IniView pending_responses;
+	IniView pending_next;
+} DialogLoad;
+
+
+/* quest_action= verbs, indexed by QuestAction */
+static const char *const dialog_quest_actions[] = {
+	"", "start", "accept", "complete", "fail"
+};
+
+
+/**
+ * dialog_split() - Take the next "number:text" pair off a list
+ * @list: Remaining list; advanced past the pair
+ * @separator: '|' or ','
+ * @number: Set to the number before the colon
+ * @text: Set to the trimmed text after it
+ *
+ * Return: False when the list is used up
+ */
+
+static bool dialog_split(IniView *list, char separator, int *number,
+			 IniView *text)
+{
+	while (list->len > 0) {
+		const char *end = memchr(list->ptr, separator, list->len);
+		size_t len = end ? (size_t)(end - list->ptr) : list->len;
+		IniView pair = ini_view_trim((IniView){ list->ptr, len });
+		const char *colon = memchr(pair.ptr, ':', pair.len);
+
+		*list = ini_view_skip(*list, end ? len + 1 : len);
+		if (!colon)
+			continue;
+
+		*number = ini_view_to_int((IniView){ pair.ptr,
+						     (size_t)(colon - pair.ptr) });
+		*text = ini_view_trim(ini_view_skip(pair,
+				      (size_t)(colon - pair.ptr) + 1));
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * dialog_separator() - Separator a responses= or next= list uses
+ * @list: The list
+ *
+ * Responses are prose and may hold commas, so pairs are split on '|'
+ * when the list has one, as STORY-FORMAT.md writes them, else on ','.
+ *
+ * Return: '|' or ','
+ */
+
+static char dialog_separator(IniView list)
+{
+	return memchr(list.ptr, '|', list.len) ? '|' : ',';
+}
+
+
+/**
+ * dialog_add_response() - Append a response to the node being read
+ * @load: Load state
+ * @arena: Arena for the response text
+ * @number: Response number
+ * @text: What the player says
+ *
+ * Return: The new response, NULL on allocation failure
+ */
+
+static DialogResponse *dialog_add_response(DialogLoad *load, Arena *arena,
+					   int number, IniView text)
+{
+	DialogResponse *grown;
+	DialogResponse *response;
+
+	grown = array_grow(load->responses, load->count, &load->capacity,
+			   sizeof(DialogResponse));
+	if (!grown)
+		return NULL;
+	load->responses = grown;
+
+	response = &load->responses[load->count++];
+	response->number = number;
+	response->next = DIALOG_END;
+	response->text = ini_view_text(arena, text);
+	response->next_id = "";
+	return response;
+}
+
+
+/**
+ * dialog_finish_node() - Split a node's pending lists into responses
+ * @load: Load state
+ * @arena: Arena for the response text and IDs
+ * @node: Node that has just ended
+ *
+ * A next= entry without a matching response still gives the player a
+ * numbered way on.
+ *
+ * Return: void
+ */
+
+static void dialog_finish_node(DialogLoad *load, Arena *arena,
+			       DialogNode *node)
+{
+	IniView list;
+	IniView text;
+	int number;
+
+	node->first_response = load->count;
+
+	list = load->pending_responses;
+	while (dialog_split(&list, dialog_separator(load->pending_responses),
+			    &number, &text)) {
+		if (!dialog_add_response(load, arena, number, text))
+			break;
+	}
+
+	list = load->pending_next;
+	while (dialog_split(&list, dialog_separator(load->pending_next),
+			    &number, &text)) {
+		DialogResponse *response = NULL;
+
+		for (int i = node->first_response; i < load->count; i++) {
+			if (load->responses[i].number == number) {
+				response = &load->responses[i];
+				break;
+			}
+		}
+		if (!response)
+			response = dialog_add_response(load, arena, number,
+						       (IniView){ "...", 3 });
+		if (!response)
+			break;
+		response->next_id = ini_view_text(arena, text);
+	}
+
+	node->response_count = load->count - node->first_response;
+	load->pending_responses = (IniView){ "", 0 };
+	load->pending_next = (IniView){ "", 0 };
+}
+
+
+/**
+ * dialog_quest_action() - Parse a quest_action= value
+ * @node: Node being read
+ * @arena: Arena for the quest ID
+ * @value: "action:quest_id"
+ *
+ * Return: void
+ */
+
+static void dialog_quest_action(DialogNode *node, Arena *arena, IniView value)
+{
+	const char *colon = memchr(value.ptr, ':', value.len);
+	IniView action;
+
+	if (!colon) {
+		add_log_entry("Dialog %s: quest_action '%.*s' has no quest",
+			      node->id, (int)value.len, value.ptr);
+		return;
+	}
+
+	action = ini_view_trim((IniView){ value.ptr,
+					  (size_t)(colon - value.ptr) });
+	for (int i = QUEST_ACTION_START; i <= QUEST_ACTION_FAIL; i++) {
+		if (ini_view_equals(action, dialog_quest_actions[i])) {
+			node->quest_action = (QuestAction)i;
+			node->quest_id = ini_view_text(arena,
+				ini_view_trim(ini_view_skip(value,
+					(size_t)(colon - value.ptr) + 1)));
+			return;
+		}
+	}
+
+	add_log_entry("Dialog %s: unknown quest_action '%.*s'", node->id,
+		      (int)action.len, action.ptr);
+}
+
+
+/**
+ * load_dialogs() - Load dialog nodes from dialogs.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena that takes ownership of the node and response arrays
+ * @dialogs_out: Pointer to store the node array
+ * @responses_out: Pointer to store the response array
+ * @response_count: Set to the number of responses
+ *
+ * Return: Number of nodes loaded, 0 if there is no dialogs.ini or on
+ * error
+ */
+
+int load_dialogs(const char *story_dir, Arena *arena,
+		 DialogNode **dialogs_out, DialogResponse **responses_out,
+		 int *response_count)
+{
+	IniFile ini;
+	IniToken token;
+	char filepath[INI_VALUE_SIZE];
+	DialogLoad load = { NULL, 0, 0, { "", 0 }, { "", 0 } };
+	DialogNode *nodes = NULL;
+	DialogNode *grown;
+	int node_count = 0;
+	int node_capacity = 0;
+	int current = -1;
+
+	log_function_entry(__func__, "story_dir=%s", story_dir);
+
+	*dialogs_out = NULL;
+	*responses_out = NULL;
+	*response_count = 0;
+
+	snprintf(filepath, sizeof(filepath), "%s/%s", story_dir,
+		 DIALOG_FILENAME);
+	if (ini_open(&ini, filepath) != 0) {
+		add_log_entry("No %s (dialog trees optional)", filepath);
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	while (ini_next(&ini, &token)) {
+		DialogNode *node;
+
+		if (token.type == INI_TOKEN_SECTION) {
+			if (current >= 0)
+				dialog_finish_node(&load, arena, &nodes[current]);
+			current = -1;
+
+			if (!ini_view_has_prefix(token.section, "DIALOG:"))
+				continue;
+
+			grown = array_grow(nodes, node_count, &node_capacity,
+					   sizeof(DialogNode));
+			if (!grown) {
+				log_function_error(__func__,
+						   "Failed to allocate dialog array");
+				break;
+			}
+			nodes = grown;
+			current = node_count++;
+
+			node = &nodes[current];
+			node->state_required = DIALOG_STATE_ANY;
+			node->set_state = DIALOG_STATE_ANY;
+			node->auto_continue = DIALOG_NONE;
+			node->first_response = 0;
+			node->response_count = 0;
+			node->quest_action = QUEST_ACTION_NONE;
+			node->quest = -1;
+			node->color = NULL;
+			node->condition_code = SCRIPT_NONE;
+			node->id = ini_view_text(arena,
+						 ini_view_skip(token.section, 7));
+			node->speaker = "";
+			node->text = "";
+			node->auto_continue_id = "";
+			node->quest_id = "";
+			node->condition = "";
+			continue;
+		}
+
+		if (current < 0)
+			continue;
+		node = &nodes[current];
+
+		if (ini_view_equals(token.key, "speaker")) {
+			node->speaker = ini_view_text(arena, token.value);
+		} else if (ini_view_equals(token.key, "text")) {
+			/* A leading '|' only marks the text as multiline */
+			if (ini_view_has_prefix(token.value, "|"))
+				token.value = ini_view_skip(token.value, 1);
+			node->text = ini_view_text(arena, token.value);
+		} else if (ini_view_equals(token.key, "color")) {
+			char name[32];
+
+			ini_view_copy(token.value, name, sizeof(name));
+			node->color = color_from_name(name);
+		} else if (ini_view_equals(token.key, "responses")) {
+			load.pending_responses = token.value;
+		} else if (ini_view_equals(token.key, "next")) {
+			load.pending_next = token.value;
+		} else if (ini_view_equals(token.key, "auto_continue")) {
+			node->auto_continue_id = ini_view_text(arena, token.value);
+		} else if (ini_view_equals(token.key, "state_required")) {
+			node->state_required = ini_view_to_int(token.value);
+		} else if (ini_view_equals(token.key, "set_state")) {
+			node->set_state = ini_view_to_int(token.value);
+		} else if (ini_view_equals(token.key, "quest_action")) {
+			dialog_quest_action(node, arena, token.value);
+		} else if (ini_view_equals(token.key, "condition")) {
+			node->condition = ini_view_text(arena, token.value);
+		}
+	}
+
+	/* The pending lists point into the mapping, so finish before closing */
+	if (current >= 0)
+		dialog_finish_node(&load, arena, &nodes[current]);
+	ini_close(&ini);
+
+	/* Finalise arrays at end of file; the arena frees them with the story */
+	nodes = array_shrink(nodes, node_count, sizeof(DialogNode));
+	load.responses = array_shrink(load.responses, load.count,
+				      sizeof(DialogResponse));
+	if (arena_adopt(arena, nodes,
+			(size_t)node_count * sizeof(DialogNode)) != 0) {
+		free(nodes);
+		free(load.responses);
+		node_count = 0;
+	} else if (arena_adopt(arena, load.responses,
+			       (size_t)load.count * sizeof(DialogResponse)) != 0) {
+		/* The nodes now belong to the arena */
+		free(load.responses);
+		node_count = 0;
+	}
+	if (node_count == 0) {
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	*dialogs_out = nodes;
+	*responses_out = load.responses;
+	*response_count = load.count;
+	add_log_entry("Loaded %d dialog nodes with %d responses at %s",
+		      node_count, load.count, log_timestamp());
+
+	log_function_exit(__func__, node_count);
+	return node_count;
+}
+
+
+/**
+ * dialog_apply_quest() - Carry out a node's quest action
+ * @game: Current game state
+ * @node: Node being shown
+ *
+ * Return: void
+ */
+
+static void dialog_apply_quest(GameState *game, const DialogNode *node)
+{
+	Quest *quest;
+
+	if (node->quest_action == QUEST_ACTION_NONE || node->quest < 0)
+		return;
+
+	quest = &game->story->quests[node->quest];
+	if (quest->completed || quest->failed)
+		return;
+
+	switch (node->quest_action) {
+	case QUEST_ACTION_START:
+	case QUEST_ACTION_ACCEPT:
+		if (quest->started)
+			break;
+		quest->started = true;
+		output_printf("\n");
+		printf_colored(COLOR_QUEST, "*** NEW QUEST: %s ***\n", quest->name);
+		if (quest->description[0] != '\0')
+			output_printf("%s\n", quest->description);
+		add_log_entry("Quest started by dialog %s: %s at %s", node->id,
+			      quest->id, log_timestamp());
+		break;
+	case QUEST_ACTION_COMPLETE:
+		complete_quest(game, quest);
+		break;
+	case QUEST_ACTION_FAIL:
+		add_log_entry("Quest failed by dialog %s: %s at %s", node->id,
+			      quest->id, log_timestamp());
+		fail_quest(game, quest);
+		break;
+	default:
+		break;
+	}
+}
+
+
+/**
+ * dialog_show_responses() - List the answers a node offers
+ * @game: Current game state
+ * @node: Node waiting for an answer
+ *
+ * Return: void
+ */
+
+static void dialog_show_responses(GameState *game, const DialogNode *node)
+{
+	const DialogResponse *responses =
+		&game->story->dialog_responses[node->first_response];
+
+	output_printf("\n");
+	for (int i = 0; i < node->response_count; i++)
+		output_printf("  %d. %s\n", responses[i].number, responses[i].text);
+	printf_colored(COLOR_INFO, "(Type a number to answer)\n");
+}
+
+
+/**
+ * dialog_enter() - Show a node and whatever it continues to
+ * @game: Current game state
+ * @npc: NPC being talked to
+ * @target: Node to enter, or DIALOG_END
+ *
+ * Follows auto_continue until a node asks for an answer, the dialog
+ * ends, or DIALOG_MAX_CHAIN nodes have been shown (a loop in the file).
+ * A node the NPC is not in the right state for, or whose condition
+ * does not hold, ends the conversation.
+ *
+ * Return: Number of nodes shown
+ */
+
+static int dialog_enter(GameState *game, NPC *npc, int target)
+{
+	const DialogNode *node;
+	int shown = 0;
+
+	while (target >= 0 && shown < DIALOG_MAX_CHAIN) {
+		node = &game->story->dialogs[target];
+
+		if ((node->state_required != DIALOG_STATE_ANY &&
+		     node->state_required != npc->dialog_state) ||
+		    !script_test(game, node->condition_code))
+			break;
+
+		output_printf("\n");
+		printf_colored(COLOR_NPC, "%s",
+			       node->speaker[0] ? node->speaker : npc->name);
+		output_printf(" says:\n");
+		printf_colored(node->color ? node->color : COLOR_CYAN,
+			       "\"%s\"\n", node->text);
+		shown++;
+
+		if (node->set_state != DIALOG_STATE_ANY)
+			npc->dialog_state = node->set_state;
+		dialog_apply_quest(game, node);
+
+		if (node->response_count > 0) {
+			dialog_show_responses(game, node);
+			game->talk_npc = npc;
+			game->talk_node = target;
+			return shown;
+		}
+
+		/* dialog_repeat without responses would repeat for ever */
+		target = node->auto_continue;
+	}
+
+	dialog_leave(game);
+	return shown;
+}
+
+
+/**
+ * dialog_talk() - Start a conversation with an NPC
+ * @game: Current game state
+ * @npc: NPC the player talks to
+ *
+ * Return: False if the NPC has no dialog tree, or none for the state
+ * it is in
+ */
+
+bool dialog_talk(GameState *game, NPC *npc)
+{
+	dialog_leave(game);
+
+	if (npc->dialog_start < 0)
+		return false;
+
+	add_log_entry("Player started dialog %s with %s (state %d) at %s",
+		      game->story->dialogs[npc->dialog_start].id, npc->id,
+		      npc->dialog_state, log_timestamp());
+	return dialog_enter(game, npc, npc->dialog_start) > 0;
+}
+
+
+/**
+ * dialog_respond() - Answer the conversation in progress
+ * @game: Current game state
+ * @number: Response number the player typed
+ *
+ * Return: False if @number is not one of the responses on offer
+ */
+
+bool dialog_respond(GameState *game, int number)
+{
+	const DialogNode *node;
+	const DialogResponse *responses;
+	NPC *npc = game->talk_npc;
+
+	if (!npc)
+		return false;
+
+	node = &game->story->dialogs[game->talk_node];
+	responses = &game->story->dialog_responses[node->first_response];
+
+	for (int i = 0; i < node->response_count; i++) {
+		int next = responses[i].next;
+
+		if (responses[i].number != number)
+			continue;
+
+		add_log_entry("Player answered %d in dialog %s at %s", number,
+			      node->id, log_timestamp());
+		dialog_enter(game, npc,
+			     next == DIALOG_REPEAT ? game->talk_node : next);
+		return true;
+	}
+
+	printf_colored(COLOR_ERROR, "That's not one of the answers.\n");
+	dialog_show_responses(game, node);
+	return false;
+}
+
+
+/**
+ * dialog_leave() - End the conversation in progress, if any
+ * @game: Current game state
+ *
+ * Return: void
+ */
+
+void dialog_leave(GameState *game)
+{
+	game->talk_npc = NULL;
+	game->talk_node = DIALOG_NONE;
+}
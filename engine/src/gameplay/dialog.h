@@ -1,9 +1,74 @@
 /*
- * dialog.h - Dialog system declarations
- *
- * STUB: Not implemented yet
+ * dialog.h - Dialog trees between the player and NPCs
  *
  * Copyright (C) 2025 Marty
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#ifndef DIALOG_H
+#define DIALOG_H
+
+#include "core/game.h"
+#include "story/story.h"
+
+
+/**
+ * load_dialogs() - Load dialog nodes from dialogs.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena that takes ownership of the node and response arrays
+ * @dialogs_out: Pointer to store the node array
+ * @responses_out: Pointer to store the response array
+ * @response_count: Set to the number of responses
+ *
+ * Single pass. Each node's responses= and next= are split into one
+ * slice of the response array, numbered as the file numbers them; the
+ * IDs they name are resolved later by link_story(). dialogs.ini is
+ * optional.
+ *
+ * Return: Number of nodes loaded, 0 if there is no dialogs.ini or on
+ * error
+ */
+
+int load_dialogs(const char *story_dir, Arena *arena,
+		 DialogNode **dialogs_out, DialogResponse **responses_out,
+		 int *response_count);
+
+
+/**
+ * dialog_talk() - Start a conversation with an NPC
+ * @game: Current game state
+ * @npc: NPC the player talks to
+ *
+ * Shows the NPC's greeting node and anything it continues to. If the
+ * node offers responses, the conversation stays open until the player
+ * answers with dialog_respond() or does something else.
+ *
+ * Return: False if the NPC has no dialog tree, or none for the state
+ * it is in, so the caller can fall back to its dialog lines
+ */
+
+bool dialog_talk(GameState *game, NPC *npc);
+
+
+/**
+ * dialog_respond() - Answer the conversation in progress
+ * @game: Current game state
+ * @number: Response number the player typed
+ *
+ * Return: False if @number is not one of the responses on offer
+ */
+
+bool dialog_respond(GameState *game, int number);
+
+
+/**
+ * dialog_leave() - End the conversation in progress, if any
+ * @game: Current game state
+ *
+ * Return: void
+ */
+
+void dialog_leave(GameState *game);
+
+
+#endif /* DIALOG_H */
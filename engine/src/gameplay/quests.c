@@ -19,24 +19,23 @@
 /**
  * load_quests() - Load quests from story files
  * @story_dir: Location of story files
+ * @arena: Arena that takes ownership of the quest array
  * @quests_out: Pointer to quests array
  *
- * Load quest information from quests.ini, parse quests, allocate array
- * return quest array pointer
+ * Load quest information from quests.ini in a single pass, growing the
+ * quest array as sections appear, return quest array pointer
  *
  * Return: number of quests loaded or 0 if no quests / error
  */
 
-int load_quests(const char *story_dir, Quest **quests_out) {
-	FILE *fp;
+int load_quests(const char *story_dir, Arena *arena, Quest **quests_out) {
+	IniFile ini;
+	IniToken token;
 	char filepath[INI_VALUE_SIZE];
-	char line[INI_LINE_BUFFER_SIZE];
-	char section[INI_SECTION_SIZE];
-	char current_section[INI_SECTION_SIZE] = "";
-	char key[INI_KEY_SIZE];
-	char value[INI_VALUE_SIZE];
-	Quest *quests;
+	Quest *quests = NULL;
+	Quest *grown;
 	int quest_count = 0;
+	int quest_capacity = 0;
 	int current_quest = -1;
 
 	log_function_entry(__func__, "story_dir=%s", story_dir);
@@ -46,111 +45,98 @@ int load_quests(const char *story_dir, Quest **quests_out) {
 	
 	add_log_entry("Opening quests file: %s at %s", filepath, log_timestamp());
 
-	/* Open file */
-	fp = fopen(filepath, "r");
-	if (!fp) {
+	/* Map file */
+	if (ini_open(&ini, filepath) != 0) {
 		printf("WARNING: Cannot open %s (quests optional)\n", filepath);
 		log_function_exit(__func__, 0);
 		*quests_out = NULL;
 		return 0;
 	}
 
-	/* First pass: count quests */
-	while (fgets(line, sizeof(line), fp)) {
-		line[strcspn(line, "\r\n")] = 0;
-
-		if (parse_ini_section(line, section, sizeof(section))) {
-			if (strncmp(section, "QUEST:", 6) == 0) {
-				quest_count++;
-				add_log_entry("Found section: '%s' at %s", 
-				             section, log_timestamp());
-			}
-		}
-	}
-
-	add_log_entry("Pass 1 complete: found %d quests at %s", 
-	             quest_count, log_timestamp());
-
-	if (quest_count == 0) {
-		fclose(fp);
-		*quests_out = NULL;
-		log_function_exit(__func__, 0);
-		return 0;
-	}
-
-	/* Allocate quest array */
-	quests = calloc(quest_count, sizeof(Quest));
-	if (!quests) {
-		fclose(fp);
-		log_function_error(__func__, "Failed to allocate quest array");
-		log_function_exit(__func__, 0);
-		return 0;
-	}
-
-	/* Second pass: parse quests */
-	rewind(fp);
-
-	while (fgets(line, sizeof(line), fp)) {
-		line[strcspn(line, "\r\n")] = 0;
+	while (ini_next(&ini, &token)) {
 
 		/* Check for section header */
-		if (parse_ini_section(line, section, sizeof(section))) {
-			strncpy(current_section, section, sizeof(current_section) - 1);
+		if (token.type == INI_TOKEN_SECTION) {
 
 			/* If it's a QUEST section, start a new quest */
-			if (strncmp(section, "QUEST:", 6) == 0) {
-				current_quest++;
-				if (current_quest >= quest_count)
+			if (ini_view_has_prefix(token.section, "QUEST:")) {
+				add_log_entry("Found section: '%.*s' at %s", 
+				             (int)token.section.len, token.section.ptr,
+				             log_timestamp());
+
+				grown = array_grow(quests, quest_count, &quest_capacity,
+				                   sizeof(Quest));
+				if (!grown) {
+					log_function_error(__func__, "Failed to allocate quest array");
 					break;
+				}
+				quests = grown;
+				current_quest = quest_count++;
 
 				/* Extract quest ID (after "QUEST:") */
-				strncpy(quests[current_quest].id, section + 6,
-				       sizeof(quests[current_quest].id) - 1);
+				quests[current_quest].id =
+					ini_view_text(arena, ini_view_skip(token.section, 6));
 				
 				/* Initialize quest */
+				quests[current_quest].name = "";
+				quests[current_quest].description = "";
+				quests[current_quest].completion_item = "";
+				quests[current_quest].completion_npc = "";
+				quests[current_quest].completion_room = "";
+				quests[current_quest].completion_message = "";
 				quests[current_quest].completed = false;
+				quests[current_quest].started = false;
+				quests[current_quest].failed = false;
 				quests[current_quest].required = false;
+				quests[current_quest].completion_check = "";
+				quests[current_quest].failure_condition = "";
+				quests[current_quest].completion_code = SCRIPT_NONE;
+				quests[current_quest].failure_code = SCRIPT_NONE;
 			}
 			continue;
 		}
 
 		/* Parse key=value pairs */
-		if (current_quest >= 0 &&
-		    parse_ini_keyvalue(line, key, sizeof(key),
-		                      value, sizeof(value))) {
+		if (current_quest >= 0) {
 			Quest *quest = &quests[current_quest];
 
-			if (strcmp(key, "name") == 0) {
-				strncpy(quest->name, value, 
-				       sizeof(quest->name) - 1);
-			} else if (strcmp(key, "description") == 0) {
-				strncpy(quest->description, value,
-				       sizeof(quest->description) - 1);
-			} else if (strcmp(key, "required") == 0) {
-				quest->required = (strcmp(value, "true") == 0);
-			} else if (strcmp(key, "completion_item") == 0) {
-				strncpy(quest->completion_item, value,
-				       sizeof(quest->completion_item) - 1);
-			} else if (strcmp(key, "completion_npc") == 0) {
-				strncpy(quest->completion_npc, value,
-				       sizeof(quest->completion_npc) - 1);
-			} else if (strcmp(key, "completion_room") == 0) {
-				strncpy(quest->completion_room, value,
-				       sizeof(quest->completion_room) - 1);
-			} else if (strcmp(key, "completion_message") == 0) {
-				strncpy(quest->completion_message, value,
-				       sizeof(quest->completion_message) - 1);
+			if (ini_view_equals(token.key, "name")) {
+				quest->name = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "description")) {
+				quest->description = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "required")) {
+				quest->required = ini_view_to_bool(token.value);
+			} else if (ini_view_equals(token.key, "completion_item")) {
+				quest->completion_item = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "completion_npc")) {
+				quest->completion_npc = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "completion_room")) {
+				quest->completion_room = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "completion_message")) {
+				quest->completion_message = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "completion_check")) {
+				quest->completion_check = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "failure_condition")) {
+				quest->failure_condition = ini_view_text(arena, token.value);
 			}
 		}
 	}
 
-	fclose(fp);
+	ini_close(&ini);
+
+	/* Finalise array at end of file; the arena frees it with the story */
+	quests = array_shrink(quests, quest_count, sizeof(Quest));
+	if (arena_adopt(arena, quests,
+	                (size_t)quest_count * sizeof(Quest)) != 0) {
+		free(quests);
+		quests = NULL;
+		quest_count = 0;
+	}
 
-	/* Print summary */
-	printf("Loaded %d quests at %s\n", quest_count, log_timestamp());
+	/* Log summary */
 	for (int i = 0; i < quest_count; i++) {
-		printf("  Quest %d: %s (%s)\n", i, quests[i].name, 
-		       quests[i].required ? "required" : "optional");
+		add_log_entry("  Quest %d: %s (%s)", i, quests[i].name, 
+		             quests[i].required ? "required" : "optional");
 	}
 
 	*quests_out = quests;
@@ -161,43 +147,41 @@ int load_quests(const char *story_dir, Quest **quests_out) {
 
 /**
  * find_quest_by_id() - Locate quest by id
- * @quests: Pointer to quest array
- * @quest_count: Number of quests
+ * @story: Story holding the quests
  * @quest_id: Quest ID to search for
  *
  *
  * Return: Quest from array or NULL if nothing / error
  */
 
-Quest* find_quest_by_id(Quest *quests, int quest_count, const char *quest_id) {
-	if (!quests || !quest_id)
-		return NULL;
+Quest* find_quest_by_id(Story *story, const char *quest_id) {
+	int i;
 
-	for (int i = 0; i < quest_count; i++) {
-		if (strcmp(quests[i].id, quest_id) == 0) {
-			return &quests[i];
-		}
-	}
+	if (!story || !quest_id)
+		return NULL;
 
-	return NULL;
+	i = story_index_find(&story->quest_index, quest_id);
+	return i >= 0 ? &story->quests[i] : NULL;
 }
 
 
 /**
  * check_quest_completion() - Check to see if quest is complete
  * @quest: Quest to check
- * @item_id: Item to be checked for completion
- * @npc_id: NPC to be checked for completion
- * @room_id: Room to be checked for completion
+ * @item: Item to be checked for completion
+ * @npc: NPC to be checked for completion
+ * @room: Room to be checked for completion
  *
  * Check to see if quest has been completed. 
- * Quests can require items and/or NPC engagement and/or room access
+ * Quests can require items and/or NPC engagement and/or room access.
+ * Targets were resolved by link_story(), so this compares pointers.
+ * Rooms of a streamed story are not linked, and are matched by ID.
  *
  * Return: True if quest is complete
  */
 
-bool check_quest_completion(Quest *quest, const char *item_id,
-                           const char *npc_id, const char *room_id) {
+bool check_quest_completion(Quest *quest, const Item *item,
+                           const NPC *npc, const Room *room) {
 	bool item_match = false;
 	bool npc_match = false;
 	bool room_match = false;
@@ -205,26 +189,29 @@ bool check_quest_completion(Quest *quest, const char *item_id,
 	if (!quest || quest->completed)
 		return false;
 
-	/* Check each condition - empty string means "not required" */
+	/* Check each condition - empty ID means "not required", an ID
+	 * that names nothing never matches */
 	
 	/* Item condition */
-	if (strlen(quest->completion_item) == 0) {
+	if (quest->completion_item[0] == '\0') {
 		item_match = true;  /* Not required */
-	} else if (item_id && strcmp(quest->completion_item, item_id) == 0) {
+	} else if (item && item == quest->completion_item_ref) {
 		item_match = true;
 	}
 
 	/* NPC condition */
-	if (strlen(quest->completion_npc) == 0) {
+	if (quest->completion_npc[0] == '\0') {
 		npc_match = true;  /* Not required */
-	} else if (npc_id && strcmp(quest->completion_npc, npc_id) == 0) {
+	} else if (npc && npc == quest->completion_npc_ref) {
 		npc_match = true;
 	}
 
 	/* Room condition */
-	if (strlen(quest->completion_room) == 0) {
+	if (quest->completion_room[0] == '\0') {
 		room_match = true;  /* Not required */
-	} else if (room_id && strcmp(quest->completion_room, room_id) == 0) {
+	} else if (room && (room == quest->completion_room_ref ||
+			    (!quest->completion_room_ref &&
+			     strcmp(room->id, quest->completion_room) == 0))) {
 		room_match = true;
 	}
 
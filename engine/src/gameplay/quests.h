@@ -13,40 +13,42 @@
 /**
  * load_quests() - Load quests from quests.ini
  * @story_dir: Path to story directory
+ * @arena: Arena that takes ownership of the quest array
  * @quests_out: Pointer to store allocated quest array
  *
- * Uses two-pass approach: counts quests, allocates array,
- * then fills quest data.
+ * Single pass: the quest array grows as [QUEST:] headers appear
+ * and is trimmed to size at end of file.
  *
  * Return: Number of quests loaded, 0 on error or empty
  */
-int load_quests(const char *story_dir, Quest **quests_out);
+int load_quests(const char *story_dir, Arena *arena, Quest **quests_out);
 
 
 /**
  * find_quest_by_id() - Find a quest by its identifier
- * @quests: Array of quests
- * @quest_count: Number of quests in array
+ * @story: Story holding the quests
  * @quest_id: Quest identifier to find
  *
+ * Uses the story's quest index; cost does not grow with the quest count.
+ *
  * Return: Pointer to quest if found, NULL otherwise
  */
-Quest* find_quest_by_id(Quest *quests, int quest_count, const char *quest_id);
+Quest* find_quest_by_id(Story *story, const char *quest_id);
 
 
 /**
  * check_quest_completion() - Check if quest conditions are met
  * @quest: Quest to check
- * @item_id: Item just acquired (or NULL)
- * @npc_id: NPC just talked to (or NULL)
- * @room_id: Room just entered (or NULL)
+ * @item: Item just acquired (or NULL)
+ * @npc: NPC just talked to (or NULL)
+ * @room: Room just entered (or NULL)
  *
- * Checks if provided IDs match quest completion conditions.
- * Returns true if quest should be marked complete.
+ * Checks if provided entities match the quest's linked completion
+ * targets. Returns true if quest should be marked complete.
  *
  * Return: true if quest completed, false otherwise
  */
-bool check_quest_completion(Quest *quest, const char *item_id, 
-                           const char *npc_id, const char *room_id);
+bool check_quest_completion(Quest *quest, const Item *item, 
+                           const NPC *npc, const Room *room);
 
 #endif /* QUESTS_H */
\ No newline at end of file
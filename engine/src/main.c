@@ -23,24 +23,41 @@
 #include "core/game.h"
 #include "core/logger.h"
 #include "core/parser.h"
+#include "story/image.h"
 #include "story/loader.h"
 #include "story/manager.h"
 #include "story/validator.h"
 #include "system/platform.h"
+#include "system/watch.h"
 #include "ui/colors.h"
 #include "ui/display.h"
 #include "ui/menu.h"
+#include "ui/output.h"
 #include "ui/splash.h"
 
 
+/* --watch: reload story files edited while playing */
+static bool watch_story = false;
+
+
  /**
   * main() - Application entry point and main loop
-  * @argc: Argument count passed from startup (unused)
-  * @argv: Vectors to argument strings (unused)
+  * @argc: Argument count passed from startup
+  * @argv: Vectors to argument strings
   *
   * This function serves as the primary entry point for the application.
   * It processes command line arguments, initializes the program environment,
   * and executes the main loop until user quits.
+  *
+  * Options:
+  *   -d, --debug                      Write a debug log
+  *   --lazy-text                      Read descriptions and dialog from
+  *                                    disk when first shown
+  *   --stream-rooms                   Load rooms region by region, even
+  *                                    if the story does not ask to
+  *   --watch                          Reload rooms, items and NPCs when
+  *                                    their story files are saved
+  *   --compile <story_dir> [output]   Compile a story image and exit
   * 
   * Return: 0 on success, Non-zero for errors
   */
@@ -48,7 +65,11 @@
 int main(int argc, char** argv) {
 
     bool debug_mode = false;
+    bool lazy_text = false;
+    bool stream_rooms = false;
     char logfile[LOG_FILENAME_SIZE];
+    const char *compile_dir = NULL;
+    const char *compile_out = NULL;
 
     /* Seed random number generator */
     srand((unsigned int)time(NULL));
@@ -59,6 +80,25 @@ int main(int argc, char** argv) {
             strcmp(argv[i], "--debug") == 0) {
                 debug_mode = true; /* Enable logging/debugging to file */
             }
+        else if (strcmp(argv[i], "--lazy-text") == 0) {
+            lazy_text = true; /* Leave story text on disk until needed */
+        }
+        else if (strcmp(argv[i], "--stream-rooms") == 0) {
+            stream_rooms = true; /* Keep only the rooms near the player */
+        }
+        else if (strcmp(argv[i], "--watch") == 0) {
+            watch_story = true; /* Patch the story as it is edited */
+        }
+        else if (strcmp(argv[i], "--compile") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Usage: %s --compile <story_dir> [output]\n",
+                        argv[0]);
+                return 1;
+            }
+            compile_dir = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                compile_out = argv[++i];
+        }
     }
 
     if (debug_mode) {
@@ -68,6 +108,17 @@ int main(int argc, char** argv) {
         add_log_entry("Silly Walk Engine v1.0");
     }
 
+    /* Build step: compile a story directory and exit */
+    if (compile_dir) {
+        int ret = compile_story(compile_dir, compile_out);
+        log_close();
+        return ret == 0 ? 0 : 1;
+    }
+
+    loader_set_lazy_text(lazy_text);
+    if (stream_rooms)
+        loader_set_room_streaming(ROOM_STREAMING_ON);
+
     splash_show();
 
     printf("Text Adventure Engine v1.0\n");
@@ -129,10 +180,40 @@ int main(int argc, char** argv) {
 }
 
 
+/**
+  * compile_story() - Compile a story directory into a binary image
+  * @story_dir: Story directory to compile
+  * @image_path: Output file, NULL for <story_dir>/story.img
+  *
+  * Return: 0 on success, negative errno on failure
+  */
+
+int compile_story(const char *story_dir, const char *image_path) {
+    char default_path[STORY_DIRECTORY_SIZE + 16];
+    int ret;
+
+    if (!image_path) {
+        snprintf(default_path, sizeof(default_path), "%s/%s", story_dir,
+                 STORY_IMAGE_FILENAME);
+        image_path = default_path;
+    }
+
+    ret = story_image_compile(story_dir, image_path);
+    if (ret != 0) {
+        printf_colored(COLOR_ERROR, "ERROR: Failed to compile %s: %s\n",
+                       story_dir, strerror(-ret));
+        return ret;
+    }
+
+    printf_colored(COLOR_SUCCESS, "Compiled %s -> %s\n", story_dir, image_path);
+    return 0;
+}
+
+
 /**
   * start_new_game() - Player has selected to begin a new game. 
   *
-  * Displays a list of available stories, gets player story selection.
+  * Lists available stories a page at a time, gets player story selection.
   * Validates story file, initialises game state. Calls game loop.
   *
   * Return: void
@@ -149,15 +230,11 @@ void start_new_game(void) {
         printf_colored(COLOR_ERROR, "No stories found in stories/ directory!\n");
         printf_colored(COLOR_INFO, "Press any key to continue...\n");
         getchar();
+        free(story_list);
         return;
     }
     
     printf_colored(COLOR_SUCCESS, "Found %d story(s):\n", story_count);
-    for (int i = 0; i < story_count; i++) {
-        printf_colored(COLOR_BRIGHT_CYAN, "%d. ", i + 1);
-        printf_colored(COLOR_BOLD, "%s ", story_list[i].title);
-        printf_colored(COLOR_GRAY, "(by %s)\n", story_list[i].author);
-    }
     
     // Let player select story
     Story* story = select_story(story_list, story_count);
@@ -223,22 +300,47 @@ void load_saved_game(void) {
   */
  
 void play_game(GameState* game) {
-    printf("\n");
-    printf("========================================\n");
-    printf("  %s\n", game->story->metadata.title);
-    printf("========================================\n");
-    printf("\n");
+    // Everything printed during play goes through the session's buffer
+    Output *previous_output = output_select(&game->output);
+
+    output_printf("\n");
+    output_printf("========================================\n");
+    output_printf("  %s\n", game->story->metadata.title);
+    output_printf("========================================\n");
+    output_printf("\n");
     
     // Show starting location
     look_at_current_room(game);
     
+    // Watch the story files if asked to
+    StoryWatch watch = { .fd = -1, .wd = -1 };
+    if (watch_story) {
+        if (story_watch_open(&watch, game->story->story_dir) == 0) {
+            /* Nothing typed may sit unseen in stdio's buffer */
+            setvbuf(stdin, NULL, _IONBF, 0);
+        } else {
+            printf_colored(COLOR_WARNING, "Cannot watch this story for edits.\n");
+        }
+    }
+    
     // Game loop
     bool playing = true;
     char input[PARSER_INPUT_BUFFER_SIZE];
     
     while (playing) {
-        // Show prompt
-        printf("\n> ");
+        // Show prompt, writing the whole turn at once
+        output_printf("\n> ");
+        output_flush(&game->output);
+        
+        // Reload story files saved while waiting
+        int changed;
+        while (watch.fd >= 0 &&
+               (changed = story_watch_wait(&watch, fileno(stdin))) > 0) {
+            output_printf("\n");
+            game_reload_story(game, (unsigned int)changed);
+            output_printf("\n> ");
+            output_flush(&game->output);
+        }
         
         // Get player input
         if (fgets(input, sizeof(input), stdin) == NULL) {
@@ -254,10 +356,13 @@ void play_game(GameState* game) {
         }
         
         // Parse command
-        Command cmd = parse_command(input);
+        Command cmd = parse_command(game->story, input);
         
         // Execute command
         CommandResult result = execute_command(game, &cmd);
+
+        // Quest conditions may have changed
+        check_quest_scripts(game);
         
         // Check for quit
         if (result == RESULT_QUIT) {
@@ -266,16 +371,22 @@ void play_game(GameState* game) {
         
         // Check for victory
         if (check_victory_condition(game)) {
-            printf("\n");
+            output_printf("\n");
             printf_colored(COLOR_SUCCESS COLOR_BOLD, "========================================\n");
             printf_colored(COLOR_SUCCESS COLOR_BOLD, "  VICTORY!\n");
             printf_colored(COLOR_SUCCESS COLOR_BOLD, "========================================\n");
-            printf("\n");
+            output_printf("\n");
             printf_colored(COLOR_BRIGHT_GREEN, "%s\n", game->story->metadata.victory_text);
-            printf("\n");
+            output_printf("\n");
             printf_colored(COLOR_INFO, "Press any key to continue...\n");
+            output_flush(&game->output);
             getchar();
             playing = false;
         }
     }
+    
+    story_watch_close(&watch);
+
+    output_flush(&game->output);
+    output_select(previous_output);
 }
\ No newline at end of file
@@ -18,6 +18,19 @@
  */
 
 
+/**
+ * compile_story() - Compile a story directory into a binary image
+ * @story_dir: Story directory to compile
+ * @image_path: Output file, NULL for <story_dir>/story.img
+ *
+ * Implements "adventure --compile <story_dir> [output]".
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int compile_story(const char *story_dir, const char *image_path);
+
+
 /**
  * start_new_game() - Initialize and start a new game
  *
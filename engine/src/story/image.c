@@ -0,0 +1,1060 @@
+/*
+ * image.c - Compiled binary story images
+ *
+ * Image layout (all offsets are bytes from the start of the file):
+ *
+ *   ImageHeader                 magic, version, counts, table offsets
+ *   ImageRoom[room_count]       fixed-size entity tables
+ *   ImageItem[item_count]
+ *   ImageNPC[npc_count]
+ *   ImageQuest[quest_count]
+ *   ImageRef[ref_count]         every list (room items, NPCs, dialog...)
+ *   string table                NUL terminated strings, offset 0 is ""
+ *
+ * Nothing in the file is a pointer. Strings are offsets into the string
+ * table, so the file can be mapped at any address and used without
+ * relocation. Cross-references (exits, room contents, NPC locations,
+ * quest targets) are stored as IDs like in the INI files and resolved
+ * by link_story() after loading, which also reports dangling ones.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "image.h"
+#include "loader.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "system/platform.h"
+#include "ui/colors.h"
+
+
+#define IMAGE_NONE		UINT32_MAX	/* Absent string (no exit) */
+#define IMAGE_BYTE_ORDER	0x01020304u	/* Written in native order */
+
+
+/**
+ * struct ImageMetadata - StoryMetadata with strings as table offsets
+ */
+
+typedef struct {
+	uint32_t title;
+	uint32_t author;
+	uint32_t version;
+	uint32_t description;
+	uint32_t start_room;
+	int32_t max_inventory_weight;
+	int32_t victory_score;
+	uint32_t victory_text;
+} ImageMetadata;
+
+
+/**
+ * struct ImageHeader - First bytes of every image
+ * @magic: STORY_IMAGE_MAGIC, not NUL terminated
+ * @version: STORY_IMAGE_VERSION the image was written with
+ * @byte_order: IMAGE_BYTE_ORDER as stored by the writer
+ * @file_size: Total size of the image in bytes
+ * @*_count: Number of records in each table
+ * @*_offset: File offset of each table
+ * @strings_size: Size of the string table in bytes
+ * @metadata: Story metadata
+ */
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t file_size;
+	uint32_t room_count;
+	uint32_t item_count;
+	uint32_t npc_count;
+	uint32_t quest_count;
+	uint32_t ref_count;
+	uint32_t rooms_offset;
+	uint32_t items_offset;
+	uint32_t npcs_offset;
+	uint32_t quests_offset;
+	uint32_t refs_offset;
+	uint32_t strings_offset;
+	uint32_t strings_size;
+	ImageMetadata metadata;
+} ImageHeader;
+
+
+/**
+ * struct ImageRef - One element of a list
+ * @string: Offset of the element text (item ID, NPC ID, dialog line)
+ */
+
+typedef struct {
+	uint32_t string;
+} ImageRef;
+
+
+typedef struct {
+	uint32_t id;
+	uint32_t name;
+	uint32_t description;
+	uint32_t exits[DIR_COUNT];
+	uint32_t items;
+	uint32_t item_count;
+	uint32_t npcs;
+	uint32_t npc_count;
+	int8_t locked_exit;
+	uint8_t dark;
+	uint8_t locked;
+	uint8_t pad;
+} ImageRoom;
+
+
+typedef struct {
+	uint32_t id;
+	uint32_t name;
+	uint32_t description;
+	int32_t weight;
+	uint8_t takeable;
+	uint8_t useable;
+	uint8_t illuminates;
+	uint8_t unlocks;
+} ImageItem;
+
+
+typedef struct {
+	uint32_t id;
+	uint32_t name;
+	uint32_t description;
+	uint32_t location;
+	uint32_t dialog;
+	uint32_t dialog_count;
+	uint32_t combat_text;
+	uint32_t combat_text_count;
+	uint32_t required_item;
+	uint32_t greeting_dialog;
+	int32_t combat_hp;
+	int32_t combat_damage;
+	float base_win_chance;
+	float item_win_chance;
+	uint8_t hostile;
+	uint8_t pad[3];
+} ImageNPC;
+
+
+typedef struct {
+	uint32_t id;
+	uint32_t name;
+	uint32_t description;
+	uint32_t completion_item;
+	uint32_t completion_npc;
+	uint32_t completion_room;
+	uint32_t completion_message;
+	uint32_t completion_check;
+	uint32_t failure_condition;
+	uint8_t required;
+	uint8_t pad[3];
+} ImageQuest;
+
+
+/**
+ * struct ImageTable - Open-addressing string -> value map used while
+ * compiling (string interning)
+ */
+
+typedef struct {
+	const char *key;
+	uint32_t value;
+} ImageSlot;
+
+typedef struct {
+	ImageSlot *slots;
+	uint32_t capacity;
+	uint32_t count;
+} ImageTable;
+
+
+/**
+ * struct ImageBuilder - State while writing an image
+ * @strings: String table being built
+ * @strings_size: Bytes used in @strings
+ * @strings_capacity: Bytes allocated for @strings
+ * @interned: String -> offset, so repeated IDs are stored once
+ * @refs: List elements being built
+ * @ref_count: Elements used in @refs
+ * @ref_capacity: Elements allocated for @refs
+ * @failed: An allocation failed, the image must not be written
+ */
+
+typedef struct {
+	char *strings;
+	size_t strings_size;
+	size_t strings_capacity;
+	ImageTable interned;
+	ImageRef *refs;
+	int ref_count;
+	int ref_capacity;
+	bool failed;
+} ImageBuilder;
+
+
+/* Story files an image is compiled from (for staleness checks) */
+static const char *const image_sources[] = {
+	"story.ini", "rooms.ini", "items.ini", "npcs.ini", "quests.ini",
+};
+
+
+/**
+ * image_hash() - FNV-1a hash of a NUL terminated string
+ * @str: String to hash
+ *
+ * Return: 32-bit hash
+ */
+
+static uint32_t image_hash(const char *str)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*str) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+
+/**
+ * image_table_slot() - Find the slot for a key
+ * @table: Table to search (must have free slots)
+ * @key: Key to look for
+ *
+ * Return: Slot holding @key, or the empty slot it would go in
+ */
+
+static ImageSlot *image_table_slot(ImageTable *table, const char *key)
+{
+	uint32_t mask = table->capacity - 1;
+	uint32_t i = image_hash(key) & mask;
+
+	while (table->slots[i].key && strcmp(table->slots[i].key, key) != 0)
+		i = (i + 1) & mask;
+
+	return &table->slots[i];
+}
+
+
+/**
+ * image_table_put() - Insert a key unless it is already present
+ * @table: Table to insert into
+ * @key: Key (must stay valid for the life of the table)
+ * @value: Value to store for a new key
+ *
+ * Keeps the load factor at or below one half.
+ *
+ * Return: Slot for @key, NULL on allocation failure
+ */
+
+static ImageSlot *image_table_put(ImageTable *table, const char *key,
+				  uint32_t value)
+{
+	ImageSlot *slot;
+
+	if ((table->count + 1) * 2 > table->capacity) {
+		ImageTable grown;
+		uint32_t i;
+
+		grown.capacity = table->capacity ? table->capacity * 2 :
+						   ARRAY_INITIAL_CAPACITY;
+		grown.count = table->count;
+		grown.slots = calloc(grown.capacity, sizeof(ImageSlot));
+		if (!grown.slots)
+			return NULL;
+
+		for (i = 0; i < table->capacity; i++) {
+			if (table->slots[i].key)
+				*image_table_slot(&grown, table->slots[i].key) =
+					table->slots[i];
+		}
+
+		free(table->slots);
+		*table = grown;
+	}
+
+	slot = image_table_slot(table, key);
+	if (!slot->key) {
+		slot->key = key;
+		slot->value = value;
+		table->count++;
+	}
+
+	return slot;
+}
+
+
+/**
+ * image_intern() - Add a string to the string table
+ * @builder: Image being built
+ * @str: String to add (NULL is treated as "")
+ *
+ * Return: Offset of the string in the table
+ */
+
+static uint32_t image_intern(ImageBuilder *builder, const char *str)
+{
+	ImageSlot *slot;
+	size_t len;
+
+	if (!str || !*str)
+		return 0;
+
+	slot = image_table_put(&builder->interned, str,
+			       (uint32_t)builder->strings_size);
+	if (!slot) {
+		builder->failed = true;
+		return 0;
+	}
+	if (slot->value != builder->strings_size)
+		return slot->value;
+
+	len = strlen(str) + 1;
+	if (builder->strings_size + len > builder->strings_capacity) {
+		size_t capacity = builder->strings_capacity;
+		char *grown;
+
+		while (builder->strings_size + len > capacity)
+			capacity *= 2;
+
+		grown = realloc(builder->strings, capacity);
+		if (!grown) {
+			builder->failed = true;
+			return 0;
+		}
+		builder->strings = grown;
+		builder->strings_capacity = capacity;
+	}
+
+	memcpy(builder->strings + builder->strings_size, str, len);
+	builder->strings_size += len;
+	return slot->value;
+}
+
+
+/**
+ * image_add_list() - Append a list of strings to the ref table
+ * @builder: Image being built
+ * @list: Strings to add (NULL elements are stored as "")
+ * @count: Number of strings
+ *
+ * Return: Index of the first element in the ref table
+ */
+
+static uint32_t image_add_list(ImageBuilder *builder, char **list, int count)
+{
+	uint32_t first = (uint32_t)builder->ref_count;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		const char *str = list[i] ? list[i] : "";
+		ImageRef *grown;
+
+		grown = array_grow(builder->refs, builder->ref_count,
+				   &builder->ref_capacity, sizeof(ImageRef));
+		if (!grown) {
+			builder->failed = true;
+			return first;
+		}
+		builder->refs = grown;
+
+		builder->refs[builder->ref_count].string = image_intern(builder, str);
+		builder->ref_count++;
+	}
+
+	return first;
+}
+
+
+/**
+ * image_write() - Write the finished image to disk
+ * @path: Destination file
+ * @header: Completed header
+ * @tables: Entity tables in file order
+ * @table_sizes: Size of each entity table in bytes
+ * @builder: Builder holding the ref and string tables
+ *
+ * Writes to "<path>.tmp" and renames it into place so a running server
+ * never maps a half written image.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int image_write(const char *path, const ImageHeader *header,
+		       const void *const tables[4], const size_t table_sizes[4],
+		       const ImageBuilder *builder)
+{
+	char tmp_path[STORY_DIRECTORY_SIZE + 16];
+	FILE *fp;
+	bool ok;
+	int i;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+	fp = fopen(tmp_path, "wb");
+	if (!fp)
+		return -errno;
+
+	ok = fwrite(header, sizeof(*header), 1, fp) == 1;
+	for (i = 0; i < 4 && ok; i++) {
+		if (table_sizes[i] > 0)
+			ok = fwrite(tables[i], table_sizes[i], 1, fp) == 1;
+	}
+	if (ok && builder->ref_count > 0)
+		ok = fwrite(builder->refs, sizeof(ImageRef),
+			    (size_t)builder->ref_count, fp) ==
+		     (size_t)builder->ref_count;
+	if (ok)
+		ok = fwrite(builder->strings, builder->strings_size, 1, fp) == 1;
+
+	if (fclose(fp) != 0)
+		ok = false;
+
+	if (!ok) {
+		remove(tmp_path);
+		return -EIO;
+	}
+
+	remove(path);
+	if (rename(tmp_path, path) != 0) {
+		remove(tmp_path);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+
+/**
+ * image_build() - Convert a loaded story into image tables and write it
+ * @story: Story loaded from .ini files
+ * @builder: Empty builder
+ * @image_path: Destination file
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int image_build(const Story *story, ImageBuilder *builder,
+		       const char *image_path)
+{
+	ImageHeader header;
+	ImageRoom *rooms;
+	ImageItem *items;
+	ImageNPC *npcs;
+	ImageQuest *quests;
+	const void *tables[4];
+	size_t table_sizes[4];
+	uint64_t offset;
+	int ret = -ENOMEM;
+	int i, j;
+
+	rooms = calloc((size_t)story->room_count + 1, sizeof(ImageRoom));
+	items = calloc((size_t)story->item_count + 1, sizeof(ImageItem));
+	npcs = calloc((size_t)story->npc_count + 1, sizeof(ImageNPC));
+	quests = calloc((size_t)story->quest_count + 1, sizeof(ImageQuest));
+	if (!rooms || !items || !npcs || !quests)
+		goto out;
+
+	for (i = 0; i < story->room_count; i++) {
+		const Room *src = &story->rooms[i];
+		ImageRoom *dst = &rooms[i];
+
+		dst->id = image_intern(builder, src->id);
+		dst->name = image_intern(builder, src->name);
+		dst->description = image_intern(builder, src->description);
+		for (j = 0; j < DIR_COUNT; j++) {
+			dst->exits[j] = src->exit_ids[j] ?
+				image_intern(builder, src->exit_ids[j]) :
+				IMAGE_NONE;
+		}
+		dst->items = image_add_list(builder, src->item_ids,
+					    src->item_id_count);
+		dst->item_count = (uint32_t)src->item_id_count;
+		dst->npcs = image_add_list(builder, src->npc_ids,
+					   src->npc_id_count);
+		dst->npc_count = (uint32_t)src->npc_id_count;
+		dst->locked_exit = (int8_t)src->locked_exit;
+		dst->dark = src->dark;
+		dst->locked = src->locked;
+	}
+
+	for (i = 0; i < story->item_count; i++) {
+		const Item *src = &story->items[i];
+		ImageItem *dst = &items[i];
+
+		dst->id = image_intern(builder, src->id);
+		dst->name = image_intern(builder, src->name);
+		dst->description = image_intern(builder, src->description);
+		dst->weight = src->weight;
+		dst->takeable = src->takeable;
+		dst->useable = src->useable;
+		dst->illuminates = src->illuminates;
+		dst->unlocks = src->unlocks;
+	}
+
+	for (i = 0; i < story->npc_count; i++) {
+		const NPC *src = &story->npcs[i];
+		ImageNPC *dst = &npcs[i];
+
+		dst->id = image_intern(builder, src->id);
+		dst->name = image_intern(builder, src->name);
+		dst->description = image_intern(builder, src->description);
+		dst->location = image_intern(builder, src->location);
+		dst->dialog = image_add_list(builder, src->dialog,
+					     src->dialog_count);
+		dst->dialog_count = (uint32_t)src->dialog_count;
+		dst->combat_text = image_add_list(builder, src->combat_text,
+						  src->combat_text_count);
+		dst->combat_text_count = (uint32_t)src->combat_text_count;
+		dst->required_item = image_intern(builder, src->required_item);
+		dst->greeting_dialog = image_intern(builder, src->greeting_dialog);
+		dst->combat_hp = src->combat_hp;
+		dst->combat_damage = src->combat_damage;
+		dst->base_win_chance = src->base_win_chance;
+		dst->item_win_chance = src->item_win_chance;
+		dst->hostile = src->hostile;
+	}
+
+	for (i = 0; i < story->quest_count; i++) {
+		const Quest *src = &story->quests[i];
+		ImageQuest *dst = &quests[i];
+
+		dst->id = image_intern(builder, src->id);
+		dst->name = image_intern(builder, src->name);
+		dst->description = image_intern(builder, src->description);
+		dst->completion_item = image_intern(builder, src->completion_item);
+		dst->completion_npc = image_intern(builder, src->completion_npc);
+		dst->completion_room = image_intern(builder, src->completion_room);
+		dst->completion_message = image_intern(builder,
+						       src->completion_message);
+		dst->completion_check = image_intern(builder,
+						     src->completion_check);
+		dst->failure_condition = image_intern(builder,
+						      src->failure_condition);
+		dst->required = src->required;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, STORY_IMAGE_MAGIC, sizeof(header.magic));
+	header.version = STORY_IMAGE_VERSION;
+	header.byte_order = IMAGE_BYTE_ORDER;
+	header.metadata.title = image_intern(builder, story->metadata.title);
+	header.metadata.author = image_intern(builder, story->metadata.author);
+	header.metadata.version = image_intern(builder, story->metadata.version);
+	header.metadata.description = image_intern(builder,
+						   story->metadata.description);
+	header.metadata.start_room = image_intern(builder,
+						  story->metadata.start_room);
+	header.metadata.max_inventory_weight = story->metadata.max_inventory_weight;
+	header.metadata.victory_score = story->metadata.victory_score;
+	header.metadata.victory_text = image_intern(builder,
+						    story->metadata.victory_text);
+
+	if (builder->failed)
+		goto out;
+
+	header.room_count = (uint32_t)story->room_count;
+	header.item_count = (uint32_t)story->item_count;
+	header.npc_count = (uint32_t)story->npc_count;
+	header.quest_count = (uint32_t)story->quest_count;
+	header.ref_count = (uint32_t)builder->ref_count;
+
+	tables[0] = rooms;
+	tables[1] = items;
+	tables[2] = npcs;
+	tables[3] = quests;
+	table_sizes[0] = (size_t)story->room_count * sizeof(ImageRoom);
+	table_sizes[1] = (size_t)story->item_count * sizeof(ImageItem);
+	table_sizes[2] = (size_t)story->npc_count * sizeof(ImageNPC);
+	table_sizes[3] = (size_t)story->quest_count * sizeof(ImageQuest);
+
+	offset = sizeof(ImageHeader);
+	header.rooms_offset = (uint32_t)offset;
+	offset += table_sizes[0];
+	header.items_offset = (uint32_t)offset;
+	offset += table_sizes[1];
+	header.npcs_offset = (uint32_t)offset;
+	offset += table_sizes[2];
+	header.quests_offset = (uint32_t)offset;
+	offset += table_sizes[3];
+	header.refs_offset = (uint32_t)offset;
+	offset += (uint64_t)builder->ref_count * sizeof(ImageRef);
+	header.strings_offset = (uint32_t)offset;
+	header.strings_size = (uint32_t)builder->strings_size;
+	offset += builder->strings_size;
+
+	if (offset > UINT32_MAX) {
+		ret = -EFBIG;
+		goto out;
+	}
+	header.file_size = (uint32_t)offset;
+
+	ret = image_write(image_path, &header, tables, table_sizes, builder);
+
+out:
+	free(rooms);
+	free(items);
+	free(npcs);
+	free(quests);
+	return ret;
+}
+
+
+/**
+ * story_image_compile() - Compile a story directory into a binary image
+ * @story_dir: Directory holding story.ini, rooms.ini, items.ini, ...
+ * @image_path: File to write the image to
+ *
+ * Always parses the story with its text and every room in memory,
+ * whatever loader_set_lazy_text() and loader_set_room_streaming() say.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_image_compile(const char *story_dir, const char *image_path)
+{
+	ImageBuilder builder;
+	RoomStreaming streaming;
+	Story *story;
+	bool lazy;
+	int ret;
+
+	log_function_entry(__func__, "story_dir=%s, image_path=%s",
+			   story_dir, image_path);
+
+	/* The image carries every string, so parse them all up front */
+	lazy = loader_lazy_text();
+	streaming = loader_room_streaming();
+	loader_set_lazy_text(false);
+	loader_set_room_streaming(ROOM_STREAMING_OFF);
+	story = load_story_from_ini(story_dir);
+	loader_set_lazy_text(lazy);
+	loader_set_room_streaming(streaming);
+	if (!story) {
+		log_function_error(__func__, "Failed to load story from .ini");
+		return -ENOENT;
+	}
+
+	memset(&builder, 0, sizeof(builder));
+	builder.strings_capacity = 4096;
+	builder.strings = malloc(builder.strings_capacity);
+	if (!builder.strings) {
+		free_story(story);
+		return -ENOMEM;
+	}
+
+	/* Offset 0 is the empty string */
+	builder.strings[0] = '\0';
+	builder.strings_size = 1;
+
+	ret = image_build(story, &builder, image_path);
+	if (ret == 0) {
+		add_log_entry("Compiled %s: %d rooms, %d items, %d NPCs, %d quests, "
+			      "%d list entries, %zu string bytes",
+			      image_path, story->room_count, story->item_count,
+			      story->npc_count, story->quest_count,
+			      builder.ref_count, builder.strings_size);
+	}
+
+	free(builder.strings);
+	free(builder.refs);
+	free(builder.interned.slots);
+	free_story(story);
+
+	log_function_exit(__func__, ret);
+	return ret;
+}
+
+
+/**
+ * story_image_is_current() - Check an image is newer than its sources
+ * @story_dir: Directory the image was compiled from
+ * @image_path: Compiled image
+ *
+ * Return: true if the image exists and no source is newer
+ */
+
+bool story_image_is_current(const char *story_dir, const char *image_path)
+{
+	char filepath[STORY_DIRECTORY_SIZE + 32];
+	struct stat image_st;
+	struct stat st;
+	size_t i;
+
+	if (stat(image_path, &image_st) != 0)
+		return false;
+
+	for (i = 0; i < sizeof(image_sources) / sizeof(image_sources[0]); i++) {
+		snprintf(filepath, sizeof(filepath), "%s/%s", story_dir,
+			 image_sources[i]);
+		if (stat(filepath, &st) == 0 && st.st_mtime > image_st.st_mtime)
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * image_header_valid() - Check a mapped image before trusting it
+ * @header: Start of the mapping
+ * @size: Size of the mapping
+ *
+ * Every table must lie inside the file in the documented order and the
+ * string table must end with a NUL, so any offset below strings_size
+ * is a terminated string.
+ *
+ * Return: true if the image can be used
+ */
+
+static bool image_header_valid(const ImageHeader *header, size_t size)
+{
+	const char *base = (const char *)header;
+	uint64_t end;
+
+	if (size < sizeof(ImageHeader))
+		return false;
+	if (memcmp(header->magic, STORY_IMAGE_MAGIC, sizeof(header->magic)) != 0)
+		return false;
+	if (header->version != STORY_IMAGE_VERSION ||
+	    header->byte_order != IMAGE_BYTE_ORDER ||
+	    header->file_size != size)
+		return false;
+
+	end = sizeof(ImageHeader);
+	if (header->rooms_offset != end)
+		return false;
+	end += (uint64_t)header->room_count * sizeof(ImageRoom);
+	if (header->items_offset != end)
+		return false;
+	end += (uint64_t)header->item_count * sizeof(ImageItem);
+	if (header->npcs_offset != end)
+		return false;
+	end += (uint64_t)header->npc_count * sizeof(ImageNPC);
+	if (header->quests_offset != end)
+		return false;
+	end += (uint64_t)header->quest_count * sizeof(ImageQuest);
+	if (header->refs_offset != end)
+		return false;
+	end += (uint64_t)header->ref_count * sizeof(ImageRef);
+	if (header->strings_offset != end)
+		return false;
+	end += header->strings_size;
+
+	return end == size && header->strings_size > 0 &&
+	       base[size - 1] == '\0';
+}
+
+
+/**
+ * struct ImageView - Typed pointers into a validated mapping
+ */
+
+typedef struct {
+	const ImageHeader *header;
+	const ImageRef *refs;
+	const char *strings;
+} ImageView;
+
+
+/**
+ * image_string() - Resolve a string offset
+ * @view: Validated image
+ * @offset: Offset into the string table
+ *
+ * Return: String at @offset, "" if the offset is out of range
+ */
+
+static const char *image_string(const ImageView *view, uint32_t offset)
+{
+	if (offset >= view->header->strings_size)
+		return "";
+
+	return view->strings + offset;
+}
+
+
+/**
+ * image_list() - Point a story list at its slice of the shared block
+ * @lists: Shared pointer block (one entry per ImageRef)
+ * @view: Validated image
+ * @first: Index of the first element
+ * @count: Number of elements
+ * @count_out: Where to store the element count
+ *
+ * Return: Start of the slice, NULL for empty or out-of-range lists
+ */
+
+static char **image_list(char **lists, const ImageView *view, uint32_t first,
+			 uint32_t count, int *count_out)
+{
+	if (count == 0 || (uint64_t)first + count > view->header->ref_count) {
+		*count_out = 0;
+		return NULL;
+	}
+
+	*count_out = (int)count;
+	return lists + first;
+}
+
+
+/**
+ * story_image_load() - Map a compiled image and build a Story from it
+ * @image_path: Compiled image
+ *
+ * Every string in the story (metadata, IDs, names, descriptions, exit
+ * IDs, dialog, combat text) points straight into the mapping, the lists
+ * through one shared pointer block. That block and the entity arrays
+ * come from the story arena.
+ *
+ * Return: Story structure, NULL if the image is missing or invalid
+ */
+
+Story *story_image_load(const char *image_path)
+{
+	const char *data;
+	size_t size;
+	bool mapped;
+	ImageView view;
+	const ImageHeader *header;
+	const ImageMetadata *meta;
+	Story *story;
+	char **lists = NULL;
+	uint32_t i;
+	int j;
+
+	log_function_entry(__func__, "image_path=%s", image_path);
+
+	if (platform_map_file(image_path, &data, &size, &mapped) != 0) {
+		log_function_error(__func__, "Cannot map image");
+		return NULL;
+	}
+
+	header = (const ImageHeader *)data;
+	if (!image_header_valid(header, size)) {
+		add_log_entry("Ignoring invalid or outdated story image %s at %s",
+			      image_path, log_timestamp());
+		platform_unmap_file(data, size, mapped);
+		log_function_exit(__func__, 0);
+		return NULL;
+	}
+
+	view.header = header;
+	view.refs = (const ImageRef *)(data + header->refs_offset);
+	view.strings = data + header->strings_offset;
+
+	story = calloc(1, sizeof(Story));
+	if (!story)
+		goto fail;
+
+	story->image = data;
+	story->image_size = size;
+	story->image_mapped = mapped;
+
+	if (header->ref_count > 0) {
+		lists = arena_alloc(&story->arena,
+				    (size_t)header->ref_count * sizeof(char *));
+		if (!lists)
+			goto fail;
+		for (i = 0; i < header->ref_count; i++)
+			lists[i] = (char *)image_string(&view, view.refs[i].string);
+	}
+
+	/* Metadata */
+	meta = &header->metadata;
+	story->metadata.title = image_string(&view, meta->title);
+	story->metadata.author = image_string(&view, meta->author);
+	story->metadata.version = image_string(&view, meta->version);
+	story->metadata.description = image_string(&view, meta->description);
+	story->metadata.start_room = image_string(&view, meta->start_room);
+	story->metadata.max_inventory_weight = meta->max_inventory_weight;
+	story->metadata.victory_score = meta->victory_score;
+	story->metadata.victory_text = image_string(&view, meta->victory_text);
+
+	/* Rooms */
+	if (header->room_count > 0) {
+		const ImageRoom *src = (const ImageRoom *)(data + header->rooms_offset);
+
+		story->rooms = arena_calloc(&story->arena, header->room_count,
+					     sizeof(Room));
+		if (!story->rooms)
+			goto fail;
+		story->room_count = (int)header->room_count;
+
+		for (i = 0; i < header->room_count; i++) {
+			Room *room = &story->rooms[i];
+
+			room->id = image_string(&view, src[i].id);
+			room->name = image_string(&view, src[i].name);
+			room->description = image_string(&view,
+							 src[i].description);
+			for (j = 0; j < DIR_COUNT; j++) {
+				if (src[i].exits[j] == IMAGE_NONE)
+					continue;
+				room->exit_ids[j] = (char *)image_string(&view,
+									 src[i].exits[j]);
+				room->exit_count++;
+			}
+			room->item_ids = image_list(lists, &view, src[i].items,
+						    src[i].item_count,
+						    &room->item_id_count);
+			room->npc_ids = image_list(lists, &view, src[i].npcs,
+						   src[i].npc_count,
+						   &room->npc_id_count);
+			room->dark = src[i].dark;
+			room->locked = src[i].locked;
+			room->locked_exit = src[i].locked_exit >= 0 &&
+					    src[i].locked_exit < DIR_COUNT ?
+					    (Direction)src[i].locked_exit : DIR_NONE;
+
+		}
+	}
+
+	/* Items */
+	if (header->item_count > 0) {
+		const ImageItem *src = (const ImageItem *)(data + header->items_offset);
+
+		story->items = arena_calloc(&story->arena, header->item_count,
+					     sizeof(Item));
+		if (!story->items)
+			goto fail;
+		story->item_count = (int)header->item_count;
+
+		for (i = 0; i < header->item_count; i++) {
+			Item *item = &story->items[i];
+
+			item->id = image_string(&view, src[i].id);
+			item->name = image_string(&view, src[i].name);
+			item->description = image_string(&view,
+							 src[i].description);
+			item->weight = src[i].weight;
+			item->takeable = src[i].takeable;
+			item->useable = src[i].useable;
+			item->illuminates = src[i].illuminates;
+			item->unlocks = src[i].unlocks;
+		}
+	}
+
+	/* NPCs */
+	if (header->npc_count > 0) {
+		const ImageNPC *src = (const ImageNPC *)(data + header->npcs_offset);
+
+		story->npcs = arena_calloc(&story->arena, header->npc_count,
+					     sizeof(NPC));
+		if (!story->npcs)
+			goto fail;
+		story->npc_count = (int)header->npc_count;
+
+		for (i = 0; i < header->npc_count; i++) {
+			NPC *npc = &story->npcs[i];
+
+			npc->id = image_string(&view, src[i].id);
+			npc->name = image_string(&view, src[i].name);
+			npc->description = image_string(&view,
+							src[i].description);
+			npc->location = image_string(&view, src[i].location);
+			npc->dialog = image_list(lists, &view, src[i].dialog,
+						 src[i].dialog_count,
+						 &npc->dialog_count);
+			npc->combat_text = image_list(lists, &view,
+						      src[i].combat_text,
+						      src[i].combat_text_count,
+						      &npc->combat_text_count);
+			npc->required_item = image_string(&view,
+							  src[i].required_item);
+			npc->greeting_dialog = image_string(&view,
+							    src[i].greeting_dialog);
+			npc->dialog_start = DIALOG_NONE;
+			npc->hostile = src[i].hostile;
+			npc->combat_hp = src[i].combat_hp;
+			npc->combat_damage = src[i].combat_damage;
+			npc->base_win_chance = src[i].base_win_chance;
+			npc->item_win_chance = src[i].item_win_chance;
+		}
+	}
+
+	/* Quests */
+	if (header->quest_count > 0) {
+		const ImageQuest *src = (const ImageQuest *)(data + header->quests_offset);
+
+		story->quests = arena_calloc(&story->arena, header->quest_count,
+					     sizeof(Quest));
+		if (!story->quests)
+			goto fail;
+		story->quest_count = (int)header->quest_count;
+
+		for (i = 0; i < header->quest_count; i++) {
+			Quest *quest = &story->quests[i];
+
+			quest->id = image_string(&view, src[i].id);
+			quest->name = image_string(&view, src[i].name);
+			quest->description = image_string(&view,
+							  src[i].description);
+			quest->completion_item = image_string(&view,
+							      src[i].completion_item);
+			quest->completion_npc = image_string(&view,
+							     src[i].completion_npc);
+			quest->completion_room = image_string(&view,
+							      src[i].completion_room);
+			quest->completion_message = image_string(&view,
+								 src[i].completion_message);
+			quest->completion_check = image_string(&view,
+							       src[i].completion_check);
+			quest->failure_condition = image_string(&view,
+								src[i].failure_condition);
+			quest->completion_code = SCRIPT_NONE;
+			quest->failure_code = SCRIPT_NONE;
+			quest->required = src[i].required;
+		}
+	}
+
+	add_log_entry("Mapped story image %s: %d rooms, %d items, %d NPCs, "
+		      "%d quests at %s", image_path, story->room_count,
+		      story->item_count, story->npc_count, story->quest_count,
+		      log_timestamp());
+	log_function_exit(__func__, 1);
+	return story;
+
+fail:
+	log_function_error(__func__, "Out of memory building story from image");
+	if (story) {
+		free_story(story);
+	} else {
+		platform_unmap_file(data, size, mapped);
+	}
+	return NULL;
+}
+
+
+/**
+ * story_image_release() - Unmap the image backing a story
+ * @story: Story loaded with story_image_load()
+ *
+ * Return: void
+ */
+
+void story_image_release(Story *story)
+{
+	if (!story || !story->image)
+		return;
+
+	platform_unmap_file(story->image, story->image_size,
+			    story->image_mapped);
+
+	story->image = NULL;
+	story->image_size = 0;
+}
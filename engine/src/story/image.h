@@ -0,0 +1,73 @@
+/*
+ * image.h - Compiled binary story images
+ *
+ * A story image is a single file produced by "adventure --compile"
+ * holding a string table and fixed-layout entity tables, so a story
+ * can be loaded without parsing any .ini text.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_IMAGE_H
+#define STORY_IMAGE_H
+
+#include <stdbool.h>
+
+#include "story.h"
+
+
+/**
+ * story_image_compile() - Compile a story directory into a binary image
+ * @story_dir: Directory holding story.ini, rooms.ini, items.ini, ...
+ * @image_path: File to write the image to
+ *
+ * Loads the story from its .ini files and writes it as one file.
+ * References are kept by ID and linked when the image is loaded, so
+ * dangling ones are reported the same way they are for .ini stories.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_image_compile(const char *story_dir, const char *image_path);
+
+
+/**
+ * story_image_is_current() - Check an image is newer than its sources
+ * @story_dir: Directory the image was compiled from
+ * @image_path: Compiled image
+ *
+ * Return: true if @image_path exists and no story .ini file in
+ * @story_dir was modified after it
+ */
+
+bool story_image_is_current(const char *story_dir, const char *image_path);
+
+
+/**
+ * story_image_load() - Map a compiled image and build a Story from it
+ * @image_path: Compiled image
+ *
+ * Maps the image read-only and points the story's strings and lists
+ * straight at its string table. Images written by a different engine version or on
+ * a machine with different byte order are rejected.
+ *
+ * Return: Story structure, NULL if the image is missing or invalid
+ */
+
+Story *story_image_load(const char *image_path);
+
+
+/**
+ * story_image_release() - Unmap the image backing a story
+ * @story: Story loaded with story_image_load()
+ *
+ * Called by free_story(). Does nothing for stories loaded from .ini.
+ *
+ * Return: void
+ */
+
+void story_image_release(Story *story);
+
+
+#endif /* STORY_IMAGE_H */
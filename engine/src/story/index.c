@@ -0,0 +1,361 @@
+/*
+ * index.c - Perfect hash indexes over story entity IDs
+ *
+ * Hash-and-displace construction: every key hashes to a bucket, and
+ * each bucket gets a displacement value chosen so that all of its keys
+ * land in distinct free slots. Buckets are placed largest first, which
+ * keeps the search short. A lookup is then
+ *
+ *   h    = hash(id)
+ *   d    = displace[bucket(h)]
+ *   slot = slot_of(h, d)
+ *
+ * followed by one strcmp() against the entity in that slot.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "index.h"
+#include "core/logger.h"
+
+
+#define INDEX_EMPTY		UINT32_MAX
+#define INDEX_KEYS_PER_BUCKET	4	/* Average bucket size */
+#define INDEX_MAX_DISPLACE	(1u << 16)	/* Tries per bucket before reseeding */
+#define INDEX_MAX_SEEDS		32	/* Reseeds before giving up */
+
+
+/**
+ * index_hash() - 64-bit FNV-1a hash of an ID
+ * @id: NUL terminated ID
+ * @seed: Seed mixed into the offset basis
+ *
+ * Return: Hash value
+ */
+
+static uint64_t index_hash(const char *id, uint64_t seed)
+{
+	uint64_t hash = 14695981039346656037ull ^ seed;
+
+	while (*id) {
+		hash ^= (unsigned char)*id++;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+
+/**
+ * index_mix() - Finaliser that spreads a hash for a displacement
+ * @hash: Key hash
+ * @displace: Bucket displacement
+ *
+ * Return: Well mixed 64-bit value
+ */
+
+static uint64_t index_mix(uint64_t hash, uint32_t displace)
+{
+	hash ^= (uint64_t)displace * 0x9e3779b97f4a7c15ull;
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+
+static uint32_t index_bucket(const StoryIndex *index, uint64_t hash)
+{
+	return (uint32_t)((hash >> 32) % index->bucket_count);
+}
+
+
+static uint32_t index_slot(const StoryIndex *index, uint64_t hash,
+			   uint32_t displace)
+{
+	return (uint32_t)(index_mix(hash, displace) % index->slot_count);
+}
+
+
+static const char *index_id(const StoryIndex *index, uint32_t entity)
+{
+	const char *entry = index->base + (size_t)entity * index->stride;
+
+	return *(const char *const *)(entry + index->id_offset);
+}
+
+
+/**
+ * index_unique() - Drop duplicate IDs, keeping the first definition
+ * @index: Index being built (base, stride and id_offset set)
+ * @count: Number of entities
+ * @keys: Array to receive the entity indices of unique IDs
+ * @what: Entity kind for log messages
+ *
+ * Return: Number of unique IDs, -ENOMEM on allocation failure
+ */
+
+static int index_unique(const StoryIndex *index, int count, uint32_t *keys,
+			const char *what)
+{
+	uint32_t capacity = 16;
+	uint32_t *table;
+	int unique = 0;
+	int i;
+
+	while (capacity < (uint32_t)count * 2)
+		capacity *= 2;
+
+	table = malloc(capacity * sizeof(uint32_t));
+	if (!table)
+		return -ENOMEM;
+	memset(table, 0xff, capacity * sizeof(uint32_t));
+
+	for (i = 0; i < count; i++) {
+		const char *id = index_id(index, (uint32_t)i);
+		uint32_t pos = (uint32_t)index_hash(id, 0) & (capacity - 1);
+
+		while (table[pos] != INDEX_EMPTY &&
+		       strcmp(index_id(index, table[pos]), id) != 0)
+			pos = (pos + 1) & (capacity - 1);
+
+		if (table[pos] != INDEX_EMPTY) {
+			add_log_entry("Duplicate %s id '%s' (entry %d) ignored, "
+				      "first definition is entry %u",
+				      what, id, i, table[pos]);
+			continue;
+		}
+
+		table[pos] = (uint32_t)i;
+		keys[unique++] = (uint32_t)i;
+	}
+
+	free(table);
+	return unique;
+}
+
+
+/**
+ * index_place() - Try to place every bucket with the current seed
+ * @index: Index with seed, sizes and arrays allocated
+ * @keys: Entity indices of unique IDs
+ * @hashes: Hash of each key under the current seed
+ * @count: Number of keys
+ * @order: Scratch, @count entries
+ * @bucket_start: Scratch, @bucket_count + 1 entries
+ *
+ * Return: true if every key found a slot
+ */
+
+static bool index_place(StoryIndex *index, const uint32_t *keys,
+			const uint64_t *hashes, uint32_t count,
+			uint32_t *order, uint32_t *bucket_start)
+{
+	uint32_t *bucket_order = NULL;
+	uint32_t *size_start = NULL;
+	uint32_t max_size = 0;
+	uint32_t b, k;
+	bool ok = false;
+
+	memset(bucket_start, 0, (index->bucket_count + 1) * sizeof(uint32_t));
+	memset(index->slots, 0xff, index->slot_count * sizeof(uint32_t));
+	memset(index->displace, 0, index->bucket_count * sizeof(uint32_t));
+
+	/* Counting sort keys by bucket */
+	for (k = 0; k < count; k++)
+		bucket_start[index_bucket(index, hashes[k]) + 1]++;
+	for (b = 0; b < index->bucket_count; b++) {
+		if (bucket_start[b + 1] > max_size)
+			max_size = bucket_start[b + 1];
+		bucket_start[b + 1] += bucket_start[b];
+	}
+	{
+		uint32_t *fill = malloc(index->bucket_count * sizeof(uint32_t));
+
+		if (!fill)
+			return false;
+		memcpy(fill, bucket_start, index->bucket_count * sizeof(uint32_t));
+		for (k = 0; k < count; k++)
+			order[fill[index_bucket(index, hashes[k])]++] = k;
+		free(fill);
+	}
+
+	/* Counting sort buckets by size, largest placed first */
+	bucket_order = malloc(index->bucket_count * sizeof(uint32_t));
+	size_start = calloc(max_size + 2, sizeof(uint32_t));
+	if (!bucket_order || !size_start)
+		goto out;
+
+	for (b = 0; b < index->bucket_count; b++)
+		size_start[max_size - (bucket_start[b + 1] - bucket_start[b]) + 1]++;
+	for (k = 0; k <= max_size; k++)
+		size_start[k + 1] += size_start[k];
+	for (b = 0; b < index->bucket_count; b++)
+		bucket_order[size_start[max_size -
+			     (bucket_start[b + 1] - bucket_start[b])]++] = b;
+
+	for (b = 0; b < index->bucket_count; b++) {
+		uint32_t bucket = bucket_order[b];
+		uint32_t first = bucket_start[bucket];
+		uint32_t last = bucket_start[bucket + 1];
+		uint32_t displace;
+
+		if (first == last)
+			break;	/* Remaining buckets are empty */
+
+		for (displace = 0; displace < INDEX_MAX_DISPLACE; displace++) {
+			uint32_t placed;
+
+			for (placed = first; placed < last; placed++) {
+				uint32_t slot = index_slot(index,
+							   hashes[order[placed]],
+							   displace);
+
+				if (index->slots[slot] != INDEX_EMPTY)
+					break;
+				index->slots[slot] = keys[order[placed]];
+			}
+			if (placed == last)
+				break;
+
+			/* Collision: undo this attempt */
+			while (placed-- > first) {
+				index->slots[index_slot(index, hashes[order[placed]],
+							displace)] = INDEX_EMPTY;
+			}
+		}
+
+		if (displace == INDEX_MAX_DISPLACE)
+			goto out;
+
+		index->displace[bucket] = displace;
+	}
+
+	ok = true;
+
+out:
+	free(bucket_order);
+	free(size_start);
+	return ok;
+}
+
+
+/**
+ * story_index_build() - Build a perfect hash index over entity IDs
+ * @index: Index to fill in
+ * @arena: Arena for the index tables
+ * @base: First entity
+ * @count: Number of entities
+ * @stride: Size of one entity in bytes
+ * @id_offset: Offset of the ID pointer within an entity
+ * @what: Entity kind for log messages
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_index_build(StoryIndex *index, Arena *arena, const void *base,
+		      int count, size_t stride, size_t id_offset,
+		      const char *what)
+{
+	uint32_t *keys = NULL;
+	uint64_t *hashes = NULL;
+	uint32_t *order = NULL;
+	uint32_t *bucket_start = NULL;
+	uint32_t unique;
+	uint32_t k;
+	int ret = -ENOMEM;
+	int n;
+
+	memset(index, 0, sizeof(*index));
+	index->base = base;
+	index->stride = stride;
+	index->id_offset = id_offset;
+
+	if (!base || count <= 0)
+		return 0;
+
+	keys = malloc((size_t)count * sizeof(uint32_t));
+	if (!keys)
+		return -ENOMEM;
+
+	n = index_unique(index, count, keys, what);
+	if (n < 0)
+		goto out;
+	unique = (uint32_t)n;
+
+	index->bucket_count = unique / INDEX_KEYS_PER_BUCKET + 1;
+	index->slot_count = unique + unique / 4 + 1;
+	index->displace = arena_alloc(arena, index->bucket_count * sizeof(uint32_t));
+	index->slots = arena_alloc(arena, index->slot_count * sizeof(uint32_t));
+	hashes = malloc(unique * sizeof(uint64_t));
+	order = malloc(unique * sizeof(uint32_t));
+	bucket_start = malloc((index->bucket_count + 1) * sizeof(uint32_t));
+	if (!index->displace || !index->slots || !hashes || !order ||
+	    !bucket_start)
+		goto out;
+
+	ret = -EAGAIN;
+	for (index->seed = 0; index->seed < INDEX_MAX_SEEDS; index->seed++) {
+		for (k = 0; k < unique; k++)
+			hashes[k] = index_hash(index_id(index, keys[k]), index->seed);
+
+		if (index_place(index, keys, hashes, unique, order, bucket_start)) {
+			ret = 0;
+			break;
+		}
+	}
+
+	if (ret == 0) {
+		add_log_entry("Indexed %u %s ids (%u buckets, %u slots, seed %llu)",
+			      unique, what, index->bucket_count, index->slot_count,
+			      (unsigned long long)index->seed);
+	}
+
+out:
+	free(keys);
+	free(hashes);
+	free(order);
+	free(bucket_start);
+	if (ret != 0) {
+		log_function_error(__func__, "Failed to build entity index");
+		memset(index, 0, sizeof(*index));
+	}
+	return ret;
+}
+
+
+/**
+ * story_index_find() - Look up an entity by ID
+ * @index: Index to search
+ * @id: ID to look for
+ *
+ * Return: Index of the entity in its array, -1 if not found
+ */
+
+int story_index_find(const StoryIndex *index, const char *id)
+{
+	uint64_t hash;
+	uint32_t entity;
+
+	if (!index || !id || index->slot_count == 0)
+		return -1;
+
+	hash = index_hash(id, index->seed);
+	entity = index->slots[index_slot(index, hash,
+					 index->displace[index_bucket(index, hash)])];
+
+	if (entity == INDEX_EMPTY || strcmp(index_id(index, entity), id) != 0)
+		return -1;
+
+	return (int)entity;
+}
+
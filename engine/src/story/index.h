@@ -0,0 +1,78 @@
+/*
+ * index.h - Perfect hash indexes over story entity IDs
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_INDEX_H
+#define STORY_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/arena.h"
+
+
+/**
+ * struct StoryIndex - Minimal-probe ID lookup for one entity array
+ * @base: First entity in the indexed array
+ * @stride: Size of one entity in bytes
+ * @id_offset: Offset of the entity's ID pointer (const char *)
+ * @seed: Seed for the bucket hash
+ * @bucket_count: Number of displacement buckets
+ * @slot_count: Number of slots
+ * @displace: Per-bucket displacement (@bucket_count entries)
+ * @slots: Slot -> entity index, or UINT32_MAX for an empty slot
+ *
+ * Built with the hash-and-displace method once the ID set is known, so
+ * every lookup is one hash, one slot read and one strcmp() to reject
+ * IDs that are not in the set, however many entities there are.
+ */
+
+typedef struct StoryIndex {
+	const char *base;
+	size_t stride;
+	size_t id_offset;
+	uint64_t seed;
+	uint32_t bucket_count;
+	uint32_t slot_count;
+	uint32_t *displace;
+	uint32_t *slots;
+} StoryIndex;
+
+
+/**
+ * story_index_build() - Build a perfect hash index over entity IDs
+ * @index: Index to fill in
+ * @arena: Arena the index tables are carved from
+ * @base: First entity
+ * @count: Number of entities
+ * @stride: Size of one entity in bytes
+ * @id_offset: Offset of the ID pointer within an entity
+ * @what: Entity kind for log messages ("room", "item", ...)
+ *
+ * Where an ID is defined more than once the first definition wins, as
+ * it did with the linear scans; later duplicates are logged and left
+ * out of the index.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_index_build(StoryIndex *index, Arena *arena, const void *base,
+		      int count, size_t stride, size_t id_offset,
+		      const char *what);
+
+
+/**
+ * story_index_find() - Look up an entity by ID
+ * @index: Index to search
+ * @id: ID to look for
+ *
+ * Return: Index of the entity in its array, -1 if not found
+ */
+
+int story_index_find(const StoryIndex *index, const char *id);
+
+
+#endif /* STORY_INDEX_H */
@@ -5,13 +5,19 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
- #include <ctype.h>
+ #include <errno.h>
  #include <stdio.h>
+ #include <stdlib.h>
  #include <string.h>
 
+ #ifndef _WIN32
+ #include <sys/mman.h>
+ #endif
+
  #include "ini_parser.h"
  #include "core/constants.h"
  #include "core/utils.h"
+ #include "system/platform.h"
 
 
  /**
@@ -129,3 +135,447 @@ int parse_ini_keyvalue(const char* line, char *key, size_t key_size,
 
 
 
+
+
+
+/**
+ * ini_open() - Map an .ini file into memory for tokenizing
+ * @ini: Tokenizer state to initialise
+ * @filepath: Path of file to open
+ *
+ * Maps the whole file read-only and hints the kernel that it will be
+ * read front to back. Empty files and platforms without mmap() take
+ * the heap buffer path instead.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int ini_open(IniFile *ini, const char *filepath)
+{
+    int ret;
+
+    if (!ini || !filepath)
+        return -EINVAL;
+
+    memset(ini, 0, sizeof(*ini));
+
+    ret = platform_map_file(filepath, &ini->data, &ini->size, &ini->mapped);
+    if (ret != 0)
+        return ret;
+
+#ifndef _WIN32
+    if (ini->mapped)
+        madvise((void *)ini->data, ini->size, MADV_SEQUENTIAL);
+#endif
+
+    return 0;
+}
+
+
+/**
+ * ini_close() - Unmap a file opened with ini_open()
+ * @ini: Tokenizer state to release
+ *
+ * Return: void
+ */
+
+void ini_close(IniFile *ini)
+{
+    if (!ini || !ini->data)
+        return;
+
+    platform_unmap_file(ini->data, ini->size, ini->mapped);
+    memset(ini, 0, sizeof(*ini));
+}
+
+
+/**
+ * ini_scan_line() - Find the end of a line and its first '='
+ * @ini: Open tokenizer
+ * @start: Offset of the line's first byte
+ * @equals: Set to the offset of the first '=' before the end of the
+ *          line, or @ini->size if there is none
+ *
+ * Walks the structural masks of each block the line touches, so both
+ * characters come out of one pass over the bytes. The masks of the
+ * block the line ends in are kept for the next line.
+ *
+ * Return: Offset of the line's '\n', or @ini->size on the last line
+ */
+
+static size_t ini_scan_line(IniFile *ini, size_t start, size_t *equals)
+{
+    size_t block = start / INI_SCAN_BLOCK_SIZE;
+    unsigned int skip = (unsigned int)(start % INI_SCAN_BLOCK_SIZE);
+
+    *equals = ini->size;
+
+    while (block * INI_SCAN_BLOCK_SIZE < ini->size) {
+        size_t base = block * INI_SCAN_BLOCK_SIZE;
+        uint64_t newlines;
+        uint64_t found;
+
+        if (ini->scan_block != block + 1) {
+            ini_scan_block(ini->data + base, ini->size - base, &ini->scan);
+            ini->scan_block = block + 1;
+        }
+
+        /* Drop bits before the start of the line */
+        newlines = ini->scan.newlines >> skip << skip;
+        found = ini->scan.equals >> skip << skip;
+
+        if (newlines) {
+            size_t eol = base + ini_scan_first(newlines);
+
+            if (*equals == ini->size && found &&
+                base + ini_scan_first(found) < eol)
+                *equals = base + ini_scan_first(found);
+            return eol;
+        }
+
+        if (*equals == ini->size && found)
+            *equals = base + ini_scan_first(found);
+
+        block++;
+        skip = 0;
+    }
+
+    return ini->size;
+}
+
+
+/**
+ * ini_next() - Fetch the next section or key=value token
+ * @ini: Open tokenizer
+ * @token: Token to fill in
+ *
+ * Walks the buffer one line at a time, finding each line's end and
+ * first '=' with ini_scan_line(). A line is a section header only when
+ * its first non-blank character is '[', so brackets inside values are
+ * left alone.
+ *
+ * Return: 1 if a token was produced, 0 at end of file
+ */
+
+int ini_next(IniFile *ini, IniToken *token)
+{
+    if (!ini || !token || !ini->data)
+        return 0;
+
+    while (ini->pos < ini->size) {
+        const char *start = ini->data + ini->pos;
+        size_t equals;
+        const char *eol = ini->data + ini_scan_line(ini, ini->pos, &equals);
+        const char *mark;
+        IniView line;
+
+        ini->pos = (size_t)(eol - ini->data) + (eol < ini->data + ini->size);
+        ini->line++;
+
+        line.ptr = start;
+        line.len = (size_t)(eol - start);
+        line = ini_view_trim(line);
+
+        /* Skip empty lines and comments */
+        if (line.len == 0 || line.ptr[0] == '#' || line.ptr[0] == ';')
+            continue;
+
+        if (line.ptr[0] == '[') {
+            mark = memchr(line.ptr + 1, ']', line.len - 1);
+            if (!mark)
+                continue;
+
+            token->type = INI_TOKEN_SECTION;
+            token->section.ptr = line.ptr + 1;
+            token->section.len = (size_t)(mark - line.ptr - 1);
+            token->section = ini_view_trim(token->section);
+            token->line = ini->line;
+            return 1;
+        }
+
+        if (equals == ini->size)
+            continue;
+        mark = ini->data + equals;
+
+        token->type = INI_TOKEN_KEYVALUE;
+        token->key.ptr = line.ptr;
+        token->key.len = (size_t)(mark - line.ptr);
+        token->key = ini_view_trim(token->key);
+        token->value.ptr = mark + 1;
+        token->value.len = (size_t)(line.ptr + line.len - mark - 1);
+        token->value = ini_view_trim(token->value);
+        token->line = ini->line;
+        return 1;
+    }
+
+    token->type = INI_TOKEN_END;
+    return 0;
+}
+
+
+/**
+ * ini_view_equals() - Compare a view with a C string
+ * @view: View to compare
+ * @str: NUL terminated string
+ *
+ * Return: true if both hold exactly the same characters
+ */
+
+bool ini_view_equals(IniView view, const char *str)
+{
+    size_t len = strlen(str);
+
+    return view.len == len && memcmp(view.ptr, str, len) == 0;
+}
+
+
+/**
+ * ini_view_has_prefix() - Check whether a view starts with a prefix
+ * @view: View to check
+ * @prefix: NUL terminated prefix
+ *
+ * Return: true if @view begins with @prefix
+ */
+
+bool ini_view_has_prefix(IniView view, const char *prefix)
+{
+    size_t len = strlen(prefix);
+
+    return view.len >= len && memcmp(view.ptr, prefix, len) == 0;
+}
+
+
+/**
+ * ini_view_skip() - Drop characters from the front of a view
+ * @view: View to shorten
+ * @count: Number of characters to drop
+ *
+ * Return: Remaining view (empty if @count exceeds the length)
+ */
+
+IniView ini_view_skip(IniView view, size_t count)
+{
+    if (count > view.len)
+        count = view.len;
+
+    view.ptr += count;
+    view.len -= count;
+    return view;
+}
+
+
+/**
+ * ini_is_space() - isspace() for the "C" locale, without the call
+ * @c: Character to test
+ *
+ * Return: True for space, tab, newline, vertical tab, form feed and CR
+ */
+
+static inline bool ini_is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+
+/**
+ * ini_view_trim() - Strip leading and trailing whitespace from a view
+ * @view: View to trim
+ *
+ * Return: Trimmed view
+ */
+
+IniView ini_view_trim(IniView view)
+{
+    while (view.len > 0 && ini_is_space(view.ptr[0])) {
+        view.ptr++;
+        view.len--;
+    }
+
+    while (view.len > 0 && ini_is_space(view.ptr[view.len - 1]))
+        view.len--;
+
+    return view;
+}
+
+
+/**
+ * ini_view_copy() - Copy a view into a fixed-size buffer
+ * @view: View to copy
+ * @dest: Destination buffer
+ * @dest_size: Size of destination buffer
+ *
+ * Return: Number of characters copied
+ */
+
+size_t ini_view_copy(IniView view, char *dest, size_t dest_size)
+{
+    size_t len = view.len;
+
+    if (!dest || dest_size == 0)
+        return 0;
+
+    if (len >= dest_size)
+        len = dest_size - 1;
+
+    memcpy(dest, view.ptr, len);
+    dest[len] = '\0';
+    return len;
+}
+
+
+/**
+ * ini_view_strdup() - Copy a view into an arena as a C string
+ * @arena: Arena to allocate from
+ * @view: View to copy
+ *
+ * Return: NUL terminated copy, or NULL on allocation failure
+ */
+
+char *ini_view_strdup(Arena *arena, IniView view)
+{
+    return arena_strndup(arena, view.ptr, view.len);
+}
+
+
+/**
+ * ini_view_text() - Copy a view into an arena as story text
+ * @arena: Arena to allocate from
+ * @view: View to copy
+ *
+ * Return: NUL terminated copy, "" on allocation failure
+ */
+
+const char *ini_view_text(Arena *arena, IniView view)
+{
+    const char *text = arena_strndup(arena, view.ptr, view.len);
+
+    return text ? text : "";
+}
+
+
+/**
+ * ini_view_to_int() - Parse a view as a decimal integer
+ * @view: View holding the number
+ *
+ * Views are not NUL terminated, so the digits are staged in a small
+ * stack buffer before handing them to atoi().
+ *
+ * Return: Parsed value, 0 if the view is not a number
+ */
+
+int ini_view_to_int(IniView view)
+{
+    char number[INI_NUMBER_SIZE];
+
+    ini_view_copy(view, number, sizeof(number));
+    return atoi(number);
+}
+
+
+/**
+ * ini_view_to_float() - Parse a view as a floating point number
+ * @view: View holding the number
+ *
+ * Return: Parsed value, 0.0 if the view is not a number
+ */
+
+float ini_view_to_float(IniView view)
+{
+    char number[INI_NUMBER_SIZE];
+
+    ini_view_copy(view, number, sizeof(number));
+    return (float)atof(number);
+}
+
+
+/**
+ * ini_view_to_bool() - Interpret a view as an .ini boolean
+ * @view: View holding the value
+ *
+ * Return: true only for the literal "true"
+ */
+
+bool ini_view_to_bool(IniView view)
+{
+    return ini_view_equals(view, "true");
+}
+
+
+/**
+ * ini_split_element() - Copy one list element, trimmed
+ * @arena: Arena the string is carved from
+ * @start: First character of the element
+ * @end: Character after the element (the comma, or the end of the list)
+ * @slot: Where to store the string
+ *
+ * Return: 1 if an element was stored, 0 if it was blank or out of memory
+ */
+
+static int ini_split_element(Arena *arena, const char *start, const char *end,
+                             char **slot)
+{
+    IniView element = { start, (size_t)(end - start) };
+
+    element = ini_view_trim(element);
+    if (element.len == 0)
+        return 0;
+
+    *slot = ini_view_strdup(arena, element);
+    return *slot ? 1 : 0;
+}
+
+
+/**
+ * ini_split_list() - Split a comma-separated value into trimmed strings
+ * @value: View holding the list
+ * @arena: Arena the array and strings are carved from
+ * @list_out: Pointer to store the array of strings
+ *
+ * Return: Number of elements stored, 0 if empty or error
+ */
+
+int ini_split_list(IniView value, Arena *arena, char ***list_out)
+{
+    const char *end = value.ptr + value.len;
+    const char *p;
+    IniScanMasks masks;
+    char **list;
+    int count = 1;
+    int i = 0;
+
+    *list_out = NULL;
+
+    if (value.len == 0)
+        return 0;
+
+    /* Count commas a block at a time to size the array */
+    for (size_t at = 0; at < value.len; at += INI_SCAN_BLOCK_SIZE) {
+        ini_scan_block(value.ptr + at, value.len - at, &masks);
+        count += (int)ini_scan_count(masks.commas);
+    }
+
+    list = arena_alloc(arena, sizeof(char *) * count);
+    if (!list)
+        return 0;
+
+    /* Split at each comma the masks mark */
+    p = value.ptr;
+    for (size_t at = 0; at < value.len; at += INI_SCAN_BLOCK_SIZE) {
+        uint64_t commas;
+
+        ini_scan_block(value.ptr + at, value.len - at, &masks);
+        for (commas = masks.commas; commas; commas &= commas - 1) {
+            const char *comma = value.ptr + at + ini_scan_first(commas);
+
+            i += ini_split_element(arena, p, comma, &list[i]);
+            p = comma + 1;
+        }
+    }
+    i += ini_split_element(arena, p, end, &list[i]);
+
+    if (i == 0)
+        return 0;
+
+    *list_out = list;
+    return i;
+}
@@ -5,12 +5,84 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
-#ifndef STORY_INI_PARSER_H 
+#ifndef STORY_INI_PARSER_H
 #define STORY_INI_PARSER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "core/arena.h"
 #include "core/constants.h"
 #include "core/utils.h"
+#include "ini_scan.h"
+
+
+/**
+ * struct IniView - Non-owning view into a loaded .ini file
+ * @ptr: First character of the view (NOT NUL terminated)
+ * @len: Number of characters in the view
+ *
+ * Views point straight into the mapped file, so they stay valid until
+ * the owning IniFile is closed. Copy anything that must outlive it.
+ */
+
+typedef struct {
+	const char *ptr;
+	size_t len;
+} IniView;
+
+
+/**
+ * enum IniTokenType - Kinds of token returned by ini_next()
+ * @INI_TOKEN_END: No more tokens in the file
+ * @INI_TOKEN_SECTION: "[SECTION]" or "[TYPE:id]" header
+ * @INI_TOKEN_KEYVALUE: "key = value" line
+ */
+
+typedef enum {
+	INI_TOKEN_END,
+	INI_TOKEN_SECTION,
+	INI_TOKEN_KEYVALUE
+} IniTokenType;
+
+
+/**
+ * struct IniToken - One structural token from an .ini file
+ * @type: Kind of token
+ * @section: Section name between the brackets (INI_TOKEN_SECTION)
+ * @key: Trimmed key (INI_TOKEN_KEYVALUE)
+ * @value: Trimmed value (INI_TOKEN_KEYVALUE)
+ * @line: 1-based line number the token came from
+ */
+
+typedef struct {
+	IniTokenType type;
+	IniView section;
+	IniView key;
+	IniView value;
+	int line;
+} IniToken;
+
+
+/**
+ * struct IniFile - Memory-mapped .ini file being tokenized
+ * @data: Start of file contents
+ * @size: Size of file contents in bytes
+ * @pos: Offset of the next unread byte (may be set to seek to a line)
+ * @line: Number of lines consumed so far
+ * @mapped: True if @data is an mmap() region, false if heap allocated
+ * @scan_block: Block @scan describes, plus one (0 before the first)
+ * @scan: Structural characters of the block ini_next() is in
+ */
+
+typedef struct {
+	const char *data;
+	size_t size;
+	size_t pos;
+	int line;
+	bool mapped;
+	size_t scan_block;
+	IniScanMasks scan;
+} IniFile;
 
 
 /**
@@ -18,7 +90,7 @@
  * @line: String read from .ini file
  * @section: Buffer to store section name
  * @section_size: Size of section buffer
- * 
+ *
  * Parses a line in "[SECTION]" or "[TYPE:id]" format.
  * Extracts the content between brackets.
  *
@@ -35,17 +107,187 @@ int parse_ini_section(const char *line, char *section, size_t section_size);
   * @key_size: Size of key buffer
   * @value: Buffer to store value
   * @value_size: Size of value buffer
-  * 
+  *
   * Parses a line in "key = value" format. Trims whitespace from
   * both key and value. Modifies buffers in place.
   *
   * Return: 1 if successfully parsed, 0 otherwise
   */
- 
+
 int parse_ini_keyvalue(const char *line, char *key, size_t key_size, char *value, size_t value_size);
 
 
+/**
+ * ini_open() - Map an .ini file into memory for tokenizing
+ * @ini: Tokenizer state to initialise
+ * @filepath: Path of file to open
+ *
+ * Maps the whole file read-only so ini_next() can hand out views
+ * without copying lines. Falls back to a single read into a heap
+ * buffer on platforms without mmap().
+ *
+ * Return: 0 on success, negative errno on failure
+ */
 
+int ini_open(IniFile *ini, const char *filepath);
 
-#endif /* STORY_INI_PARSER_H */
 
+/**
+ * ini_close() - Unmap a file opened with ini_open()
+ * @ini: Tokenizer state to release
+ *
+ * Invalidates every view handed out for this file. Safe to call on
+ * a zeroed or already closed IniFile.
+ *
+ * Return: void
+ */
+
+void ini_close(IniFile *ini);
+
+
+/**
+ * ini_next() - Fetch the next section or key=value token
+ * @ini: Open tokenizer
+ * @token: Token to fill in
+ *
+ * Skips blank lines, comments ('#' or ';') and lines that are neither
+ * a section header nor contain '='. There is no line length limit.
+ *
+ * Return: 1 if a token was produced, 0 at end of file
+ */
+
+int ini_next(IniFile *ini, IniToken *token);
+
+
+/**
+ * ini_view_equals() - Compare a view with a C string
+ * @view: View to compare
+ * @str: NUL terminated string
+ *
+ * Return: true if both hold exactly the same characters
+ */
+
+bool ini_view_equals(IniView view, const char *str);
+
+
+/**
+ * ini_view_has_prefix() - Check whether a view starts with a prefix
+ * @view: View to check
+ * @prefix: NUL terminated prefix
+ *
+ * Return: true if @view begins with @prefix
+ */
+
+bool ini_view_has_prefix(IniView view, const char *prefix);
+
+
+/**
+ * ini_view_skip() - Drop characters from the front of a view
+ * @view: View to shorten
+ * @count: Number of characters to drop
+ *
+ * Return: Remaining view (empty if @count exceeds the length)
+ */
+
+IniView ini_view_skip(IniView view, size_t count);
+
+
+/**
+ * ini_view_trim() - Strip leading and trailing whitespace from a view
+ * @view: View to trim
+ *
+ * Return: Trimmed view
+ */
+
+IniView ini_view_trim(IniView view);
+
+
+/**
+ * ini_view_copy() - Copy a view into a fixed-size buffer
+ * @view: View to copy
+ * @dest: Destination buffer
+ * @dest_size: Size of destination buffer
+ *
+ * Copies at most dest_size-1 characters and always NUL terminates.
+ *
+ * Return: Number of characters copied
+ */
+
+size_t ini_view_copy(IniView view, char *dest, size_t dest_size);
+
+
+/**
+ * ini_view_strdup() - Copy a view into an arena as a C string
+ * @arena: Arena to allocate from
+ * @view: View to copy
+ *
+ * Return: NUL terminated copy, or NULL on allocation failure
+ */
+
+char *ini_view_strdup(Arena *arena, IniView view);
+
+
+/**
+ * ini_view_text() - Copy a view into an arena as story text
+ * @arena: Arena to allocate from
+ * @view: View to copy
+ *
+ * For IDs, names and descriptions, which are printed and compared
+ * without NULL checks: running out of memory yields "" rather than
+ * NULL. The copy is exactly as long as @view.
+ *
+ * Return: NUL terminated copy, "" on allocation failure
+ */
+
+const char *ini_view_text(Arena *arena, IniView view);
+
+
+/**
+ * ini_view_to_int() - Parse a view as a decimal integer
+ * @view: View holding the number
+ *
+ * Return: Parsed value, 0 if the view is not a number
+ */
+
+int ini_view_to_int(IniView view);
+
+
+/**
+ * ini_view_to_float() - Parse a view as a floating point number
+ * @view: View holding the number
+ *
+ * Return: Parsed value, 0.0 if the view is not a number
+ */
+
+float ini_view_to_float(IniView view);
+
+
+/**
+ * ini_view_to_bool() - Interpret a view as an .ini boolean
+ * @view: View holding the value
+ *
+ * Return: true only for the literal "true"
+ */
+
+bool ini_view_to_bool(IniView view);
+
+
+/**
+ * ini_split_list() - Split a comma-separated value into trimmed strings
+ * @value: View holding the list (e.g. "north:hall, south:yard")
+ * @arena: Arena the array and strings are carved from
+ * @list_out: Pointer to store the array of strings
+ *
+ * Splits straight from the mapped file with no intermediate buffer,
+ * so lists have no length limit. Empty elements are skipped. Nothing
+ * needs freeing apart from the arena itself.
+ *
+ * Return: Number of elements stored, 0 if empty or error
+ */
+
+int ini_split_list(IniView value, Arena *arena, char ***list_out);
+
+
+
+
+#endif /* STORY_INI_PARSER_H */
@@ -0,0 +1,263 @@
+/*
+ * ini_scan.c - Find the structural characters of an .ini buffer
+ *
+ * Each kernel compares a 64-byte block against '\n', '=' and ',' and
+ * packs the results into one bit per byte, so the tokenizer finds line
+ * ends and separators by counting zero bits instead of testing bytes.
+ * The SIMD kernels are compiled with per-function target attributes
+ * and chosen at run time, so one build runs on any x86 CPU.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <string.h>
+
+#include "ini_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INI_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+
+typedef void (*IniScanFn)(const char *block, IniScanMasks *masks);
+
+
+/**
+ * scan_scalar() - Classify a block one byte at a time
+ * @block: INI_SCAN_BLOCK_SIZE bytes
+ * @masks: Filled in
+ *
+ * Return: void
+ */
+
+static void scan_scalar(const char *block, IniScanMasks *masks)
+{
+	uint64_t newlines = 0;
+	uint64_t equals = 0;
+	uint64_t commas = 0;
+
+	for (int i = 0; i < INI_SCAN_BLOCK_SIZE; i++) {
+		uint64_t bit = (uint64_t)1 << i;
+
+		newlines |= block[i] == '\n' ? bit : 0;
+		equals |= block[i] == '=' ? bit : 0;
+		commas |= block[i] == ',' ? bit : 0;
+	}
+
+	masks->newlines = newlines;
+	masks->equals = equals;
+	masks->commas = commas;
+}
+
+
+#ifdef INI_SCAN_X86
+
+/**
+ * scan_sse2() - Classify a block 16 bytes at a time
+ * @block: INI_SCAN_BLOCK_SIZE bytes
+ * @masks: Filled in
+ *
+ * Return: void
+ */
+
+__attribute__((target("sse2")))
+static void scan_sse2(const char *block, IniScanMasks *masks)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i equals = _mm_set1_epi8('=');
+	const __m128i comma = _mm_set1_epi8(',');
+	uint64_t n = 0;
+	uint64_t e = 0;
+	uint64_t c = 0;
+
+	for (int i = 0; i < 4; i++) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+		int shift = 16 * i;
+
+		n |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(bytes, newline)) << shift;
+		e |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(bytes, equals)) << shift;
+		c |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(bytes, comma)) << shift;
+	}
+
+	masks->newlines = n;
+	masks->equals = e;
+	masks->commas = c;
+}
+
+
+/**
+ * scan_avx2() - Classify a block 32 bytes at a time
+ * @block: INI_SCAN_BLOCK_SIZE bytes
+ * @masks: Filled in
+ *
+ * Return: void
+ */
+
+__attribute__((target("avx2")))
+static void scan_avx2(const char *block, IniScanMasks *masks)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+	const __m256i equals = _mm256_set1_epi8('=');
+	const __m256i comma = _mm256_set1_epi8(',');
+	__m256i lo = _mm256_loadu_si256((const __m256i *)block);
+	__m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+	masks->newlines =
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(lo, newline)) |
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(hi, newline)) << 32;
+	masks->equals =
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(lo, equals)) |
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(hi, equals)) << 32;
+	masks->commas =
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(lo, comma)) |
+		(uint64_t)(uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(hi, comma)) << 32;
+}
+
+#endif /* INI_SCAN_X86 */
+
+
+static const IniScanFn scan_kernels[INI_SCAN_KERNEL_COUNT] = {
+	[INI_SCAN_SCALAR] = scan_scalar,
+#ifdef INI_SCAN_X86
+	[INI_SCAN_SSE2] = scan_sse2,
+	[INI_SCAN_AVX2] = scan_avx2,
+#endif
+};
+
+static const char *const scan_kernel_names[INI_SCAN_KERNEL_COUNT] = {
+	[INI_SCAN_SCALAR] = "scalar",
+	[INI_SCAN_SSE2] = "sse2",
+	[INI_SCAN_AVX2] = "avx2",
+};
+
+/* Chosen kernel plus one; 0 until first use. The loader's threads may
+ * race to choose, which is harmless since they all choose the same. */
+static int scan_kernel_chosen;
+
+
+/**
+ * scan_supported() - Can this CPU run a kernel
+ * @kernel: Kernel to check
+ *
+ * Return: True if it can
+ */
+
+static bool scan_supported(IniScanKernel kernel)
+{
+	if ((unsigned int)kernel >= INI_SCAN_KERNEL_COUNT ||
+	    !scan_kernels[kernel])
+		return false;
+
+#ifdef INI_SCAN_X86
+	__builtin_cpu_init();
+	if (kernel == INI_SCAN_SSE2)
+		return __builtin_cpu_supports("sse2");
+	if (kernel == INI_SCAN_AVX2)
+		return __builtin_cpu_supports("avx2");
+#endif
+	return true;
+}
+
+
+/**
+ * ini_scan_kernel() - Kernel ini_scan_block() is using
+ *
+ * Return: The kernel
+ */
+
+IniScanKernel ini_scan_kernel(void)
+{
+#ifdef INI_SCAN_X86
+	int chosen = __atomic_load_n(&scan_kernel_chosen, __ATOMIC_RELAXED);
+
+	if (chosen == 0) {
+		IniScanKernel best = INI_SCAN_SCALAR;
+
+		if (scan_supported(INI_SCAN_AVX2))
+			best = INI_SCAN_AVX2;
+		else if (scan_supported(INI_SCAN_SSE2))
+			best = INI_SCAN_SSE2;
+
+		chosen = (int)best + 1;
+		__atomic_store_n(&scan_kernel_chosen, chosen, __ATOMIC_RELAXED);
+	}
+	return (IniScanKernel)(chosen - 1);
+#else
+	return scan_kernel_chosen ? (IniScanKernel)(scan_kernel_chosen - 1) :
+				    INI_SCAN_SCALAR;
+#endif
+}
+
+
+/**
+ * ini_scan_set_kernel() - Choose the kernel ini_scan_block() uses
+ * @kernel: Kernel to use
+ *
+ * Return: False if the CPU cannot run @kernel
+ */
+
+bool ini_scan_set_kernel(IniScanKernel kernel)
+{
+	if (!scan_supported(kernel))
+		return false;
+
+#ifdef INI_SCAN_X86
+	__atomic_store_n(&scan_kernel_chosen, (int)kernel + 1, __ATOMIC_RELAXED);
+#else
+	scan_kernel_chosen = (int)kernel + 1;
+#endif
+	return true;
+}
+
+
+/**
+ * ini_scan_kernel_name() - Name of a kernel, for reports
+ * @kernel: Kernel
+ *
+ * Return: Kernel name, "" if unknown
+ */
+
+const char *ini_scan_kernel_name(IniScanKernel kernel)
+{
+	return (unsigned int)kernel < INI_SCAN_KERNEL_COUNT ?
+	       scan_kernel_names[kernel] : "";
+}
+
+
+/**
+ * ini_scan_block() - Classify up to one block of bytes
+ * @data: First byte
+ * @len: Bytes to classify
+ * @masks: Filled in
+ *
+ * A short block is copied into a zeroed buffer first, so the kernels
+ * always read whole blocks and never past the end of the data.
+ *
+ * Return: void
+ */
+
+void ini_scan_block(const char *data, size_t len, IniScanMasks *masks)
+{
+	IniScanFn scan = scan_kernels[ini_scan_kernel()];
+	char padded[INI_SCAN_BLOCK_SIZE];
+
+	if (len >= INI_SCAN_BLOCK_SIZE) {
+		scan(data, masks);
+		return;
+	}
+
+	memset(padded, 0, sizeof(padded));
+	memcpy(padded, data, len);
+	scan(padded, masks);
+}
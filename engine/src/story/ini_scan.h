@@ -0,0 +1,140 @@
+/*
+ * ini_scan.h - Find the structural characters of an .ini buffer
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_INI_SCAN_H
+#define STORY_INI_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Bytes classified at once: one bit per byte in a 64-bit mask */
+#define INI_SCAN_BLOCK_SIZE 64
+
+
+/**
+ * enum IniScanKernel - Ways of classifying a block
+ * @INI_SCAN_SCALAR: One byte at a time, on any platform
+ * @INI_SCAN_SSE2: Four 16-byte compares (x86)
+ * @INI_SCAN_AVX2: Two 32-byte compares (x86 with AVX2)
+ * @INI_SCAN_KERNEL_COUNT: Number of kernels
+ */
+
+typedef enum {
+	INI_SCAN_SCALAR,
+	INI_SCAN_SSE2,
+	INI_SCAN_AVX2,
+	INI_SCAN_KERNEL_COUNT
+} IniScanKernel;
+
+
+/**
+ * struct IniScanMasks - Structural characters in one block
+ * @newlines: Bit n set where byte n is '\n'
+ * @equals: Bit n set where byte n is '='
+ * @commas: Bit n set where byte n is ','
+ */
+
+typedef struct {
+	uint64_t newlines;
+	uint64_t equals;
+	uint64_t commas;
+} IniScanMasks;
+
+
+/**
+ * ini_scan_block() - Classify up to one block of bytes
+ * @data: First byte
+ * @len: Bytes to classify; those past INI_SCAN_BLOCK_SIZE are ignored
+ * @masks: Filled in; bits at and beyond @len are clear
+ *
+ * Uses the fastest kernel the CPU supports unless ini_scan_set_kernel()
+ * chose another. Never reads past @data + @len.
+ *
+ * Return: void
+ */
+
+void ini_scan_block(const char *data, size_t len, IniScanMasks *masks);
+
+
+/**
+ * ini_scan_set_kernel() - Choose the kernel ini_scan_block() uses
+ * @kernel: Kernel to use
+ *
+ * For benchmarks and tests; the default is picked on first use.
+ *
+ * Return: False (and nothing changed) if the CPU cannot run @kernel
+ */
+
+bool ini_scan_set_kernel(IniScanKernel kernel);
+
+
+/**
+ * ini_scan_kernel() - Kernel ini_scan_block() is using
+ *
+ * Return: The kernel
+ */
+
+IniScanKernel ini_scan_kernel(void);
+
+
+/**
+ * ini_scan_kernel_name() - Name of a kernel, for reports
+ * @kernel: Kernel
+ *
+ * Return: "scalar", "sse2" or "avx2"
+ */
+
+const char *ini_scan_kernel_name(IniScanKernel kernel);
+
+
+/**
+ * ini_scan_first() - Position of the lowest set bit
+ * @mask: Non-zero mask
+ *
+ * Return: Bit number, 0 to 63
+ */
+
+static inline unsigned int ini_scan_first(uint64_t mask)
+{
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctzll(mask);
+#else
+	unsigned int n = 0;
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+
+/**
+ * ini_scan_count() - Number of set bits
+ * @mask: Mask
+ *
+ * Return: Bits set, 0 to 64
+ */
+
+static inline unsigned int ini_scan_count(uint64_t mask)
+{
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_popcountll(mask);
+#else
+	unsigned int n = 0;
+
+	for (; mask; mask &= mask - 1)
+		n++;
+	return n;
+#endif
+}
+
+
+#endif /* STORY_INI_SCAN_H */
@@ -0,0 +1,453 @@
+/*
+ * link.c - Resolve story cross-references after loading
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "link.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "ui/colors.h"
+#include "world/rooms.h"
+
+
+/**
+ * struct LinkReport - Dangling references found while linking
+ * @count: Number found so far
+ * @quiet: Log them without printing (rooms linked during play)
+ */
+
+typedef struct {
+	int count;
+	bool quiet;
+} LinkReport;
+
+
+/**
+ * link_dangling() - Report one reference to something that is not defined
+ * @report: Running report
+ * @owner_kind: Kind of entity holding the reference ("room", "NPC", ...)
+ * @owner_id: ID of that entity
+ * @field: What the reference is ("exit north", "item", ...)
+ * @target: ID that could not be found
+ *
+ * Every reference is logged; only the first LINK_MAX_REPORTED are
+ * printed so a badly broken story does not flood the console.
+ *
+ * Return: void
+ */
+
+static void link_dangling(LinkReport *report, const char *owner_kind,
+			  const char *owner_id, const char *field,
+			  const char *target)
+{
+	report->count++;
+
+	add_log_entry("Dangling reference: %s '%s' %s '%s' does not exist",
+		      owner_kind, owner_id, field, target);
+
+	if (!report->quiet && report->count <= LINK_MAX_REPORTED) {
+		printf_colored(COLOR_WARNING,
+			       "WARNING: %s '%s' %s '%s' does not exist\n",
+			       owner_kind, owner_id, field, target);
+	}
+}
+
+
+/**
+ * link_room() - Resolve a room ID
+ * @story: Story being linked
+ * @id: Room ID
+ * @found: Set to whether the story defines the room
+ *
+ * Rooms of a streamed story come and go, so only those loaded right now
+ * are returned; the rest stay NULL until room_exit() fetches them.
+ *
+ * Return: The room, NULL if it is not defined or not loaded
+ */
+
+static Room *link_room(Story *story, const char *id, bool *found)
+{
+	int i = story_index_find(&story->room_index, id);
+
+	*found = i >= 0;
+	if (i < 0)
+		return NULL;
+	return story->stream.enabled ? story->stream.slots[i].room :
+				       &story->rooms[i];
+}
+
+
+static Item *link_item(Story *story, const char *id)
+{
+	int i = story_index_find(&story->item_index, id);
+
+	return i >= 0 ? &story->items[i] : NULL;
+}
+
+
+static NPC *link_npc(Story *story, const char *id)
+{
+	int i = story_index_find(&story->npc_index, id);
+
+	return i >= 0 ? &story->npcs[i] : NULL;
+}
+
+
+/**
+ * link_dialog_target() - Resolve where a dialog transition goes
+ * @story: Story being linked
+ * @owner_id: Dialog node holding the reference
+ * @field: What the reference is ("next 2", "auto_continue", ...)
+ * @id: Dialog ID, dialog_end or dialog_repeat
+ * @report: Running report
+ *
+ * Return: Node index, DIALOG_END or DIALOG_REPEAT; a node that does
+ * not exist ends the conversation
+ */
+
+static int link_dialog_target(Story *story, const char *owner_id,
+			      const char *field, const char *id,
+			      LinkReport *report)
+{
+	int i;
+
+	if (id[0] == '\0' || strcmp(id, "dialog_end") == 0)
+		return DIALOG_END;
+	if (strcmp(id, "dialog_repeat") == 0)
+		return DIALOG_REPEAT;
+
+	i = story_index_find(&story->dialog_index, id);
+	if (i < 0) {
+		link_dangling(report, "dialog", owner_id, field, id);
+		return DIALOG_END;
+	}
+	return i;
+}
+
+
+/**
+ * link_rooms() - Resolve exits and the item and NPC lists of rooms
+ * @story: Story being linked
+ * @rooms: Rooms to link
+ * @count: Number of entries in @rooms
+ * @arena: Arena the lists are carved from
+ * @report: Running report
+ *
+ * The NPC and item lists of every room slice into one arena block
+ * each. An item list that outgrows its slice when something is dropped
+ * moves to fresh arena memory with arena_grow().
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure
+ */
+
+static int link_rooms(Story *story, Room *rooms, int count, Arena *arena,
+		      LinkReport *report)
+{
+	size_t npc_total = 0;
+	size_t item_total = 0;
+	NPC **npc_next;
+	Item **item_next;
+	bool found;
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		npc_total += (size_t)rooms[i].npc_id_count;
+		item_total += (size_t)rooms[i].item_id_count;
+	}
+
+	npc_next = arena_alloc(arena, npc_total * sizeof(NPC *));
+	item_next = arena_alloc(arena, item_total * sizeof(Item *));
+	if (!npc_next || !item_next)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		Room *room = &rooms[i];
+
+		/* Exits */
+		for (j = 0; j < DIR_COUNT; j++) {
+			char field[32];
+
+			room->exits[j] = NULL;
+			if (!room->exit_ids[j])
+				continue;
+
+			room->exits[j] = link_room(story, room->exit_ids[j],
+						   &found);
+			if (!found) {
+				snprintf(field, sizeof(field), "exit %s",
+					 direction_name((Direction)j));
+				link_dangling(report, "room", room->id, field,
+					      room->exit_ids[j]);
+			}
+		}
+
+		/* NPCs */
+		room->npcs = npc_next;
+		room->npc_count = 0;
+		for (j = 0; j < room->npc_id_count; j++) {
+			NPC *npc = link_npc(story, room->npc_ids[j]);
+
+			if (npc)
+				room->npcs[room->npc_count++] = npc;
+			else
+				link_dangling(report, "room", room->id, "NPC",
+					      room->npc_ids[j]);
+		}
+		npc_next += room->npc_count;
+
+		/* Items */
+		room->items = item_next;
+		room->item_count = 0;
+		room->item_capacity = room->item_id_count;
+		item_next += room->item_id_count;
+		for (j = 0; j < room->item_id_count; j++) {
+			Item *item = link_item(story, room->item_ids[j]);
+
+			if (item)
+				room->items[room->item_count++] = item;
+			else
+				link_dangling(report, "room", room->id, "item",
+					      room->item_ids[j]);
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * link_npcs() - Resolve NPC locations and required items
+ * @story: Story being linked
+ * @npcs: NPCs to link
+ * @count: Number of entries in @npcs
+ * @report: Running report
+ *
+ * Return: void
+ */
+
+static void link_npcs(Story *story, NPC *npcs, int count,
+		      LinkReport *report)
+{
+	bool found;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		NPC *npc = &npcs[i];
+
+		npc->location_ref = NULL;
+		if (npc->location[0] != '\0') {
+			npc->location_ref = link_room(story, npc->location, &found);
+			if (!found)
+				link_dangling(report, "NPC", npc->id, "location",
+					      npc->location);
+		}
+
+		npc->required_item_ref = NULL;
+		if (npc->required_item[0] != '\0') {
+			npc->required_item_ref = link_item(story, npc->required_item);
+			if (!npc->required_item_ref)
+				link_dangling(report, "NPC", npc->id,
+					      "required_item", npc->required_item);
+		}
+
+		npc->dialog_start = DIALOG_NONE;
+		if (npc->greeting_dialog[0] != '\0') {
+			npc->dialog_start = story_index_find(&story->dialog_index,
+							     npc->greeting_dialog);
+			if (npc->dialog_start < 0) {
+				npc->dialog_start = DIALOG_NONE;
+				link_dangling(report, "NPC", npc->id,
+					      "greeting_dialog",
+					      npc->greeting_dialog);
+			}
+		}
+	}
+}
+
+
+/**
+ * link_quests() - Resolve quest completion targets
+ * @story: Story being linked
+ * @report: Running report
+ *
+ * A target that cannot be resolved stays NULL while its ID is still
+ * set, so check_quest_completion() treats it as never satisfied, just
+ * as the string comparison did.
+ *
+ * Return: void
+ */
+
+static void link_quests(Story *story, LinkReport *report)
+{
+	bool found;
+	int i;
+
+	for (i = 0; i < story->quest_count; i++) {
+		Quest *quest = &story->quests[i];
+
+		quest->completion_item_ref = NULL;
+		if (quest->completion_item[0] != '\0') {
+			quest->completion_item_ref = link_item(story,
+							       quest->completion_item);
+			if (!quest->completion_item_ref)
+				link_dangling(report, "quest", quest->id,
+					      "completion_item",
+					      quest->completion_item);
+		}
+
+		quest->completion_npc_ref = NULL;
+		if (quest->completion_npc[0] != '\0') {
+			quest->completion_npc_ref = link_npc(story,
+							     quest->completion_npc);
+			if (!quest->completion_npc_ref)
+				link_dangling(report, "quest", quest->id,
+					      "completion_npc",
+					      quest->completion_npc);
+		}
+
+		quest->completion_room_ref = NULL;
+		if (quest->completion_room[0] != '\0') {
+			quest->completion_room_ref = link_room(story,
+							       quest->completion_room,
+							       &found);
+			if (!found)
+				link_dangling(report, "quest", quest->id,
+					      "completion_room",
+					      quest->completion_room);
+		}
+	}
+}
+
+
+/**
+ * link_dialogs() - Compile dialog IDs into node numbers
+ * @story: Story being linked
+ * @report: Running report
+ *
+ * After this every transition and quest action of a node is an
+ * integer, so a conversation never looks an ID up.
+ *
+ * Return: void
+ */
+
+static void link_dialogs(Story *story, LinkReport *report)
+{
+	char field[32];
+	int i, r;
+
+	for (i = 0; i < story->dialog_count; i++) {
+		DialogNode *node = &story->dialogs[i];
+
+		for (r = 0; r < node->response_count; r++) {
+			DialogResponse *response =
+				&story->dialog_responses[node->first_response + r];
+
+			snprintf(field, sizeof(field), "next %d",
+				 response->number);
+			response->next = link_dialog_target(story, node->id,
+							    field,
+							    response->next_id,
+							    report);
+		}
+
+		node->auto_continue = DIALOG_NONE;
+		if (node->auto_continue_id[0] != '\0')
+			node->auto_continue = link_dialog_target(story, node->id,
+								 "auto_continue",
+								 node->auto_continue_id,
+								 report);
+
+		node->quest = -1;
+		if (node->quest_action != QUEST_ACTION_NONE) {
+			node->quest = story_index_find(&story->quest_index,
+						       node->quest_id);
+			if (node->quest < 0)
+				link_dangling(report, "dialog", node->id,
+					      "quest", node->quest_id);
+		}
+	}
+}
+
+
+/**
+ * link_story() - Turn every ID reference in a story into a pointer
+ * @story: Loaded story with its ID indexes built
+ *
+ * Return: Number of dangling references, negative errno on failure
+ */
+
+int link_story(Story *story)
+{
+	LinkReport report = { 0 };
+	int ret;
+
+	log_function_entry(__func__, "rooms=%d", story->room_count);
+
+	/* A streamed story links its rooms as their regions load */
+	ret = 0;
+	if (!story->stream.enabled)
+		ret = link_rooms(story, story->rooms, story->room_count,
+				 &story->arena, &report);
+	if (ret != 0) {
+		log_function_error(__func__, "Out of memory linking rooms");
+		return ret;
+	}
+
+	link_npcs(story, story->npcs, story->npc_count, &report);
+	link_quests(story, &report);
+	link_dialogs(story, &report);
+
+	if (report.count > LINK_MAX_REPORTED) {
+		printf_colored(COLOR_WARNING,
+			       "WARNING: ... and %d more dangling references "
+			       "(see log)\n", report.count - LINK_MAX_REPORTED);
+	}
+
+	log_function_exit(__func__, report.count);
+	return report.count;
+}
+
+
+
+/**
+ * link_room_array() - Link rooms loaded after the story was linked
+ * @story: Linked story
+ * @rooms: Rooms to link
+ * @count: Number of entries in @rooms
+ * @arena: Arena the rooms' item and NPC lists are carved from
+ *
+ * Return: Number of dangling references, negative errno on failure
+ */
+
+int link_room_array(Story *story, Room *rooms, int count, Arena *arena)
+{
+	LinkReport report = { 0, true };
+	int ret;
+
+	ret = link_rooms(story, rooms, count, arena, &report);
+	return ret < 0 ? ret : report.count;
+}
+
+
+/**
+ * link_npc_array() - Link NPCs again after they have changed
+ * @story: Linked story
+ * @npcs: NPCs to link
+ * @count: Number of entries in @npcs
+ *
+ * Return: Number of dangling references
+ */
+
+int link_npc_array(Story *story, NPC *npcs, int count)
+{
+	LinkReport report = { 0, true };
+
+	link_npcs(story, npcs, count, &report);
+	return report.count;
+}
@@ -0,0 +1,65 @@
+/*
+ * link.h - Resolve story cross-references after loading
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_LINK_H
+#define STORY_LINK_H
+
+#include "story.h"
+
+
+/**
+ * link_story() - Turn every ID reference in a story into a pointer
+ * @story: Loaded story with its ID indexes built
+ *
+ * Resolves room exits, room item and NPC lists, NPC locations and
+ * required items, and quest completion targets. Each reference that
+ * names something the story does not define is reported once here and
+ * left unresolved (NULL, or dropped from the room lists), so the game
+ * never has to look an ID up while playing. Link tables are carved
+ * from the story arena. A streamed story's rooms are linked by
+ * link_room_array() as they load instead.
+ *
+ * Return: Number of dangling references, negative errno on failure
+ */
+
+int link_story(Story *story);
+
+
+/**
+ * link_room_array() - Link rooms loaded after the story was linked
+ * @story: Linked story
+ * @rooms: Rooms to link
+ * @count: Number of entries in @rooms
+ * @arena: Arena the rooms' item and NPC lists are carved from
+ *
+ * Used when a streamed story loads a region, and when rooms are
+ * reloaded from a changed rooms.ini. Exits are resolved only to rooms
+ * that are loaded at the time. Dangling references are logged
+ * but not printed, since the player is mid-game.
+ *
+ * Return: Number of dangling references, negative errno on failure
+ */
+
+int link_room_array(Story *story, Room *rooms, int count, Arena *arena);
+
+
+/**
+ * link_npc_array() - Link NPCs again after they have changed
+ * @story: Linked story
+ * @npcs: NPCs to link
+ * @count: Number of entries in @npcs
+ *
+ * Resolves location and required item from the NPCs' current IDs.
+ * Dangling references are logged but not printed.
+ *
+ * Return: Number of dangling references
+ */
+
+int link_npc_array(Story *story, NPC *npcs, int count);
+
+
+#endif /* STORY_LINK_H */
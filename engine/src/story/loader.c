@@ -8,211 +8,534 @@
  */
 
 #include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
 #include "core/constants.h"
+#include "core/grammar.h"
 #include "core/logger.h"
 #include "core/utils.h" 
+#include "core/verbs.h"
+#include "image.h"
+#include "index.h"
 #include "ini_parser.h"
+#include "link.h"
+#include "scripts.h"
+#include "stream.h"
+#include "gameplay/dialog.h"
 #include "gameplay/quests.h"
 #include "loader.h"
+#include "system/platform.h"
 #include "ui/colors.h"
 #include "world/items.h"
+#include "world/nouns.h"
 #include "world/npcs.h"
+#include "world/rooms.h"
 
 
 
-/* Static function declarations */
-static int parse_exits(const char* exit_str, char*** exits_out);
-static int parse_items(const char *item_str, char ***items_out);
-static int parse_npcs(const char *npc_str, char ***npcs_out);
+/**
+ * enum LoadPhase - Entity files parsed by load_story_from_ini()
+ */
+
+typedef enum {
+    LOAD_ROOMS,
+    LOAD_ITEMS,
+    LOAD_NPCS,
+    LOAD_QUESTS,
+    LOAD_PHASE_COUNT
+} LoadPhase;
 
 
 /**
- * parse_exits() - Parse comma-separates exit list
- * @exit_str: String containing exits (e.g., "north:room1, south:room2")
- * @exits_out: Pointer to store allocated exit array
- *
- * Parses comma-separated list of "direction:room_id" pairs.
- * Caller must free both the strings and the array
+ * struct LoadJob - One entity file, parsed on its own thread
+ * @phase: Which file to parse
+ * @story_dir: Story directory
+ * @story: Story receiving the array (each phase owns distinct fields)
+ * @arena: Private arena the phase allocates from, merged after the join
+ * @lazy_text: Leave descriptions, dialog and combat text on disk
+ * @elapsed_ms: Time spent parsing the file
+ */
+
+typedef struct {
+    LoadPhase phase;
+    const char *story_dir;
+    Story *story;
+    Arena arena;
+    bool lazy_text;
+    double elapsed_ms;
+} LoadJob;
+
+
+/* Set with loader_set_lazy_text(); read by load_story_from_ini() */
+static bool lazy_text_enabled = false;
+
+/* Set with loader_set_room_streaming(); read by load_story_from_ini() */
+static RoomStreaming room_streaming = ROOM_STREAMING_STORY;
+
+/* Filled in by load_story(); read with story_load_timings() */
+static StoryLoadTimings load_timings;
+
+
+static const char *const load_phase_files[LOAD_PHASE_COUNT] = {
+    "rooms.ini", "items.ini", "npcs.ini", "quests.ini"
+};
+
+static const char *const load_phase_nouns[LOAD_PHASE_COUNT] = {
+    "rooms", "items", "NPCs", "quests"
+};
+
+
+/**
+ * load_phase_count() - Number of entities a phase loaded
+ * @story: Loaded story
+ * @phase: Phase to report
  *
- * Return: Number of exits parsed, 0 if empty or error
+ * Return: Entity count for @phase
  */
 
-static int parse_exits(const char* exit_str, char*** exits_out) { 
-   
-    char buffer[INI_VALUE_SIZE];
-    char **exits;
-    char *token;
-    const char *p;
-    int count = 1;
-    int i = 0;
-    
-    if (!exit_str || strlen(exit_str) == 0) {
-        *exits_out = NULL;
+static int load_phase_count(const Story *story, int phase) {
+    switch (phase) {
+    case LOAD_ROOMS:
+        return story->room_count;
+    case LOAD_ITEMS:
+        return story->item_count;
+    case LOAD_NPCS:
+        return story->npc_count;
+    case LOAD_QUESTS:
+        return story->quest_count;
+    default:
         return 0;
     }
+}
 
-    // Make a copy so we can modify
-    
-    strncpy(buffer, exit_str, sizeof(buffer) - 1);
-    buffer[sizeof(buffer) - 1] = '\0';
 
-    // Count commas to determine number of exits
-    for (p = buffer; *p; p++) {
-        if (*p == ',') 
-            count++;
-    }
+/**
+ * load_job_run() - Parse one entity file into the story
+ * @job: Job to run
+ *
+ * Return: void
+ */
 
-    // Allocate array of string pointers
-    exits = malloc(sizeof(char *) * count);
-    if (!exits) 
-        return 0;
+static void load_job_run(LoadJob *job) {
+    Story *story = job->story;
+    double start_ms = platform_time_ms();
 
-    // Parse exits
-    token = strtok(buffer, ",");
-    while (token && i < count) {
-        exits[i] = strdup(trim_whitespace(token));
-        i++;
-        token = strtok(NULL, ",");
+    switch (job->phase) {
+    case LOAD_ROOMS:
+        if (story->stream.enabled) {
+            story->stream.lazy_text = job->lazy_text;
+            story->room_count = room_stream_scan(job->story_dir, &job->arena,
+                                                 story->metadata.start_room,
+                                                 &story->stream);
+        } else {
+            story->room_count = load_rooms(job->story_dir, &job->arena,
+                                           job->lazy_text, &story->rooms);
+        }
+        break;
+    case LOAD_ITEMS:
+        story->item_count = load_items(job->story_dir, &job->arena,
+                                       job->lazy_text, &story->items);
+        break;
+    case LOAD_NPCS:
+        story->npc_count = load_npcs(job->story_dir, &job->arena,
+                                     job->lazy_text, &story->npcs);
+        break;
+    case LOAD_QUESTS:
+        story->quest_count = load_quests(job->story_dir, &job->arena,
+                                         &story->quests);
+        break;
+    default:
+        break;
     }
 
-    *exits_out = exits;
-    return i;
+    job->elapsed_ms = platform_time_ms() - start_ms;
 }
 
 
+#ifdef HAVE_PTHREADS
+static void *load_job_thread(void *arg) {
+    load_job_run(arg);
+    return NULL;
+}
+#endif
+
 
 /**
- * parse_items() - Parse comma-separated item list
- * @item_str: String containing items (e.g., "sword,shield,potion")
- * @items_out: Pointer to store allocated item array
+ * load_entity_files() - Parse rooms, items, NPCs and quests concurrently
+ * @story: Story to fill in
+ * @story_dir: Story directory
+ * @jobs: One job per phase, filled in with timings
  *
- * Parses comma-separated list of item identifiers.
- * Caller must free both the strings and the array.
+ * The four files are independent, so each gets its own thread and this
+ * returns once all of them have joined. Any job whose thread cannot be
+ * started (or every job, without pthreads) runs on the calling thread.
+ * Each job allocates from a private arena, handed to the story's arena
+ * once everything has joined.
  *
- * Return: Number of items parsed, 0 if empty or error
+ * Return: void
  */
-static int parse_items(const char* item_str, char*** items_out) {
-    
-    char buffer[INI_VALUE_SIZE];
-	char **items;
-	char *token;
-	const char *p;
-	int count = 1;
-	int i = 0;
-
-    if (!item_str || strlen(item_str) == 0) {
-        *items_out = NULL;
-        return 0;
+
+static void load_entity_files(Story *story, const char *story_dir,
+                              LoadJob jobs[LOAD_PHASE_COUNT]) {
+#ifdef HAVE_PTHREADS
+    pthread_t threads[LOAD_PHASE_COUNT];
+    bool started[LOAD_PHASE_COUNT];
+#endif
+
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++) {
+        jobs[i].phase = (LoadPhase)i;
+        jobs[i].story_dir = story_dir;
+        jobs[i].story = story;
+        arena_init(&jobs[i].arena, 0);
+        jobs[i].lazy_text = lazy_text_enabled;
+        jobs[i].elapsed_ms = 0.0;
     }
-    
-    /* Make a copy we can modify */
-    strncpy(buffer, item_str, sizeof(buffer) - 1);
-    buffer[sizeof(buffer) - 1] = '\0';
-    
-    /* Count commas to determine number of items */
-    for (p = buffer; *p; p++) {
-        if (*p == ',') 
-            count++;
+
+#ifdef HAVE_PTHREADS
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++) {
+        started[i] = pthread_create(&threads[i], NULL, load_job_thread,
+                                    &jobs[i]) == 0;
+        if (!started[i])
+            load_job_run(&jobs[i]);
     }
-    
-    /* Allocate array of string pointers */
-    items = malloc(sizeof(char *) * count);
-    if (!items) 
-        return 0;
-    
-    /* Parse items */
-    token = strtok(buffer, ",");
-    while (token && i < count) {
-        items[i] = strdup(trim_whitespace(token));
-        i++;
-        token = strtok(NULL, ",");
+
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
     }
-    
-    *items_out = items;
-    return i;
+#else
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++)
+        load_job_run(&jobs[i]);
+#endif
+
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++)
+        arena_merge(&story->arena, &jobs[i].arena);
 }
 
 
 /**
- * parse_npcs() - Parse comma-separated NPC list
- * @npc_str: String containing NPCs (e.g., "wizard,guard,merchant")
- * @npcs_out: Pointer to store allocated NPC array
+ * build_story_indexes() - Build the ID lookup indexes for a loaded story
+ * @story: Story with its entity arrays in place
  *
- * Parses comma-separated list of NPC identifiers.
- * Caller must free both the strings and the array.
+ * Must be called again whenever an entity array is reallocated.
  *
- * Return: Number of NPCs parsed, 0 if empty or error
+ * Return: 0 on success, negative errno on failure
  */
-static int parse_npcs(const char* npc_str, char*** npcs_out) {
-    
-    char buffer[INI_VALUE_SIZE];
-    char **npcs;
-    char *token;
-    const char *p;
-    int count = 1;
-    int i = 0;
-
-    if (!npc_str || strlen(npc_str) == 0) {
-        *npcs_out = NULL;
-        return 0;
+
+static int build_story_indexes(Story *story) {
+    int ret;
+
+    /* A streamed story indexes its room slots, loaded or not */
+    if (story->stream.enabled)
+        ret = story_index_build(&story->room_index, &story->arena,
+                                story->stream.slots,
+                                story->room_count, sizeof(RoomSlot),
+                                offsetof(RoomSlot, id), "room");
+    else
+        ret = story_index_build(&story->room_index, &story->arena,
+                                story->rooms,
+                                story->room_count, sizeof(Room),
+                                offsetof(Room, id), "room");
+    if (ret == 0)
+        ret = story_index_build(&story->item_index, &story->arena,
+                                story->items,
+                                story->item_count, sizeof(Item),
+                                offsetof(Item, id), "item");
+    if (ret == 0)
+        ret = story_index_build(&story->npc_index, &story->arena,
+                                story->npcs,
+                                story->npc_count, sizeof(NPC),
+                                offsetof(NPC, id), "NPC");
+    if (ret == 0)
+        ret = story_index_build(&story->quest_index, &story->arena,
+                                story->quests,
+                                story->quest_count, sizeof(Quest),
+                                offsetof(Quest, id), "quest");
+    if (ret == 0)
+        ret = story_index_build(&story->dialog_index, &story->arena,
+                                story->dialogs,
+                                story->dialog_count, sizeof(DialogNode),
+                                offsetof(DialogNode, id), "dialog");
+    if (ret == 0)
+        ret = story_index_build(&story->script_index, &story->arena,
+                                story->scripts,
+                                story->script_count, sizeof(Script),
+                                offsetof(Script, id), "script");
+    if (ret == 0)
+        ret = story_index_build(&story->synonym_index, &story->arena,
+                                story->synonyms,
+                                story->synonym_count, sizeof(VerbEntry),
+                                offsetof(VerbEntry, word), "synonym");
+
+    return ret;
+}
+
+
+/**
+ * loader_set_lazy_text() - Choose whether text is loaded on demand
+ * @enabled: Leave descriptions, dialog and combat text on disk
+ *
+ * Applies to stories parsed from .ini files from now on. The loaders
+ * then record where each string is, and the game reads it back through
+ * the story's text cache the first time it is shown. Compiled images
+ * already leave their text in the mapping until it is touched.
+ *
+ * Return: void
+ */
+
+void loader_set_lazy_text(bool enabled) {
+    lazy_text_enabled = enabled;
+}
+
+
+/**
+ * loader_lazy_text() - Report whether lazy text is switched on
+ *
+ * Return: true if stories are parsed with lazy text
+ */
+
+bool loader_lazy_text(void) {
+    return lazy_text_enabled;
+}
+
+
+/**
+ * loader_set_room_streaming() - Choose whether rooms are streamed
+ * @mode: ROOM_STREAMING_STORY to do what story.ini asks, or force it
+ *        on or off
+ *
+ * Applies to stories parsed from .ini files from now on. A streamed
+ * story scans rooms.ini up front and loads rooms region by region as
+ * the player nears them (see story/stream.h). Compiled images always
+ * hold every room.
+ *
+ * Return: void
+ */
+
+void loader_set_room_streaming(RoomStreaming mode) {
+    room_streaming = mode;
+}
+
+
+/**
+ * loader_room_streaming() - Report how rooms streaming is chosen
+ *
+ * Return: Mode set with loader_set_room_streaming()
+ */
+
+RoomStreaming loader_room_streaming(void) {
+    return room_streaming;
+}
+
+
+/**
+ * load_story() - Load a story, preferring its compiled image
+ * @story_dir: Pointer to string contianing file path to story 
+ *
+ * Maps <story_dir>/story.img when it exists and is newer than every
+ * .ini file, otherwise falls back to parsing the .ini files. Either
+ * way the ID lookup indexes are built and every cross-reference is
+ * linked before the story is returned.
+ *
+ * Return: Story structure, NULL on failure
+ */
+
+Story* load_story(const char* story_dir) {
+
+    Story *story = NULL;
+    char image_path[STORY_DIRECTORY_SIZE + 16];
+    double load_start_ms = platform_time_ms();
+    double start_ms;
+
+    log_function_entry(__func__, "story_dir=%s", story_dir);
+    memset(&load_timings, 0, sizeof(load_timings));
+
+    printf_colored(COLOR_INFO, "Loading story from: %s\n", story_dir);
+
+    snprintf(image_path, sizeof(image_path), "%s/%s", story_dir,
+             STORY_IMAGE_FILENAME);
+    if (story_image_is_current(story_dir, image_path)) {
+        start_ms = platform_time_ms();
+        story = story_image_load(image_path);
+        if (story) {
+            load_timings.from_image = true;
+            load_timings.image_ms = platform_time_ms() - start_ms;
+            printf("  Mapped compiled image: %s (%.2f ms)\n", image_path,
+                   load_timings.image_ms);
+        }
     }
-    
-    /* Make a copy we can modify */
-    strncpy(buffer, npc_str, sizeof(buffer) - 1);
-    buffer[sizeof(buffer) - 1] = '\0';
-    
-    /* Count commas to determine number of NPCs */
-    for (p = buffer; *p; p++) {
-        if (*p == ',') 
-            count++;
+
+    if (!story)
+        story = load_story_from_ini(story_dir);
+
+    if (story) {
+        safe_strcpy(story->story_dir, story_dir, sizeof(story->story_dir));
+
+        /* Dialog trees are not part of the image; both paths parse them */
+        start_ms = platform_time_ms();
+        story->dialog_count = load_dialogs(story_dir, &story->arena,
+                                           &story->dialogs,
+                                           &story->dialog_responses,
+                                           &story->dialog_response_count);
+        load_timings.dialogs_ms = platform_time_ms() - start_ms;
+        if (story->dialog_count > 0)
+            printf("  Loaded %d dialog nodes (%d responses) in %.2f ms\n",
+                   story->dialog_count, story->dialog_response_count,
+                   load_timings.dialogs_ms);
+
+        start_ms = platform_time_ms();
+        story->script_count = load_scripts(story_dir, &story->arena,
+                                           &story->scripts);
+        load_timings.scripts_ms = platform_time_ms() - start_ms;
+
+        story->synonym_count = load_verb_synonyms(story_dir, &story->arena,
+                                                  &story->synonyms);
+        if (story->synonym_count > 0)
+            printf("  Added %d verb synonyms\n", story->synonym_count);
+
+        story->grammar_rule_count = load_grammar_rules(story_dir,
+                                                       &story->arena,
+                                                       &story->grammar_rules);
+        if (story->grammar_rule_count > 0)
+            printf("  Added %d grammar patterns\n", story->grammar_rule_count);
+
+        start_ms = platform_time_ms();
+        if (build_story_indexes(story) != 0 ||
+            build_noun_keys(story) != 0) {
+            printf_colored(COLOR_ERROR, "ERROR: Failed to index story IDs\n");
+            free_story(story);
+            story = NULL;
+        } else if (compile_grammar(story) != 0) {
+            printf_colored(COLOR_ERROR, "ERROR: Failed to compile grammar\n");
+            free_story(story);
+            story = NULL;
+        } else {
+            load_timings.index_ms = platform_time_ms() - start_ms;
+            printf("  Indexed IDs in %.2f ms\n", load_timings.index_ms);
+        }
     }
-    
-    /* Allocate array of string pointers */
-    npcs = malloc(sizeof(char *) * count);
-    if (!npcs) 
-        return 0;
-    
-    /* Parse NPCs */
-    token = strtok(buffer, ",");
-    while (token && i < count) {
-        npcs[i] = strdup(trim_whitespace(token));
-        i++;
-        token = strtok(NULL, ",");
+
+    /* Link phase: resolve every cross-reference once */
+    if (story) {
+        int dangling;
+
+        start_ms = platform_time_ms();
+        dangling = link_story(story);
+        if (dangling < 0) {
+            printf_colored(COLOR_ERROR, "ERROR: Failed to link story\n");
+            free_story(story);
+            story = NULL;
+        } else {
+            load_timings.link_ms = platform_time_ms() - start_ms;
+            printf("  Linked references in %.2f ms (%d dangling)\n",
+                   load_timings.link_ms, dangling);
+        }
     }
-    
-    *npcs_out = npcs;
-    return i;
+
+    /* Compile phase: conditions become bytecode over resolved indexes */
+    if (story) {
+        int errors;
+
+        start_ms = platform_time_ms();
+        errors = compile_scripts(story);
+        if (errors < 0) {
+            printf_colored(COLOR_ERROR, "ERROR: Failed to compile scripts\n");
+            free_story(story);
+            story = NULL;
+        } else {
+            load_timings.scripts_ms += platform_time_ms() - start_ms;
+            if (story->script_code_length > 0)
+                printf("  Compiled %d scripts and conditions to %d "
+                       "instructions in %.2f ms (%d errors)\n",
+                       story->script_count, story->script_code_length,
+                       load_timings.scripts_ms, errors);
+        }
+    }
+
+    if (story) {
+        StoryFootprint footprint;
+
+        story_footprint(story, &footprint);
+        printf("  Resident: %.1f KB (entities %.1f KB, text %.1f KB in "
+               "%ld strings, arena %.1f of %.1f KB, image %.1f KB)\n",
+               footprint.resident_bytes / 1024.0,
+               footprint.entity_bytes / 1024.0,
+               footprint.text_bytes / 1024.0, footprint.string_count,
+               footprint.arena.used / 1024.0,
+               footprint.arena.reserved / 1024.0,
+               footprint.image_bytes / 1024.0);
+        if (footprint.lazy_bytes > 0)
+            printf("  Lazy text: %.1f KB left on disk\n",
+                   footprint.lazy_bytes / 1024.0);
+        if (story->stream.enabled)
+            printf("  Streaming: %d of %d rooms loaded (%.1f KB in regions)\n",
+                   footprint.rooms_loaded, story->room_count,
+                   footprint.region_bytes / 1024.0);
+        add_log_entry("Story %s resident: %zu bytes (entities %zu, text %zu "
+                      "in %ld strings, arena %zu used of %zu, image %zu)",
+                      story_dir, footprint.resident_bytes,
+                      footprint.entity_bytes, footprint.text_bytes,
+                      footprint.string_count, footprint.arena.used,
+                      footprint.arena.reserved, footprint.image_bytes);
+    }
+
+    load_timings.total_ms = platform_time_ms() - load_start_ms;
+
+    log_function_exit(__func__, story ? 1 : 0);
+    return story;
 }
 
 
 /**
- * load_story() - Loads story metadata from story.ini
+ * story_load_timings() - Report where the last load_story() spent its time
+ * @timings: Filled in; all zero before the first load
+ *
+ * Only the phases the last load ran are set: an image load has no
+ * parse times, a failed load stops at the phase that failed.
+ *
+ * Return: void
+ */
+
+void story_load_timings(StoryLoadTimings* timings) {
+    *timings = load_timings;
+}
+
+
+/**
+ * load_story_from_ini() - Load a story by parsing its .ini files
  * @story_dir: Pointer to string contianing file path to story 
  *
- * Opens story, allocates resources, parses line by line, closes file, 
- * returns current story
+ * Maps story.ini, allocates resources, walks the tokenized file without
+ * copying lines, unmaps the file, then parses rooms, items, NPCs and
+ * quests from their own files in parallel. Prints the time taken by
+ * each phase.
  *
  * Return: Story structure, NULL on failure
  */
 
-Story* load_story(const char* story_dir) {
+Story* load_story_from_ini(const char* story_dir) {
     
     Story *story;
-	FILE *fp;
+	IniFile ini;
+	IniToken token;
+	IniView current_section = { "", 0 };
 	char filepath[INI_VALUE_SIZE];
-	char line[INI_LINE_BUFFER_SIZE];
-	char current_section[INI_SECTION_SIZE] = "";
-	char section[INI_SECTION_SIZE];
-	char key[INI_KEY_SIZE];
-	char value[INI_VALUE_SIZE];
+    LoadJob jobs[LOAD_PHASE_COUNT];
+    double start_ms;
+    double metadata_ms;
+    double wall_ms;
+    double busy_ms = 0.0;
 
     log_function_entry(__func__, "story_dir=%s", story_dir);
-
-    printf_colored(COLOR_INFO, "Loading story from: %s\n", story_dir);
+    start_ms = platform_time_ms();
 
     // Allocate story structure
     story = malloc(sizeof(Story));
@@ -224,68 +547,79 @@ Story* load_story(const char* story_dir) {
 
     // Initialise to zero
     memset(story, 0, sizeof(Story));
+    story->metadata.title = "";
+    story->metadata.author = "";
+    story->metadata.version = "";
+    story->metadata.description = "";
+    story->metadata.start_room = "";
+    story->metadata.victory_text = "";
 
     /* Build filepath */
     snprintf(filepath, sizeof(filepath), "%s/story.ini", story_dir);
     printf("Opening: %s\n", filepath);
 
-    /* Open file */
+    /* Map file */
     add_log_entry("Opening story file: %s at %s", filepath, log_timestamp());
-    fp = fopen(filepath, "r");
-    if (!fp) {
+    if (ini_open(&ini, filepath) != 0) {
         printf_colored(COLOR_ERROR, "ERROR: Cannot open %s\n", filepath);
         log_function_error(__func__, "ERROR: Failed to open story.ini");
         free(story);
         return NULL;
     }
 
-    /* Parse line by line */
-    while (fgets(line, sizeof(line), fp)) {
-        /* Remove newline */
-        line[strcspn(line, "\r\n")] = 0;
+    /* Walk tokens */
+    while (ini_next(&ini, &token)) {
 
         /* Check is this is a section header */
-        if (parse_ini_section(line, section, sizeof(section))) {
-            strncpy(current_section, section, sizeof(current_section) - 1);
-            printf("  [Section: %s]\n", current_section);
+        if (token.type == INI_TOKEN_SECTION) {
+            current_section = token.section;
+            printf("  [Section: %.*s]\n", (int)current_section.len,
+                   current_section.ptr);
             continue;
         }
 
-        /* Try to parse as key=value */
-        if (parse_ini_keyvalue(line, key, sizeof(key), value, sizeof(value))) {
-
-            /* If we're in the STORY section, populate metadata */
-            if (strcmp(current_section, "STORY") == 0) {
-                if (strcmp(key, "title") == 0) {
-                    strncpy(story->metadata.title, value, sizeof(story->metadata.title) -1);
-                }
-                else if (strcmp(key, "author") == 0) {
-                    strncpy(story->metadata.author, value, sizeof(story->metadata.author) -1);
-                }
-                else if (strcmp(key, "version") == 0) {
-                    strncpy(story->metadata.version, value, sizeof(story->metadata.version) -1);
-                }
-                else if (strcmp(key, "description") == 0) {
-                    strncpy(story->metadata.description, value, sizeof(story->metadata.description) -1);
-                }
-                else if (strcmp(key, "start_room") == 0) {
-                    strncpy(story->metadata.start_room, value, sizeof(story->metadata.start_room) -1);
-                }
+        /* If we're in the STORY section, populate metadata */
+        if (ini_view_equals(current_section, "STORY")) {
+            if (ini_view_equals(token.key, "title")) {
+                story->metadata.title = ini_view_text(&story->arena, token.value);
             }
-            /* if we're in the SETTINGS section */
-            else if (strcmp(current_section, "SETTINGS") == 0) {
-                if (strcmp(key, "max_inventory_weight") == 0) {
-                    story->metadata.max_inventory_weight = atoi(value);
-                    add_log_entry("Set max_inventory_weight=%d at %s", 
-                     story->metadata.max_inventory_weight, 
-                     log_timestamp());
-                }
+            else if (ini_view_equals(token.key, "author")) {
+                story->metadata.author = ini_view_text(&story->arena, token.value);
+            }
+            else if (ini_view_equals(token.key, "version")) {
+                story->metadata.version = ini_view_text(&story->arena, token.value);
+            }
+            else if (ini_view_equals(token.key, "description")) {
+                story->metadata.description = ini_view_text(&story->arena, token.value);
+            }
+            else if (ini_view_equals(token.key, "start_room")) {
+                story->metadata.start_room = ini_view_text(&story->arena, token.value);
+            }
+        }
+        /* if we're in the SETTINGS section */
+        else if (ini_view_equals(current_section, "SETTINGS")) {
+            if (ini_view_equals(token.key, "max_inventory_weight")) {
+                story->metadata.max_inventory_weight = ini_view_to_int(token.value);
+                add_log_entry("Set max_inventory_weight=%d at %s", 
+                 story->metadata.max_inventory_weight, 
+                 log_timestamp());
+            }
+            else if (ini_view_equals(token.key, "stream_rooms")) {
+                story->stream.enabled = ini_view_to_bool(token.value);
+            }
+            else if (ini_view_equals(token.key, "region_rooms")) {
+                story->stream.region_rooms = ini_view_to_int(token.value);
+            }
+            else if (ini_view_equals(token.key, "resident_regions")) {
+                story->stream.resident_limit = ini_view_to_int(token.value);
             }
-
         }
     }
     add_log_entry("Closing story file at %s", log_timestamp());
-    fclose(fp);
+    ini_close(&ini);
+
+    if (room_streaming != ROOM_STREAMING_STORY)
+        story->stream.enabled = room_streaming == ROOM_STREAMING_ON;
 
     printf("  Title: %s\n", story->metadata.title);
     printf("  Author: %s\n", story->metadata.author);
@@ -293,42 +627,59 @@ Story* load_story(const char* story_dir) {
     printf("  Start Room: %s\n", story->metadata.start_room);
     add_log_entry("Story metadata at %s: Title: %s, Author: %s, Version: %s, Start Room: %s", log_timestamp(), story->metadata.title, story->metadata.author, story->metadata.version, story->metadata.start_room);
 
-    /* Load rooms */
-    story->room_count = load_rooms(story_dir, &story->rooms);
+    metadata_ms = platform_time_ms() - start_ms;
+
+    /* Parse the entity files concurrently; cross-references come after the join */
+    start_ms = platform_time_ms();
+    load_entity_files(story, story_dir, jobs);
+    wall_ms = platform_time_ms() - start_ms;
+
+    if (lazy_text_enabled)
+        text_cache_init(&story->text, story_dir);
+
+    load_timings.metadata_ms = metadata_ms;
+    load_timings.rooms_ms = jobs[LOAD_ROOMS].elapsed_ms;
+    load_timings.items_ms = jobs[LOAD_ITEMS].elapsed_ms;
+    load_timings.npcs_ms = jobs[LOAD_NPCS].elapsed_ms;
+    load_timings.quests_ms = jobs[LOAD_QUESTS].elapsed_ms;
+    load_timings.parse_wall_ms = wall_ms;
+
+    /* Report per phase in a fixed order, whatever order the threads finished */
+    printf("  %-12s %8s %-8s %9.2f ms\n", "story.ini", "", "metadata",
+           metadata_ms);
+    for (int i = 0; i < LOAD_PHASE_COUNT; i++) {
+        busy_ms += jobs[i].elapsed_ms;
+        printf("  %-12s %8d %-8s %9.2f ms\n", load_phase_files[i],
+               load_phase_count(story, i), load_phase_nouns[i],
+               jobs[i].elapsed_ms);
+        add_log_entry("Loaded %d %s from %s in %.2f ms",
+                      load_phase_count(story, i), load_phase_nouns[i],
+                      load_phase_files[i], jobs[i].elapsed_ms);
+    }
+    printf("  Parsed %d files in %.2f ms wall (%.2f ms of parsing)%s\n",
+           LOAD_PHASE_COUNT, wall_ms, busy_ms,
+           lazy_text_enabled ? ", text left on disk" : "");
+    if (story->stream.enabled)
+        printf("  Streaming rooms: %d regions, %d kept loaded\n",
+               story->stream.region_count, story->stream.resident_limit);
+
     if (story->room_count == 0) {
         printf_colored(COLOR_WARNING, "WARNING: No rooms loaded!\n");
         log_function_error(__func__, "WARNING: No rooms loaded from story");
     }
-    
-    /* Load items */
-    story->item_count = load_items(story_dir, &story->items);
     if (story->item_count == 0) {
         printf_colored(COLOR_WARNING, "WARNING: No items loaded!\n");
         log_function_error(__func__, "WARNING: No items loaded from story");
-    } else {
-        add_log_entry("Loaded %d items at %s", story->item_count, log_timestamp());
     }
-
-    /* Load NPCs */
-    story->npc_count = load_npcs(story_dir, &story->npcs);
     if (story->npc_count == 0) {
         printf_colored(COLOR_WARNING, "WARNING: No NPCs loaded!\n");
         log_function_error(__func__, "WARNING: No NPCs loaded from story");
-    } else {
-        add_log_entry("Loaded %d NPCs at %s", story->npc_count, log_timestamp());
     }
-
-    /* Load quests */
-    story->quest_count = load_quests(story_dir, &story->quests);
     if (story->quest_count == 0) {
         printf_colored(COLOR_WARNING, "WARNING: No quests loaded!\n");
         log_function_error(__func__, "WARNING: No quests loaded from story");
-    } else {
-        add_log_entry("Loaded %d quests at %s", story->quest_count, log_timestamp());
     }
 
-
-
     log_function_exit(__func__, 1);
     return story;
 }
@@ -336,170 +687,350 @@ Story* load_story(const char* story_dir) {
 
 
 
+/**
+ * load_room_exits() - Parse a room's exits= list into its exit table
+ * @room: Room being loaded
+ * @arena: Arena the exit IDs are carved from
+ * @value: Comma-separated "direction:room_id" list
+ *
+ * Directions are resolved here, once, so nothing compares direction
+ * strings while playing. Malformed entries, unknown directions and
+ * repeated directions are skipped with a warning.
+ *
+ * Return: void
+ */
+static void load_room_exits(Room *room, Arena *arena, IniView value) {
+    char **list;
+    int count = ini_split_list(value, arena, &list);
+
+    for (int i = 0; i < count; i++) {
+        if (room_parse_exit(room, list[i]) != 0) {
+            printf_colored(COLOR_WARNING,
+                           "WARNING: room '%s' has a bad exit '%s'\n",
+                           room->id, list[i]);
+        }
+    }
+}
+
+/**
+ * load_room_begin() - Start a room at its [ROOM:] header
+ * @room: Zeroed room
+ * @id: Room ID (string pool)
+ * @lazy_text: Leave the description on disk
+ *
+ * Return: void
+ */
+void load_room_begin(Room *room, const char *id, bool lazy_text) {
+    room->id = id;
+    room->name = "";
+    room->description = lazy_text ? NULL : "";
+    room->locked_exit = DIR_NONE;
+}
+
+/**
+ * load_room_value() - Apply one key=value line to a room
+ * @room: Room being loaded
+ * @arena: Arena for the room's text and ID lists
+ * @ini: rooms.ini, mapped
+ * @token: Key and value
+ * @lazy_text: Record where the description is instead of copying it
+ *
+ * Unknown keys (including region, which only streaming reads) are
+ * ignored.
+ *
+ * Return: void
+ */
+void load_room_value(Room *room, Arena *arena, const IniFile *ini,
+                     const IniToken *token, bool lazy_text) {
+    if (ini_view_equals(token->key, "name")) {
+        room->name = ini_view_text(arena, token->value);
+    } else if (ini_view_equals(token->key, "description")) {
+        if (lazy_text)
+            room->description_ref = text_ref(ini, token->value);
+        else
+            room->description = ini_view_text(arena, token->value);
+    } else if (ini_view_equals(token->key, "exits")) {
+        load_room_exits(room, arena, token->value);
+    } else if (ini_view_equals(token->key, "items")) {
+        room->item_id_count = ini_split_list(token->value, arena,
+            &room->item_ids);
+    } else if (ini_view_equals(token->key, "npcs")) {
+        room->npc_id_count = ini_split_list(token->value, arena,
+            &room->npc_ids);
+    } else if (ini_view_equals(token->key, "dark")) {
+        room->dark = ini_view_to_bool(token->value);
+    } else if (ini_view_equals(token->key, "locked")) {
+        room->locked = ini_view_to_bool(token->value);
+    } else if (ini_view_equals(token->key, "locked_exit")) {
+        char direction[INI_KEY_SIZE];
+
+        ini_view_copy(token->value, direction, sizeof(direction));
+        room->locked_exit = direction_from_string(direction);
+    }
+}
+
 /**
  * load_rooms() - Load rooms from rooms.ini
  * @story_dir: Path to story directory
+ * @arena: Arena for the room array, exit IDs and item and NPC ID lists
+ * @lazy_text: Record where descriptions are instead of copying them
  * @rooms_out: Pointer to store allocated room array
  *
- * Uses two-pass approach: counts rooms, allocates array,
- * then fills room data.
+ * Single pass over the mapped file: the room array grows geometrically
+ * as [ROOM:] headers appear and is trimmed to size at end of file.
  *
  * Return: Number of rooms loaded, 0 on error or empty
  */
-int load_rooms(const char *story_dir, Room **rooms_out) {
+int load_rooms(const char *story_dir, Arena *arena, bool lazy_text,
+               Room **rooms_out) {
     
-    FILE *fp;
+    IniFile ini;
+	IniToken token;
 	char filepath[INI_VALUE_SIZE];
-	char line[INI_LINE_BUFFER_SIZE];
-	char section[INI_SECTION_SIZE];
-	char current_section[INI_SECTION_SIZE] = "";
-	char key[INI_KEY_SIZE];
-	char value[INI_VALUE_SIZE];
-	Room *rooms;
+	Room *rooms = NULL;
+	Room *grown;
+	int room_capacity = 0;
 	int room_count = 0;
-	int current_room = -1;
+	bool lazy;
 
     /* Build path to rooms.ini */
     snprintf(filepath, sizeof(filepath), "%s/rooms.ini", story_dir);
-    printf("\nLoading rooms from: %s\n", filepath);
     
-    /* Open file */
-    fp = fopen(filepath, "r");
-    if (!fp) {
+    /* Map file */
+    if (ini_open(&ini, filepath) != 0) {
         printf("ERROR: Cannot open %s\n", filepath);
-        return 0;
-    }
-    
-    /* First pass: count rooms */
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\r\n")] = 0;
-
-        if (parse_ini_section(line, section, sizeof(section))) {
-            if (strncmp(section, "ROOM:", 5) == 0) 
-                room_count++;
-        }
-    }
-    
-    printf("  Found %d rooms\n", room_count);
-    
-    if (room_count == 0) {
-        fclose(fp);
         *rooms_out = NULL;
         return 0;
     }
+    lazy = lazy_text && text_ref_fits(&ini);
     
-    /* Allocate room array */
-    rooms = calloc(room_count, sizeof(Room));
-    if (!rooms) {
-        fclose(fp);
-        return 0;
-    }
-    
-    /* Second pass: parse rooms */
-    rewind(fp);
-    
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\r\n")] = 0;
+    while (ini_next(&ini, &token)) {
         
         /*  Check for section header */
-        if (parse_ini_section(line, section, sizeof(section))) {
-            strncpy(current_section, section, sizeof(current_section) - 1);
+        if (token.type == INI_TOKEN_SECTION) {
             
             /* If it's a ROOM section, start a new room */
-            if (strncmp(section, "ROOM:", 5) == 0) {
-                current_room++;
-                if (current_room >= room_count) 
+            if (ini_view_has_prefix(token.section, "ROOM:")) {
+                IniView id = ini_view_skip(token.section, 5);
+
+                grown = array_grow(rooms, room_count, &room_capacity,
+                                   sizeof(Room));
+                if (!grown) {
+                    log_function_error(__func__, "Failed to grow room array");
                     break;
+                }
+                rooms = grown;
                 
                 /* Extract room ID (after "ROOM:") */
-                strncpy(rooms[current_room].id, section + 5,
-                        sizeof(rooms[current_room].id) - 1);
+                load_room_begin(&rooms[room_count], ini_view_text(arena, id),
+                                lazy);
+                room_count++;
                 
-                printf("  Loading room: %s\n", section + 5);
+                add_log_entry("Loading room: %.*s", (int)id.len, id.ptr);
             }
             continue;
         }
         
         /* Parse key=value pairs */
-        if (current_room >= 0 && 
-            parse_ini_keyvalue(line, key, sizeof(key),
-                               value, sizeof(value))) {
-            Room *room = &rooms[current_room];
-            
-            if (strcmp(key, "name") == 0) {
-                strncpy(room->name, value, 
-                    sizeof(room->name) - 1);
-            } else if (strcmp(key, "description") == 0) {
-                strncpy(room->description, value, 
-                    sizeof(room->description) - 1);
-            } else if (strcmp(key, "exits") == 0) {
-                room->exit_count = parse_exits(value, 
-                    &room->exits);
-            } else if (strcmp(key, "items") == 0) {
-                room->item_count = parse_items(value, 
-                    &room->items);
-            } else if (strcmp(key, "npcs") == 0) {
-                room->npc_count = parse_npcs(value, 
-                    &room->npcs);
-            } else if (strcmp(key, "dark") == 0) {
-                room->dark = (strcmp(value, "true") == 0);
-            } else if (strcmp(key, "locked") == 0) {
-                room->locked = (strcmp(value, "true") == 0);
-            } else if (strcmp(key, "locked_exit") == 0) {
-                strncpy(room->locked_exit, value,
-                    sizeof(room->locked_exit) - 1);
-            }
-        }
+        if (room_count > 0)
+            load_room_value(&rooms[room_count - 1], arena, &ini, &token, lazy);
     }
     
-    fclose(fp);
+    ini_close(&ini);
+
+    /* Finalise array at end of file; the arena frees it with the story */
+    rooms = array_shrink(rooms, room_count, sizeof(Room));
+    if (arena_adopt(arena, rooms, (size_t)room_count * sizeof(Room)) != 0) {
+        free(rooms);
+        rooms = NULL;
+        room_count = 0;
+    }
     
-    /* Print summary */
-    printf("\n  Loaded %d rooms:\n", room_count);
+    /* Log summary */
+    add_log_entry("Loaded %d rooms from %s", room_count, filepath);
     for (int i = 0; i < room_count; i++) {
-        printf("    - %s (%s)\n", rooms[i].id, rooms[i].name);
-        printf("      Exits: %d\n", rooms[i].exit_count);
-        printf("      Items: %d\n", rooms[i].item_count);
-        printf("      NPCs: %d\n", rooms[i].npc_count);
+        add_log_entry("  Room %s (%s): exits=%d items=%d npcs=%d",
+                      rooms[i].id, rooms[i].name, rooms[i].exit_count,
+                      rooms[i].item_id_count, rooms[i].npc_id_count);
     }
     
     *rooms_out = rooms;
     return room_count;
 }
 
+/**
+ * footprint_text() - Count one string towards a story's text
+ * @footprint: Footprint being measured
+ * @text: String (NULL is skipped)
+ *
+ * Return: void
+ */
+static void footprint_text(StoryFootprint *footprint, const char *text) {
+    if (text) {
+        footprint->text_bytes += strlen(text) + 1;
+        footprint->string_count++;
+    }
+}
+
+static void footprint_list(StoryFootprint *footprint, char **list, int count) {
+    for (int i = 0; list && i < count; i++)
+        footprint_text(footprint, list[i]);
+}
+
+/**
+ * footprint_refs() - Count lazily loaded strings left on disk
+ * @footprint: Footprint being measured
+ * @refs: Where the strings are (NULL if none)
+ * @count: Number of entries in @refs
+ *
+ * Return: void
+ */
+static void footprint_refs(StoryFootprint *footprint, const TextRef *refs,
+                           int count) {
+    for (int i = 0; refs && i < count; i++)
+        footprint->lazy_bytes += refs[i].length;
+}
+
+/**
+ * footprint_room() - Count a room's text, its ID aside
+ * @footprint: Footprint being measured
+ * @room: Loaded room
+ *
+ * A streamed room shares its ID with the room's slot, so the caller
+ * counts IDs.
+ *
+ * Return: void
+ */
+static void footprint_room(StoryFootprint *footprint, const Room *room) {
+    footprint_text(footprint, room->name);
+    footprint_text(footprint, room->description);
+    footprint_refs(footprint, &room->description_ref, 1);
+    for (int dir = 0; dir < DIR_COUNT; dir++)
+        footprint_text(footprint, room->exit_ids[dir]);
+    footprint_list(footprint, room->item_ids, room->item_id_count);
+    footprint_list(footprint, room->npc_ids, room->npc_id_count);
+}
+
+/**
+ * story_footprint() - Measure the memory a loaded story holds
+ * @story: Loaded story
+ * @footprint: Filled in with the totals
+ *
+ * Text is counted at its exact length wherever it lives, so the
+ * figure is the same for a story parsed from .ini files and for its
+ * compiled image. Strings shared between entities (such as image
+ * strings used by several lists) are counted once per use. Lazily
+ * loaded text is counted separately, since only what sits in the
+ * text cache is resident. A streamed story counts only the rooms of
+ * its resident regions, plus a slot per room.
+ *
+ * Return: void
+ */
+void story_footprint(const Story *story, StoryFootprint *footprint) {
+    const StoryMetadata *meta = &story->metadata;
+    const RoomStream *stream = &story->stream;
+
+    memset(footprint, 0, sizeof(*footprint));
+
+    footprint->rooms_loaded = story->room_count;
+    if (stream->enabled)
+        room_stream_footprint(stream, &footprint->region_bytes,
+                              &footprint->rooms_loaded);
+
+    footprint->entity_bytes = (size_t)footprint->rooms_loaded * sizeof(Room) +
+                              (size_t)story->item_count * sizeof(Item) +
+                              (size_t)story->npc_count * sizeof(NPC) +
+                              (size_t)story->quest_count * sizeof(Quest);
+
+    footprint_text(footprint, meta->title);
+    footprint_text(footprint, meta->author);
+    footprint_text(footprint, meta->version);
+    footprint_text(footprint, meta->description);
+    footprint_text(footprint, meta->start_room);
+    footprint_text(footprint, meta->victory_text);
+
+    if (stream->enabled) {
+        footprint->entity_bytes +=
+            (size_t)story->room_count * sizeof(RoomSlot) +
+            (size_t)stream->region_count * sizeof(RoomRegion);
+        for (int i = 0; i < story->room_count; i++)
+            footprint_text(footprint, stream->slots[i].id);
+        for (int r = 0; r < stream->region_count; r++) {
+            footprint_text(footprint, stream->regions[r].key);
+            for (uint32_t i = 0; stream->regions[r].rooms &&
+                                 i < stream->regions[r].count; i++)
+                footprint_room(footprint, &stream->regions[r].rooms[i]);
+        }
+    } else {
+        for (int i = 0; i < story->room_count; i++) {
+            footprint_text(footprint, story->rooms[i].id);
+            footprint_room(footprint, &story->rooms[i]);
+        }
+    }
+
+    for (int i = 0; i < story->item_count; i++) {
+        footprint_text(footprint, story->items[i].id);
+        footprint_text(footprint, story->items[i].name);
+        footprint_text(footprint, story->items[i].description);
+        footprint_refs(footprint, &story->items[i].description_ref, 1);
+    }
+
+    for (int i = 0; i < story->npc_count; i++) {
+        const NPC *npc = &story->npcs[i];
+
+        footprint_text(footprint, npc->id);
+        footprint_text(footprint, npc->name);
+        footprint_text(footprint, npc->description);
+        footprint_text(footprint, npc->location);
+        footprint_text(footprint, npc->required_item);
+        footprint_list(footprint, npc->dialog, npc->dialog_count);
+        footprint_list(footprint, npc->combat_text, npc->combat_text_count);
+        footprint_refs(footprint, &npc->description_ref, 1);
+        footprint_refs(footprint, npc->dialog_refs, npc->dialog_count);
+        footprint_refs(footprint, npc->combat_text_refs,
+                       npc->combat_text_count);
+    }
+
+    for (int i = 0; i < story->quest_count; i++) {
+        const Quest *quest = &story->quests[i];
+
+        footprint_text(footprint, quest->id);
+        footprint_text(footprint, quest->name);
+        footprint_text(footprint, quest->description);
+        footprint_text(footprint, quest->completion_item);
+        footprint_text(footprint, quest->completion_npc);
+        footprint_text(footprint, quest->completion_room);
+        footprint_text(footprint, quest->completion_message);
+    }
+
+    arena_usage(&story->arena, &footprint->arena);
+    footprint->image_bytes = story->image ? story->image_size : 0;
+    footprint->text_cache_bytes = story->text.bytes;
+    footprint->resident_bytes = sizeof(Story) + footprint->arena.reserved +
+                                footprint->region_bytes +
+                                footprint->image_bytes +
+                                footprint->text_cache_bytes;
+}
+
 /**
  * free_story() - Free story and all associated data
  * @story: Pointer to story to free
  *
- * Frees all allocated memory including rooms, items, NPCs.
+ * Everything the story points at lives in its arena (or, for a
+ * compiled story, in the mapped image), so this is one arena_free()
+ * and an unmap however large the story is, plus emptying the small
+ * text cache, the arenas of any resident room regions and the rooms'
+ * rendered views.
  *
  * Return: void
  */
 void free_story(Story* story) {
     if (story) {
-        /* Free rooms */
-        if (story->rooms) {
-            // TODO: Free individual room data
-            free(story->rooms);
-        }
-        
-        /* Free items */
-        if (story->items) {
-            // TODO: Free individual item data
-            free(story->items);
-        }
-        
-        /* Free NPCs */
-        if (story->npcs) {
-            // TODO: Free individual NPC data
-            free(story->npcs);
-        }
-
-        /* Free quests */
-        if (story->quests) {
-            free(story->quests);
-        }
-        
+        story_image_release(story);
+        text_cache_free(&story->text);
+        room_stream_free(&story->stream);
+        room_views_free(story->rooms, story->room_count);
+        arena_free(&story->arena);
         free(story);
     }
-}
\ No newline at end of file
+}
@@ -1,17 +1,127 @@
 #ifndef LOADER_H
 #define LOADER_H
 
+#include "ini_parser.h"
 #include "story.h"
 
+/**
+ * struct StoryFootprint - Memory a loaded story keeps resident
+ * @entity_bytes: Room, item, NPC and quest arrays
+ * @text_bytes: Every string the story holds (metadata, IDs, names,
+ *              descriptions, exits, dialog, ...), terminators included
+ * @string_count: Number of strings counted in @text_bytes
+ * @arena: What the story arena holds: the entity arrays, text for .ini
+ *         stories, ID lists, indexes and link tables
+ * @lazy_bytes: Lazily loaded text left on disk until it is needed
+ * @text_cache_bytes: Lazy text currently held in the text cache
+ * @image_bytes: Compiled image behind the story's text (0 for .ini)
+ * @rooms_loaded: Rooms in memory (all of them unless streamed)
+ * @region_bytes: Memory reserved by a streamed story's resident regions
+ * @resident_bytes: Story struct, arena reservation, resident regions,
+ *                  text cache and image together
+ */
+
+typedef struct {
+    size_t entity_bytes;
+    size_t text_bytes;
+    long string_count;
+    size_t lazy_bytes;
+    size_t text_cache_bytes;
+    ArenaUsage arena;
+    size_t image_bytes;
+    int rooms_loaded;
+    size_t region_bytes;
+    size_t resident_bytes;
+} StoryFootprint;
+
+
+/**
+ * struct StoryLoadTimings - Where the last load_story() spent its time
+ * @from_image: Story was mapped from its compiled image
+ * @image_ms: Mapping the compiled image (0 when parsed from .ini)
+ * @metadata_ms: Reading story.ini
+ * @rooms_ms: Parsing rooms.ini (or scanning it into regions)
+ * @items_ms: Parsing items.ini
+ * @npcs_ms: Parsing npcs.ini
+ * @quests_ms: Parsing quests.ini
+ * @parse_wall_ms: Wall time of the four entity files, parsed in parallel
+ * @dialogs_ms: Parsing dialogs.ini
+ * @scripts_ms: Parsing scripts.ini and compiling every condition
+ * @index_ms: Building the ID indexes
+ * @link_ms: Resolving cross-references
+ * @total_ms: The whole load
+ */
+
+typedef struct {
+    bool from_image;
+    double image_ms;
+    double metadata_ms;
+    double rooms_ms;
+    double items_ms;
+    double npcs_ms;
+    double quests_ms;
+    double parse_wall_ms;
+    double dialogs_ms;
+    double scripts_ms;
+    double index_ms;
+    double link_ms;
+    double total_ms;
+} StoryLoadTimings;
+
+
+/**
+ * enum RoomStreaming - Whether rooms are loaded region by region
+ * @ROOM_STREAMING_STORY: As story.ini's stream_rooms setting says
+ * @ROOM_STREAMING_OFF: Always load every room
+ * @ROOM_STREAMING_ON: Always stream rooms
+ */
+
+typedef enum {
+    ROOM_STREAMING_STORY,
+    ROOM_STREAMING_OFF,
+    ROOM_STREAMING_ON
+} RoomStreaming;
+
+
 /*
  * Story loading functions
  */
 
-// Load complete story from directory
+// Load complete story from directory (compiled image if up to date)
 Story* load_story(const char* story_dir);
 
+// Leave descriptions, dialog and combat text on disk until first use
+// in stories parsed from now on (compiled images are unaffected)
+void loader_set_lazy_text(bool enabled);
+
+// Report whether lazy text is switched on
+bool loader_lazy_text(void);
+
+// Choose whether stories parsed from now on stream their rooms
+void loader_set_room_streaming(RoomStreaming mode);
+
+// Report how room streaming is chosen
+RoomStreaming loader_room_streaming(void);
+
+// Load complete story by parsing the .ini files, ignoring any image
+Story* load_story_from_ini(const char* story_dir);
+
 // Load rooms from rooms.ini
-int load_rooms(const char* story_dir, Room** rooms_out);
+int load_rooms(const char* story_dir, Arena* arena, bool lazy_text,
+               Room** rooms_out);
+
+// Start a room at its [ROOM:] header (room zeroed, id pooled)
+void load_room_begin(Room* room, const char* id, bool lazy_text);
+
+// Apply one rooms.ini key=value line to a room
+void load_room_value(Room* room, Arena* arena, const IniFile* ini,
+                     const IniToken* token, bool lazy_text);
+
+// Report the phase timings of the most recent load_story()
+void story_load_timings(StoryLoadTimings* timings);
+
+// Measure the memory a loaded story holds
+void story_footprint(const Story* story, StoryFootprint* footprint);
 
 // Free story and all its data
 void free_story(Story* story);
@@ -1,72 +1,572 @@
+/*
+ * manager.c - Story catalog and story selection
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
 #include "manager.h"
+#include "ini_parser.h"
 #include "loader.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "system/platform.h"
+#include "ui/colors.h"
+#include <dirent.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+static char stories_directory[STORY_DIRECTORY_SIZE];
+
+
+/**
+ * struct CatalogEntry - One story directory as last seen
+ * @info: Metadata from the [STORY] section (title "" if there is none)
+ * @dir_mtime: Modification time of the story directory
+ * @ini_mtime: Modification time of story.ini
+ * @ini_size: Size of story.ini
+ *
+ * An entry is reused as long as all three stamps still match.
+ */
+
+typedef struct {
+    StoryInfo info;
+    long long dir_mtime;
+    long long ini_mtime;
+    long long ini_size;
+} CatalogEntry;
 
-static char stories_directory[256];
 
 /*
  * Initialize story manager
  */
 void story_manager_init(const char* stories_dir) {
-    printf("[STUB] story_manager_init(%s)\n", stories_dir);
-    strncpy(stories_directory, stories_dir, sizeof(stories_directory) - 1);
+    size_t len;
+
+    safe_strcpy(stories_directory, stories_dir, sizeof(stories_directory));
+
+    /* Story paths are joined with '/' */
+    len = strlen(stories_directory);
+    while (len > 1 && stories_directory[len - 1] == '/')
+        stories_directory[--len] = '\0';
+
+    add_log_entry("Story manager using %s", stories_directory);
 }
 
 /*
  * Cleanup story manager
  */
 void story_manager_cleanup(void) {
-    printf("[STUB] story_manager_cleanup()\n");
 }
 
-/*
- * Scan for available stories
+
+/**
+ * catalog_compare_directory() - Order catalog entries by directory
+ * @a: First entry
+ * @b: Second entry
+ *
+ * Return: strcmp() of the directories
+ */
+
+static int catalog_compare_directory(const void *a, const void *b) {
+    return strcmp(((const CatalogEntry *)a)->info.directory,
+                  ((const CatalogEntry *)b)->info.directory);
+}
+
+
+/**
+ * catalog_compare_title() - Order stories for the menu
+ * @a: First story
+ * @b: Second story
+ *
+ * Return: Title order ignoring case, then directory order
+ */
+
+static int catalog_compare_title(const void *a, const void *b) {
+    const StoryInfo *x = a;
+    const StoryInfo *y = b;
+    int ret = strcasecmp(x->title, y->title);
+
+    return ret != 0 ? ret : strcmp(x->directory, y->directory);
+}
+
+
+/**
+ * catalog_field() - Split the next tab-separated field off a line
+ * @cursor: Current position, advanced past the field
+ *
+ * Return: The field, NUL terminated in place
  */
+
+static char *catalog_field(char **cursor) {
+    char *field = *cursor;
+    char *end = strpbrk(field, "\t\n");
+
+    if (end) {
+        *cursor = *end == '\t' ? end + 1 : end;
+        *end = '\0';
+    } else {
+        *cursor = field + strlen(field);
+    }
+    return field;
+}
+
+
+/**
+ * catalog_put() - Write one field, keeping tabs and newlines out of it
+ * @f: Catalog being written
+ * @value: Field value
+ * @last: Field ends the line
+ *
+ * Return: void
+ */
+
+static void catalog_put(FILE *f, const char *value, bool last) {
+    for (; *value; value++)
+        fputc(*value == '\t' || *value == '\n' || *value == '\r' ?
+              ' ' : *value, f);
+    fputc(last ? '\n' : '\t', f);
+}
+
+
+/**
+ * catalog_read() - Read the metadata cache
+ * @path: Cache file
+ * @entries: Set to the entries, sorted by directory (caller frees)
+ *
+ * A missing, foreign or older cache reads as empty; every story is then
+ * parsed and the cache rewritten.
+ *
+ * Return: Number of entries
+ */
+
+static int catalog_read(const char *path, CatalogEntry **entries) {
+    char line[sizeof(StoryInfo) + 128];
+    CatalogEntry *list = NULL;
+    int capacity = 0;
+    int count = 0;
+    int version = 0;
+    char magic[16];
+    FILE *f;
+
+    *entries = NULL;
+
+    f = fopen(path, "r");
+    if (!f)
+        return 0;
+
+    if (!fgets(line, sizeof(line), f) ||
+        sscanf(line, "%15s %d", magic, &version) != 2 ||
+        strcmp(magic, STORY_CATALOG_MAGIC) != 0 ||
+        version != STORY_CATALOG_VERSION) {
+        add_log_entry("Ignoring story catalog %s (wrong format)", path);
+        fclose(f);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        CatalogEntry *entry;
+        char *cursor = line;
+        CatalogEntry *grown;
+
+        grown = array_grow(list, count, &capacity, sizeof(*list));
+        if (!grown)
+            break;
+        list = grown;
+        entry = &list[count];
+
+        safe_strcpy(entry->info.directory, catalog_field(&cursor),
+                    sizeof(entry->info.directory));
+        entry->dir_mtime = strtoll(catalog_field(&cursor), NULL, 10);
+        entry->ini_mtime = strtoll(catalog_field(&cursor), NULL, 10);
+        entry->ini_size = strtoll(catalog_field(&cursor), NULL, 10);
+        safe_strcpy(entry->info.title, catalog_field(&cursor),
+                    sizeof(entry->info.title));
+        safe_strcpy(entry->info.author, catalog_field(&cursor),
+                    sizeof(entry->info.author));
+        safe_strcpy(entry->info.version, catalog_field(&cursor),
+                    sizeof(entry->info.version));
+        safe_strcpy(entry->info.description, catalog_field(&cursor),
+                    sizeof(entry->info.description));
+
+        if (entry->info.directory[0] != '\0')
+            count++;
+    }
+
+    fclose(f);
+
+    qsort(list, (size_t)count, sizeof(*list), catalog_compare_directory);
+    *entries = list;
+    return count;
+}
+
+
+/**
+ * catalog_write() - Replace the metadata cache
+ * @path: Cache file
+ * @entries: Every story directory found
+ * @count: Number of entries
+ *
+ * Written beside the cache and renamed over it, so a scan that is
+ * interrupted leaves the old cache intact. A stories directory that
+ * cannot be written to only costs the next scan its speed.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int catalog_write(const char *path, const CatalogEntry *entries,
+                         int count) {
+    char temp[STORY_DIRECTORY_SIZE + 32];
+    FILE *f;
+    int ret = 0;
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    f = fopen(temp, "w");
+    if (!f) {
+        add_log_entry("Cannot write story catalog %s: %s", temp,
+                      strerror(errno));
+        return -errno;
+    }
+
+    fprintf(f, "%s %d\n", STORY_CATALOG_MAGIC, STORY_CATALOG_VERSION);
+    for (int i = 0; i < count; i++) {
+        const CatalogEntry *entry = &entries[i];
+
+        catalog_put(f, entry->info.directory, false);
+        fprintf(f, "%lld\t%lld\t%lld\t", entry->dir_mtime,
+                entry->ini_mtime, entry->ini_size);
+        catalog_put(f, entry->info.title, false);
+        catalog_put(f, entry->info.author, false);
+        catalog_put(f, entry->info.version, false);
+        catalog_put(f, entry->info.description, true);
+    }
+
+    if (ferror(f))
+        ret = -EIO;
+    if (fclose(f) != 0 && ret == 0)
+        ret = -EIO;
+    if (ret == 0 && rename(temp, path) != 0)
+        ret = -errno;
+    if (ret != 0) {
+        remove(temp);
+        add_log_entry("Cannot write story catalog %s: %s", path,
+                      strerror(-ret));
+    }
+    return ret;
+}
+
+
+/**
+ * read_story_info() - Read the [STORY] section of one story.ini
+ * @path: story.ini to read
+ * @info: Filled in; fields the file leaves out are ""
+ *
+ * Stops at the first section after [STORY], so settings and anything
+ * else in the file are never tokenized.
+ *
+ * Return: 0 on success, negative errno if the file cannot be opened
+ */
+
+static int read_story_info(const char *path, StoryInfo *info) {
+    IniFile ini;
+    IniToken token;
+    bool in_story = false;
+
+    info->title[0] = '\0';
+    info->author[0] = '\0';
+    info->version[0] = '\0';
+    info->description[0] = '\0';
+
+    if (ini_open(&ini, path) != 0)
+        return -ENOENT;
+
+    while (ini_next(&ini, &token)) {
+        if (token.type == INI_TOKEN_SECTION) {
+            if (in_story)
+                break;
+            in_story = ini_view_equals(token.section, "STORY");
+            continue;
+        }
+
+        if (!in_story)
+            continue;
+
+        if (ini_view_equals(token.key, "title"))
+            ini_view_copy(token.value, info->title, sizeof(info->title));
+        else if (ini_view_equals(token.key, "author"))
+            ini_view_copy(token.value, info->author, sizeof(info->author));
+        else if (ini_view_equals(token.key, "version"))
+            ini_view_copy(token.value, info->version, sizeof(info->version));
+        else if (ini_view_equals(token.key, "description"))
+            ini_view_copy(token.value, info->description,
+                          sizeof(info->description));
+    }
+
+    ini_close(&ini);
+    return 0;
+}
+
+
+/**
+ * scan_stories() - Find every story in the stories directory
+ * @story_list: Set to the stories found, sorted by title (caller frees)
+ *
+ * Directories without a story.ini, or whose story.ini has no title,
+ * are not stories and are left out (they stay in the cache so they are
+ * not parsed again). Costs two stat() calls per story directory, plus
+ * a parse of [STORY] for each one that is new or has changed.
+ *
+ * Return: Number of stories found
+ */
+
 int scan_stories(StoryInfo** story_list) {
-    printf("[STUB] scan_stories()\n");
-    
-    // For now, create a dummy story list with test-story
-    *story_list = malloc(sizeof(StoryInfo) * 2);
-    
-    // Story 1: Test Adventure
-    strcpy((*story_list)[0].title, "Test Adventure");
-    strcpy((*story_list)[0].author, "Engine Team");
-    strcpy((*story_list)[0].version, "0.1.0");
-    strcpy((*story_list)[0].description, "A minimal test story");
-    strcpy((*story_list)[0].directory, "stories/test-story");
-    
-    // Story 2: Gravy Boat (not yet implemented)
-    strcpy((*story_list)[1].title, "Quest for the Holy Gravy Boat");
-    strcpy((*story_list)[1].author, "Marty & Claude");
-    strcpy((*story_list)[1].version, "1.0.0");
-    strcpy((*story_list)[1].description, "A Monty Python adventure (not yet playable)");
-    strcpy((*story_list)[1].directory, "stories/gravy-boat");
-    
-    return 2;  // Return count
+    char catalog_path[STORY_DIRECTORY_SIZE + 16];
+    char ini_path[STORY_DIRECTORY_SIZE + 16];
+    CatalogEntry *cached;
+    CatalogEntry *found = NULL;
+    StoryInfo *stories;
+    struct dirent *dirent;
+    struct stat st;
+    DIR *dir;
+    int cached_count;
+    int capacity = 0;
+    int count = 0;
+    int parsed = 0;
+    int story_count = 0;
+    double start_ms = platform_time_ms();
+
+    log_function_entry(__func__, "dir=%s", stories_directory);
+    *story_list = NULL;
+
+    snprintf(catalog_path, sizeof(catalog_path), "%s/%s", stories_directory,
+             STORY_CATALOG_FILENAME);
+    cached_count = catalog_read(catalog_path, &cached);
+
+    dir = opendir(stories_directory);
+    if (!dir) {
+        log_function_error(__func__, "Cannot open stories directory");
+        free(cached);
+        log_function_exit(__func__, 0);
+        return 0;
+    }
+
+    while ((dirent = readdir(dir)) != NULL) {
+        CatalogEntry key;
+        CatalogEntry *entry;
+        CatalogEntry *hit;
+        CatalogEntry *grown;
+        long long dir_mtime;
+
+        if (dirent->d_name[0] == '.')
+            continue;
+
+        if (snprintf(key.info.directory, sizeof(key.info.directory), "%s/%s",
+                     stories_directory, dirent->d_name) >=
+            (int)sizeof(key.info.directory))
+            continue;
+
+        if (stat(key.info.directory, &st) != 0 || !S_ISDIR(st.st_mode))
+            continue;
+        dir_mtime = (long long)st.st_mtime;
+
+        snprintf(ini_path, sizeof(ini_path), "%s/story.ini",
+                 key.info.directory);
+        if (stat(ini_path, &st) != 0)
+            continue;
+
+        grown = array_grow(found, count, &capacity, sizeof(*found));
+        if (!grown)
+            break;
+        found = grown;
+        entry = &found[count++];
+
+        hit = cached_count > 0 ?
+              bsearch(&key, cached, (size_t)cached_count, sizeof(*cached),
+                      catalog_compare_directory) : NULL;
+        if (hit && hit->dir_mtime == dir_mtime &&
+            hit->ini_mtime == (long long)st.st_mtime &&
+            hit->ini_size == (long long)st.st_size) {
+            *entry = *hit;
+            continue;
+        }
+
+        entry->info = key.info;
+        entry->dir_mtime = dir_mtime;
+        entry->ini_mtime = (long long)st.st_mtime;
+        entry->ini_size = (long long)st.st_size;
+        read_story_info(ini_path, &entry->info);
+        parsed++;
+    }
+    closedir(dir);
+
+    /* Rewrite only when a story was added, changed or removed */
+    if (parsed > 0 || count != cached_count)
+        catalog_write(catalog_path, found, count);
+    free(cached);
+
+    stories = malloc(sizeof(StoryInfo) * (size_t)(count > 0 ? count : 1));
+    if (!stories) {
+        free(found);
+        log_function_error(__func__, "story list malloc failed");
+        log_function_exit(__func__, 0);
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (found[i].info.title[0] != '\0')
+            stories[story_count++] = found[i].info;
+    }
+    free(found);
+
+    qsort(stories, (size_t)story_count, sizeof(*stories),
+          catalog_compare_title);
+    *story_list = stories;
+
+    add_log_entry("Found %d stories in %d directories in %.2f ms "
+                  "(%d parsed, %d from %s)", story_count, count,
+                  platform_time_ms() - start_ms, parsed, count - parsed,
+                  STORY_CATALOG_FILENAME);
+    log_function_exit(__func__, story_count);
+    return story_count;
 }
 
-/*
- * Select a story
+
+/**
+ * filter_stories() - Find the stories matching a menu filter
+ * @story_list: Stories to search
+ * @count: Number of stories
+ * @filter: Text to look for, ignoring case ("" or NULL matches all)
+ * @matches: Receives the position of each match (room for @count)
+ *
+ * Return: Number of matches
+ */
+
+int filter_stories(const StoryInfo* story_list, int count, const char* filter,
+                   int* matches) {
+    int match_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        const StoryInfo *info = &story_list[i];
+
+        if (!filter || filter[0] == '\0' ||
+            contains_ignore_case(info->title, filter) ||
+            contains_ignore_case(info->author, filter) ||
+            contains_ignore_case(info->description, filter))
+            matches[match_count++] = i;
+    }
+
+    return match_count;
+}
+
+
+/**
+ * select_story() - Let the player choose a story
+ * @story_list: Stories to choose from
+ * @count: Number of stories
+ *
+ * Lists STORY_MENU_PAGE_SIZE stories at a time. The player picks one by
+ * number, moves between pages with n and p, or types /text to list only
+ * stories whose title, author or description contain it (a lone /
+ * lists everything again).
+ *
+ * Return: The loaded story, NULL if cancelled or it failed to load
  */
+
 Story* select_story(StoryInfo* story_list, int count) {
-    printf("\nSelect a story (1-%d, or 0 to cancel): ", count);
-    
-    char input[10];
-    if (fgets(input, sizeof(input), stdin) == NULL) {
+    char filter[STORY_FILTER_SIZE] = "";
+    char input[STORY_FILTER_SIZE + 8];
+    int *matches;
+    int match_count;
+    int page = 0;
+    int choice;
+    Story* story;
+
+    if (count <= 0)
         return NULL;
+
+    matches = malloc(sizeof(int) * (size_t)count);
+    if (!matches)
+        return NULL;
+    match_count = filter_stories(story_list, count, filter, matches);
+
+    for (;;) {
+        int pages = (match_count + STORY_MENU_PAGE_SIZE - 1) /
+                    STORY_MENU_PAGE_SIZE;
+        int first;
+        int last;
+
+        if (page >= pages)
+            page = pages > 0 ? pages - 1 : 0;
+        first = page * STORY_MENU_PAGE_SIZE;
+        last = first + STORY_MENU_PAGE_SIZE;
+        if (last > match_count)
+            last = match_count;
+
+        if (filter[0] != '\0')
+            printf_colored(COLOR_INFO, "%d matching \"%s\":\n", match_count,
+                           filter);
+        for (int i = first; i < last; i++) {
+            const StoryInfo *info = &story_list[matches[i]];
+
+            printf_colored(COLOR_BRIGHT_CYAN, "%d. ", i + 1);
+            printf_colored(COLOR_BOLD, "%s ", info->title);
+            printf_colored(COLOR_GRAY, "(by %s)\n", info->author);
+        }
+
+        if (pages > 1)
+            printf_colored(COLOR_GRAY, "Page %d of %d\n", page + 1, pages);
+
+        if (pages > 1 || filter[0] != '\0' || count > STORY_MENU_PAGE_SIZE)
+            printf("\nSelect a story (1-%d), n/p to page, /text to filter, "
+                   "or 0 to cancel: ", match_count);
+        else
+            printf("\nSelect a story (1-%d, or 0 to cancel): ", match_count);
+
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            free(matches);
+            return NULL;
+        }
+        input[strcspn(input, "\r\n")] = '\0';
+
+        if (strcmp(input, "n") == 0) {
+            if (page + 1 < pages)
+                page++;
+            printf("\n");
+            continue;
+        }
+        if (strcmp(input, "p") == 0) {
+            if (page > 0)
+                page--;
+            printf("\n");
+            continue;
+        }
+        if (input[0] == '/') {
+            safe_strcpy(filter, trim_whitespace(input + 1), sizeof(filter));
+            match_count = filter_stories(story_list, count, filter, matches);
+            page = 0;
+            printf("\n");
+            continue;
+        }
+
+        break;
     }
-    
-    int choice = atoi(input);
-    
-    if (choice < 1 || choice > count) {
+
+    choice = atoi(input);
+    if (choice < 1 || choice > match_count) {
+        free(matches);
         return NULL;
     }
-    
+
     // Load the selected story
-    printf("\nLoading: %s...\n", story_list[choice - 1].title);
-    Story* story = load_story(story_list[choice - 1].directory);
-    
+    choice = matches[choice - 1];
+    free(matches);
+    printf("\nLoading: %s...\n", story_list[choice].title);
+    story = load_story(story_list[choice].directory);
+
     return story;
-}
\ No newline at end of file
+}
@@ -5,6 +5,12 @@
 
 /*
  * Story manager functions
+ *
+ * The stories directory holds one directory per story. scan_stories()
+ * reads only the [STORY] section of each story.ini and remembers what
+ * it found in STORY_CATALOG_FILENAME, keyed by the modification times
+ * of the story directory and its story.ini, so a later scan parses only
+ * the stories that changed.
  */
 
 // Initialize story manager
@@ -13,10 +19,15 @@ void story_manager_init(const char* stories_dir);
 // Cleanup story manager
 void story_manager_cleanup(void);
 
-// Scan for available stories
+// Scan for available stories, sorted by title (caller frees the list)
 int scan_stories(StoryInfo** story_list);
 
-// Select a story (returns loaded story or NULL)
+// Positions of stories whose title, author or description contain filter
+int filter_stories(const StoryInfo* story_list, int count, const char* filter,
+                   int* matches);
+
+// Let the player page through, filter and pick a story (returns loaded
+// story or NULL)
 Story* select_story(StoryInfo* story_list, int count);
 
-#endif // STORY_MANAGER_H
\ No newline at end of file
+#endif // STORY_MANAGER_H
@@ -0,0 +1,485 @@
+/*
+ * reload.c - Patch a loaded story from a story file edited on disk
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "reload.h"
+#include "core/logger.h"
+#include "index.h"
+#include "link.h"
+#include "loader.h"
+#include "system/platform.h"
+#include "world/items.h"
+#include "world/nouns.h"
+#include "world/npcs.h"
+#include "world/rooms.h"
+
+
+/**
+ * struct ReloadPatch - Patching one entity
+ * @arena: Story arena, which receives changed text
+ * @changed: Something differed
+ * @failed: Text could not be copied
+ */
+
+typedef struct {
+	Arena *arena;
+	bool changed;
+	bool failed;
+} ReloadPatch;
+
+
+/**
+ * reload_string() - Bring one string field up to date
+ * @patch: Entity being patched
+ * @field: Field in the loaded story
+ * @value: Value just parsed (NULL for a lazily loaded description)
+ *
+ * Return: void
+ */
+
+static void reload_string(ReloadPatch *patch, const char **field,
+			  const char *value)
+{
+	char *copy;
+
+	if (*field == value || (*field && value && strcmp(*field, value) == 0))
+		return;
+
+	patch->changed = true;
+	if (!value) {
+		*field = NULL;
+		return;
+	}
+
+	copy = arena_strndup(patch->arena, value, strlen(value));
+	if (copy)
+		*field = copy;
+	else
+		patch->failed = true;
+}
+
+
+/**
+ * reload_list() - Bring a string list up to date
+ * @patch: Entity being patched
+ * @list: List in the loaded story
+ * @count: Its length
+ * @values: List just parsed
+ * @value_count: Its length
+ *
+ * The list is replaced as a whole if any entry differs.
+ *
+ * Return: void
+ */
+
+static void reload_list(ReloadPatch *patch, char ***list, int *count,
+			char **values, int value_count)
+{
+	char **copy;
+	int i;
+
+	if (*count == value_count) {
+		for (i = 0; i < value_count; i++) {
+			const char *a = (*list)[i];
+			const char *b = values[i];
+
+			if (a != b && (!a || !b || strcmp(a, b) != 0))
+				break;
+		}
+		if (i == value_count)
+			return;
+	}
+
+	patch->changed = true;
+	copy = value_count > 0 ?
+	       arena_calloc(patch->arena, (size_t)value_count, sizeof(char *)) :
+	       NULL;
+	if (value_count > 0 && !copy) {
+		patch->failed = true;
+		return;
+	}
+
+	for (i = 0; i < value_count; i++) {
+		if (values[i])
+			copy[i] = arena_strndup(patch->arena, values[i],
+						strlen(values[i]));
+	}
+
+	*list = copy;
+	*count = value_count;
+}
+
+
+/**
+ * reload_refs() - Take over where lazily loaded lines now are
+ * @patch: Entity being patched
+ * @refs: Positions in the loaded story
+ * @old_count: Number of entries in @refs
+ * @values: Positions just parsed
+ * @count: Number of entries in @values
+ *
+ * Offsets move whenever anything earlier in the file changes, so the
+ * positions are always replaced. Only a change of length or of the
+ * number of lines counts as a change of text.
+ *
+ * Return: void
+ */
+
+static void reload_refs(ReloadPatch *patch, TextRef **refs, int old_count,
+			const TextRef *values, int count)
+{
+	TextRef *copy = NULL;
+	int common = old_count < count ? old_count : count;
+
+	if (!values && !*refs)
+		return;
+
+	if (count > 0 && values) {
+		copy = arena_alloc(patch->arena, (size_t)count * sizeof(TextRef));
+		if (!copy) {
+			patch->failed = true;
+			return;
+		}
+		memcpy(copy, values, (size_t)count * sizeof(TextRef));
+	}
+
+	if (old_count != count)
+		patch->changed = true;
+	for (int i = 0; *refs && copy && i < common; i++) {
+		if ((*refs)[i].length != copy[i].length)
+			patch->changed = true;
+	}
+
+	*refs = copy;
+}
+
+
+static void reload_ref(ReloadPatch *patch, TextRef *ref, TextRef value)
+{
+	if (ref->length != value.length)
+		patch->changed = true;
+	*ref = value;
+}
+
+
+#define RELOAD_FIELD(patch, field, value)			\
+	do {							\
+		if ((field) != (value)) {			\
+			(field) = (value);			\
+			(patch)->changed = true;		\
+		}						\
+	} while (0)
+
+
+/**
+ * reload_room() - Patch one room from its new definition
+ * @story: Story being played
+ * @room: Loaded room
+ * @fresh: Room just parsed
+ * @patch: Patch state
+ *
+ * Return: void
+ */
+
+static void reload_room(Story *story, Room *room, const Room *fresh,
+			ReloadPatch *patch)
+{
+	Item **items = room->items;
+	int item_count = room->item_count;
+	int item_capacity = room->item_capacity;
+	int d;
+
+	reload_string(patch, &room->name, fresh->name);
+	reload_string(patch, &room->description, fresh->description);
+	reload_ref(patch, &room->description_ref, fresh->description_ref);
+	for (d = 0; d < DIR_COUNT; d++)
+		reload_string(patch, (const char **)&room->exit_ids[d],
+			      fresh->exit_ids[d]);
+	reload_list(patch, &room->item_ids, &room->item_id_count,
+		    fresh->item_ids, fresh->item_id_count);
+	reload_list(patch, &room->npc_ids, &room->npc_id_count,
+		    fresh->npc_ids, fresh->npc_id_count);
+	RELOAD_FIELD(patch, room->dark, fresh->dark);
+
+	/* The player may have unlocked it */
+	if (!room->changed) {
+		RELOAD_FIELD(patch, room->locked, fresh->locked);
+		RELOAD_FIELD(patch, room->locked_exit, fresh->locked_exit);
+	}
+
+	if (!patch->changed)
+		return;
+
+	room->exit_count = fresh->exit_count;
+	if (link_room_array(story, room, 1, patch->arena) < 0) {
+		patch->failed = true;
+		return;
+	}
+
+	/* Keep what the player took or dropped */
+	if (room->changed) {
+		room->items = items;
+		room->item_count = item_count;
+		room->item_capacity = item_capacity;
+	}
+}
+
+
+/**
+ * reload_item() - Patch one item from its new definition
+ * @item: Loaded item
+ * @fresh: Item just parsed
+ * @patch: Patch state
+ *
+ * Return: void
+ */
+
+static void reload_item(Item *item, const Item *fresh, ReloadPatch *patch)
+{
+	reload_string(patch, &item->name, fresh->name);
+	reload_string(patch, &item->description, fresh->description);
+	reload_ref(patch, &item->description_ref, fresh->description_ref);
+	RELOAD_FIELD(patch, item->weight, fresh->weight);
+	RELOAD_FIELD(patch, item->takeable, fresh->takeable);
+	RELOAD_FIELD(patch, item->useable, fresh->useable);
+	RELOAD_FIELD(patch, item->illuminates, fresh->illuminates);
+	RELOAD_FIELD(patch, item->unlocks, fresh->unlocks);
+
+	if (patch->changed &&
+	    noun_key_build(&item->key, patch->arena, item->name, item->id) != 0)
+		patch->failed = true;
+}
+
+
+/**
+ * reload_npc() - Patch one NPC from its new definition
+ * @story: Story being played
+ * @npc: Loaded NPC
+ * @fresh: NPC just parsed
+ * @patch: Patch state
+ *
+ * Return: void
+ */
+
+static void reload_npc(Story *story, NPC *npc, const NPC *fresh,
+		       ReloadPatch *patch)
+{
+	int dialog_count = npc->dialog ? npc->dialog_count : 0;
+	int combat_text_count = npc->combat_text ? npc->combat_text_count : 0;
+	int dialog_ref_count = npc->dialog_refs ? npc->dialog_count : 0;
+	int combat_text_ref_count = npc->combat_text_refs ?
+				    npc->combat_text_count : 0;
+
+	reload_string(patch, &npc->name, fresh->name);
+	reload_string(patch, &npc->description, fresh->description);
+	reload_ref(patch, &npc->description_ref, fresh->description_ref);
+	reload_list(patch, &npc->dialog, &dialog_count, fresh->dialog,
+		    fresh->dialog ? fresh->dialog_count : 0);
+	reload_list(patch, &npc->combat_text, &combat_text_count,
+		    fresh->combat_text,
+		    fresh->combat_text ? fresh->combat_text_count : 0);
+	RELOAD_FIELD(patch, npc->dialog_count, fresh->dialog_count);
+	RELOAD_FIELD(patch, npc->combat_text_count, fresh->combat_text_count);
+	reload_refs(patch, &npc->dialog_refs, dialog_ref_count,
+		    fresh->dialog_refs,
+		    fresh->dialog_refs ? fresh->dialog_count : 0);
+	reload_refs(patch, &npc->combat_text_refs, combat_text_ref_count,
+		    fresh->combat_text_refs,
+		    fresh->combat_text_refs ? fresh->combat_text_count : 0);
+	reload_string(patch, &npc->location, fresh->location);
+	reload_string(patch, &npc->required_item, fresh->required_item);
+	reload_string(patch, &npc->greeting_dialog, fresh->greeting_dialog);
+	RELOAD_FIELD(patch, npc->hostile, fresh->hostile);
+	RELOAD_FIELD(patch, npc->combat_damage, fresh->combat_damage);
+	RELOAD_FIELD(patch, npc->base_win_chance, fresh->base_win_chance);
+	RELOAD_FIELD(patch, npc->item_win_chance, fresh->item_win_chance);
+	if (!npc->defeated)
+		RELOAD_FIELD(patch, npc->combat_hp, fresh->combat_hp);
+
+	if (npc->dialog_index >= npc->dialog_count)
+		npc->dialog_index = 0;
+
+	if (!patch->changed)
+		return;
+
+	link_npc_array(story, npc, 1);
+	if (noun_key_build(&npc->key, patch->arena, npc->name, npc->id) != 0)
+		patch->failed = true;
+}
+
+
+/**
+ * reload_load() - Parse one story file into a scratch arena
+ * @story: Story being played
+ * @file: File to parse
+ * @arena: Scratch arena
+ * @entities: Set to the parsed array
+ *
+ * Return: Number of entities parsed
+ */
+
+static int reload_load(Story *story, TextFile file, Arena *arena,
+		       void **entities)
+{
+	bool lazy = story->text.enabled;
+
+	switch (file) {
+	case TEXT_FILE_ROOMS:
+		return load_rooms(story->story_dir, arena, lazy,
+				  (Room **)entities);
+	case TEXT_FILE_ITEMS:
+		return load_items(story->story_dir, arena, lazy,
+				  (Item **)entities);
+	case TEXT_FILE_NPCS:
+		return load_npcs(story->story_dir, arena, lazy,
+				 (NPC **)entities);
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * story_reload_file() - Re-read one story file into a loaded story
+ * @story: Story being played
+ * @file: rooms.ini, items.ini or npcs.ini
+ * @result: Filled in with what changed
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_reload_file(Story *story, TextFile file, StoryReload *result)
+{
+	const StoryIndex *index;
+	StoryIndex fresh_index;
+	ReloadPatch patch;
+	Arena scratch;
+	void *fresh = NULL;
+	char *loaded;
+	size_t stride;
+	size_t id_offset;
+	int loaded_count;
+	int count;
+	int ret = 0;
+	double start = platform_time_ms();
+	int i;
+
+	log_function_entry(__func__, "file=%s", text_file_name(file));
+	memset(result, 0, sizeof(*result));
+
+	switch (file) {
+	case TEXT_FILE_ROOMS:
+		/* Slots hold header offsets into the old file */
+		if (story->stream.enabled) {
+			log_function_exit(__func__, -ENOTSUP);
+			return -ENOTSUP;
+		}
+		index = &story->room_index;
+		loaded = (char *)story->rooms;
+		loaded_count = story->room_count;
+		stride = sizeof(Room);
+		id_offset = offsetof(Room, id);
+		break;
+	case TEXT_FILE_ITEMS:
+		index = &story->item_index;
+		loaded = (char *)story->items;
+		loaded_count = story->item_count;
+		stride = sizeof(Item);
+		id_offset = offsetof(Item, id);
+		break;
+	case TEXT_FILE_NPCS:
+		index = &story->npc_index;
+		loaded = (char *)story->npcs;
+		loaded_count = story->npc_count;
+		stride = sizeof(NPC);
+		id_offset = offsetof(NPC, id);
+		break;
+	default:
+		log_function_exit(__func__, -EINVAL);
+		return -EINVAL;
+	}
+
+	arena_init(&scratch, 0);
+	count = reload_load(story, file, &scratch, &fresh);
+	if (count == 0) {
+		/* Most likely caught half written; keep what is loaded */
+		arena_free(&scratch);
+		log_function_exit(__func__, -ENOENT);
+		return -ENOENT;
+	}
+
+	for (i = 0; i < count; i++) {
+		char *entity = (char *)fresh + (size_t)i * stride;
+		const char *id = *(const char *const *)(entity + id_offset);
+		int n = story_index_find(index, id);
+
+		if (n < 0) {
+			result->added++;
+			add_log_entry("Reload: %s defines new '%s'; restart to "
+				      "add it", text_file_name(file), id);
+			continue;
+		}
+
+		patch.arena = &story->arena;
+		patch.changed = false;
+		patch.failed = false;
+
+		switch (file) {
+		case TEXT_FILE_ROOMS:
+			reload_room(story, &story->rooms[n], (Room *)entity,
+				    &patch);
+			break;
+		case TEXT_FILE_ITEMS:
+			reload_item(&story->items[n], (Item *)entity, &patch);
+			break;
+		default:
+			reload_npc(story, &story->npcs[n], (NPC *)entity,
+				   &patch);
+			break;
+		}
+
+		if (patch.failed)
+			ret = -ENOMEM;
+		if (patch.changed) {
+			result->changed++;
+			add_log_entry("Reload: patched '%s' from %s", id,
+				      text_file_name(file));
+		}
+	}
+
+	/* IDs the file no longer defines */
+	if (story_index_build(&fresh_index, &scratch, fresh, count, stride,
+			      id_offset, "reloaded") == 0) {
+		for (i = 0; i < loaded_count; i++) {
+			const char *id = *(const char *const *)
+				(loaded + (size_t)i * stride + id_offset);
+
+			if (story_index_find(&fresh_index, id) < 0)
+				result->removed++;
+		}
+	}
+
+	text_cache_refresh(&story->text, file);
+	arena_free(&scratch);
+
+	/*
+	 * A patched room, item or NPC may be on show in any room. Lazy
+	 * text edited without changing its length is not counted as a
+	 * change (the old bytes are gone), so drop the views regardless.
+	 */
+	room_views_invalidate_all(story);
+
+	result->elapsed_ms = platform_time_ms() - start;
+	add_log_entry("Reloaded %s: %d changed, %d added, %d removed in %.2f ms",
+		      text_file_name(file), result->changed, result->added,
+		      result->removed, result->elapsed_ms);
+	log_function_exit(__func__, ret);
+	return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ * reload.h - Patch a loaded story from a story file edited on disk
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_RELOAD_H
+#define STORY_RELOAD_H
+
+#include "story.h"
+
+
+/**
+ * struct StoryReload - What reloading one file changed
+ * @changed: Entities patched in place
+ * @added: IDs new to the file, left out until the story is restarted
+ * @removed: IDs gone from the file, left as they were
+ * @elapsed_ms: Time taken to parse the file and patch the story
+ */
+
+typedef struct StoryReload {
+	int changed;
+	int added;
+	int removed;
+	double elapsed_ms;
+} StoryReload;
+
+
+/**
+ * story_reload_file() - Re-read one story file into a loaded story
+ * @story: Story being played
+ * @file: rooms.ini, items.ini or npcs.ini
+ * @result: Filled in with what changed
+ *
+ * Parses @file again and compares each entity with the one of the same
+ * ID already loaded. Entities that differ are patched where they are,
+ * so every pointer into the story (the player's room, inventory, the
+ * NPC being fought, links between entities) stays valid. Changed text
+ * is copied into the story arena; what it replaces stays there until
+ * the story is freed.
+ *
+ * What the player has done is kept: the contents and lock of a room the
+ * player has changed, and a defeated NPC stays defeated. Entities
+ * cannot be added or removed without moving the arrays, so new and
+ * missing IDs are only counted.
+ *
+ * Return: 0 on success, -ENOTSUP for the rooms of a streamed story,
+ * -ENOENT if the file holds no entities, other negative errno on
+ * failure
+ */
+
+int story_reload_file(Story *story, TextFile file, StoryReload *result);
+
+
+#endif /* STORY_RELOAD_H */
@@ -1,6 +1,1107 @@
 /*
- * Script system - not yet implemented
+ * scripts.c - Compile condition expressions to bytecode and run them
+ *
+ * Scripts, quests and dialog nodes hold conditions such as
+ *
+ *	has(gravy_boat) && done(rabbit_quest) && turns < 500
+ *
+ * compile_scripts() turns each one into a short run of instructions for
+ * a stack machine while the story loads: constant subexpressions are
+ * folded away and every ID becomes an array index. script_eval() then
+ * walks the run with a fixed stack, so the conditions checked every
+ * turn cost a few switch cases rather than string parsing and lookups.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
-// Prevent empty translation unit warning
-typedef int prevent_empty_translation_unit_warning_scripts;
\ No newline at end of file
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "scripts.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "story/ini_parser.h"
+#include "ui/colors.h"
+
+
+/**
+ * enum ScriptOpcode - Instructions of the expression stack machine
+ *
+ * Loads push one value. Unary operators replace the top value; binary
+ * operators pop two and push one. The jumps implement && and ||: they
+ * leave the deciding value and skip forward by their argument, or pop
+ * it and fall through to the right-hand side.
+ */
+
+typedef enum {
+	SCRIPT_OP_RETURN,
+	SCRIPT_OP_PUSH,		/* arg: constant */
+	SCRIPT_OP_VAR,		/* arg: ScriptVar */
+	SCRIPT_OP_HAS,		/* arg: item index */
+	SCRIPT_OP_IN,		/* arg: room number */
+	SCRIPT_OP_HERE_ITEM,	/* arg: item index */
+	SCRIPT_OP_HERE_NPC,	/* arg: NPC index */
+	SCRIPT_OP_DEFEATED,	/* arg: NPC index */
+	SCRIPT_OP_STATE,	/* arg: NPC index */
+	SCRIPT_OP_STARTED,	/* arg: quest index */
+	SCRIPT_OP_DONE,		/* arg: quest index */
+	SCRIPT_OP_FAILED,	/* arg: quest index */
+	SCRIPT_OP_NOT,
+	SCRIPT_OP_NEG,
+	SCRIPT_OP_BOOL,
+	SCRIPT_OP_ADD,
+	SCRIPT_OP_SUB,
+	SCRIPT_OP_MUL,
+	SCRIPT_OP_DIV,
+	SCRIPT_OP_MOD,
+	SCRIPT_OP_LT,
+	SCRIPT_OP_LE,
+	SCRIPT_OP_GT,
+	SCRIPT_OP_GE,
+	SCRIPT_OP_EQ,
+	SCRIPT_OP_NE,
+	SCRIPT_OP_JUMP_FALSE,	/* arg: forward offset */
+	SCRIPT_OP_JUMP_TRUE	/* arg: forward offset */
+} ScriptOpcode;
+
+
+/**
+ * enum ScriptVar - Game values an expression can read by name
+ */
+
+typedef enum {
+	SCRIPT_VAR_TURNS,
+	SCRIPT_VAR_SCORE,
+	SCRIPT_VAR_DEATHS,
+	SCRIPT_VAR_WEIGHT,
+	SCRIPT_VAR_ITEMS,
+	SCRIPT_VAR_HP,
+	SCRIPT_VAR_COUNT
+} ScriptVar;
+
+/* Variable names, indexed by ScriptVar */
+static const char *const script_vars[SCRIPT_VAR_COUNT] = {
+	"turns", "score", "deaths", "weight", "items", "hp"
+};
+
+
+/**
+ * enum ScriptArg - What the ID passed to a function names
+ */
+
+typedef enum {
+	SCRIPT_ARG_ITEM,
+	SCRIPT_ARG_ROOM,
+	SCRIPT_ARG_NPC,
+	SCRIPT_ARG_QUEST,
+	SCRIPT_ARG_THING,	/* NPC, or item if no NPC has the ID */
+	SCRIPT_ARG_SCRIPT
+} ScriptArg;
+
+/* Functions of one ID and the instruction each compiles to */
+static const struct {
+	const char *name;
+	ScriptOpcode op;
+	ScriptArg arg;
+} script_functions[] = {
+	{ "has",       SCRIPT_OP_HAS,      SCRIPT_ARG_ITEM },
+	{ "in",        SCRIPT_OP_IN,       SCRIPT_ARG_ROOM },
+	{ "here",      SCRIPT_OP_HERE_NPC, SCRIPT_ARG_THING },
+	{ "defeated",  SCRIPT_OP_DEFEATED, SCRIPT_ARG_NPC },
+	{ "state",     SCRIPT_OP_STATE,    SCRIPT_ARG_NPC },
+	{ "started",   SCRIPT_OP_STARTED,  SCRIPT_ARG_QUEST },
+	{ "done",      SCRIPT_OP_DONE,     SCRIPT_ARG_QUEST },
+	{ "completed", SCRIPT_OP_DONE,     SCRIPT_ARG_QUEST },
+	{ "failed",    SCRIPT_OP_FAILED,   SCRIPT_ARG_QUEST },
+	{ "script",    SCRIPT_OP_RETURN,   SCRIPT_ARG_SCRIPT },
+};
+
+
+/**
+ * struct ScriptCompiler - State of compile_scripts()
+ * @story: Story whose indexes resolve IDs
+ * @code: Bytecode of every expression compiled so far
+ * @length: Instructions used in @code
+ * @capacity: Instructions allocated for @code
+ * @source: Expression being parsed (a called script's, inside script())
+ * @pos: Parse position in @source
+ * @nesting: script() calls being compiled inside one another
+ * @failed: The current expression has an error
+ * @out_of_memory: @code could not grow
+ * @errors: Expressions that failed to compile
+ * @error: Message for the current expression's first error
+ */
+
+typedef struct {
+	Story *story;
+	ScriptOp *code;
+	int length;
+	int capacity;
+	const char *source;
+	const char *pos;
+	int nesting;
+	bool failed;
+	bool out_of_memory;
+	int errors;
+	char error[128];
+} ScriptCompiler;
+
+
+/**
+ * struct ScriptOperand - What parsing a subexpression produced
+ * @constant: The subexpression is a constant, compiled to a single push
+ * @value: Its value, when @constant
+ * @start: Where its code starts in ScriptCompiler.code
+ */
+
+typedef struct {
+	bool constant;
+	int32_t value;
+	int start;
+} ScriptOperand;
+
+
+/**
+ * script_arith() - Apply an operator to values
+ * @op: Unary or binary operator
+ * @a: Left operand (the only one for unary operators)
+ * @b: Right operand
+ *
+ * Shared by constant folding and the interpreter so both agree.
+ * Arithmetic wraps, and dividing by zero gives 0.
+ *
+ * Return: The result
+ */
+
+static int32_t script_arith(ScriptOpcode op, int32_t a, int32_t b)
+{
+	switch (op) {
+	case SCRIPT_OP_NOT:
+		return !a;
+	case SCRIPT_OP_NEG:
+		return (int32_t)(0u - (uint32_t)a);
+	case SCRIPT_OP_BOOL:
+		return a != 0;
+	case SCRIPT_OP_ADD:
+		return (int32_t)((uint32_t)a + (uint32_t)b);
+	case SCRIPT_OP_SUB:
+		return (int32_t)((uint32_t)a - (uint32_t)b);
+	case SCRIPT_OP_MUL:
+		return (int32_t)((uint32_t)a * (uint32_t)b);
+	case SCRIPT_OP_DIV:
+		if (b == 0)
+			return 0;
+		return b == -1 ? (int32_t)(0u - (uint32_t)a) : a / b;
+	case SCRIPT_OP_MOD:
+		return b == 0 || b == -1 ? 0 : a % b;
+	case SCRIPT_OP_LT:
+		return a < b;
+	case SCRIPT_OP_LE:
+		return a <= b;
+	case SCRIPT_OP_GT:
+		return a > b;
+	case SCRIPT_OP_GE:
+		return a >= b;
+	case SCRIPT_OP_EQ:
+		return a == b;
+	case SCRIPT_OP_NE:
+		return a != b;
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * script_error() - Record the current expression's first error
+ * @c: Compiler
+ * @fmt: printf-style message
+ *
+ * Return: void
+ */
+
+static void script_error(ScriptCompiler *c, const char *fmt, ...)
+{
+	va_list args;
+	size_t len;
+
+	if (c->failed)
+		return;
+	c->failed = true;
+
+	va_start(args, fmt);
+	vsnprintf(c->error, sizeof(c->error), fmt, args);
+	va_end(args);
+
+	len = strlen(c->error);
+	snprintf(c->error + len, sizeof(c->error) - len, " at column %d",
+		 (int)(c->pos - c->source) + 1);
+}
+
+
+static void script_emit(ScriptCompiler *c, ScriptOpcode op, int32_t arg)
+{
+	ScriptOp *grown;
+
+	if (c->out_of_memory)
+		return;
+
+	grown = array_grow(c->code, c->length, &c->capacity, sizeof(ScriptOp));
+	if (!grown) {
+		c->out_of_memory = true;
+		script_error(c, "out of memory");
+		return;
+	}
+	c->code = grown;
+	c->code[c->length].op = (uint8_t)op;
+	c->code[c->length].arg = arg;
+	c->length++;
+}
+
+
+/* Drop code emitted since @start; folding replaces it with one push */
+static void script_truncate(ScriptCompiler *c, int start)
+{
+	if (start < c->length)
+		c->length = start;
+}
+
+
+static ScriptOperand script_push(ScriptCompiler *c, int32_t value)
+{
+	ScriptOperand result = { true, value, c->length };
+
+	script_emit(c, SCRIPT_OP_PUSH, value);
+	return result;
+}
+
+
+static void script_skip_space(ScriptCompiler *c)
+{
+	while (isspace((unsigned char)*c->pos))
+		c->pos++;
+}
+
+
+/* Consume @token if the input continues with it */
+static bool script_accept(ScriptCompiler *c, const char *token)
+{
+	size_t len = strlen(token);
+
+	script_skip_space(c);
+	if (strncmp(c->pos, token, len) != 0)
+		return false;
+	c->pos += len;
+	return true;
+}
+
+
+/* Consume the keyword @word, but not the start of a longer name */
+static bool script_accept_word(ScriptCompiler *c, const char *word)
+{
+	size_t len = strlen(word);
+
+	script_skip_space(c);
+	if (strncmp(c->pos, word, len) != 0 ||
+	    isalnum((unsigned char)c->pos[len]) || c->pos[len] == '_')
+		return false;
+	c->pos += len;
+	return true;
+}
+
+
+/**
+ * script_read() - Read a name or ID
+ * @c: Compiler
+ * @out: Buffer for it
+ * @out_size: Size of @out
+ * @id: Read an entity ID, which ends only at a space, ',' or ')'
+ *
+ * Return: False if there is none, or it does not fit
+ */
+
+static bool script_read(ScriptCompiler *c, char *out, size_t out_size,
+			bool id)
+{
+	size_t len = 0;
+
+	script_skip_space(c);
+	while (c->pos[len] != '\0') {
+		unsigned char ch = (unsigned char)c->pos[len];
+
+		if (id ? (isspace(ch) || ch == ')' || ch == ',') :
+			 !(isalnum(ch) || ch == '_'))
+			break;
+		len++;
+	}
+
+	if (len == 0 || len >= out_size)
+		return false;
+	memcpy(out, c->pos, len);
+	out[len] = '\0';
+	c->pos += len;
+	return true;
+}
+
+
+static ScriptOperand script_or(ScriptCompiler *c);
+
+
+/**
+ * script_call() - Compile a script's condition in place of script(id)
+ * @c: Compiler
+ * @id: Script ID
+ *
+ * The condition is compiled inline, so it folds with its surroundings
+ * and runs without a call.
+ *
+ * Return: The condition, as an operand
+ */
+
+static ScriptOperand script_call(ScriptCompiler *c, const char *id)
+{
+	ScriptOperand result = { true, 0, c->length };
+	const char *saved_source = c->source;
+	const char *saved_pos = c->pos;
+	const Script *script;
+	int i;
+
+	i = story_index_find(&c->story->script_index, id);
+	if (i < 0) {
+		script_error(c, "no script '%s'", id);
+		return result;
+	}
+	script = &c->story->scripts[i];
+	if (script->condition[0] == '\0') {
+		script_error(c, "script '%s' has no condition", id);
+		return result;
+	}
+	if (c->nesting >= SCRIPT_MAX_NESTING) {
+		script_error(c, "scripts call each other too deeply");
+		return result;
+	}
+
+	c->nesting++;
+	c->source = script->condition;
+	c->pos = script->condition;
+	result = script_or(c);
+	script_skip_space(c);
+	if (*c->pos != '\0')
+		script_error(c, "unexpected '%c' in script '%s'", *c->pos, id);
+	c->source = saved_source;
+	c->pos = saved_pos;
+	c->nesting--;
+
+	return result;
+}
+
+
+/**
+ * script_function() - Compile a function of one ID, like has(torch)
+ * @c: Compiler, positioned after the function name
+ * @op: Instruction the function compiles to
+ * @kind: What the ID names
+ *
+ * Return: The call, as an operand
+ */
+
+static ScriptOperand script_function(ScriptCompiler *c, ScriptOpcode op,
+				     ScriptArg kind)
+{
+	ScriptOperand result = { false, 0, c->length };
+	char id[SCRIPT_NAME_SIZE];
+	Story *story = c->story;
+	int index = -1;
+
+	if (!script_accept(c, "(") || !script_read(c, id, sizeof(id), true) ||
+	    !script_accept(c, ")")) {
+		script_error(c, "expected (id)");
+		return result;
+	}
+
+	switch (kind) {
+	case SCRIPT_ARG_ITEM:
+		index = story_index_find(&story->item_index, id);
+		break;
+	case SCRIPT_ARG_ROOM:
+		index = story_index_find(&story->room_index, id);
+		break;
+	case SCRIPT_ARG_NPC:
+		index = story_index_find(&story->npc_index, id);
+		break;
+	case SCRIPT_ARG_QUEST:
+		index = story_index_find(&story->quest_index, id);
+		break;
+	case SCRIPT_ARG_THING:
+		index = story_index_find(&story->npc_index, id);
+		if (index < 0) {
+			op = SCRIPT_OP_HERE_ITEM;
+			index = story_index_find(&story->item_index, id);
+		}
+		break;
+	case SCRIPT_ARG_SCRIPT:
+		return script_call(c, id);
+	}
+
+	if (index < 0) {
+		script_error(c, "'%s' does not exist", id);
+		return result;
+	}
+	script_emit(c, op, index);
+	return result;
+}
+
+
+static ScriptOperand script_primary(ScriptCompiler *c)
+{
+	ScriptOperand result = { true, 0, c->length };
+	char name[SCRIPT_NAME_SIZE];
+	size_t i;
+
+	if (script_accept(c, "(")) {
+		result = script_or(c);
+		if (!script_accept(c, ")"))
+			script_error(c, "expected ')'");
+		return result;
+	}
+
+	if (isdigit((unsigned char)*c->pos)) {
+		char *end;
+		long value = strtol(c->pos, &end, 10);
+
+		c->pos = end;
+		return script_push(c, (int32_t)value);
+	}
+
+	if (!script_read(c, name, sizeof(name), false)) {
+		script_error(c, *c->pos ? "unexpected '%c'" : "expression ends early",
+			     *c->pos);
+		return result;
+	}
+
+	if (strcmp(name, "true") == 0)
+		return script_push(c, 1);
+	if (strcmp(name, "false") == 0)
+		return script_push(c, 0);
+
+	for (i = 0; i < SCRIPT_VAR_COUNT; i++) {
+		if (strcmp(name, script_vars[i]) == 0) {
+			result.constant = false;
+			script_emit(c, SCRIPT_OP_VAR, (int32_t)i);
+			return result;
+		}
+	}
+
+	for (i = 0; i < sizeof(script_functions) / sizeof(script_functions[0]); i++) {
+		if (strcmp(name, script_functions[i].name) == 0)
+			return script_function(c, script_functions[i].op,
+					       script_functions[i].arg);
+	}
+
+	script_error(c, "unknown name '%s'", name);
+	return result;
+}
+
+
+static ScriptOperand script_unary(ScriptCompiler *c)
+{
+	ScriptOperand operand;
+	ScriptOpcode op;
+
+	if (script_accept(c, "!") || script_accept_word(c, "not"))
+		op = SCRIPT_OP_NOT;
+	else if (script_accept(c, "-"))
+		op = SCRIPT_OP_NEG;
+	else
+		return script_primary(c);
+
+	operand = script_unary(c);
+	if (operand.constant) {
+		script_truncate(c, operand.start);
+		return script_push(c, script_arith(op, operand.value, 0));
+	}
+	script_emit(c, op, 0);
+	return operand;
+}
+
+
+/* Emit a binary operator, or fold it if both sides are constant */
+static ScriptOperand script_binary(ScriptCompiler *c, ScriptOpcode op,
+				   ScriptOperand left, ScriptOperand right)
+{
+	if (left.constant && right.constant) {
+		script_truncate(c, left.start);
+		return script_push(c, script_arith(op, left.value, right.value));
+	}
+	script_emit(c, op, 0);
+	left.constant = false;
+	return left;
+}
+
+
+static ScriptOperand script_product(ScriptCompiler *c)
+{
+	ScriptOperand left = script_unary(c);
+	ScriptOpcode op;
+
+	while (!c->failed) {
+		if (script_accept(c, "*"))
+			op = SCRIPT_OP_MUL;
+		else if (script_accept(c, "/"))
+			op = SCRIPT_OP_DIV;
+		else if (script_accept(c, "%"))
+			op = SCRIPT_OP_MOD;
+		else
+			break;
+		left = script_binary(c, op, left, script_unary(c));
+	}
+	return left;
+}
+
+
+static ScriptOperand script_sum(ScriptCompiler *c)
+{
+	ScriptOperand left = script_product(c);
+	ScriptOpcode op;
+
+	while (!c->failed) {
+		if (script_accept(c, "+"))
+			op = SCRIPT_OP_ADD;
+		else if (script_accept(c, "-"))
+			op = SCRIPT_OP_SUB;
+		else
+			break;
+		left = script_binary(c, op, left, script_product(c));
+	}
+	return left;
+}
+
+
+static ScriptOperand script_compare(ScriptCompiler *c)
+{
+	ScriptOperand left = script_sum(c);
+	ScriptOpcode op;
+
+	while (!c->failed) {
+		if (script_accept(c, "=="))
+			op = SCRIPT_OP_EQ;
+		else if (script_accept(c, "!="))
+			op = SCRIPT_OP_NE;
+		else if (script_accept(c, "<="))
+			op = SCRIPT_OP_LE;
+		else if (script_accept(c, ">="))
+			op = SCRIPT_OP_GE;
+		else if (script_accept(c, "<"))
+			op = SCRIPT_OP_LT;
+		else if (script_accept(c, ">"))
+			op = SCRIPT_OP_GT;
+		else
+			break;
+		left = script_binary(c, op, left, script_sum(c));
+	}
+	return left;
+}
+
+
+/**
+ * script_logic() - Compile the right-hand side of && or ||
+ * @c: Compiler, positioned after the operator
+ * @jump: SCRIPT_OP_JUMP_FALSE for &&, SCRIPT_OP_JUMP_TRUE for ||
+ * @left: Left-hand side, already compiled
+ * @parse_right: Parser for the right-hand side
+ *
+ * A constant side that decides the result replaces the whole
+ * expression; one that does not is dropped. Otherwise the left side
+ * jumps over the right when it decides, and both paths end in a
+ * SCRIPT_OP_BOOL so the result is 0 or 1.
+ *
+ * Return: The combined operand
+ */
+
+static ScriptOperand script_logic(ScriptCompiler *c, ScriptOpcode jump,
+				  ScriptOperand left,
+				  ScriptOperand (*parse_right)(ScriptCompiler *))
+{
+	int32_t decides = jump == SCRIPT_OP_JUMP_TRUE;
+	ScriptOperand right;
+	int jump_at;
+
+	if (left.constant) {
+		/* The right side's code takes the place of the push */
+		script_truncate(c, left.start);
+		right = parse_right(c);
+		if ((left.value != 0) == decides || right.constant) {
+			script_truncate(c, left.start);
+			return script_push(c, (left.value != 0) == decides ?
+					      decides : right.value != 0);
+		}
+		script_emit(c, SCRIPT_OP_BOOL, 0);
+		return right;
+	}
+
+	jump_at = c->length;
+	script_emit(c, jump, 0);
+	right = parse_right(c);
+
+	if (right.constant) {
+		if ((right.value != 0) == decides) {
+			script_truncate(c, left.start);
+			return script_push(c, decides);
+		}
+		script_truncate(c, jump_at);
+	} else if (jump_at < c->length) {
+		c->code[jump_at].arg = c->length - jump_at;
+	}
+	script_emit(c, SCRIPT_OP_BOOL, 0);
+	return left;
+}
+
+
+static ScriptOperand script_and(ScriptCompiler *c)
+{
+	ScriptOperand left = script_compare(c);
+
+	while (!c->failed &&
+	       (script_accept(c, "&&") || script_accept_word(c, "and")))
+		left = script_logic(c, SCRIPT_OP_JUMP_FALSE, left, script_compare);
+	return left;
+}
+
+
+static ScriptOperand script_or(ScriptCompiler *c)
+{
+	ScriptOperand left = script_and(c);
+
+	while (!c->failed &&
+	       (script_accept(c, "||") || script_accept_word(c, "or")))
+		left = script_logic(c, SCRIPT_OP_JUMP_TRUE, left, script_and);
+	return left;
+}
+
+
+/**
+ * script_stack_depth() - Deepest stack a compiled expression needs
+ * @code: First instruction of the expression
+ *
+ * Jumps only go forward and leave the stack as deep as the path they
+ * skip, so one pass in order sees every depth.
+ *
+ * Return: Number of stack slots
+ */
+
+static int script_stack_depth(const ScriptOp *code)
+{
+	int depth = 0;
+	int max_depth = 0;
+
+	for (; code->op != SCRIPT_OP_RETURN; code++) {
+		if (code->op <= SCRIPT_OP_FAILED)
+			depth++;
+		else if (code->op > SCRIPT_OP_BOOL)
+			depth--;
+
+		if (depth > max_depth)
+			max_depth = depth;
+	}
+	return max_depth;
+}
+
+
+/**
+ * script_compile() - Compile one expression
+ * @c: Compiler
+ * @owner_kind: Kind of entity holding it ("quest", "dialog", ...)
+ * @owner_id: ID of that entity
+ * @field: Key the expression was given in
+ * @source: The expression, or "script:id" to use a script's condition
+ *
+ * Return: Offset of the compiled code, SCRIPT_NONE if @source is empty
+ */
+
+static int script_compile(ScriptCompiler *c, const char *owner_kind,
+			  const char *owner_id, const char *field,
+			  const char *source)
+{
+	int start = c->length;
+
+	if (source[0] == '\0')
+		return SCRIPT_NONE;
+
+	c->source = source;
+	c->pos = source;
+	c->nesting = 0;
+	c->failed = false;
+
+	/* A script used whole shares the script's compiled code */
+	if (strncmp(source, "script:", 7) == 0) {
+		char id[SCRIPT_NAME_SIZE];
+		int i;
+
+		c->pos += 7;
+		if (!script_read(c, id, sizeof(id), true)) {
+			script_error(c, "expected a script ID");
+		} else {
+			i = story_index_find(&c->story->script_index, id);
+			if (i >= 0 && c->story->scripts[i].code != SCRIPT_NONE)
+				return c->story->scripts[i].code;
+			script_error(c, "no script '%s' with a condition", id);
+		}
+	} else {
+		script_or(c);
+		script_skip_space(c);
+		if (*c->pos != '\0')
+			script_error(c, "unexpected '%c'", *c->pos);
+	}
+
+	if (!c->failed) {
+		script_emit(c, SCRIPT_OP_RETURN, 0);
+		if (!c->failed &&
+		    script_stack_depth(&c->code[start]) > SCRIPT_MAX_STACK)
+			script_error(c, "nested too deeply");
+	}
+
+	if (c->failed) {
+		c->errors++;
+		add_log_entry("Script error: %s '%s' %s: %s", owner_kind,
+			      owner_id, field, c->error);
+		printf_colored(COLOR_WARNING, "WARNING: %s '%s' %s: %s\n",
+			       owner_kind, owner_id, field, c->error);
+
+		/* A broken condition never holds */
+		script_truncate(c, start);
+		script_emit(c, SCRIPT_OP_PUSH, 0);
+		script_emit(c, SCRIPT_OP_RETURN, 0);
+	}
+
+	return start;
+}
+
+
+/**
+ * compile_scripts() - Compile every expression in a story to bytecode
+ * @story: Story with its ID indexes built
+ *
+ * Scripts are compiled first so that "script:id" fields can share
+ * their code.
+ *
+ * Return: Number of expressions that failed to compile, negative errno
+ * on allocation failure
+ */
+
+int compile_scripts(Story *story)
+{
+	ScriptCompiler c;
+	int i;
+
+	log_function_entry(__func__, "scripts=%d", story->script_count);
+
+	memset(&c, 0, sizeof(c));
+	c.story = story;
+
+	for (i = 0; i < story->script_count; i++) {
+		Script *script = &story->scripts[i];
+
+		script->code = script_compile(&c, "script", script->id,
+					      "condition", script->condition);
+	}
+
+	for (i = 0; i < story->quest_count; i++) {
+		Quest *quest = &story->quests[i];
+
+		quest->completion_code = script_compile(&c, "quest", quest->id,
+							"completion_check",
+							quest->completion_check);
+		quest->failure_code = script_compile(&c, "quest", quest->id,
+						     "failure_condition",
+						     quest->failure_condition);
+	}
+
+	for (i = 0; i < story->dialog_count; i++) {
+		DialogNode *node = &story->dialogs[i];
+
+		node->condition_code = script_compile(&c, "dialog", node->id,
+						      "condition",
+						      node->condition);
+	}
+
+	if (c.out_of_memory) {
+		free(c.code);
+		log_function_error(__func__, "Out of memory compiling scripts");
+		return -ENOMEM;
+	}
+
+	/* The arena frees the bytecode with the story */
+	if (c.length > 0) {
+		c.code = array_shrink(c.code, c.length, sizeof(ScriptOp));
+		if (arena_adopt(&story->arena, c.code,
+				(size_t)c.length * sizeof(ScriptOp)) != 0) {
+			free(c.code);
+			log_function_error(__func__, "Out of memory compiling scripts");
+			return -ENOMEM;
+		}
+	}
+	story->script_code = c.code;
+	story->script_code_length = c.length;
+
+	add_log_entry("Compiled scripts into %d instructions (%d errors) at %s",
+		      c.length, c.errors, log_timestamp());
+	log_function_exit(__func__, c.errors);
+	return c.errors;
+}
+
+
+/* Is @item carried? The inventory is short, so a scan beats an index */
+static bool script_carried(const GameState *game, const Item *item)
+{
+	for (int i = 0; i < game->inventory_count; i++) {
+		if (game->inventory[i] == item)
+			return true;
+	}
+	return false;
+}
+
+
+static bool script_item_here(const Room *room, const Item *item)
+{
+	for (int i = 0; i < room->item_count; i++) {
+		if (room->items[i] == item)
+			return true;
+	}
+	return false;
+}
+
+
+static bool script_npc_here(const Room *room, const NPC *npc)
+{
+	for (int i = 0; i < room->npc_count; i++) {
+		if (room->npcs[i] == npc)
+			return true;
+	}
+	return false;
+}
+
+
+/* Is the player in room @number? A streamed story's room is its slot's */
+static bool script_in_room(const GameState *game, int number)
+{
+	const Story *story = game->story;
+
+	if (story->stream.enabled)
+		return story->stream.slots[number].room == game->current_room;
+	return &story->rooms[number] == game->current_room;
+}
+
+
+static int32_t script_var(const GameState *game, int32_t var)
+{
+	switch ((ScriptVar)var) {
+	case SCRIPT_VAR_TURNS:
+		return game->turn_count;
+	case SCRIPT_VAR_SCORE:
+		return game->score;
+	case SCRIPT_VAR_DEATHS:
+		return game->death_count;
+	case SCRIPT_VAR_WEIGHT:
+		return game->inventory_weight;
+	case SCRIPT_VAR_ITEMS:
+		return game->inventory_count;
+	case SCRIPT_VAR_HP:
+		return game->player_combat_hp;
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * script_eval() - Run a compiled expression
+ * @game: Current game state
+ * @code: Offset of the expression in story->script_code
+ *
+ * Return: Value of the expression
+ */
+
+int32_t script_eval(const GameState *game, int code)
+{
+	const Story *story = game->story;
+	const ScriptOp *pc = &story->script_code[code];
+	int32_t stack[SCRIPT_MAX_STACK];
+	int32_t *sp = stack;	/* Next free slot */
+
+	for (;; pc++) {
+		switch ((ScriptOpcode)pc->op) {
+		case SCRIPT_OP_RETURN:
+			return sp[-1];
+		case SCRIPT_OP_PUSH:
+			*sp++ = pc->arg;
+			break;
+		case SCRIPT_OP_VAR:
+			*sp++ = script_var(game, pc->arg);
+			break;
+		case SCRIPT_OP_HAS:
+			*sp++ = script_carried(game, &story->items[pc->arg]);
+			break;
+		case SCRIPT_OP_IN:
+			*sp++ = script_in_room(game, pc->arg);
+			break;
+		case SCRIPT_OP_HERE_ITEM:
+			*sp++ = script_item_here(game->current_room,
+						 &story->items[pc->arg]);
+			break;
+		case SCRIPT_OP_HERE_NPC:
+			*sp++ = script_npc_here(game->current_room,
+						&story->npcs[pc->arg]);
+			break;
+		case SCRIPT_OP_DEFEATED:
+			*sp++ = story->npcs[pc->arg].defeated;
+			break;
+		case SCRIPT_OP_STATE:
+			*sp++ = story->npcs[pc->arg].dialog_state;
+			break;
+		case SCRIPT_OP_STARTED:
+			*sp++ = story->quests[pc->arg].started;
+			break;
+		case SCRIPT_OP_DONE:
+			*sp++ = story->quests[pc->arg].completed;
+			break;
+		case SCRIPT_OP_FAILED:
+			*sp++ = story->quests[pc->arg].failed;
+			break;
+		case SCRIPT_OP_NOT:
+		case SCRIPT_OP_NEG:
+		case SCRIPT_OP_BOOL:
+			sp[-1] = script_arith((ScriptOpcode)pc->op, sp[-1], 0);
+			break;
+		case SCRIPT_OP_JUMP_FALSE:
+			if (sp[-1] == 0)
+				pc += pc->arg - 1;
+			else
+				sp--;
+			break;
+		case SCRIPT_OP_JUMP_TRUE:
+			if (sp[-1] != 0)
+				pc += pc->arg - 1;
+			else
+				sp--;
+			break;
+		default:
+			sp--;
+			sp[-1] = script_arith((ScriptOpcode)pc->op, sp[-1], sp[0]);
+			break;
+		}
+	}
+}
+
+
+/**
+ * script_test() - Evaluate an optional condition
+ * @game: Current game state
+ * @code: Offset of the expression, or SCRIPT_NONE
+ *
+ * Return: True if there is no condition or it holds
+ */
+
+bool script_test(const GameState *game, int code)
+{
+	return code == SCRIPT_NONE || script_eval(game, code) != 0;
+}
+
+
+/**
+ * load_scripts() - Load script definitions from scripts.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena that takes ownership of the script array
+ * @scripts_out: Pointer to store the script array
+ *
+ * Only type, description and condition are read; the behaviour keys
+ * of the format (success_text, damage, ...) are not run yet.
+ *
+ * Return: Number of scripts loaded, 0 if there is no scripts.ini or on
+ * error
+ */
+
+int load_scripts(const char *story_dir, Arena *arena, Script **scripts_out)
+{
+	IniFile ini;
+	IniToken token;
+	char filepath[INI_VALUE_SIZE];
+	Script *scripts = NULL;
+	Script *grown;
+	int script_count = 0;
+	int script_capacity = 0;
+	int current = -1;
+
+	log_function_entry(__func__, "story_dir=%s", story_dir);
+
+	*scripts_out = NULL;
+
+	snprintf(filepath, sizeof(filepath), "%s/%s", story_dir,
+		 SCRIPTS_FILENAME);
+	if (ini_open(&ini, filepath) != 0) {
+		add_log_entry("No %s (scripts optional)", filepath);
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	while (ini_next(&ini, &token)) {
+		Script *script;
+
+		if (token.type == INI_TOKEN_SECTION) {
+			current = -1;
+			if (!ini_view_has_prefix(token.section, "SCRIPT:"))
+				continue;
+
+			grown = array_grow(scripts, script_count,
+					   &script_capacity, sizeof(Script));
+			if (!grown) {
+				log_function_error(__func__,
+						   "Failed to allocate script array");
+				break;
+			}
+			scripts = grown;
+			current = script_count++;
+
+			script = &scripts[current];
+			script->code = SCRIPT_NONE;
+			script->id = ini_view_text(arena,
+						   ini_view_skip(token.section, 7));
+			script->type = "";
+			script->description = "";
+			script->condition = "";
+			continue;
+		}
+
+		if (current < 0)
+			continue;
+		script = &scripts[current];
+
+		if (ini_view_equals(token.key, "type"))
+			script->type = ini_view_text(arena, token.value);
+		else if (ini_view_equals(token.key, "description"))
+			script->description = ini_view_text(arena, token.value);
+		else if (ini_view_equals(token.key, "condition"))
+			script->condition = ini_view_text(arena, token.value);
+	}
+
+	ini_close(&ini);
+
+	/* Finalise array at end of file; the arena frees it with the story */
+	scripts = array_shrink(scripts, script_count, sizeof(Script));
+	if (arena_adopt(arena, scripts,
+			(size_t)script_count * sizeof(Script)) != 0) {
+		free(scripts);
+		scripts = NULL;
+		script_count = 0;
+	}
+
+	*scripts_out = scripts;
+	add_log_entry("Loaded %d scripts at %s", script_count, log_timestamp());
+	log_function_exit(__func__, script_count);
+	return script_count;
+}
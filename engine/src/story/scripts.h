@@ -0,0 +1,76 @@
+/*
+ * scripts.h - scripts.ini and compiled condition expressions
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SCRIPTS_H
+#define SCRIPTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core/game.h"
+#include "story/story.h"
+
+
+/**
+ * load_scripts() - Load script definitions from scripts.ini
+ * @story_dir: Path to story directory
+ * @arena: Arena that takes ownership of the script array
+ * @scripts_out: Pointer to store the script array
+ *
+ * scripts.ini is optional. Conditions are kept as text here and
+ * compiled by compile_scripts() once the story's indexes exist.
+ *
+ * Return: Number of scripts loaded, 0 if there is no scripts.ini or on
+ * error
+ */
+
+int load_scripts(const char *story_dir, Arena *arena, Script **scripts_out);
+
+
+/**
+ * compile_scripts() - Compile every expression in a story to bytecode
+ * @story: Story with its ID indexes built
+ *
+ * Compiles script conditions, quest completion_check and
+ * failure_condition, and dialog conditions into story->script_code.
+ * Constants are folded and every entity an expression names is
+ * resolved to its array index, so evaluation never sees a string. An
+ * expression that does not compile is reported and evaluates as false.
+ *
+ * Return: Number of expressions that failed to compile, negative errno
+ * on allocation failure
+ */
+
+int compile_scripts(Story *story);
+
+
+/**
+ * script_eval() - Run a compiled expression
+ * @game: Current game state
+ * @code: Offset of the expression in story->script_code
+ *
+ * Allocates nothing; the evaluation stack is a fixed array whose depth
+ * compile_scripts() has already checked.
+ *
+ * Return: Value of the expression (conditions are 0 or 1)
+ */
+
+int32_t script_eval(const GameState *game, int code);
+
+
+/**
+ * script_test() - Evaluate an optional condition
+ * @game: Current game state
+ * @code: Offset of the expression, or SCRIPT_NONE
+ *
+ * Return: True if there is no condition or it holds
+ */
+
+bool script_test(const GameState *game, int code);
+
+
+#endif /* SCRIPTS_H */
@@ -12,8 +12,14 @@
 #define STORY_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "core/arena.h"
 #include "core/constants.h"
+#include "index.h"
+#include "stream.h"
+#include "text.h"
 
 
 /**
@@ -26,117 +32,244 @@
  * @max_inventory_weight: Maximum weight player can carry
  * @victory_score: Score needed to win (0 = not used)
  * @victory_text: Text displayed when player wins
+ *
+ * Strings live in the story's string pool and are "" when unset.
  */
 
 typedef struct {
-	char title[STORY_TITLE_SIZE];
-	char author[STORY_AUTHOR_SIZE];
-	char version[STORY_VERSION_SIZE];
-	char description[STORY_DESCRIPTION_SIZE];
-	char start_room[ROOM_ID_SIZE];
+	const char *title;
+	const char *author;
+	const char *version;
+	const char *description;
+	const char *start_room;
 	int max_inventory_weight;
 	int victory_score;
-	char victory_text[STORY_DESCRIPTION_SIZE];
+	const char *victory_text;
 } StoryMetadata;
 
 
+/**
+ * enum Direction - Ways out of a room
+ *
+ * Room exits are indexed by these values. Spellings the parser and
+ * rooms.ini accept for each one live in world/rooms.c.
+ */
+
+typedef enum {
+	DIR_NONE = -1,
+	DIR_NORTH,
+	DIR_SOUTH,
+	DIR_EAST,
+	DIR_WEST,
+	DIR_NORTHEAST,
+	DIR_NORTHWEST,
+	DIR_SOUTHEAST,
+	DIR_SOUTHWEST,
+	DIR_UP,
+	DIR_DOWN,
+	DIR_IN,
+	DIR_OUT,
+	DIR_COUNT
+} Direction;
+
+
 /**
  * struct Room - Game location
- * @id: Unique room identifier
- * @name: Display name
- * @description: Full room description
- * @exits: Array of "direction:room_id" strings
- * @exit_count: Number of exits
- * @items: Array of item IDs present in room
- * @item_count: Number of items in room
- * @npcs: Array of NPC IDs present in room
- * @npc_count: Number of NPCs in room
  * @dark: Room is dark - needs light
  * @locked: Room has locked exit
- * @locked_exit: Which exit is locked (e.g. "north")
  * @visited: Has player been here before
+ * @changed: Player has taken, dropped or unlocked something here
+ * @locked_exit: Which exit is locked, DIR_NONE if none
+ * @exit_count: Number of directions with an exit
+ * @item_count: Number of items in room
+ * @item_capacity: Allocated length of @items
+ * @npc_count: Number of NPCs in room
+ * @items: Items currently in the room (changes on take/drop)
+ * @npcs: NPCs present in room
+ * @exits: Destination room per direction, NULL if no exit that way or
+ *         the destination does not exist (or, in a streamed story, is
+ *         not loaded; room_exit() fetches it)
+ * @id: Unique room identifier (string pool)
+ * @name: Display name (string pool)
+ * @description: Full room description (string pool), NULL when loaded
+ *               lazily
+ * @description_ref: Where @description is in rooms.ini, when lazy
+ * @exit_ids: Destination room ID per direction, NULL if no exit that way
+ * @item_ids: Item IDs listed for the room in rooms.ini
+ * @item_id_count: Number of item IDs
+ * @npc_ids: NPC IDs listed for the room in rooms.ini
+ * @npc_id_count: Number of NPC IDs
+ * @view: What looking at the room printed last (not NUL-terminated),
+ *        NULL if it has not been looked at; heap, see room_views_free()
+ * @view_length: Bytes in @view, 0 once something shown in it changes
+ * @view_capacity: Bytes allocated for @view
+ * @view_generation: Story's @view_generation when @view was rendered
+ * @view_lit: @view was rendered with light to see by
+ *
+ * Fields the game reads every turn are grouped first, but they are not
+ * a separate array: a scan over the rooms still steps a whole Room at
+ * a time. What keeps the struct small is that no text is stored
+ * inline; every string is exactly as long as the story file made it
+ * and lives in the story's string pool (the arena, or the mapped
+ * image).
+ *
+ * Read descriptions through room_description(), which fetches lazily
+ * loaded text on demand.
+ *
+ * The ID lists are what the story files say. link_story() resolves
+ * them into @exits, @items and @npcs, which is all the game
+ * looks at while playing.
  */
 
 typedef struct Room {
-	char id[ROOM_ID_SIZE];
-	char name[ROOM_NAME_SIZE];
-	char description[ROOM_DESCRIPTION_SIZE];
-	char** exits;
-	int exit_count;
-	char** items;
-	int item_count;
-	char** npcs;
-	int npc_count;
+	/* Hot: flags, counts and resolved references */
 	bool dark;
 	bool locked;
-	char locked_exit[ROOM_LOCKED_EXIT_SIZE];
 	bool visited;
+	bool changed;
+	Direction locked_exit;
+	int exit_count;
+	int item_count;
+	int item_capacity;
+	int npc_count;
+	struct Item **items;
+	struct NPC **npcs;
+	struct Room *exits[DIR_COUNT];
+
+	/* Cold: identity, text and the IDs as loaded */
+	const char *id;
+	const char *name;
+	const char *description;
+	TextRef description_ref;
+	char *exit_ids[DIR_COUNT];
+	char** item_ids;
+	int item_id_count;
+	char** npc_ids;
+	int npc_id_count;
+
+	/* Render cache: look_at_current_room() output, reused until stale */
+	char *view;
+	size_t view_length;
+	size_t view_capacity;
+	uint32_t view_generation;
+	bool view_lit;
 } Room;
 
 
+/**
+ * struct NounKey - Case-folded name of an item or NPC, for noun matching
+ * @name: Display name, lowercased (the name itself when already lower)
+ * @id: Identifier, lowercased (the ID itself when already lower)
+ * @bigrams: One bit per adjacent character pair of @name and @id. A noun
+ *           with a pair that is not set cannot match, so most candidates
+ *           are rejected without reading either string.
+ *
+ * Built once at load by build_noun_keys() and rebuilt when a reload
+ * renames the entity.
+ */
+
+typedef struct NounKey {
+	const char *name;
+	const char *id;
+	uint64_t bigrams;
+} NounKey;
+
+
 /**
  * struct Item - Collectible object
- * @id: Unique item identifier
- * @name: Display name
- * @description: Full item description
  * @weight: Item weight in kg
  * @takeable: Can item be picked up
  * @useable: Can item be used
  * @illuminates: Can item light a dark space
  * @unlocks: Can item unlock locked exits
+ * @key: Folded @name and @id that commands match nouns against
+ * @id: Unique item identifier (string pool)
+ * @name: Display name (string pool)
+ * @description: Full item description (string pool), NULL when loaded
+ *               lazily; read it through item_description()
+ * @description_ref: Where @description is in items.ini, when lazy
  */
 
 typedef struct Item {
-	char id[ITEM_ID_SIZE];           
-	char name[ITEM_NAME_SIZE];       
-	char description[ITEM_DESCRIPTION_SIZE];  
+	/* Hot */
 	int weight;
 	bool takeable;
 	bool useable;
 	bool illuminates;
 	bool unlocks;
+	NounKey key;
+
+	/* Cold */
+	const char *id;
+	const char *name;
+	const char *description;
+	TextRef description_ref;
 } Item;
 
 
 /**
  * struct NPC - Non-player character
- * @id: Unique NPC identifier
- * @name: Display name
- * @description: Full NPC description
- * @location: Room ID where NPC is located
- * @dialog: Array of dialog lines
- * @dialog_count: Number of dialog lines
- * @dialog_index: Current dialog line (cycles through)
  * @hostile: Can be fought
+ * @defeated: Permanently defeated
  * @combat_hp: NPC Health (hits to defeat)
  * @combat_damage: Damage NPC does per hit
- * @required_item: Item that boost chance of success
  * @base_win_chance: Base hit chance (0.75)
  * @item_win_chance: Hit chance with required item (0.95)
- * @defeated: Permanently defeated
- * @combat_text: Array of combat flavour messages
+ * @dialog_count: Number of dialog lines
+ * @dialog_index: Current dialog line (cycles through)
+ * @dialog_start: Dialog node @greeting_dialog resolves to, DIALOG_NONE
+ *                if the NPC only has dialog lines
+ * @dialog_state: Conversation state, changed by set_state in dialogs.ini
  * @combat_text_count: Number of combat messages
+ * @location_ref: Room the NPC is located in (NULL if unknown, or if the
+ *                story streams its rooms)
+ * @required_item_ref: Resolved @required_item (NULL if none or unknown)
+ * @key: Folded @name and @id that commands match nouns against
+ * @id: Unique NPC identifier (string pool)
+ * @name: Display name (string pool)
+ * @description: Full NPC description (string pool), NULL when lazy
+ * @description_ref: Where @description is in npcs.ini, when lazy
+ * @dialog: Array of dialog lines, NULL when lazy
+ * @combat_text: Array of combat flavour messages, NULL when lazy
+ * @dialog_refs: Where each dialog line is in npcs.ini, when lazy
+ * @combat_text_refs: Where each combat message is, when lazy
+ * @location: Room ID where NPC is located ("" if none)
+ * @required_item: Item that boost chance of success ("" if none)
+ * @greeting_dialog: Dialog node talking starts at ("" if none)
+ *
+ * Read text through npc_description(), npc_dialog_line() and
+ * npc_combat_text(), which fetch lazily loaded lines on demand.
  */
 
 typedef struct NPC {
-	char id[NPC_ID_SIZE];
-	char name[NPC_NAME_SIZE];
-	char description[NPC_DESCRIPTION_SIZE];
-	char location[NPC_LOCATION_SIZE];
-	char **dialog;
+	/* Hot: combat state and resolved references */
+	bool hostile;
+	bool defeated;
+	int combat_hp;
+	int combat_damage;
+	float base_win_chance;
+	float item_win_chance;
 	int dialog_count;
 	int dialog_index;
+	int dialog_start;
+	int dialog_state;
+	int combat_text_count;
+	struct Room *location_ref;
+	struct Item *required_item_ref;
+	NounKey key;
 
-	/* Combat fields */
-	bool hostile;                   
-	int combat_hp;                  
-	int combat_damage;               
-	char required_item[ITEM_ID_SIZE]; 
-	float base_win_chance;          
-	float item_win_chance;          
-	bool defeated;                
-	char **combat_text;             
-	int combat_text_count;          
+	/* Cold */
+	const char *id;
+	const char *name;
+	const char *description;
+	TextRef description_ref;
+	char **dialog;
+	char **combat_text;
+	TextRef *dialog_refs;
+	TextRef *combat_text_refs;
+	const char *location;
+	const char *required_item;
+	const char *greeting_dialog;
 } NPC;
 
 
@@ -146,44 +279,231 @@ typedef struct NPC {
  * @name: Display name
  * @description: Quest description/objective
  * @required: Must be completed to win game
+ * @started: A dialog has started or accepted the quest
  * @completed: Current completion status
+ * @failed: A dialog has failed the quest; it can no longer complete
  * @completion_item: Item ID that completes quest (or empty)
  * @completion_npc: NPC ID that completes quest (or empty)
  * @completion_room: Room ID that completes quest (or empty)
  * @completion_message: Message shown when quest completes
+ * @completion_item_ref: Resolved @completion_item
+ * @completion_npc_ref: Resolved @completion_npc
+ * @completion_room_ref: Resolved @completion_room (NULL in a streamed
+ *                       story, where the ID is compared instead)
+ * @completion_code: Compiled @completion_check, SCRIPT_NONE if none
+ * @failure_code: Compiled @failure_condition, SCRIPT_NONE if none
+ * @completion_check: Expression that must hold to complete ("" if none)
+ * @failure_condition: Expression that fails the quest ("" if none)
  *
  * A quest can be completed by:
  * - Taking a specific item (completion_item set)
  * - Talking to specific NPC (completion_npc set)
  * - Entering specific room (completion_room set)
  * Multiple conditions can be set (all must be met)
+ *
+ * Strings live in the story's string pool; unset ones are "".
  */
 typedef struct Quest {
-	char id[QUEST_ID_SIZE];
-	char name[QUEST_NAME_SIZE];
-	char description[QUEST_DESCRIPTION_SIZE];
+	const char *id;
+	const char *name;
+	const char *description;
 	bool required;
+	bool started;
 	bool completed;
-	char completion_item[QUEST_COMPLETION_ID_SIZE];
-	char completion_npc[QUEST_COMPLETION_ID_SIZE];
-	char completion_room[QUEST_COMPLETION_ID_SIZE];
-	char completion_message[QUEST_DESCRIPTION_SIZE];
+	bool failed;
+	const char *completion_item;
+	const char *completion_npc;
+	const char *completion_room;
+	const char *completion_message;
+	struct Item *completion_item_ref;
+	struct NPC *completion_npc_ref;
+	struct Room *completion_room_ref;
+	int completion_code;
+	int failure_code;
+	const char *completion_check;
+	const char *failure_condition;
 } Quest;
 
 
+/**
+ * enum DialogTarget - Where a dialog transition goes, besides a node
+ * @DIALOG_NONE: No transition (no auto_continue, no greeting)
+ * @DIALOG_END: dialog_end, or a target that does not exist
+ * @DIALOG_REPEAT: dialog_repeat, show the current node again
+ *
+ * Node numbers are indexes into Story.dialogs, so every target is an
+ * int and a real node is >= 0.
+ */
+
+typedef enum {
+	DIALOG_NONE = -1,
+	DIALOG_END = -2,
+	DIALOG_REPEAT = -3
+} DialogTarget;
+
+
+/**
+ * enum QuestAction - What a dialog node does to a quest
+ */
+
+typedef enum {
+	QUEST_ACTION_NONE,
+	QUEST_ACTION_START,
+	QUEST_ACTION_ACCEPT,
+	QUEST_ACTION_COMPLETE,
+	QUEST_ACTION_FAIL
+} QuestAction;
+
+
+/**
+ * struct DialogResponse - One answer the player can give
+ * @number: Number the player types
+ * @next: Node it leads to, DIALOG_END or DIALOG_REPEAT
+ * @text: What the player says (string pool)
+ * @next_id: Dialog ID next= gives for @number ("" for dialog_end)
+ */
+
+typedef struct DialogResponse {
+	int number;
+	int next;
+	const char *text;
+	const char *next_id;
+} DialogResponse;
+
+
+/**
+ * struct DialogNode - One step of a conversation from dialogs.ini
+ * @state_required: NPC dialog state the node needs, DIALOG_STATE_ANY
+ * @set_state: Dialog state the NPC moves to, DIALOG_STATE_ANY to keep
+ * @auto_continue: Node that follows when there are no responses
+ * @first_response: First of this node's entries in Story.dialog_responses
+ * @response_count: Number of responses
+ * @quest_action: What the node does to @quest
+ * @quest: Quest index, -1 if none or unknown
+ * @color: Escape sequence for color=, NULL for the usual dialog color
+ * @condition_code: Compiled @condition, SCRIPT_NONE if none
+ * @id: Unique dialog identifier (string pool)
+ * @speaker: Who speaks ("" for the NPC's name)
+ * @text: What is said
+ * @auto_continue_id: auto_continue= as written ("" if none)
+ * @quest_id: Quest named by quest_action= ("" if none)
+ * @condition: Expression that must hold to show the node ("" if none)
+ *
+ * load_dialogs() splits responses= and next= into the node's slice of
+ * Story.dialog_responses; link_story() then resolves every ID into the
+ * integers at the top, so a conversation never looks up an ID.
+ */
+
+typedef struct DialogNode {
+	/* Hot: the compiled transition table */
+	int state_required;
+	int set_state;
+	int auto_continue;
+	int first_response;
+	int response_count;
+	QuestAction quest_action;
+	int quest;
+	const char *color;
+	int condition_code;
+
+	/* Cold */
+	const char *id;
+	const char *speaker;
+	const char *text;
+	const char *auto_continue_id;
+	const char *quest_id;
+	const char *condition;
+} DialogNode;
+
+
+/**
+ * struct ScriptOp - One bytecode instruction of a compiled expression
+ * @op: Opcode (see scripts.c)
+ * @arg: Constant, variable, entity index or relative jump
+ */
+
+typedef struct ScriptOp {
+	uint8_t op;
+	int32_t arg;
+} ScriptOp;
+
+
+/**
+ * struct Script - A named script from scripts.ini
+ * @code: Compiled @condition, SCRIPT_NONE if it has none
+ * @id: Unique script identifier (string pool)
+ * @type: Script type (item_use, trigger, ...)
+ * @description: What the script does
+ * @condition: Expression the script evaluates ("" if none)
+ *
+ * Quests and dialogs refer to a script as "script:id" or call it as
+ * script(id) inside an expression.
+ */
+
+typedef struct Script {
+	int code;
+	const char *id;
+	const char *type;
+	const char *description;
+	const char *condition;
+} Script;
+
+
 /**
  * struct Story - Complete story package
  * @metadata: Story metadata and settings
- * @rooms: Array of rooms
- * @room_count: Number of rooms
+ * @rooms: Array of rooms, NULL when @stream is enabled
+ * @room_count: Number of rooms (loaded or not); fetch one by number
+ *              with story_room()
  * @items: Array of items
  * @item_count: Number of items
  * @npcs: Array of NPCs
  * @npc_count: Number of NPCs
+ * @dialogs: Dialog nodes from dialogs.ini (NULL if it has none)
+ * @dialog_count: Number of dialog nodes
+ * @dialog_responses: Every node's responses, one slice per node
+ * @dialog_response_count: Number of entries in @dialog_responses
+ * @scripts: Scripts from scripts.ini (NULL if it has none)
+ * @script_count: Number of scripts
+ * @script_code: Bytecode of every compiled expression, each run ending
+ *               in a return
+ * @script_code_length: Number of instructions in @script_code
+ * @synonyms: Words the [SYNONYMS] section of story.ini adds to the
+ *            parser (NULL if none)
+ * @synonym_count: Number of synonyms
+ * @grammar_rules: Verb patterns the [GRAMMAR] section of story.ini
+ *                 declares (NULL if none)
+ * @grammar_rule_count: Number of grammar rules
+ * @grammar: Built-in and story verb patterns compiled into one DFA by
+ *           compile_grammar(); NULL before that, when commands are
+ *           parsed with the built-in grammar alone
  * @story_dir: Directory where story files are located
+ * @room_index: Room ID -> room array index
+ * @item_index: Item ID -> item array index
+ * @npc_index: NPC ID -> NPC array index
+ * @quest_index: Quest ID -> quest array index
+ * @dialog_index: Dialog ID -> dialog node index
+ * @script_index: Script ID -> script array index
+ * @synonym_index: Synonym word -> synonym array index
+ * @arena: Owns every allocation reachable from the story
+ * @image: Compiled image backing this story (NULL if loaded from .ini)
+ * @image_size: Size of @image in bytes
+ * @image_mapped: @image is an mmap() region rather than a heap copy
+ * @text: Reads back descriptions, dialog and combat text for a story
+ *        loaded with lazy text
+ * @stream: Loads rooms region by region, for stories that ask for it
+ * @view_generation: Bumped by changes that can show in any room's view
+ *                   (a reload, a loaded save), making every cached
+ *                   room view stale at once
+ *
+ * Entity arrays, strings, ID lists, indexes and link tables all come
+ * from @arena, so free_story() is one arena_free() plus unmapping
+ * @image, emptying the small @text cache, evicting @stream's regions,
+ * each of which has an arena of its own, and freeing rendered room
+ * views, which are rewritten too often to live in an arena.
  */
 
-typedef struct {
+typedef struct Story {
 	StoryMetadata metadata;
 	
 	Room* rooms;
@@ -197,8 +517,43 @@ typedef struct {
 
 	Quest* quests;
 	int quest_count;
+
+	DialogNode *dialogs;
+	int dialog_count;
+	DialogResponse *dialog_responses;
+	int dialog_response_count;
+
+	Script *scripts;
+	int script_count;
+	ScriptOp *script_code;
+	int script_code_length;
+
+	struct VerbEntry *synonyms;
+	int synonym_count;
+	struct GrammarRule *grammar_rules;
+	int grammar_rule_count;
+	const struct Grammar *grammar;
 	
 	char story_dir[STORY_DIRECTORY_SIZE];
+
+	StoryIndex room_index;
+	StoryIndex item_index;
+	StoryIndex npc_index;
+	StoryIndex quest_index;
+	StoryIndex dialog_index;
+	StoryIndex script_index;
+	StoryIndex synonym_index;
+
+	Arena arena;
+
+	const char *image;
+	size_t image_size;
+	bool image_mapped;
+
+	TextCache text;
+	RoomStream stream;
+
+	uint32_t view_generation;
 } Story;
 
 
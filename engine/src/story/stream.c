@@ -0,0 +1,849 @@
+/*
+ * stream.c - Load rooms region by region for very large stories
+ *
+ * A streamed story scans rooms.ini once at load time and keeps only a
+ * slot per room: its ID, where its [ROOM:] header is and which region
+ * it belongs to. Regions are loaded from those offsets when a room in
+ * them is first fetched and evicted least recently used first, so the
+ * rooms held in memory follow the player rather than the size of the
+ * world.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "stream.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "index.h"
+#include "ini_parser.h"
+#include "link.h"
+#include "loader.h"
+#include "story.h"
+#include "world/rooms.h"
+
+
+#define STREAM_NO_REGION	UINT32_MAX
+#define STREAM_QUEUED		(UINT32_MAX - 1)
+#define STREAM_NO_ROOM		UINT32_MAX
+
+
+/**
+ * struct StreamScan - Scratch state for room_stream_scan()
+ * @slot_capacity: Allocated length of RoomStream.slots
+ * @region_capacity: Allocated length of RoomStream.regions
+ * @edge_first: First entry in @edges for each slot
+ * @edge_capacity: Allocated length of @edge_first
+ * @edges: Exit targets as written, pointing into the mapped file
+ * @edge_count: Entries in @edges
+ * @edges_allocated: Allocated length of @edges
+ * @keys: Open addressed region key table, region number + 1 per slot
+ * @key_capacity: Length of @keys, a power of two
+ */
+
+typedef struct {
+	int slot_capacity;
+	int region_capacity;
+	uint32_t *edge_first;
+	int edge_capacity;
+	IniView *edges;
+	int edge_count;
+	int edges_allocated;
+	uint32_t *keys;
+	uint32_t key_capacity;
+} StreamScan;
+
+
+static uint32_t stream_key_hash(IniView key)
+{
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < key.len; i++) {
+		hash ^= (unsigned char)key.ptr[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/**
+ * stream_new_region() - Append an empty region
+ * @stream: Stream being scanned
+ * @scan: Scratch state
+ * @key: Region key (string pool), NULL for a graph group
+ *
+ * Return: Region number, STREAM_NO_REGION on allocation failure
+ */
+
+static uint32_t stream_new_region(RoomStream *stream, StreamScan *scan,
+				  const char *key)
+{
+	RoomRegion *grown;
+
+	grown = array_grow(stream->regions, stream->region_count,
+			   &scan->region_capacity, sizeof(RoomRegion));
+	if (!grown)
+		return STREAM_NO_REGION;
+
+	stream->regions = grown;
+	stream->regions[stream->region_count].key = key;
+	return (uint32_t)stream->region_count++;
+}
+
+
+/**
+ * stream_key_region() - Find or add the region for a region= value
+ * @stream: Stream being scanned
+ * @scan: Scratch state
+ * @arena: Arena for new keys
+ * @key: Value as written
+ *
+ * Return: Region number, STREAM_NO_REGION on allocation failure
+ */
+
+static uint32_t stream_key_region(RoomStream *stream, StreamScan *scan,
+				  Arena *arena, IniView key)
+{
+	uint32_t mask;
+	uint32_t i;
+	uint32_t region;
+
+	/* Keep the table at most half full */
+	if ((uint32_t)stream->region_count * 2 >= scan->key_capacity) {
+		uint32_t capacity = scan->key_capacity ?
+				    scan->key_capacity * 2 : 64;
+		uint32_t *keys = calloc(capacity, sizeof(uint32_t));
+
+		if (!keys)
+			return STREAM_NO_REGION;
+
+		for (i = 0; i < scan->key_capacity; i++) {
+			uint32_t slot;
+			IniView old;
+
+			if (scan->keys[i] == 0)
+				continue;
+			old.ptr = stream->regions[scan->keys[i] - 1].key;
+			old.len = strlen(old.ptr);
+			slot = stream_key_hash(old) & (capacity - 1);
+			while (keys[slot] != 0)
+				slot = (slot + 1) & (capacity - 1);
+			keys[slot] = scan->keys[i];
+		}
+
+		free(scan->keys);
+		scan->keys = keys;
+		scan->key_capacity = capacity;
+	}
+
+	mask = scan->key_capacity - 1;
+	for (i = stream_key_hash(key) & mask; scan->keys[i] != 0;
+	     i = (i + 1) & mask) {
+		if (ini_view_equals(key, stream->regions[scan->keys[i] - 1].key))
+			return scan->keys[i] - 1;
+	}
+
+	region = stream_new_region(stream, scan, ini_view_text(arena, key));
+	if (region != STREAM_NO_REGION)
+		scan->keys[i] = region + 1;
+	return region;
+}
+
+
+/**
+ * stream_add_exits() - Remember where a room's exits lead
+ * @scan: Scratch state
+ * @value: exits= value as written
+ *
+ * Only the targets matter for grouping rooms, so directions are not
+ * checked here; the room is parsed properly when its region loads.
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure
+ */
+
+static int stream_add_exits(StreamScan *scan, IniView value)
+{
+	const char *end = value.ptr + value.len;
+	const char *item = value.ptr;
+
+	while (item < end) {
+		const char *comma = memchr(item, ',', (size_t)(end - item));
+		const char *colon;
+		IniView target;
+		IniView *grown;
+
+		if (!comma)
+			comma = end;
+
+		colon = memchr(item, ':', (size_t)(comma - item));
+		if (colon) {
+			grown = array_grow(scan->edges, scan->edge_count,
+					   &scan->edges_allocated, sizeof(IniView));
+			if (!grown)
+				return -ENOMEM;
+			scan->edges = grown;
+
+			target.ptr = colon + 1;
+			target.len = (size_t)(comma - colon - 1);
+			scan->edges[scan->edge_count++] = ini_view_trim(target);
+		}
+
+		item = comma + 1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * stream_group_rooms() - Group the rooms rooms.ini gives no region
+ * @stream: Stream with every slot recorded
+ * @scan: Scratch state holding the exit targets
+ * @index: Room index over the slots
+ * @start: Number of the start room, -1 if unknown
+ * @room_count: Number of rooms
+ *
+ * Walks the exit graph breadth first, starting from the start room and
+ * then from each room not reached yet, and cuts the visiting order
+ * into groups of @stream->region_rooms rooms.
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure
+ */
+
+static int stream_group_rooms(RoomStream *stream, StreamScan *scan,
+			      const StoryIndex *index, int start,
+			      int room_count)
+{
+	char id[INI_VALUE_SIZE];
+	uint32_t *target;
+	uint32_t *queue;
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	uint32_t region = STREAM_NO_REGION;
+	int filled = stream->region_rooms;
+	int seed;
+	int i;
+
+	target = malloc(((size_t)scan->edge_count + 1) * sizeof(uint32_t));
+	queue = malloc(((size_t)room_count + 1) * sizeof(uint32_t));
+	if (!target || !queue) {
+		free(target);
+		free(queue);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < scan->edge_count; i++) {
+		int n;
+
+		ini_view_copy(scan->edges[i], id, sizeof(id));
+		n = story_index_find(index, id);
+		target[i] = n >= 0 ? (uint32_t)n : STREAM_NO_ROOM;
+		if (n < 0)
+			add_log_entry("Dangling reference: an exit leads to "
+				      "room '%s', which does not exist", id);
+	}
+
+	for (seed = -1; seed < room_count; seed++) {
+		uint32_t s = (uint32_t)(seed < 0 ? start : seed);
+
+		if (seed < 0 && start < 0)
+			continue;
+		if (stream->slots[s].region != STREAM_NO_REGION)
+			continue;
+
+		stream->slots[s].region = STREAM_QUEUED;
+		queue[tail++] = s;
+
+		while (head < tail) {
+			uint32_t n = queue[head++];
+			uint32_t e;
+
+			if (filled == stream->region_rooms) {
+				region = stream_new_region(stream, scan, NULL);
+				if (region == STREAM_NO_REGION) {
+					free(target);
+					free(queue);
+					return -ENOMEM;
+				}
+				filled = 0;
+			}
+			stream->slots[n].region = region;
+			filled++;
+
+			for (e = scan->edge_first[n]; e < scan->edge_first[n + 1];
+			     e++) {
+				uint32_t t = target[e];
+
+				if (t == STREAM_NO_ROOM ||
+				    stream->slots[t].region != STREAM_NO_REGION)
+					continue;
+				stream->slots[t].region = STREAM_QUEUED;
+				queue[tail++] = t;
+			}
+		}
+	}
+
+	free(target);
+	free(queue);
+	return 0;
+}
+
+
+/**
+ * stream_index_members() - Lay the room numbers out region by region
+ * @stream: Stream with every room assigned a region
+ * @arena: Arena for the member list
+ * @room_count: Number of rooms
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure
+ */
+
+static int stream_index_members(RoomStream *stream, Arena *arena,
+				int room_count)
+{
+	uint32_t next = 0;
+	int i;
+
+	stream->members = arena_alloc(arena,
+				      (size_t)room_count * sizeof(uint32_t));
+	if (room_count > 0 && !stream->members)
+		return -ENOMEM;
+
+	for (i = 0; i < room_count; i++)
+		stream->regions[stream->slots[i].region].count++;
+
+	for (i = 0; i < stream->region_count; i++) {
+		stream->regions[i].first = next;
+		next += stream->regions[i].count;
+		stream->regions[i].count = 0;
+	}
+
+	for (i = 0; i < room_count; i++) {
+		RoomRegion *region = &stream->regions[stream->slots[i].region];
+
+		stream->members[region->first + region->count++] = (uint32_t)i;
+	}
+
+	return 0;
+}
+
+
+/**
+ * stream_scan_file() - Record every room's slot, region key and exits
+ * @stream: Stream being scanned
+ * @scan: Scratch state
+ * @ini: Mapped rooms.ini
+ * @arena: Arena for IDs and region keys
+ *
+ * Return: Number of rooms, negative errno on allocation failure
+ */
+
+static int stream_scan_file(RoomStream *stream, StreamScan *scan,
+			    IniFile *ini, Arena *arena)
+{
+	IniToken token;
+	int count = 0;
+	bool in_room = false;
+	size_t header = ini->pos;
+
+	while (ini_next(ini, &token)) {
+		if (token.type == INI_TOKEN_SECTION) {
+			in_room = ini_view_has_prefix(token.section, "ROOM:");
+			if (in_room) {
+				RoomSlot *slots;
+				uint32_t *first;
+
+				slots = array_grow(stream->slots, count,
+						   &scan->slot_capacity,
+						   sizeof(RoomSlot));
+				if (!slots)
+					return -ENOMEM;
+				stream->slots = slots;
+
+				first = array_grow(scan->edge_first, count + 1,
+						   &scan->edge_capacity,
+						   sizeof(uint32_t));
+				if (!first)
+					return -ENOMEM;
+				scan->edge_first = first;
+
+				slots[count].id = ini_view_text(arena,
+					ini_view_skip(token.section, 5));
+				slots[count].offset = (uint32_t)header;
+				slots[count].region = STREAM_NO_REGION;
+				first[count] = (uint32_t)scan->edge_count;
+				count++;
+			}
+		} else if (in_room && ini_view_equals(token.key, "region") &&
+			   token.value.len > 0) {
+			uint32_t region = stream_key_region(stream, scan, arena,
+							    token.value);
+
+			if (region == STREAM_NO_REGION)
+				return -ENOMEM;
+			stream->slots[count - 1].region = region;
+		} else if (in_room && ini_view_equals(token.key, "exits")) {
+			if (stream_add_exits(scan, token.value) != 0)
+				return -ENOMEM;
+		}
+
+		header = ini->pos;
+	}
+
+	if (scan->edge_first)
+		scan->edge_first[count] = (uint32_t)scan->edge_count;
+	return count;
+}
+
+
+/**
+ * room_stream_scan() - Index rooms.ini without loading any room
+ * @story_dir: Story directory
+ * @arena: Arena for the slots, regions and room IDs
+ * @start_room: ID of the room the player starts in
+ * @stream: Stream to fill in
+ *
+ * Return: Number of rooms found, 0 on error or empty
+ */
+
+int room_stream_scan(const char *story_dir, Arena *arena,
+		     const char *start_room, RoomStream *stream)
+{
+	StreamScan scan;
+	StoryIndex index;
+	Arena scratch;
+	IniFile ini;
+	struct stat st;
+	int start = -1;
+	int count;
+	int ret;
+
+	log_function_entry(__func__, "story_dir=%s", story_dir);
+
+	memset(&scan, 0, sizeof(scan));
+	arena_init(&scratch, 0);
+	snprintf(stream->path, sizeof(stream->path), "%s/rooms.ini", story_dir);
+	if (stream->region_rooms <= 0)
+		stream->region_rooms = STREAM_REGION_ROOMS;
+	if (stream->resident_limit <= 0)
+		stream->resident_limit = STREAM_RESIDENT_REGIONS;
+	if (stream->resident_limit < STREAM_MIN_RESIDENT_REGIONS)
+		stream->resident_limit = STREAM_MIN_RESIDENT_REGIONS;
+	stream->active = -1;
+
+	if (stat(stream->path, &st) != 0 || ini_open(&ini, stream->path) != 0) {
+		printf("ERROR: Cannot open %s\n", stream->path);
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+	stream->file_size = (long)st.st_size;
+	stream->file_mtime = st.st_mtime;
+
+	/* Header offsets are kept in 32 bits, like lazy text */
+	if (!text_ref_fits(&ini)) {
+		printf("ERROR: %s is too large to stream\n", stream->path);
+		ini_close(&ini);
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	count = stream_scan_file(stream, &scan, &ini, arena);
+	ret = count < 0 ? count : 0;
+
+	if (ret == 0 && count > 0)
+		ret = story_index_build(&index, &scratch, stream->slots, count,
+					sizeof(RoomSlot), offsetof(RoomSlot, id),
+					"room");
+	if (ret == 0 && count > 0) {
+		start = story_index_find(&index, start_room);
+		ret = stream_group_rooms(stream, &scan, &index, start, count);
+	}
+	if (ret == 0)
+		ret = stream_index_members(stream, arena, count);
+
+	ini_close(&ini);
+	arena_free(&scratch);
+	free(scan.edge_first);
+	free(scan.edges);
+	free(scan.keys);
+
+	if (ret == 0 && count > 0) {
+		stream->slots = array_shrink(stream->slots, count,
+					     sizeof(RoomSlot));
+		stream->regions = array_shrink(stream->regions,
+					       stream->region_count,
+					       sizeof(RoomRegion));
+		if (arena_adopt(arena, stream->slots,
+				(size_t)count * sizeof(RoomSlot)) != 0) {
+			free(stream->regions);
+			ret = -ENOMEM;
+		} else if (arena_adopt(arena, stream->regions,
+				       (size_t)stream->region_count *
+				       sizeof(RoomRegion)) != 0) {
+			ret = -ENOMEM;
+		}
+	} else {
+		free(stream->slots);
+		free(stream->regions);
+	}
+
+	if (ret != 0 || count == 0) {
+		if (ret != 0)
+			log_function_error(__func__, "Failed to scan rooms.ini");
+		stream->slots = NULL;
+		stream->regions = NULL;
+		stream->members = NULL;
+		stream->region_count = 0;
+		log_function_exit(__func__, 0);
+		return 0;
+	}
+
+	if (start >= 0)
+		stream->regions[stream->slots[start].region].pinned = true;
+
+	add_log_entry("Streaming %d rooms from %s in %d regions "
+		      "(%d rooms per unnamed region, %d kept loaded)",
+		      count, stream->path, stream->region_count,
+		      stream->region_rooms, stream->resident_limit);
+	log_function_exit(__func__, count);
+	return count;
+}
+
+
+/**
+ * stream_region_changed() - Check whether the player changed a region
+ * @region: Resident region
+ *
+ * Return: true if any of its rooms has been changed
+ */
+
+static bool stream_region_changed(const RoomRegion *region)
+{
+	uint32_t i;
+
+	for (i = 0; i < region->count; i++) {
+		if (region->rooms[i].changed)
+			return true;
+	}
+	return false;
+}
+
+
+/**
+ * stream_evict() - Drop a resident region
+ * @stream: Stream holding the region
+ * @victim: Region to drop
+ *
+ * Exits that other resident rooms resolved into the region are
+ * cleared, to be resolved again if they are taken.
+ *
+ * Return: void
+ */
+
+static void stream_evict(RoomStream *stream, int victim)
+{
+	RoomRegion *region = &stream->regions[victim];
+	uintptr_t lo = (uintptr_t)region->rooms;
+	uintptr_t hi = (uintptr_t)(region->rooms + region->count);
+	uint32_t i;
+	int r;
+	int d;
+
+	for (i = 0; i < region->count; i++) {
+		RoomSlot *slot = &stream->slots[stream->members[region->first + i]];
+
+		slot->visited = region->rooms[i].visited;
+		slot->room = NULL;
+	}
+
+	for (r = 0; r < stream->region_count; r++) {
+		RoomRegion *other = &stream->regions[r];
+
+		if (r == victim || !other->rooms)
+			continue;
+
+		for (i = 0; i < other->count; i++) {
+			Room *room = &other->rooms[i];
+
+			for (d = 0; d < DIR_COUNT; d++) {
+				uintptr_t exit = (uintptr_t)room->exits[d];
+
+				if (exit >= lo && exit < hi)
+					room->exits[d] = NULL;
+			}
+		}
+	}
+
+	room_views_free(region->rooms, (int)region->count);
+	arena_free(&region->arena);
+	region->rooms = NULL;
+	stream->resident--;
+	stream->evictions++;
+
+	add_log_entry("Evicted room region %d (%u rooms)", victim,
+		      region->count);
+}
+
+
+/**
+ * stream_make_room() - Evict until another region fits the budget
+ * @stream: Stream about to load a region
+ * @keep: Region being loaded
+ *
+ * The active region, pinned regions and regions the player has changed
+ * are never evicted, so the budget is exceeded rather than lose them.
+ *
+ * Return: void
+ */
+
+static void stream_make_room(RoomStream *stream, int keep)
+{
+	while (stream->resident >= stream->resident_limit) {
+		int victim = -1;
+		int r;
+
+		for (r = 0; r < stream->region_count; r++) {
+			RoomRegion *region = &stream->regions[r];
+
+			if (!region->rooms || region->pinned || r == keep ||
+			    r == stream->active)
+				continue;
+
+			if (stream_region_changed(region)) {
+				region->pinned = true;
+				continue;
+			}
+
+			if (victim < 0 ||
+			    region->last_used < stream->regions[victim].last_used)
+				victim = r;
+		}
+
+		if (victim < 0)
+			return;
+		stream_evict(stream, victim);
+	}
+}
+
+
+/**
+ * stream_parse_region() - Parse a region's rooms from rooms.ini
+ * @stream: Stream holding the region
+ * @region: Region to parse
+ * @rooms: Array of @region->count zeroed rooms to fill in
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int stream_parse_region(RoomStream *stream, RoomRegion *region,
+			       Room *rooms)
+{
+	struct stat st;
+	IniToken token;
+	IniFile ini;
+	uint32_t i;
+
+	/* Offsets are only good for the file that was scanned */
+	if (stat(stream->path, &st) != 0 ||
+	    (long)st.st_size != stream->file_size ||
+	    st.st_mtime != stream->file_mtime) {
+		log_function_error(__func__, "rooms.ini changed since loading");
+		return -ESTALE;
+	}
+
+	if (ini_open(&ini, stream->path) != 0)
+		return -EIO;
+
+	for (i = 0; i < region->count; i++) {
+		RoomSlot *slot = &stream->slots[stream->members[region->first + i]];
+		Room *room = &rooms[i];
+
+		ini.pos = slot->offset;
+		if (!ini_next(&ini, &token) ||
+		    token.type != INI_TOKEN_SECTION ||
+		    !ini_view_has_prefix(token.section, "ROOM:") ||
+		    !ini_view_equals(ini_view_skip(token.section, 5), slot->id)) {
+			ini_close(&ini);
+			log_function_error(__func__, "room header moved");
+			return -ESTALE;
+		}
+
+		load_room_begin(room, slot->id, stream->lazy_text);
+		while (ini_next(&ini, &token) && token.type != INI_TOKEN_SECTION)
+			load_room_value(room, &region->arena, &ini, &token,
+					stream->lazy_text);
+		room->visited = slot->visited;
+	}
+
+	ini_close(&ini);
+	return 0;
+}
+
+
+/**
+ * stream_load() - Make a region resident
+ * @story: Streamed story
+ * @r: Region to load
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int stream_load(Story *story, int r)
+{
+	RoomStream *stream = &story->stream;
+	RoomRegion *region = &stream->regions[r];
+	Room *rooms;
+	uint32_t i;
+	int ret;
+
+	stream_make_room(stream, r);
+
+	arena_init(&region->arena, 0);
+	rooms = arena_calloc(&region->arena, region->count, sizeof(Room));
+	ret = rooms ? stream_parse_region(stream, region, rooms) : -ENOMEM;
+
+	if (ret == 0) {
+		for (i = 0; i < region->count; i++)
+			stream->slots[stream->members[region->first + i]].room =
+				&rooms[i];
+		region->rooms = rooms;
+
+		ret = link_room_array(story, rooms, (int)region->count,
+				      &region->arena);
+		if (ret < 0) {
+			for (i = 0; i < region->count; i++)
+				stream->slots[stream->members[region->first + i]].room =
+					NULL;
+			region->rooms = NULL;
+		}
+	}
+
+	if (ret < 0) {
+		arena_free(&region->arena);
+		log_function_error(__func__, "Failed to load a room region");
+		return ret;
+	}
+
+	stream->resident++;
+	stream->loads++;
+	add_log_entry("Loaded room region %d (%u rooms, %d resident)", r,
+		      region->count, stream->resident);
+	return 0;
+}
+
+
+/**
+ * story_room() - Fetch a room by its position in the story
+ * @story: Story holding the room
+ * @number: Room number
+ *
+ * Return: The room, NULL if its region cannot be loaded
+ */
+
+Room *story_room(Story *story, int number)
+{
+	RoomStream *stream = &story->stream;
+	RoomSlot *slot;
+
+	if (number < 0 || number >= story->room_count)
+		return NULL;
+
+	if (!stream->enabled)
+		return &story->rooms[number];
+
+	slot = &stream->slots[number];
+	if (!slot->room && stream_load(story, (int)slot->region) != 0)
+		return NULL;
+
+	stream->regions[slot->region].last_used = ++stream->clock;
+	return slot->room;
+}
+
+
+/**
+ * room_stream_enter() - Note that the player has moved into a room
+ * @story: Story holding the room
+ * @room: Room the player is now in
+ *
+ * Return: void
+ */
+
+void room_stream_enter(Story *story, Room *room)
+{
+	RoomStream *stream = &story->stream;
+	int number;
+	int d;
+
+	if (!stream->enabled || !room)
+		return;
+
+	number = story_index_find(&story->room_index, room->id);
+	if (number < 0)
+		return;
+
+	stream->active = (int)stream->slots[number].region;
+	stream->regions[stream->active].last_used = ++stream->clock;
+
+	/* Fetch the neighbours now rather than on the next move */
+	for (d = 0; d < DIR_COUNT; d++)
+		room_exit(story, room, (Direction)d);
+}
+
+
+/**
+ * room_stream_footprint() - Measure the rooms a stream holds
+ * @stream: Stream to measure
+ * @region_bytes: Set to the memory reserved by resident regions
+ * @rooms_loaded: Set to the number of rooms loaded
+ *
+ * Return: void
+ */
+
+void room_stream_footprint(const RoomStream *stream, size_t *region_bytes,
+			   int *rooms_loaded)
+{
+	ArenaUsage usage;
+	int r;
+
+	*region_bytes = 0;
+	*rooms_loaded = 0;
+
+	for (r = 0; r < stream->region_count; r++) {
+		if (!stream->regions[r].rooms)
+			continue;
+		arena_usage(&stream->regions[r].arena, &usage);
+		*region_bytes += usage.reserved;
+		*rooms_loaded += (int)stream->regions[r].count;
+	}
+}
+
+
+/**
+ * room_stream_free() - Evict every region
+ * @stream: Stream to empty
+ *
+ * Return: void
+ */
+
+void room_stream_free(RoomStream *stream)
+{
+	int r;
+
+	for (r = 0; r < stream->region_count; r++) {
+		if (stream->regions[r].rooms) {
+			room_views_free(stream->regions[r].rooms,
+					(int)stream->regions[r].count);
+			arena_free(&stream->regions[r].arena);
+		}
+		stream->regions[r].rooms = NULL;
+	}
+	stream->resident = 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * stream.h - Load rooms region by region for very large stories
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_STREAM_H
+#define STORY_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "core/arena.h"
+#include "core/constants.h"
+
+
+struct Room;
+struct Story;
+
+
+/**
+ * struct RoomSlot - What is known about a room whether or not it is loaded
+ * @id: Room ID (string pool); the room index is built over the slots
+ * @offset: Byte offset of the room's [ROOM:] header in rooms.ini
+ * @region: Region the room belongs to
+ * @room: The loaded room, NULL while its region is not resident
+ * @visited: Carries Room.visited across eviction
+ */
+
+typedef struct RoomSlot {
+	const char *id;
+	uint32_t offset;
+	uint32_t region;
+	struct Room *room;
+	bool visited;
+} RoomSlot;
+
+
+/**
+ * struct RoomRegion - Rooms loaded and evicted together
+ * @key: region= value from rooms.ini, NULL for a group found by walking
+ *       the exit graph
+ * @first: First entry for this region in RoomStream.members
+ * @count: Number of rooms in the region
+ * @rooms: The loaded rooms, in @first order; NULL when not resident
+ * @arena: Holds @rooms and everything they point at
+ * @last_used: Stream clock when a room in the region was last fetched
+ * @pinned: Never evicted: the start region, and any region where the
+ *          player has changed a room
+ */
+
+typedef struct RoomRegion {
+	const char *key;
+	uint32_t first;
+	uint32_t count;
+	struct Room *rooms;
+	Arena arena;
+	uint64_t last_used;
+	bool pinned;
+} RoomRegion;
+
+
+/**
+ * struct RoomStream - Rooms of a story loaded on demand
+ * @enabled: The story streams its rooms; Story.rooms is NULL
+ * @lazy_text: Loaded rooms leave their descriptions on disk
+ * @path: rooms.ini, re-read whenever a region is loaded
+ * @file_size: Size of rooms.ini when it was scanned
+ * @file_mtime: Modification time of rooms.ini when it was scanned
+ * @slots: One per room, in file order (Story.room_count entries)
+ * @members: Room numbers grouped by region
+ * @regions: Every region
+ * @region_count: Number of entries in @regions
+ * @region_rooms: Rooms per region when rooms.ini names none
+ * @resident_limit: Regions kept loaded before the least recently used
+ *                  one is evicted
+ * @resident: Regions currently loaded
+ * @active: Region holding the player, never evicted (-1 before play)
+ * @clock: Bumped on every fetch
+ * @loads: Regions loaded so far
+ * @evictions: Regions evicted so far
+ */
+
+typedef struct RoomStream {
+	bool enabled;
+	bool lazy_text;
+	char path[STORY_DIRECTORY_SIZE + 16];
+	long file_size;
+	time_t file_mtime;
+	RoomSlot *slots;
+	uint32_t *members;
+	RoomRegion *regions;
+	int region_count;
+	int region_rooms;
+	int resident_limit;
+	int resident;
+	int active;
+	uint64_t clock;
+	long loads;
+	long evictions;
+} RoomStream;
+
+
+/**
+ * room_stream_scan() - Index rooms.ini without loading any room
+ * @story_dir: Story directory
+ * @arena: Arena for the slots, regions and room IDs
+ * @start_room: ID of the room the player starts in
+ * @stream: Stream to fill in; @region_rooms and @resident_limit are
+ *          used as set, 0 for the defaults
+ *
+ * Records each room's ID, header offset and region in one pass. Rooms
+ * with a region= key are grouped by it. The rest are grouped by a
+ * breadth-first walk of the exit graph from the start room, cut into
+ * @region_rooms sized pieces, so neighbouring rooms usually share a
+ * region. The start room's region is pinned.
+ *
+ * Return: Number of rooms found, 0 on error or empty
+ */
+
+int room_stream_scan(const char *story_dir, Arena *arena,
+		     const char *start_room, RoomStream *stream);
+
+
+/**
+ * story_room() - Fetch a room by its position in the story
+ * @story: Story holding the room
+ * @number: Room number, 0 to room_count - 1 (what the room index holds)
+ *
+ * For a streamed story this loads the room's region if needed, which
+ * may evict the least recently used region that is neither active nor
+ * pinned. Pointers to rooms outside the active and pinned regions are
+ * only good until the next fetch.
+ *
+ * Return: The room, NULL if its region cannot be loaded
+ */
+
+struct Room *story_room(struct Story *story, int number);
+
+
+/**
+ * room_stream_enter() - Note that the player has moved into a room
+ * @story: Story holding the room
+ * @room: Room the player is now in
+ *
+ * Makes the room's region the active one, so it stays loaded, and
+ * loads the regions its exits lead into so the next move does not
+ * wait. Does nothing for a story that is not streamed.
+ *
+ * Return: void
+ */
+
+void room_stream_enter(struct Story *story, struct Room *room);
+
+
+/**
+ * room_stream_footprint() - Measure the rooms a stream holds
+ * @stream: Stream to measure
+ * @region_bytes: Set to the memory reserved by resident regions
+ * @rooms_loaded: Set to the number of rooms loaded
+ *
+ * Return: void
+ */
+
+void room_stream_footprint(const RoomStream *stream, size_t *region_bytes,
+			   int *rooms_loaded);
+
+
+/**
+ * room_stream_free() - Evict every region
+ * @stream: Stream to empty
+ *
+ * Slots and regions live in the story arena and go with it.
+ *
+ * Return: void
+ */
+
+void room_stream_free(RoomStream *stream);
+
+
+#endif /* STORY_STREAM_H */
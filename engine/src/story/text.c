@@ -0,0 +1,254 @@
+/*
+ * text.c - Lazily loaded story text
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "text.h"
+#include "core/logger.h"
+#include "core/utils.h"
+
+
+static const char *const text_files[TEXT_FILE_COUNT] = {
+	"rooms.ini", "items.ini", "npcs.ini"
+};
+
+
+/**
+ * text_ref_fits() - Check that every value in a file can be a TextRef
+ * @ini: File about to be tokenized
+ *
+ * Return: true if the file can be addressed with 32-bit offsets
+ */
+
+bool text_ref_fits(const IniFile *ini)
+{
+	return ini->size <= UINT32_MAX;
+}
+
+
+/**
+ * text_ref() - Record where a value sits in a mapped .ini file
+ * @ini: File being tokenized
+ * @view: Value inside @ini
+ *
+ * Return: The value's position
+ */
+
+TextRef text_ref(const IniFile *ini, IniView view)
+{
+	TextRef ref;
+
+	ref.offset = (uint32_t)(view.ptr - ini->data);
+	ref.length = (uint32_t)view.len;
+	return ref;
+}
+
+
+/**
+ * text_cache_init() - Start serving lazy text for a story
+ * @cache: Cache to set up
+ * @story_dir: Story directory holding the text files
+ *
+ * Return: void
+ */
+
+void text_cache_init(TextCache *cache, const char *story_dir)
+{
+	char filepath[STORY_DIRECTORY_SIZE + 16];
+	struct stat st;
+	int i;
+
+	memset(cache, 0, sizeof(*cache));
+	cache->enabled = true;
+	safe_strcpy(cache->story_dir, story_dir, sizeof(cache->story_dir));
+
+	for (i = 0; i < TEXT_FILE_COUNT; i++) {
+		snprintf(filepath, sizeof(filepath), "%s/%s", story_dir,
+			 text_files[i]);
+		cache->file_size[i] = -1;
+		if (stat(filepath, &st) == 0) {
+			cache->file_size[i] = (long)st.st_size;
+			cache->file_mtime[i] = st.st_mtime;
+		}
+	}
+}
+
+
+/**
+ * text_read() - Read one string back from its story file
+ * @cache: Story's text cache
+ * @file: File the string is in
+ * @ref: Where it is
+ *
+ * Return: malloc()ed NUL terminated copy, NULL on failure
+ */
+
+static char *text_read(const TextCache *cache, TextFile file, TextRef ref)
+{
+	char filepath[STORY_DIRECTORY_SIZE + 16];
+	struct stat st;
+	char *text;
+	FILE *fp;
+
+	snprintf(filepath, sizeof(filepath), "%s/%s", cache->story_dir,
+		 text_files[file]);
+
+	if (stat(filepath, &st) != 0 ||
+	    (long)st.st_size != cache->file_size[file] ||
+	    st.st_mtime != cache->file_mtime[file]) {
+		log_function_error(__func__, "story file changed since loading");
+		return NULL;
+	}
+
+	fp = fopen(filepath, "rb");
+	if (!fp)
+		return NULL;
+
+	text = malloc((size_t)ref.length + 1);
+	if (text && (fseek(fp, (long)ref.offset, SEEK_SET) != 0 ||
+		     fread(text, 1, ref.length, fp) != ref.length)) {
+		free(text);
+		text = NULL;
+	}
+	fclose(fp);
+
+	if (text)
+		text[ref.length] = '\0';
+	return text;
+}
+
+
+/**
+ * text_cache_get() - Fetch a string recorded with text_ref()
+ * @cache: Story's text cache
+ * @file: File the string is in
+ * @ref: Where it is
+ *
+ * Return: The string, "" if it is empty or cannot be read
+ */
+
+const char *text_cache_get(TextCache *cache, TextFile file, TextRef ref)
+{
+	TextCacheEntry *victim;
+	TextCacheEntry *entry;
+	char *text;
+	int i;
+
+	if (!cache->enabled || ref.length == 0 ||
+	    (unsigned int)file >= TEXT_FILE_COUNT)
+		return "";
+
+	cache->clock++;
+	victim = &cache->entries[0];
+
+	for (i = 0; i < TEXT_CACHE_SLOTS; i++) {
+		entry = &cache->entries[i];
+
+		if (entry->text && entry->file == file &&
+		    entry->ref.offset == ref.offset &&
+		    entry->ref.length == ref.length) {
+			entry->last_used = cache->clock;
+			cache->hits++;
+			return entry->text;
+		}
+
+		/* Free slots first, then the least recently used */
+		if (victim->text &&
+		    (!entry->text || entry->last_used < victim->last_used))
+			victim = entry;
+	}
+
+	cache->misses++;
+	text = text_read(cache, file, ref);
+	if (!text)
+		return "";
+
+	if (victim->text) {
+		cache->bytes -= victim->ref.length + 1;
+		free(victim->text);
+	}
+
+	victim->text = text;
+	victim->last_used = cache->clock;
+	victim->file = file;
+	victim->ref = ref;
+	cache->bytes += ref.length + 1;
+
+	return text;
+}
+
+
+/**
+ * text_file_name() - Name of a story text file
+ * @file: File
+ *
+ * Return: File name inside the story directory ("rooms.ini", ...)
+ */
+
+const char *text_file_name(TextFile file)
+{
+	return (unsigned int)file < TEXT_FILE_COUNT ? text_files[file] : "";
+}
+
+
+/**
+ * text_cache_refresh() - Pick up a story file that has been rewritten
+ * @cache: Story's text cache
+ * @file: File that changed
+ *
+ * Return: void
+ */
+
+void text_cache_refresh(TextCache *cache, TextFile file)
+{
+	char filepath[STORY_DIRECTORY_SIZE + 16];
+	struct stat st;
+	int i;
+
+	if (!cache->enabled || (unsigned int)file >= TEXT_FILE_COUNT)
+		return;
+
+	for (i = 0; i < TEXT_CACHE_SLOTS; i++) {
+		TextCacheEntry *entry = &cache->entries[i];
+
+		if (entry->text && entry->file == file) {
+			cache->bytes -= entry->ref.length + 1;
+			free(entry->text);
+			entry->text = NULL;
+		}
+	}
+
+	snprintf(filepath, sizeof(filepath), "%s/%s", cache->story_dir,
+		 text_files[file]);
+	cache->file_size[file] = -1;
+	if (stat(filepath, &st) == 0) {
+		cache->file_size[file] = (long)st.st_size;
+		cache->file_mtime[file] = st.st_mtime;
+	}
+}
+
+
+/**
+ * text_cache_free() - Drop every cached string
+ * @cache: Cache to empty
+ *
+ * Return: void
+ */
+
+void text_cache_free(TextCache *cache)
+{
+	int i;
+
+	for (i = 0; i < TEXT_CACHE_SLOTS; i++) {
+		free(cache->entries[i].text);
+		cache->entries[i].text = NULL;
+	}
+	cache->bytes = 0;
+}
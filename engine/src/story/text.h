@@ -0,0 +1,174 @@
+/*
+ * text.h - Lazily loaded story text
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STORY_TEXT_H
+#define STORY_TEXT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "core/constants.h"
+#include "ini_parser.h"
+
+
+/**
+ * enum TextFile - Story files that lazy text is read back from
+ */
+
+typedef enum {
+	TEXT_FILE_ROOMS,
+	TEXT_FILE_ITEMS,
+	TEXT_FILE_NPCS,
+	TEXT_FILE_COUNT
+} TextFile;
+
+
+/**
+ * struct TextRef - Where a string sits in its story file
+ * @offset: Byte offset of the first character
+ * @length: Length in bytes (0 for an empty or missing string)
+ */
+
+typedef struct TextRef {
+	uint32_t offset;
+	uint32_t length;
+} TextRef;
+
+
+/**
+ * struct TextCacheEntry - One string read back from disk
+ * @text: NUL terminated copy, NULL if the slot is free
+ * @last_used: Cache clock at the last hit, for eviction
+ * @file: File the string came from
+ * @ref: Where it came from in @file
+ */
+
+typedef struct TextCacheEntry {
+	char *text;
+	uint64_t last_used;
+	TextFile file;
+	TextRef ref;
+} TextCacheEntry;
+
+
+/**
+ * struct TextCache - Small LRU cache over a story's text files
+ * @enabled: The story was loaded lazily and its text lives on disk
+ * @story_dir: Directory the files are read from
+ * @file_size: Size of each file when the story was loaded
+ * @file_mtime: Modification time of each file when it was loaded
+ * @entries: Cached strings
+ * @clock: Bumped on every lookup
+ * @bytes: Bytes held by @entries
+ * @hits: Lookups served from the cache
+ * @misses: Lookups that read the file
+ */
+
+typedef struct TextCache {
+	bool enabled;
+	char story_dir[STORY_DIRECTORY_SIZE];
+	long file_size[TEXT_FILE_COUNT];
+	time_t file_mtime[TEXT_FILE_COUNT];
+	TextCacheEntry entries[TEXT_CACHE_SLOTS];
+	uint64_t clock;
+	size_t bytes;
+	long hits;
+	long misses;
+} TextCache;
+
+
+/**
+ * text_ref_fits() - Check that every value in a file can be a TextRef
+ * @ini: File about to be tokenized
+ *
+ * Return: true if the file is small enough to address with 32-bit
+ * offsets; otherwise the caller keeps its text in memory
+ */
+
+bool text_ref_fits(const IniFile *ini);
+
+
+/**
+ * text_ref() - Record where a value sits in a mapped .ini file
+ * @ini: File being tokenized (text_ref_fits() must hold)
+ * @view: Value inside @ini
+ *
+ * Return: The value's position
+ */
+
+TextRef text_ref(const IniFile *ini, IniView view);
+
+
+/**
+ * text_cache_init() - Start serving lazy text for a story
+ * @cache: Cache to set up
+ * @story_dir: Story directory holding the text files
+ *
+ * Notes each file's size and modification time, so text is never read
+ * back from a file that has changed since its offsets were recorded.
+ *
+ * Return: void
+ */
+
+void text_cache_init(TextCache *cache, const char *story_dir);
+
+
+/**
+ * text_cache_get() - Fetch a string recorded with text_ref()
+ * @cache: Story's text cache
+ * @file: File the string is in
+ * @ref: Where it is
+ *
+ * Hits cost a scan of TEXT_CACHE_SLOTS entries; misses evict the
+ * least recently used entry and read the string from disk. The result
+ * stays valid until TEXT_CACHE_SLOTS further strings have been read,
+ * so print it or copy it straight away.
+ *
+ * Return: The string, "" if it is empty or cannot be read
+ */
+
+const char *text_cache_get(TextCache *cache, TextFile file, TextRef ref);
+
+
+/**
+ * text_file_name() - Name of a story text file
+ * @file: File
+ *
+ * Return: File name inside the story directory ("rooms.ini", ...)
+ */
+
+const char *text_file_name(TextFile file);
+
+
+/**
+ * text_cache_refresh() - Pick up a story file that has been rewritten
+ * @cache: Story's text cache
+ * @file: File that changed
+ *
+ * Drops the strings cached from @file and notes its new size and
+ * modification time. Call it once every TextRef into @file has been
+ * updated to the new contents.
+ *
+ * Return: void
+ */
+
+void text_cache_refresh(TextCache *cache, TextFile file);
+
+
+/**
+ * text_cache_free() - Drop every cached string
+ * @cache: Cache to empty; it stays usable
+ *
+ * Return: void
+ */
+
+void text_cache_free(TextCache *cache);
+
+
+#endif /* STORY_TEXT_H */
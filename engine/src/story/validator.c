@@ -1,26 +1,539 @@
-#include "validator.h"
+/*
+ * validator.c - Check a loaded story can be played
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-/*
- * Validate story
- */
-bool validate_story(Story* story) {
-    printf("[STUB] validate_story()\n");
-    
-    if (!story) {
-        printf("ERROR: Story is NULL\n");
-        return false;
-    }
-    
-    // Basic validation
-    if (strlen(story->metadata.title) == 0) {
-        printf("ERROR: Story has no title\n");
-        return false;
-    }
-    
-    printf("Story '%s' passed basic validation\n", story->metadata.title);
-    
-    // For now, always return true
-    return true;
-}
\ No newline at end of file
+#include "validator.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "core/utils.h"
+#include "system/platform.h"
+#include "ui/colors.h"
+#include "world/rooms.h"
+
+
+/**
+ * struct ValidateReport - Problems found so far
+ * @errors: Problems that stop the story being played
+ * @warnings: Problems the story can be played with
+ * @printed: Problems printed (all are logged)
+ */
+
+typedef struct {
+	int errors;
+	int warnings;
+	int printed;
+} ValidateReport;
+
+
+/**
+ * struct RoomRefs - Where one room's references are in the reference list
+ * @first: First entry: exits, then items, then NPCs
+ * @exits: Exits that lead to a defined room
+ * @items: Items listed in the room that are defined
+ * @npcs: NPCs listed in the room that are defined
+ */
+
+typedef struct {
+	uint32_t first;
+	uint8_t exits;
+	uint16_t items;
+	uint16_t npcs;
+} RoomRefs;
+
+
+/**
+ * struct ValidateGraph - Resolved references of every room
+ * @rooms: One entry per room number
+ * @refs: Room, item and NPC numbers, grouped per room
+ * @ref_count: Entries used in @refs
+ * @ref_capacity: Entries allocated in @refs
+ * @reached: Rooms reachable from the start room
+ */
+
+typedef struct {
+	RoomRefs *rooms;
+	int32_t *refs;
+	int ref_count;
+	int ref_capacity;
+	bool *reached;
+} ValidateGraph;
+
+
+/**
+ * validate_report() - Report one problem
+ * @report: Running report
+ * @error: Problem stops the story being played
+ * @fmt: printf-style description
+ *
+ * Every problem is logged; only the first VALIDATE_MAX_REPORTED are
+ * printed so a badly broken story does not flood the console.
+ *
+ * Return: void
+ */
+
+static void validate_report(ValidateReport *report, bool error,
+			    const char *fmt, ...)
+	__attribute__((format(printf, 3, 4)));
+
+static void validate_report(ValidateReport *report, bool error,
+			    const char *fmt, ...)
+{
+	char message[LOG_MESSAGE_BUFFER_SIZE];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(message, sizeof(message), fmt, args);
+	va_end(args);
+
+	if (error)
+		report->errors++;
+	else
+		report->warnings++;
+
+	add_log_entry("Validation %s: %s", error ? "error" : "warning",
+		      message);
+
+	if (report->printed < VALIDATE_MAX_REPORTED) {
+		report->printed++;
+		printf_colored(error ? COLOR_ERROR : COLOR_WARNING, "%s: %s\n",
+			       error ? "ERROR" : "WARNING", message);
+	}
+}
+
+
+/**
+ * validate_ref() - Add one resolved reference to the current room
+ * @graph: Graph being built
+ * @number: Room, item or NPC number
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+static int validate_ref(ValidateGraph *graph, int number)
+{
+	int32_t *grown;
+
+	grown = array_grow(graph->refs, graph->ref_count, &graph->ref_capacity,
+			   sizeof(*graph->refs));
+	if (!grown)
+		return -ENOMEM;
+
+	graph->refs = grown;
+	graph->refs[graph->ref_count++] = number;
+	return 0;
+}
+
+
+/**
+ * validate_room() - Check one room's references and record them
+ * @story: Story being validated
+ * @room: Room to check
+ * @number: Its room number
+ * @graph: Graph being built
+ * @report: Running report
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+static int validate_room(Story *story, const Room *room, int number,
+			 ValidateGraph *graph, ValidateReport *report)
+{
+	RoomRefs *refs = &graph->rooms[number];
+	int target;
+	int ret = 0;
+
+	refs->first = (uint32_t)graph->ref_count;
+
+	for (int d = 0; d < DIR_COUNT && ret == 0; d++) {
+		if (!room->exit_ids[d])
+			continue;
+
+		target = story_index_find(&story->room_index, room->exit_ids[d]);
+		if (target < 0) {
+			validate_report(report, true,
+					"room '%s' exit %s leads to unknown room '%s'",
+					room->id, direction_name((Direction)d),
+					room->exit_ids[d]);
+			continue;
+		}
+		ret = validate_ref(graph, target);
+		refs->exits++;
+	}
+
+	for (int i = 0; i < room->item_id_count && ret == 0; i++) {
+		target = story_index_find(&story->item_index, room->item_ids[i]);
+		if (target < 0) {
+			validate_report(report, true,
+					"room '%s' lists unknown item '%s'",
+					room->id, room->item_ids[i]);
+			continue;
+		}
+		ret = validate_ref(graph, target);
+		refs->items++;
+	}
+
+	for (int i = 0; i < room->npc_id_count && ret == 0; i++) {
+		target = story_index_find(&story->npc_index, room->npc_ids[i]);
+		if (target < 0) {
+			validate_report(report, true,
+					"room '%s' lists unknown NPC '%s'",
+					room->id, room->npc_ids[i]);
+			continue;
+		}
+		ret = validate_ref(graph, target);
+		refs->npcs++;
+	}
+
+	return ret;
+}
+
+
+/**
+ * validate_rooms() - Check every room, visiting each exactly once
+ * @story: Story being validated
+ * @graph: Graph to build
+ * @report: Running report
+ *
+ * A streamed story is walked region by region, so each region is
+ * loaded once and only a few are resident at a time.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int validate_rooms(Story *story, ValidateGraph *graph,
+			  ValidateReport *report)
+{
+	const RoomStream *stream = &story->stream;
+	int ret;
+
+	if (!stream->enabled) {
+		for (int i = 0; i < story->room_count; i++) {
+			ret = validate_room(story, &story->rooms[i], i, graph,
+					    report);
+			if (ret != 0)
+				return ret;
+		}
+		return 0;
+	}
+
+	for (int r = 0; r < stream->region_count; r++) {
+		const RoomRegion *region = &stream->regions[r];
+
+		for (uint32_t k = 0; k < region->count; k++) {
+			int number = (int)stream->members[region->first + k];
+			Room *room = story_room(story, number);
+
+			if (!room) {
+				validate_report(report, true,
+						"room '%s' cannot be loaded",
+						stream->slots[number].id);
+				continue;
+			}
+
+			ret = validate_room(story, room, number, graph, report);
+			if (ret != 0)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * validate_reach() - Find the rooms reachable from the start room
+ * @story: Story being validated
+ * @graph: Graph with every room's exits
+ * @start: Start room number
+ *
+ * Breadth-first over the exits, ignoring locks (every lock in a story
+ * is meant to be opened).
+ *
+ * Return: Number of rooms reached, negative errno on failure
+ */
+
+static int validate_reach(const Story *story, ValidateGraph *graph,
+			  int start)
+{
+	int32_t *queue;
+	int head = 0;
+	int tail = 0;
+
+	queue = malloc(sizeof(*queue) * (size_t)story->room_count);
+	if (!queue)
+		return -ENOMEM;
+
+	graph->reached[start] = true;
+	queue[tail++] = start;
+
+	while (head < tail) {
+		const RoomRefs *refs = &graph->rooms[queue[head++]];
+
+		for (int e = 0; e < refs->exits; e++) {
+			int32_t next = graph->refs[refs->first + (uint32_t)e];
+
+			if (!graph->reached[next]) {
+				graph->reached[next] = true;
+				queue[tail++] = next;
+			}
+		}
+	}
+
+	free(queue);
+	return tail;
+}
+
+
+/**
+ * validate_duplicates() - Report IDs defined more than once
+ * @report: Running report
+ * @index: Index over the entities (the first definition wins)
+ * @base: First entity's ID field
+ * @count: Number of entities
+ * @stride: Distance between entities in bytes
+ * @what: Kind of entity, for the report
+ *
+ * Return: void
+ */
+
+static void validate_duplicates(ValidateReport *report,
+				const StoryIndex *index, const void *base,
+				int count, size_t stride, const char *what)
+{
+	for (int i = 0; i < count; i++) {
+		const char *id = *(const char *const *)
+			((const char *)base + (size_t)i * stride);
+
+		if (story_index_find(index, id) != i)
+			validate_report(report, true, "%s '%s' is defined more "
+					"than once", what, id);
+	}
+}
+
+
+/**
+ * validate_quests() - Check every quest can be completed
+ * @story: Story being validated
+ * @graph: Graph with reachability worked out
+ * @report: Running report
+ *
+ * The game checks a quest when the player takes an item, talks to an
+ * NPC or enters a room, one at a time, so a quest naming more than one
+ * target can never complete. Otherwise the item must be takeable and
+ * lie in a reachable room, the NPC must be in a reachable room, and
+ * the room must be reachable. A required quest that cannot complete
+ * makes the story unwinnable and is an error.
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+static int validate_quests(Story *story, const ValidateGraph *graph,
+			   ValidateReport *report)
+{
+	bool *item_reached;
+	bool *npc_reached;
+
+	item_reached = calloc((size_t)story->item_count + 1, sizeof(bool));
+	npc_reached = calloc((size_t)story->npc_count + 1, sizeof(bool));
+	if (!item_reached || !npc_reached) {
+		free(item_reached);
+		free(npc_reached);
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < story->room_count; i++) {
+		const RoomRefs *refs = &graph->rooms[i];
+		uint32_t at = refs->first + refs->exits;
+
+		if (!graph->reached[i])
+			continue;
+		for (int k = 0; k < refs->items; k++)
+			item_reached[graph->refs[at++]] = true;
+		for (int k = 0; k < refs->npcs; k++)
+			npc_reached[graph->refs[at++]] = true;
+	}
+
+	for (int i = 0; i < story->quest_count; i++) {
+		const Quest *quest = &story->quests[i];
+		const char *why = NULL;
+		int targets = 0;
+		int n;
+
+		targets += quest->completion_item[0] != '\0';
+		targets += quest->completion_npc[0] != '\0';
+		targets += quest->completion_room[0] != '\0';
+
+		if (targets > 1) {
+			why = "names more than one target";
+		} else if (quest->completion_item[0] != '\0') {
+			n = story_index_find(&story->item_index,
+					     quest->completion_item);
+			if (n < 0)
+				why = "needs an unknown item";
+			else if (!story->items[n].takeable)
+				why = "needs an item that cannot be taken";
+			else if (!item_reached[n])
+				why = "needs an item no reachable room holds";
+		} else if (quest->completion_npc[0] != '\0') {
+			n = story_index_find(&story->npc_index,
+					     quest->completion_npc);
+			if (n < 0)
+				why = "needs an unknown NPC";
+			else if (!npc_reached[n])
+				why = "needs an NPC no reachable room holds";
+		} else if (quest->completion_room[0] != '\0') {
+			n = story_index_find(&story->room_index,
+					     quest->completion_room);
+			if (n < 0)
+				why = "needs an unknown room";
+			else if (!graph->reached[n])
+				why = "needs a room that cannot be reached";
+		}
+
+		if (why)
+			validate_report(report, quest->required,
+					"%s quest '%s' can never complete: it %s",
+					quest->required ? "required" : "optional",
+					quest->id, why);
+	}
+
+	free(item_reached);
+	free(npc_reached);
+	return 0;
+}
+
+
+/**
+ * validate_story() - Check a loaded story can be played
+ * @story: Story with its indexes built
+ *
+ * Return: True if the story has no errors (warnings are allowed)
+ */
+
+bool validate_story(Story* story)
+{
+	ValidateReport report = { 0 };
+	ValidateGraph graph = { 0 };
+	const void *room_ids;
+	size_t room_stride;
+	double start_ms = platform_time_ms();
+	int reached = 0;
+	int start = -1;
+	int ret = 0;
+
+	if (!story) {
+		printf("ERROR: Story is NULL\n");
+		return false;
+	}
+
+	log_function_entry(__func__, "rooms=%d, items=%d, npcs=%d, quests=%d",
+			   story->room_count, story->item_count,
+			   story->npc_count, story->quest_count);
+
+	if (strlen(story->metadata.title) == 0)
+		validate_report(&report, true, "story has no title");
+
+	/* Duplicate IDs */
+	if (story->stream.enabled) {
+		room_ids = &story->stream.slots[0].id;
+		room_stride = sizeof(RoomSlot);
+	} else {
+		room_ids = story->rooms ? &story->rooms[0].id : NULL;
+		room_stride = sizeof(Room);
+	}
+	validate_duplicates(&report, &story->room_index, room_ids,
+			    story->room_count, room_stride, "room");
+	validate_duplicates(&report, &story->item_index,
+			    story->items ? &story->items[0].id : NULL,
+			    story->item_count, sizeof(Item), "item");
+	validate_duplicates(&report, &story->npc_index,
+			    story->npcs ? &story->npcs[0].id : NULL,
+			    story->npc_count, sizeof(NPC), "NPC");
+	validate_duplicates(&report, &story->quest_index,
+			    story->quests ? &story->quests[0].id : NULL,
+			    story->quest_count, sizeof(Quest), "quest");
+
+	/* NPC references */
+	for (int i = 0; i < story->npc_count; i++) {
+		const NPC *npc = &story->npcs[i];
+
+		if (npc->location[0] != '\0' &&
+		    story_index_find(&story->room_index, npc->location) < 0)
+			validate_report(&report, true,
+					"NPC '%s' is located in unknown room '%s'",
+					npc->id, npc->location);
+		if (npc->required_item[0] != '\0' &&
+		    story_index_find(&story->item_index, npc->required_item) < 0)
+			validate_report(&report, true,
+					"NPC '%s' requires unknown item '%s'",
+					npc->id, npc->required_item);
+	}
+
+	/* Rooms, then everything reachable from the start */
+	if (story->metadata.start_room[0] == '\0')
+		validate_report(&report, true, "story has no start_room");
+	else if ((start = story_index_find(&story->room_index,
+					   story->metadata.start_room)) < 0)
+		validate_report(&report, true, "start_room '%s' does not exist",
+				story->metadata.start_room);
+
+	if (story->room_count > 0) {
+		graph.rooms = calloc((size_t)story->room_count,
+				     sizeof(*graph.rooms));
+		graph.reached = calloc((size_t)story->room_count,
+				       sizeof(*graph.reached));
+		ret = graph.rooms && graph.reached ? 0 : -ENOMEM;
+		if (ret == 0)
+			ret = validate_rooms(story, &graph, &report);
+		if (ret == 0 && start >= 0) {
+			reached = validate_reach(story, &graph, start);
+			if (reached < 0)
+				ret = reached;
+			else if (reached < story->room_count)
+				validate_report(&report, false,
+						"%d of %d rooms cannot be reached "
+						"from '%s'",
+						story->room_count - reached,
+						story->room_count,
+						story->metadata.start_room);
+		}
+		if (ret == 0 && start >= 0)
+			ret = validate_quests(story, &graph, &report);
+	} else {
+		validate_report(&report, true, "story has no rooms");
+	}
+
+	free(graph.rooms);
+	free(graph.refs);
+	free(graph.reached);
+
+	if (ret < 0) {
+		printf_colored(COLOR_ERROR, "ERROR: Out of memory validating story\n");
+		log_function_exit(__func__, ret);
+		return false;
+	}
+
+	if (report.printed < report.errors + report.warnings)
+		printf_colored(COLOR_WARNING, "... and %d more problems (see log)\n",
+			       report.errors + report.warnings - report.printed);
+
+	printf("Validated %d rooms, %d items, %d NPCs, %d quests in %.2f ms: "
+	       "%d errors, %d warnings\n", story->room_count, story->item_count,
+	       story->npc_count, story->quest_count,
+	       platform_time_ms() - start_ms, report.errors, report.warnings);
+	if (report.errors == 0)
+		printf("Story '%s' passed validation\n", story->metadata.title);
+
+	log_function_exit(__func__, report.errors);
+	return report.errors == 0;
+}
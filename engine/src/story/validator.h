@@ -9,6 +9,14 @@
  */
 
 // Validate story (returns true if valid)
+//
+// Errors: no title, no rooms, a missing start_room, IDs defined more
+// than once, exits, room contents or NPC references naming something
+// the story does not define, and required quests that can never
+// complete. Warnings: rooms unreachable from the start, and optional
+// quests that can never complete. Every ID is looked up through the
+// story's hash indexes and reachability is one breadth-first walk, so
+// the time taken grows linearly with the size of the story.
 bool validate_story(Story* story);
 
 #endif // VALIDATOR_H
\ No newline at end of file
@@ -1,5 +1,22 @@
 #include "platform.h"
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef PLATFORM_WINDOWS
+#include <io.h>
+#include <limits.h>
+#include <psapi.h>
+#endif
+
+#ifndef PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /*
  * Initialize platform-specific code
@@ -56,4 +73,173 @@ int platform_get_key(void) {
     }
 #endif
     return -1;  // No key pressed
-}
\ No newline at end of file
+}
+
+/*
+ * Monotonic wall clock in milliseconds
+ */
+double platform_time_ms(void) {
+#ifdef PLATFORM_WINDOWS
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+#endif
+}
+
+/*
+ * Read a whole file into a heap buffer (fallback for platform_map_file)
+ */
+static int platform_read_file(const char *path, const char **data,
+                              size_t *size) {
+    FILE *fp;
+    char *buffer;
+    long length;
+
+    fp = fopen(path, "rb");
+    if (!fp)
+        return -ENOENT;
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (length = ftell(fp)) < 0) {
+        fclose(fp);
+        return -EIO;
+    }
+    rewind(fp);
+
+    buffer = malloc((size_t)length + 1);
+    if (!buffer) {
+        fclose(fp);
+        return -ENOMEM;
+    }
+
+    *size = fread(buffer, 1, (size_t)length, fp);
+    fclose(fp);
+
+    if (*size == 0) {
+        free(buffer);
+        *data = "";
+        return 0;
+    }
+
+    *data = buffer;
+    return 0;
+}
+
+/*
+ * Map a whole file read-only. Empty files give "" with size 0 and
+ * platforms without mmap() fall back to one read into the heap.
+ * Returns 0 on success, negative errno on failure.
+ */
+int platform_map_file(const char *path, const char **data, size_t *size,
+                      bool *mapped) {
+    *data = NULL;
+    *size = 0;
+    *mapped = false;
+
+#ifndef PLATFORM_WINDOWS
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -EIO;
+    }
+
+    if (st.st_size == 0) {
+        close(fd);
+        *data = "";
+        return 0;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return platform_read_file(path, data, size);
+
+    *data = map;
+    *size = (size_t)st.st_size;
+    *mapped = true;
+    return 0;
+#else
+    return platform_read_file(path, data, size);
+#endif
+}
+
+/*
+ * Release a file mapped with platform_map_file
+ */
+void platform_unmap_file(const char *data, size_t size, bool mapped) {
+    if (!data || size == 0)
+        return;
+
+#ifndef PLATFORM_WINDOWS
+    if (mapped) {
+        munmap((void *)data, size);
+        return;
+    }
+#else
+    (void)mapped;
+#endif
+    free((void *)data);
+}
+
+/*
+ * Write a whole buffer to a file descriptor. Normally one write() call;
+ * more only when a pipe or socket takes part of it or a signal
+ * interrupts. Returns 0 on success, negative errno on failure.
+ */
+int platform_write(int fd, const void *data, size_t size) {
+    const char *p = data;
+
+    while (size > 0) {
+#ifdef PLATFORM_WINDOWS
+        int n = _write(fd, p, size > INT_MAX ? INT_MAX : (unsigned int)size);
+#else
+        ssize_t n = write(fd, p, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+/*
+ * Most memory the process has had resident so far, in bytes
+ */
+size_t platform_peak_rss(void) {
+#ifdef PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                                 sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return (size_t)usage.ru_maxrss;             /* bytes on macOS */
+#else
+    return (size_t)usage.ru_maxrss * 1024;      /* kilobytes elsewhere */
+#endif
+#endif
+}
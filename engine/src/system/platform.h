@@ -1,6 +1,9 @@
 #ifndef PLATFORM_H
 #define PLATFORM_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 /*
  * Platform detection
  */
@@ -33,4 +36,20 @@ void platform_clear_screen(void);
 // Get single keypress (non-blocking)
 int platform_get_key(void);
 
+// Monotonic wall clock in milliseconds (for timing, not dates)
+double platform_time_ms(void);
+
+// Map a whole file read-only (heap copy where mmap is unavailable)
+int platform_map_file(const char *path, const char **data, size_t *size,
+                      bool *mapped);
+
+// Release a file mapped with platform_map_file
+void platform_unmap_file(const char *data, size_t size, bool mapped);
+
+// Write a whole buffer to a file descriptor, retrying short writes
+int platform_write(int fd, const void *data, size_t size);
+
+// Most memory the process has had resident so far, in bytes (0 if unknown)
+size_t platform_peak_rss(void);
+
 #endif // PLATFORM_H
\ No newline at end of file
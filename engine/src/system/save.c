@@ -20,6 +20,7 @@
 #include "story/ini_parser.h"
 #include "world/items.h"
 #include "world/npcs.h"
+#include "world/rooms.h"
 
 /**
  * save_exists() - Check if save file exists
@@ -110,6 +111,12 @@ int save_game(GameState *game, int slot)
 		if (game->story->quests[i].completed) {
 			fprintf(f, "completed_%s=true\n", game->story->quests[i].id);
 		}
+		if (game->story->quests[i].started) {
+			fprintf(f, "started_%s=true\n", game->story->quests[i].id);
+		}
+		if (game->story->quests[i].failed) {
+			fprintf(f, "failed_%s=true\n", game->story->quests[i].id);
+		}
 	}
 	fprintf(f, "\n");
 
@@ -120,6 +127,10 @@ int save_game(GameState *game, int slot)
 		if (game->story->npcs[i].defeated) {
 			fprintf(f, "defeated_%s=true\n", game->story->npcs[i].id);
 		}
+		if (game->story->npcs[i].dialog_state != 0) {
+			fprintf(f, "dialog_state_%s=%d\n", game->story->npcs[i].id,
+			        game->story->npcs[i].dialog_state);
+		}
 	}
 
 	fclose(f);
@@ -213,8 +224,7 @@ int save_game(GameState *game, int slot)
 				item_index = atoi(key + 5);
 				
 				/* Find item in story */
-				Item *item = find_item_by_id(game->story->items,
-				                            game->story->item_count,
+				Item *item = find_item_by_id(game->story,
 				                            value);
 				if (item && item_index < 100) {
 					/* Add to inventory */
@@ -233,14 +243,23 @@ int save_game(GameState *game, int slot)
 				const char *quest_id = key + 10;
 				
 				/* Find quest in story */
-				Quest *quest = find_quest_by_id(game->story->quests,
-				                               game->story->quest_count,
+				Quest *quest = find_quest_by_id(game->story,
 				                               quest_id);
 				if (quest && strcmp(value, "true") == 0) {
 					quest->completed = true;
 					add_log_entry("Loaded completed quest: %s at %s",
 					             quest_id, log_timestamp());
 				}
+			} else if (strncmp(key, "started_", 8) == 0) {
+				Quest *quest = find_quest_by_id(game->story, key + 8);
+
+				if (quest)
+					quest->started = strcmp(value, "true") == 0;
+			} else if (strncmp(key, "failed_", 7) == 0) {
+				Quest *quest = find_quest_by_id(game->story, key + 7);
+
+				if (quest)
+					quest->failed = strcmp(value, "true") == 0;
 			}
 		}
 
@@ -251,20 +270,27 @@ int save_game(GameState *game, int slot)
 				const char *npc_id = key + 9;
 				
 				/* Find NPC in story */
-				NPC *npc = find_npc_by_id(game->story->npcs,
-				                         game->story->npc_count,
+				NPC *npc = find_npc_by_id(game->story,
 				                         npc_id);
 				if (npc && strcmp(value, "true") == 0) {
 					npc->defeated = true;
 					add_log_entry("Loaded defeated NPC: %s at %s",
 					             npc_id, log_timestamp());
 				}
+			} else if (strncmp(key, "dialog_state_", 13) == 0) {
+				NPC *npc = find_npc_by_id(game->story, key + 13);
+
+				if (npc)
+					npc->dialog_state = atoi(value);
 			}
 		}
 	}
 
 	fclose(f);
 
+	/* What the rooms show was rendered for the game being replaced */
+	room_views_invalidate_all(game->story);
+
 	/* Set current room */
 	if (room_id[0] != '\0') {
 		game->current_room = find_room_by_id(game->story, room_id);
@@ -273,6 +299,7 @@ int save_game(GameState *game, int slot)
 			log_function_exit(__func__, -EINVAL);
 			return -EINVAL;
 		}
+		room_stream_enter(game->story, game->current_room);
 	}
 
 	add_log_entry("Game loaded from slot %d at %s", slot, log_timestamp());
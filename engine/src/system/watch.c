@@ -0,0 +1,198 @@
+/*
+ * watch.c - Notice story files being edited while the story is played
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "watch.h"
+#include "core/constants.h"
+#include "core/logger.h"
+#include "story/text.h"
+#include "system/platform.h"
+
+#ifdef PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <sys/select.h>
+#endif
+
+
+#ifdef PLATFORM_LINUX
+
+/**
+ * watch_read() - Collect the story files named by pending events
+ * @watch: Open watch
+ *
+ * Return: Bit per changed story file, negative errno on failure
+ */
+
+static int watch_read(StoryWatch *watch)
+{
+	char buffer[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *event;
+	ssize_t len;
+	int files = 0;
+
+	len = read(watch->fd, buffer, sizeof(buffer));
+	if (len < 0)
+		return errno == EINTR || errno == EAGAIN ? 0 : -errno;
+
+	for (char *p = buffer; p < buffer + len;
+	     p += sizeof(*event) + event->len) {
+		event = (const struct inotify_event *)p;
+		if (event->len == 0)
+			continue;
+
+		for (int file = 0; file < TEXT_FILE_COUNT; file++) {
+			if (strcmp(event->name, text_file_name(file)) == 0)
+				files |= 1 << file;
+		}
+	}
+
+	return files;
+}
+
+
+/**
+ * watch_ready() - Wait until a descriptor is readable
+ * @watch_fd: inotify descriptor
+ * @input_fd: Player input, -1 for none
+ * @timeout_ms: Longest wait, -1 for no limit
+ *
+ * Return: 1 for the watch, 2 for input, 0 on timeout, negative errno on
+ * failure
+ */
+
+static int watch_ready(int watch_fd, int input_fd, int timeout_ms)
+{
+	struct timeval timeout;
+	fd_set fds;
+	int max_fd = watch_fd > input_fd ? watch_fd : input_fd;
+	int ret;
+
+	FD_ZERO(&fds);
+	FD_SET(watch_fd, &fds);
+	if (input_fd >= 0)
+		FD_SET(input_fd, &fds);
+
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+	ret = select(max_fd + 1, &fds, NULL, NULL,
+		     timeout_ms < 0 ? NULL : &timeout);
+	if (ret < 0)
+		return errno == EINTR ? 0 : -errno;
+	if (input_fd >= 0 && FD_ISSET(input_fd, &fds))
+		return 2;
+	return FD_ISSET(watch_fd, &fds) ? 1 : 0;
+}
+
+#endif /* PLATFORM_LINUX */
+
+
+/**
+ * story_watch_open() - Start watching a story directory
+ * @watch: Watch to set up
+ * @story_dir: Directory holding rooms.ini, items.ini and npcs.ini
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int story_watch_open(StoryWatch *watch, const char *story_dir)
+{
+	watch->fd = -1;
+	watch->wd = -1;
+
+#ifdef PLATFORM_LINUX
+	watch->fd = inotify_init1(IN_CLOEXEC);
+	if (watch->fd < 0) {
+		int err = errno;
+
+		log_function_error(__func__, strerror(err));
+		return -err;
+	}
+
+	watch->wd = inotify_add_watch(watch->fd, story_dir,
+				      IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watch->wd < 0) {
+		int err = errno;
+
+		add_log_entry("Cannot watch %s: %s", story_dir, strerror(err));
+		story_watch_close(watch);
+		return -err;
+	}
+
+	add_log_entry("Watching %s for edits", story_dir);
+	return 0;
+#else
+	(void)story_dir;
+	return -ENOSYS;
+#endif
+}
+
+
+/**
+ * story_watch_wait() - Wait for player input or an edited story file
+ * @watch: Open watch
+ * @input_fd: Descriptor the player types into
+ *
+ * Return: Bit per changed story file, 0 when input is ready, negative
+ * errno on failure
+ */
+
+int story_watch_wait(StoryWatch *watch, int input_fd)
+{
+#ifdef PLATFORM_LINUX
+	int files = 0;
+	int ret;
+
+	if (watch->fd < 0)
+		return -EBADF;
+
+	for (;;) {
+		/* Input waits while an edit settles */
+		ret = watch_ready(watch->fd, files ? -1 : input_fd,
+				  files ? WATCH_SETTLE_MS : -1);
+		if (ret < 0)
+			return ret;
+		if (ret == 2)
+			return 0;
+		if (ret == 0) {
+			if (files)
+				return files;
+			continue;
+		}
+
+		ret = watch_read(watch);
+		if (ret < 0)
+			return ret;
+		files |= ret;
+	}
+#else
+	(void)watch;
+	(void)input_fd;
+	return 0;
+#endif
+}
+
+
+/**
+ * story_watch_close() - Stop watching
+ * @watch: Watch to close
+ *
+ * Return: void
+ */
+
+void story_watch_close(StoryWatch *watch)
+{
+#ifdef PLATFORM_LINUX
+	if (watch->fd >= 0)
+		close(watch->fd);
+#endif
+	watch->fd = -1;
+	watch->wd = -1;
+}
@@ -0,0 +1,65 @@
+/*
+ * watch.h - Notice story files being edited while the story is played
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef SYSTEM_WATCH_H
+#define SYSTEM_WATCH_H
+
+
+/**
+ * struct StoryWatch - Watch on one story directory
+ * @fd: inotify descriptor, -1 when not watching
+ * @wd: Watch on the story directory
+ */
+
+typedef struct StoryWatch {
+	int fd;
+	int wd;
+} StoryWatch;
+
+
+/**
+ * story_watch_open() - Start watching a story directory
+ * @watch: Watch to set up
+ * @story_dir: Directory holding rooms.ini, items.ini and npcs.ini
+ *
+ * Both files written in place and files renamed over the old ones (as
+ * most editors save) are noticed.
+ *
+ * Return: 0 on success, -ENOSYS where the platform cannot watch files,
+ * other negative errno on failure
+ */
+
+int story_watch_open(StoryWatch *watch, const char *story_dir);
+
+
+/**
+ * story_watch_wait() - Wait for player input or an edited story file
+ * @watch: Open watch
+ * @input_fd: Descriptor the player types into
+ *
+ * Once a story file changes, waits until nothing has been written for
+ * WATCH_SETTLE_MS so a file is not read while the editor is still
+ * saving it.
+ *
+ * Return: Bit (1u << TextFile) set for each story file that changed, 0
+ * when input is ready, negative errno on failure
+ */
+
+int story_watch_wait(StoryWatch *watch, int input_fd);
+
+
+/**
+ * story_watch_close() - Stop watching
+ * @watch: Watch to close (may never have been opened)
+ *
+ * Return: void
+ */
+
+void story_watch_close(StoryWatch *watch);
+
+
+#endif /* SYSTEM_WATCH_H */
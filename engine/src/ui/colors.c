@@ -6,9 +6,11 @@
  */
 
 #include "colors.h"
+#include "output.h"
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <strings.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -16,6 +18,30 @@
 
 static bool colors_enabled = true;
 
+/* Color names story files may use, with their escape sequences */
+static const struct {
+	const char *name;
+	const char *code;
+} color_names[] = {
+	{ "black", COLOR_BLACK },
+	{ "red", COLOR_RED },
+	{ "green", COLOR_GREEN },
+	{ "yellow", COLOR_YELLOW },
+	{ "blue", COLOR_BLUE },
+	{ "magenta", COLOR_MAGENTA },
+	{ "cyan", COLOR_CYAN },
+	{ "white", COLOR_WHITE },
+	{ "gray", COLOR_GRAY },
+	{ "bright_black", COLOR_BRIGHT_BLACK },
+	{ "bright_red", COLOR_BRIGHT_RED },
+	{ "bright_green", COLOR_BRIGHT_GREEN },
+	{ "bright_yellow", COLOR_BRIGHT_YELLOW },
+	{ "bright_blue", COLOR_BRIGHT_BLUE },
+	{ "bright_magenta", COLOR_BRIGHT_MAGENTA },
+	{ "bright_cyan", COLOR_BRIGHT_CYAN },
+	{ "bright_white", COLOR_BRIGHT_WHITE },
+};
+
 /**
  * color_init() - Initialize color system
  *
@@ -66,15 +92,18 @@ int color_enabled(void) {
  * @text: Text to print
  * @color: ANSI color code
  *
- * Prints text in specified color, then resets to default.
+ * Prints text in specified color, then resets to default. Goes to
+ * the thread's output buffer when one is selected (see ui/output.h).
  *
  * Return: void
  */
 void print_colored(const char* text, const char* color) {
 	if (colors_enabled) {
-		printf("%s%s%s", color, text, COLOR_RESET);
+		output_text(color);
+		output_text(text);
+		output_text(COLOR_RESET);
 	} else {
-		printf("%s", text);
+		output_text(text);
 	}
 }
 
@@ -84,7 +113,8 @@ void print_colored(const char* text, const char* color) {
  * @format: Printf format string
  * @...: Variable arguments for format string
  *
- * Prints formatted text in specified color with auto-reset.
+ * Prints formatted text in specified color with auto-reset, to the
+ * thread's output buffer when one is selected.
  *
  * Return: void
  */
@@ -92,14 +122,30 @@ void printf_colored(const char* color, const char* format, ...) {
 	va_list args;
 	
 	if (colors_enabled) {
-		printf("%s", color);
+		output_text(color);
 	}
 	
 	va_start(args, format);
-	vprintf(format, args);
+	output_vprintf(format, args);
 	va_end(args);
 	
 	if (colors_enabled) {
-		printf("%s", COLOR_RESET);
+		output_text(COLOR_RESET);
 	}
-}
\ No newline at end of file
+}
+
+/**
+ * color_from_name() - Look up a color named in a story file
+ * @name: Color name, case-insensitive ("cyan", "bright_red"...)
+ *
+ * Meant for load time, so printing never compares names.
+ *
+ * Return: Escape sequence, NULL if @name is not a color
+ */
+const char* color_from_name(const char* name) {
+	for (size_t i = 0; i < sizeof(color_names) / sizeof(color_names[0]); i++) {
+		if (strcasecmp(color_names[i].name, name) == 0)
+			return color_names[i].code;
+	}
+	return NULL;
+}
@@ -81,4 +81,7 @@ void print_colored(const char* text, const char* color);
 /* Printf-style colored output */
 void printf_colored(const char* color, const char* format, ...);
 
+/* Escape sequence for a color name from a story file ("cyan", "bright_red") */
+const char* color_from_name(const char* name);
+
 #endif /* COLORS_H */
\ No newline at end of file
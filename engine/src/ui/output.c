@@ -0,0 +1,252 @@
+/*
+ * output.c - Per-turn output buffer
+ *
+ * Handlers print many small pieces per turn: a colour, a name, a
+ * reset, a newline. Through stdio each piece is a call and, on a pipe
+ * or socket, often a write of its own. Appending them to a session's
+ * buffer instead and writing it once at the end of the turn makes the
+ * number of writes per turn constant.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "output.h"
+#include "core/constants.h"
+#include "system/platform.h"
+
+
+/* Buffer each thread's printing goes to, NULL for stdout */
+static _Thread_local Output *output_sink;
+
+
+/**
+ * output_init() - Set up an empty output buffer
+ * @out: Buffer to set up
+ * @fd: File descriptor the buffer is flushed to
+ */
+
+void output_init(Output *out, int fd)
+{
+	out->data = NULL;
+	out->length = 0;
+	out->capacity = 0;
+	out->fd = fd;
+	out->truncated = false;
+}
+
+
+/**
+ * output_free() - Release an output buffer without flushing it
+ * @out: Buffer to release
+ */
+
+void output_free(Output *out)
+{
+	if (output_sink == out)
+		output_sink = NULL;
+	free(out->data);
+	out->data = NULL;
+	out->length = 0;
+	out->capacity = 0;
+}
+
+
+/**
+ * output_flush() - Write everything buffered in one call
+ * @out: Buffer to flush
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int output_flush(Output *out)
+{
+	int ret;
+
+	fflush(stdout);
+	if (out->length == 0)
+		return 0;
+
+	ret = platform_write(out->fd, out->data, out->length);
+	out->length = 0;
+	return ret;
+}
+
+
+/**
+ * output_reserve() - Make room for more bytes
+ * @out: Buffer to grow
+ * @extra: Bytes about to be appended, not counting a NUL
+ *
+ * Return: true if @extra bytes and a NUL fit
+ */
+
+static bool output_reserve(Output *out, size_t extra)
+{
+	size_t capacity = out->capacity > 0 ? out->capacity :
+			  OUTPUT_INITIAL_CAPACITY;
+	char *data;
+
+	if (out->length + extra < out->capacity)
+		return true;
+
+	while (capacity <= out->length + extra)
+		capacity *= 2;
+	data = realloc(out->data, capacity);
+	if (!data)
+		return false;
+	out->data = data;
+	out->capacity = capacity;
+	return true;
+}
+
+
+/**
+ * output_select() - Send this thread's printing to a buffer
+ * @out: Buffer to append to, NULL to print straight to stdout
+ *
+ * Return: The buffer selected before
+ */
+
+Output *output_select(Output *out)
+{
+	Output *previous = output_sink;
+
+	output_sink = out;
+	return previous;
+}
+
+
+/**
+ * output_current() - Buffer this thread prints to
+ *
+ * Return: The selected buffer, NULL when printing goes to stdout
+ */
+
+Output *output_current(void)
+{
+	return output_sink;
+}
+
+
+/**
+ * output_write() - Print bytes
+ * @text: Bytes to print
+ * @length: Number of bytes
+ *
+ * Without memory to grow the buffer, what is buffered and @text are
+ * written at once so nothing is lost or reordered; a buffer that only
+ * collects marks itself truncated instead.
+ */
+
+void output_write(const char *text, size_t length)
+{
+	Output *out = output_sink;
+
+	if (!out) {
+		fwrite(text, 1, length, stdout);
+		return;
+	}
+
+	if (!output_reserve(out, length)) {
+		if (out->fd < 0) {
+			out->truncated = true;
+			return;
+		}
+		output_flush(out);
+		platform_write(out->fd, text, length);
+		return;
+	}
+	memcpy(out->data + out->length, text, length);
+	out->length += length;
+}
+
+
+/**
+ * output_text() - Print a string
+ * @text: NUL-terminated text
+ */
+
+void output_text(const char *text)
+{
+	output_write(text, strlen(text));
+}
+
+
+/**
+ * output_vprintf() - Print formatted text from a va_list
+ * @format: printf() format
+ * @args: Arguments for @format
+ *
+ * Formats straight into the buffer; only text longer than the space
+ * left is formatted twice.
+ */
+
+void output_vprintf(const char *format, va_list args)
+{
+	Output *out = output_sink;
+	va_list again;
+	size_t room;
+	int n;
+
+	if (!out) {
+		vprintf(format, args);
+		return;
+	}
+
+	if (!output_reserve(out, 0)) {
+		if (out->fd < 0) {
+			out->truncated = true;
+			return;
+		}
+		output_flush(out);
+		vprintf(format, args);
+		fflush(stdout);
+		return;
+	}
+
+	va_copy(again, args);
+	room = out->capacity - out->length;
+	n = vsnprintf(out->data + out->length, room, format, args);
+	if (n >= 0 && (size_t)n >= room) {
+		if (output_reserve(out, (size_t)n)) {
+			room = out->capacity - out->length;
+			n = vsnprintf(out->data + out->length, room, format,
+				      again);
+		} else if (out->fd < 0) {
+			out->truncated = true;
+			n = -1;
+		} else {
+			output_flush(out);
+			vprintf(format, again);
+			fflush(stdout);
+			n = -1;
+		}
+	}
+	va_end(again);
+
+	if (n > 0)
+		out->length += (size_t)n;
+}
+
+
+/**
+ * output_printf() - Print formatted text
+ * @format: printf() format
+ * @...: Arguments for @format
+ */
+
+void output_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	output_vprintf(format, args);
+	va_end(args);
+}
@@ -0,0 +1,128 @@
+/*
+ * output.h - Per-turn output buffer
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * struct Output - Text a session has produced but not yet written
+ * @data: Buffered bytes, kept between turns
+ * @length: Bytes buffered
+ * @capacity: Bytes allocated
+ * @fd: Where output_flush() writes: a terminal, pipe, socket or file,
+ *      or -1 for a buffer that only collects text
+ * @truncated: Text was dropped for lack of memory (only when @fd is -1)
+ *
+ * A turn's text is appended here and written with one call at the end
+ * of the turn, however many pieces it was built from. Whatever reads
+ * @fd (a player, a capture file, a test harness) sees the same bytes
+ * the terminal would have.
+ */
+
+typedef struct Output {
+	char *data;
+	size_t length;
+	size_t capacity;
+	int fd;
+	bool truncated;
+} Output;
+
+
+/**
+ * output_init() - Set up an empty output buffer
+ * @out: Buffer to set up
+ * @fd: File descriptor the buffer is flushed to
+ */
+
+void output_init(Output *out, int fd);
+
+
+/**
+ * output_free() - Release an output buffer without flushing it
+ * @out: Buffer to release
+ */
+
+void output_free(Output *out);
+
+
+/**
+ * output_flush() - Write everything buffered in one call
+ * @out: Buffer to flush
+ *
+ * Anything still in stdio's buffer is written first, so text printed
+ * outside the buffer keeps its place. The buffer is emptied even if
+ * the write fails.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int output_flush(Output *out);
+
+
+/**
+ * output_select() - Send this thread's printing to a buffer
+ * @out: Buffer to append to, NULL to print straight to stdout
+ *
+ * Command handlers do not know which session they print for; they
+ * print to whatever buffer their thread has selected.
+ *
+ * Return: The buffer selected before
+ */
+
+Output *output_select(Output *out);
+
+
+/**
+ * output_current() - Buffer this thread prints to
+ *
+ * Return: The selected buffer, NULL when printing goes to stdout
+ */
+
+Output *output_current(void);
+
+
+/**
+ * output_write() - Print bytes
+ * @text: Bytes to print
+ * @length: Number of bytes
+ */
+
+void output_write(const char *text, size_t length);
+
+
+/**
+ * output_text() - Print a string
+ * @text: NUL-terminated text
+ */
+
+void output_text(const char *text);
+
+
+/**
+ * output_printf() - Print formatted text
+ * @format: printf() format
+ * @...: Arguments for @format
+ */
+
+void output_printf(const char *format, ...);
+
+
+/**
+ * output_vprintf() - Print formatted text from a va_list
+ * @format: printf() format
+ * @args: Arguments for @format
+ */
+
+void output_vprintf(const char *format, va_list args);
+
+
+#endif /* OUTPUT_H */
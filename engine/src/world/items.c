@@ -5,63 +5,82 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
- #include <errno.h>
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
 
  #include "core/logger.h"
+ #include "core/utils.h"
  #include "items.h"
  #include "story/ini_parser.h"
 
  /**
   * find_item_by_id() - Find an item by its identifier 
-  * @items: Array of items to dearch
-  * @count: Number of items in array
+  * @story: Story holding the items
   * @item_id: String identifier to search for
   *
-  * Searches the item array fora matching item ID
+  * Looks the ID up in the story's perfect hash item index.
   * 
   * Return: Pointer to item if found, NULL otherwise
   */
  
-  Item *find_item_by_id(Item *items, int count, const char *item_id)
+  Item *find_item_by_id(Story *story, const char *item_id)
   {
     int i;
 
-    if (!items || !item_id)
+    if (!story || !item_id)
         return NULL;
 
-    for (i = 0; i < count; i++) {
-        if (strcmp(items[i].id, item_id) == 0)
-            return &items[i];
-    }
+    i = story_index_find(&story->item_index, item_id);
+    return i >= 0 ? &story->items[i] : NULL;
+  }
+
+
+  /**
+   * item_description() - Get an item's description
+   * @story: Story holding the item
+   * @item: Item to describe
+   *
+   * Return: Description, valid until more lazy text is read
+   */
+
+  const char *item_description(Story *story, const Item *item)
+  {
+    if (item->description)
+        return item->description;
 
-    return NULL;
+    return text_cache_get(&story->text, TEXT_FILE_ITEMS,
+                          item->description_ref);
   }
 
 
   /**
    * load_items() - Load items from items.ini file
    * @filename: Path to items.ini
+   * @arena: Arena that takes ownership of the item array
+   * @lazy_text: Record where descriptions are instead of copying them
    * @items: Pointer to store allocated items array
    * @count: Pointer to store number of items loaded
    * 
-   * Parses items.ini file usinf two-pass approach: first counts
-   * items, the nallocated and fills the array. Uses INI parser 
-   * to read item properties.
+   * Parses items.ini in a single pass, growing the item array
+   * geometrically and trimming it once the file is exhausted. Uses
+   * the INI tokenizer to read item properties.
    * 
    * Return: Description of return value and error codes
    */
   
-   int load_items(const char *story_dir, Item **items_out)
+   int load_items(const char *story_dir, Arena *arena, bool lazy_text,
+                  Item **items_out)
    {
-    FILE *f;
+    IniFile ini;
+    IniToken token;
+    bool lazy;
     char filepath[INI_VALUE_SIZE];
-    char line[INI_LINE_BUFFER_SIZE];
     int item_count = 0;
+    int item_capacity = 0;
     int current_item = -1;
     Item *item_array = NULL;
+    Item *grown;
 
     log_function_entry(__func__, "story_dir=%s", story_dir);
 
@@ -74,62 +93,39 @@
     snprintf(filepath, sizeof(filepath), "%s/items.ini", story_dir);
     add_log_entry("Opening items file: %s at %s", filepath, log_timestamp());
 
-    /* Open file */
-    f = fopen(filepath, "r");
-    if (!f) {
+    /* Map file */
+    if (ini_open(&ini, filepath) != 0) {
         printf("WARNING: Cannot open %s\n", filepath);
         log_function_error(__func__, "Failed to open items.ini");
         log_function_exit(__func__, 0);
-        return EIO;
-    }
-    /* Pass 1: Count items */
-    while (fgets(line, sizeof(line), f)) {
-        char section[INI_SECTION_SIZE];
-
-        if (parse_ini_section(line, section, sizeof(section))) {
-            add_log_entry("Found section: '%s' at %s", section, log_timestamp());
-            /* Check if it's an ITEM section*/
-            if (strncmp(section, "ITEM:", 5) == 0)
-                item_count++;
-        } 
-    }
-    add_log_entry("Pass 1 complete: found %d items at %s", item_count,          log_timestamp());
-    if (item_count == 0) {
-        fclose(f);
         *items_out = NULL;
-        log_function_error(__func__, "No items found in items.ini");
-        log_function_exit(__func__, 0);
-        return 0; /* No items is not an error */
-    }
-
-    /* Allocate item array */
-    item_array = calloc(item_count, sizeof(Item));
-    if (!item_array) {
-        fclose(f);
-        log_function_error(__func__, "Failed to allocate memory");
-        log_function_exit(__func__, 0);
         return 0;
     }
+    lazy = lazy_text && text_ref_fits(&ini);
 
-
-    /* Pass 2: Load items */
-    rewind(f);
-    current_item = -1;
-
-    while (fgets(line, sizeof(line), f)) {
-        char section[INI_SECTION_SIZE];
-        char key[INI_KEY_SIZE];
-        char value[INI_VALUE_SIZE];
+    while (ini_next(&ini, &token)) {
 
         /* Check for section header */
-        if (parse_ini_section(line, section, sizeof(section))) {
-            if (strncmp(section, "ITEM:", 5) ==0) {
-                current_item++;
+        if (token.type == INI_TOKEN_SECTION) {
+            add_log_entry("Found section: '%.*s' at %s", (int)token.section.len,
+                          token.section.ptr, log_timestamp());
+
+            if (ini_view_has_prefix(token.section, "ITEM:")) {
+                grown = array_grow(item_array, item_count, &item_capacity,
+                                   sizeof(Item));
+                if (!grown) {
+                    log_function_error(__func__, "Failed to allocate memory");
+                    break;
+                }
+                item_array = grown;
+                current_item = item_count++;
+
                 /* Extract item ID from "Item:id" */
-                strncpy(item_array[current_item].id,
-                    section + 5,
-                    ITEM_ID_SIZE - 1);
+                item_array[current_item].id =
+                    ini_view_text(arena, ini_view_skip(token.section, 5));
                 /* Set defaults */
+                item_array[current_item].name = "";
+                item_array[current_item].description = lazy ? NULL : "";
                 item_array[current_item].weight = 0;
                 item_array[current_item].takeable = false;
                 item_array[current_item].useable = false;
@@ -140,32 +136,42 @@
         }
 
         /* Parse key-value pair */
-        if (current_item >= 0 &&
-            parse_ini_keyvalue(line, key, sizeof(key),
-                    value, sizeof(value))) {
+        if (current_item >= 0) {
             Item *item = &item_array[current_item];
 
-            if (strcmp(key, "name") == 0) {
-                strncpy(item->name, value,
-                    ITEM_NAME_SIZE - 1);
-            } else if (strcmp(key, "description") == 0) {
-                strncpy(item->description, value,
-                    ITEM_DESCRIPTION_SIZE - 1);
-            } else if (strcmp(key, "weight") == 0) {
-                item->weight = atoi(value);
-            } else if (strcmp(key, "takeable") == 0) {
-                item->takeable = (strcmp(value, "true") == 0);
-            } else if (strcmp(key, "useable") == 0) {
-                item->useable = (strcmp(value, "true") == 0);
-            } else if (strcmp(key, "illuminates") == 0) {
-                item->illuminates = (strcmp(value, "true") == 0);
-            } else if (strcmp(key, "unlocks") == 0) {
-                item->unlocks = (strcmp(value, "true") == 0);
+            if (ini_view_equals(token.key, "name")) {
+                item->name = ini_view_text(arena, token.value);
+            } else if (ini_view_equals(token.key, "description")) {
+                if (lazy)
+                    item->description_ref = text_ref(&ini, token.value);
+                else
+                    item->description = ini_view_text(arena, token.value);
+            } else if (ini_view_equals(token.key, "weight")) {
+                item->weight = ini_view_to_int(token.value);
+            } else if (ini_view_equals(token.key, "takeable")) {
+                item->takeable = ini_view_to_bool(token.value);
+            } else if (ini_view_equals(token.key, "useable")) {
+                item->useable = ini_view_to_bool(token.value);
+            } else if (ini_view_equals(token.key, "illuminates")) {
+                item->illuminates = ini_view_to_bool(token.value);
+            } else if (ini_view_equals(token.key, "unlocks")) {
+                item->unlocks = ini_view_to_bool(token.value);
             }
         }   
    }
 
-   fclose(f);
+   ini_close(&ini);
+
+   /* Finalise array at end of file; the arena frees it with the story */
+   item_array = array_shrink(item_array, item_count, sizeof(Item));
+   if (arena_adopt(arena, item_array,
+                   (size_t)item_count * sizeof(Item)) != 0) {
+       free(item_array);
+       item_array = NULL;
+       item_count = 0;
+   }
+   if (item_count == 0)
+       log_function_error(__func__, "No items found in items.ini");
 
    *items_out = item_array;
    add_log_entry("Loaded %d items at %s", item_count, log_timestamp());
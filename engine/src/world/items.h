@@ -17,30 +17,47 @@
  /**
   * load_items() - Load items from items.ini file
   * @filename: Path to items.ini file
+  * @arena: Arena that takes ownership of the item array
+  * @lazy_text: Record where descriptions are instead of copying them
   * @items: Pointer to store allocated item array
   * @count: Pointer to store number of items loaded
   *
-  * Parses items.ini file and allocates array of Item structures.
-  * Caller is responsible for freeing the allocated array.
+  * Parses items.ini file and allocates array of Item structures,
+  * which is freed along with @arena.
   *
   * Return: 0 on success, negative errno on failure
   */
 
-  int load_items(const char *story_dir, Item **items_out);
+  int load_items(const char *story_dir, Arena *arena, bool lazy_text,
+                 Item **items_out);
 
 
   /**
    * find_item_by_id() - Find an item by its identifier
-   * @items: Array of items to search
-   * @count: Number of items in array
+   * @story: Story holding the items
    * @item_id: String identifier to search for
    *
-   * Searches the item array for a matching item ID.
+   * Looks the ID up in the story's item index, so the cost does not
+   * grow with the number of items.
    *
    * Return: Pointer to item if found, NULL otherwise
    */
   
-   Item *find_item_by_id(Item *items, int count, const char *item_id);
+   Item *find_item_by_id(Story *story, const char *item_id);
+
+
+  /**
+   * item_description() - Get an item's description
+   * @story: Story holding the item
+   * @item: Item to describe
+   *
+   * Reads the text back from items.ini on first use when the story
+   * was loaded with lazy text.
+   *
+   * Return: Description, valid until more lazy text is read
+   */
+
+   const char *item_description(Story *story, const Item *item);
  
 
 #endif /* WORLD_ITEMS_H */
@@ -0,0 +1,177 @@
+/*
+ * nouns.c - Matching the player's nouns against items and NPCs
+ *
+ * Every item and NPC carries its name and ID already lowercased, plus a
+ * 64-bit summary of the character pairs in them. A command compares the
+ * noun with those keys directly: a candidate whose summary lacks one of
+ * the noun's pairs is skipped on a single AND, and the rest need only
+ * strcmp() and strstr(), never a case-folding copy.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+
+#include "nouns.h"
+
+
+/**
+ * noun_bigram() - Bit that stands for one pair of lowercase characters
+ * @a: First character
+ * @b: Second character
+ *
+ * Return: Mask with one bit set
+ */
+
+static inline uint64_t noun_bigram(unsigned char a, unsigned char b)
+{
+	return (uint64_t)1 << (((unsigned)a * 31u ^ b) & 63u);
+}
+
+
+/**
+ * noun_bigrams() - Summarise the character pairs of folded text
+ * @text: Lowercase text
+ *
+ * Return: Mask of every pair in @text
+ */
+
+static uint64_t noun_bigrams(const char *text)
+{
+	const unsigned char *p = (const unsigned char *)text;
+	uint64_t bigrams = 0;
+
+	if (!*p)
+		return 0;
+	for (; p[1]; p++)
+		bigrams |= noun_bigram(p[0], p[1]);
+	return bigrams;
+}
+
+
+/**
+ * noun_fold() - Lowercase text, copying it only if it has to change
+ * @arena: Arena for the copy
+ * @text: Text to fold (NULL reads as "")
+ *
+ * Return: Folded text, NULL on allocation failure
+ */
+
+static const char *noun_fold(Arena *arena, const char *text)
+{
+	const char *p;
+	char *copy;
+	size_t len;
+	size_t i;
+
+	if (!text)
+		return "";
+
+	for (p = text; *p; p++) {
+		if (isupper((unsigned char)*p))
+			break;
+	}
+	if (!*p)
+		return text;
+
+	len = strlen(text);
+	copy = arena_strndup(arena, text, len);
+	if (!copy)
+		return NULL;
+	for (i = (size_t)(p - text); i < len; i++)
+		copy[i] = (char)tolower((unsigned char)copy[i]);
+	return copy;
+}
+
+
+int noun_key_build(NounKey *key, Arena *arena, const char *name,
+		   const char *id)
+{
+	const char *folded_name = noun_fold(arena, name);
+	const char *folded_id = noun_fold(arena, id);
+
+	if (!folded_name || !folded_id)
+		return -ENOMEM;
+
+	key->name = folded_name;
+	key->id = folded_id;
+	key->bigrams = noun_bigrams(folded_name) | noun_bigrams(folded_id);
+	return 0;
+}
+
+
+int build_noun_keys(Story *story)
+{
+	int i;
+
+	for (i = 0; i < story->item_count; i++) {
+		Item *item = &story->items[i];
+
+		if (noun_key_build(&item->key, &story->arena, item->name,
+				   item->id) != 0)
+			return -ENOMEM;
+	}
+
+	for (i = 0; i < story->npc_count; i++) {
+		NPC *npc = &story->npcs[i];
+
+		if (noun_key_build(&npc->key, &story->arena, npc->name,
+				   npc->id) != 0)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+
+/**
+ * noun_matches() - Test one key against a noun
+ * @key: Candidate's key
+ * @noun: Lowercase noun
+ * @bigrams: noun_bigrams() of @noun
+ * @partial: Accept @noun anywhere in the name
+ *
+ * Return: True if the candidate is the one the noun names
+ */
+
+static inline bool noun_matches(const NounKey *key, const char *noun,
+				uint64_t bigrams, bool partial)
+{
+	if ((key->bigrams & bigrams) != bigrams)
+		return false;
+	if (strcmp(key->id, noun) == 0)
+		return true;
+	if (partial)
+		return strstr(key->name, noun) != NULL;
+	return strcmp(key->name, noun) == 0;
+}
+
+
+int noun_find_item(Item *const *items, int count, const char *noun,
+		   bool partial)
+{
+	uint64_t bigrams = noun_bigrams(noun);
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (noun_matches(&items[i]->key, noun, bigrams, partial))
+			return i;
+	}
+	return -1;
+}
+
+
+int noun_find_npc(NPC *const *npcs, int count, const char *noun)
+{
+	uint64_t bigrams = noun_bigrams(noun);
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (noun_matches(&npcs[i]->key, noun, bigrams, true))
+			return i;
+	}
+	return -1;
+}
@@ -0,0 +1,73 @@
+/*
+ * nouns.h - Matching the player's nouns against items and NPCs
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef WORLD_NOUNS_H
+#define WORLD_NOUNS_H
+
+#include <stdbool.h>
+
+#include "story/story.h"
+
+
+/**
+ * noun_key_build() - Fold a name and ID into a noun key
+ * @key: Key to fill in
+ * @arena: Arena for the folded copies, needed only for text that has
+ *         upper case letters in it
+ * @name: Display name
+ * @id: Identifier
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+int noun_key_build(NounKey *key, Arena *arena, const char *name,
+		   const char *id);
+
+
+/**
+ * build_noun_keys() - Build the noun key of every item and NPC
+ * @story: Loaded story
+ *
+ * Return: 0 on success, -ENOMEM on failure
+ */
+
+int build_noun_keys(Story *story);
+
+
+/**
+ * noun_find_item() - Find the item a noun names
+ * @items: Items to search, such as a room's or the inventory
+ * @count: Number of items
+ * @noun: Lowercase noun, as parse_command() leaves it
+ * @partial: Also match part of a name ("sword" for "rusty sword")
+ *
+ * Matches the item's ID or name against keys folded at load. The
+ * noun is compared as it is, never folded here, so a caller with
+ * text that did not come from parse_command() must lowercase it first.
+ *
+ * Return: Index of the first item that matches, -1 if none does
+ */
+
+int noun_find_item(Item *const *items, int count, const char *noun,
+		   bool partial);
+
+
+/**
+ * noun_find_npc() - Find the NPC a noun names
+ * @npcs: NPCs to search
+ * @count: Number of NPCs
+ * @noun: Lowercase noun, as parse_command() leaves it
+ *
+ * Like noun_find_item(), always matching part of a name.
+ *
+ * Return: Index of the first NPC that matches, -1 if none does
+ */
+
+int noun_find_npc(NPC *const *npcs, int count, const char *noun);
+
+
+#endif /* WORLD_NOUNS_H */
@@ -13,50 +13,193 @@
 #include "npcs.h"
 #include "core/constants.h"
 #include "core/logger.h"
+#include "core/utils.h"
 #include "story/ini_parser.h"
 
 /**
  * find_npc_by_id() - Find NPC by ID
- * @npcs: Array of NPCs
- * @count: Number of NPCs
+ * @story: Story holding the NPCs
  * @id: NPC ID to search for
  *
  * Return: Pointer to NPC if found, NULL otherwise
  */
-NPC *find_npc_by_id(NPC *npcs, int count, const char *id)
+NPC *find_npc_by_id(Story *story, const char *id)
 {
 	int i;
 
-	if (!npcs || !id)
+	if (!story || !id)
 		return NULL;
 
-	for (i = 0; i < count; i++) {
-		if (strcmp(npcs[i].id, id) == 0)
-			return &npcs[i];
+	i = story_index_find(&story->npc_index, id);
+	return i >= 0 ? &story->npcs[i] : NULL;
+}
+
+/**
+ * npc_description() - Get an NPC's description
+ * @story: Story holding the NPC
+ * @npc: NPC to describe
+ *
+ * Return: Description, valid until more lazy text is read
+ */
+const char *npc_description(Story *story, const NPC *npc)
+{
+	if (npc->description)
+		return npc->description;
+
+	return text_cache_get(&story->text, TEXT_FILE_NPCS,
+	                      npc->description_ref);
+}
+
+/**
+ * npc_text_line() - Fetch one line of a numbered NPC text list
+ * @story: Story holding the NPC
+ * @lines: Copied lines (NULL when lazy)
+ * @refs: Line positions (NULL unless lazy)
+ * @count: Number of lines
+ * @index: Line wanted
+ *
+ * Return: The line, "" for a gap or an index out of range
+ */
+static const char *npc_text_line(Story *story, char **lines,
+                                 const TextRef *refs, int count, int index)
+{
+	if (index < 0 || index >= count)
+		return "";
+
+	if (lines)
+		return lines[index] ? lines[index] : "";
+
+	if (refs)
+		return text_cache_get(&story->text, TEXT_FILE_NPCS, refs[index]);
+
+	return "";
+}
+
+/**
+ * npc_dialog_line() - Get one of an NPC's dialog lines
+ * @story: Story holding the NPC
+ * @npc: NPC speaking
+ * @index: Line number, 0 to dialog_count - 1
+ *
+ * Return: The line, valid until more lazy text is read
+ */
+const char *npc_dialog_line(Story *story, const NPC *npc, int index)
+{
+	return npc_text_line(story, npc->dialog, npc->dialog_refs,
+	                     npc->dialog_count, index);
+}
+
+/**
+ * npc_combat_text() - Get one of an NPC's combat messages
+ * @story: Story holding the NPC
+ * @npc: NPC fighting
+ * @index: Message number, 0 to combat_text_count - 1
+ *
+ * Return: The message, valid until more lazy text is read
+ */
+const char *npc_combat_text(Story *story, const NPC *npc, int index)
+{
+	return npc_text_line(story, npc->combat_text, npc->combat_text_refs,
+	                     npc->combat_text_count, index);
+}
+
+/**
+ * npc_line_grow() - Make room for a numbered NPC text line
+ * @arena: Arena the line array is carved from
+ * @lines: Line array (dialog or combat text, or their TextRefs)
+ * @count: Number of slots in @lines, updated on growth
+ * @index: Line number from the key ("dialog_3" -> 3)
+ * @size: Size of one slot
+ *
+ * Lines may appear in any order, so the array is sized to the highest
+ * index seen and gaps stay zeroed. Lists are a handful of lines long;
+ * growing copies into fresh arena memory.
+ *
+ * Return: Array with a slot for @index, NULL on a bad index or out of
+ * memory
+ */
+static void *npc_line_grow(Arena *arena, void *lines, int *count, int index,
+                           size_t size)
+{
+	void *grown;
+
+	if (index < 0)
+		return NULL;
+
+	if (index >= *count) {
+		grown = arena_calloc(arena, (size_t)index + 1, size);
+		if (!grown)
+			return NULL;
+		if (*count > 0)
+			memcpy(grown, lines, (size_t)*count * size);
+		lines = grown;
+		*count = index + 1;
 	}
 
-	return NULL;
+	return lines;
+}
+
+/**
+ * npc_store_line() - Store a numbered dialog or combat text line
+ * @arena: Arena for the line arrays and copied text
+ * @ini: File being loaded
+ * @lazy: Record where the line is rather than copying it
+ * @lines: Copied lines, used when not @lazy
+ * @refs: Line positions, used when @lazy
+ * @count: Number of slots, shared by @lines and @refs
+ * @index: Line number from the key
+ * @value: Line text
+ *
+ * Return: void
+ */
+static void npc_store_line(Arena *arena, const IniFile *ini, bool lazy,
+                           char ***lines, TextRef **refs, int *count,
+                           int index, IniView value)
+{
+	if (lazy) {
+		TextRef *grown = npc_line_grow(arena, *refs, count, index,
+		                               sizeof(TextRef));
+
+		if (grown) {
+			grown[index] = text_ref(ini, value);
+			*refs = grown;
+		}
+	} else {
+		char **grown = npc_line_grow(arena, *lines, count, index,
+		                             sizeof(char *));
+
+		if (grown) {
+			grown[index] = ini_view_strdup(arena, value);
+			*lines = grown;
+		}
+	}
 }
 
 /**
  * load_npcs() - Load NPCs from npcs.ini file
  * @story_dir: Path to story directory
+ * @arena: Arena for the NPC array and dialog and combat text
+ * @lazy_text: Record where descriptions, dialog and combat text are
+ *             instead of copying them
  * @npcs_out: Pointer to store allocated NPC array
  *
+ * Single pass: the NPC array grows geometrically as [NPC:] headers
+ * appear and is trimmed to size at end of file.
+ *
  * Return: Number of NPCs loaded, 0 on error or empty
  */
-int load_npcs(const char *story_dir, NPC **npcs_out)
+int load_npcs(const char *story_dir, Arena *arena, bool lazy_text,
+              NPC **npcs_out)
 {
-	FILE *f;
+	IniFile ini;
+	IniToken token;
 	char filepath[INI_VALUE_SIZE];
-	char line[INI_LINE_BUFFER_SIZE];
-	char section[INI_SECTION_SIZE];
-	char key[INI_KEY_SIZE];
-	char value[INI_VALUE_SIZE];
 	NPC *npc_array = NULL;
+	NPC *grown;
 	int npc_count = 0;
+	int npc_capacity = 0;
 	int current_npc = -1;
-	int dialog_index;
+	bool lazy;
 
 	log_function_entry(__func__, "story_dir=%s", story_dir);
 
@@ -70,76 +213,55 @@ int load_npcs(const char *story_dir, NPC **npcs_out)
 	snprintf(filepath, sizeof(filepath), "%s/npcs.ini", story_dir);
 	add_log_entry("Opening NPCs file: %s at %s", filepath, log_timestamp());
 
-	/* Open file */
-	f = fopen(filepath, "r");
-	if (!f) {
+	/* Map file */
+	if (ini_open(&ini, filepath) != 0) {
 		printf("WARNING: Cannot open %s\n", filepath);
 		log_function_error(__func__, "Failed to open npcs.ini");
 		log_function_exit(__func__, 0);
 		*npcs_out = NULL;
 		return 0;
 	}
+	lazy = lazy_text && text_ref_fits(&ini);
 
-	/* Pass 1: Count NPCs */
-	while (fgets(line, sizeof(line), f)) {
-		if (parse_ini_section(line, section, sizeof(section))) {
-			if (strncmp(section, "NPC:", 4) == 0) {
-				npc_count++;
-				add_log_entry("Found section: '%s' at %s", 
-				             section, log_timestamp());
-			}
-		}
-	}
-
-	add_log_entry("Pass 1 complete: found %d NPCs at %s", 
-	             npc_count, log_timestamp());
-
-	if (npc_count == 0) {
-		fclose(f);
-		*npcs_out = NULL;
-		log_function_error(__func__, "No NPCs found in npcs.ini");
-		log_function_exit(__func__, 0);
-		return 0;
-	}
-
-	/* Allocate NPC array */
-	npc_array = calloc(npc_count, sizeof(NPC));
-	if (!npc_array) {
-		fclose(f);
-		log_function_error(__func__, "Failed to allocate memory");
-		log_function_exit(__func__, 0);
-		return 0;
-	}
-
-	/* Pass 2: Load NPCs */
-	rewind(f);
-	current_npc = -1;
-
-	while (fgets(line, sizeof(line), f)) {
-		char *trimmed;
-
-		line[strcspn(line, "\r\n")] = 0;
+	while (ini_next(&ini, &token)) {
 
 		/* Check for section header */
-		if (parse_ini_section(line, section, sizeof(section))) {
-			if (strncmp(section, "NPC:", 4) == 0) {
-				current_npc++;
+		if (token.type == INI_TOKEN_SECTION) {
+			if (ini_view_has_prefix(token.section, "NPC:")) {
+				add_log_entry("Found section: '%.*s' at %s", 
+				             (int)token.section.len, token.section.ptr,
+				             log_timestamp());
+
+				grown = array_grow(npc_array, npc_count, &npc_capacity,
+				                   sizeof(NPC));
+				if (!grown) {
+					log_function_error(__func__, "Failed to allocate memory");
+					break;
+				}
+				npc_array = grown;
+				current_npc = npc_count++;
 				
 				/* Extract NPC ID from "NPC:id" */
-				strncpy(npc_array[current_npc].id,
-				       section + 4,
-				       NPC_ID_SIZE - 1);
+				npc_array[current_npc].id =
+					ini_view_text(arena, ini_view_skip(token.section, 4));
+
+				npc_array[current_npc].name = "";
+				npc_array[current_npc].description = lazy ? NULL : "";
 
 				/* Initialize dialog array */
 				npc_array[current_npc].dialog = NULL;
 				npc_array[current_npc].dialog_count = 0;
 				npc_array[current_npc].dialog_index = 0;
+				npc_array[current_npc].greeting_dialog = "";
+				npc_array[current_npc].dialog_start = DIALOG_NONE;
+				npc_array[current_npc].dialog_state = 0;
 
 				/* Initialize combat fields */
 				npc_array[current_npc].hostile = false;
 				npc_array[current_npc].combat_hp = 0;
 				npc_array[current_npc].combat_damage = 0;
-				npc_array[current_npc].required_item[0] = '\0';
+				npc_array[current_npc].location = "";
+				npc_array[current_npc].required_item = "";
 				npc_array[current_npc].base_win_chance = COMBAT_BASE_WIN_CHANCE;
 				npc_array[current_npc].item_win_chance = COMBAT_ITEM_WIN_CHANCE;
 				npc_array[current_npc].defeated = false;
@@ -151,62 +273,61 @@ int load_npcs(const char *story_dir, NPC **npcs_out)
 		}
 
 		/* Parse key=value pairs */
-		if (current_npc >= 0 &&
-		    parse_ini_keyvalue(line, key, sizeof(key),
-		                      value, sizeof(value))) {
+		if (current_npc >= 0) {
 			NPC *npc = &npc_array[current_npc];
 
-			if (strcmp(key, "name") == 0) {
-				strncpy(npc->name, value, NPC_NAME_SIZE - 1);
-			} else if (strcmp(key, "description") == 0) {
-				strncpy(npc->description, value,
-				       NPC_DESCRIPTION_SIZE - 1);
-			} else if (strcmp(key, "location") == 0) {
-				strncpy(npc->location, value,
-				       NPC_LOCATION_SIZE - 1);
-			} else if (strncmp(key, "dialog_", 7) == 0) {
-				/* Extract dialog index */
-				dialog_index = atoi(key + 7);
-
-				/* Expand dialog array if needed */
-				if (dialog_index >= npc->dialog_count) {
-					npc->dialog = realloc(npc->dialog,
-					                     (dialog_index + 1) * sizeof(char*));
-					npc->dialog_count = dialog_index + 1;
-				}
-
-				/* Store dialog line */
-				npc->dialog[dialog_index] = strdup(value);
-			} else if (strcmp(key, "hostile") == 0) {
-				npc->hostile = (strcmp(value, "true") == 0);
-			} else if (strcmp(key, "combat_hp") == 0) {
-				npc->combat_hp = atoi(value);
-			} else if (strcmp(key, "combat_damage") == 0) {
-				npc->combat_damage = atoi(value);
-			} else if (strcmp(key, "required_item") == 0) {
-				strncpy(npc->required_item, value, ITEM_ID_SIZE - 1);
-			} else if (strcmp(key, "base_win_chance") == 0) {
-				npc->base_win_chance = atof(value);
-			} else if (strcmp(key, "item_win_chance") == 0) {
-				npc->item_win_chance = atof(value);
-			} else if (strncmp(key, "combat_text_", 12) == 0) {
-				/* Extract combat text index */
-				int combat_index = atoi(key + 12);
-
-				/* Expand combat_text array if needed */
-				if (combat_index >= npc->combat_text_count) {
-					npc->combat_text = realloc(npc->combat_text,
-					                          (combat_index + 1) * sizeof(char*));
-					npc->combat_text_count = combat_index + 1;
-				}
-
-				/* Store combat text line */
-				npc->combat_text[combat_index] = strdup(value);
+			if (ini_view_equals(token.key, "name")) {
+				npc->name = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "description")) {
+				if (lazy)
+					npc->description_ref = text_ref(&ini, token.value);
+				else
+					npc->description = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "location")) {
+				npc->location = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "greeting_dialog")) {
+				npc->greeting_dialog = ini_view_text(arena, token.value);
+			} else if (ini_view_has_prefix(token.key, "dialog_")) {
+				/* Store dialog line at its index */
+				npc_store_line(arena, &ini, lazy, &npc->dialog,
+				               &npc->dialog_refs, &npc->dialog_count,
+				               ini_view_to_int(ini_view_skip(token.key, 7)),
+				               token.value);
+			} else if (ini_view_equals(token.key, "hostile")) {
+				npc->hostile = ini_view_to_bool(token.value);
+			} else if (ini_view_equals(token.key, "combat_hp")) {
+				npc->combat_hp = ini_view_to_int(token.value);
+			} else if (ini_view_equals(token.key, "combat_damage")) {
+				npc->combat_damage = ini_view_to_int(token.value);
+			} else if (ini_view_equals(token.key, "required_item")) {
+				npc->required_item = ini_view_text(arena, token.value);
+			} else if (ini_view_equals(token.key, "base_win_chance")) {
+				npc->base_win_chance = ini_view_to_float(token.value);
+			} else if (ini_view_equals(token.key, "item_win_chance")) {
+				npc->item_win_chance = ini_view_to_float(token.value);
+			} else if (ini_view_has_prefix(token.key, "combat_text_")) {
+				/* Store combat text line at its index */
+				npc_store_line(arena, &ini, lazy, &npc->combat_text,
+				               &npc->combat_text_refs,
+				               &npc->combat_text_count,
+				               ini_view_to_int(ini_view_skip(token.key, 12)),
+				               token.value);
 			}
 		}
 	}
 
-	fclose(f);
+	ini_close(&ini);
+
+	/* Finalise array at end of file; the arena frees it with the story */
+	npc_array = array_shrink(npc_array, npc_count, sizeof(NPC));
+	if (arena_adopt(arena, npc_array,
+	                (size_t)npc_count * sizeof(NPC)) != 0) {
+		free(npc_array);
+		npc_array = NULL;
+		npc_count = 0;
+	}
+	if (npc_count == 0)
+		log_function_error(__func__, "No NPCs found in npcs.ini");
 
 	*npcs_out = npc_array;
 	add_log_entry("Loaded %d NPCs at %s", npc_count, log_timestamp());
@@ -13,23 +13,63 @@
 /**
  * load_npcs() - Load NPCs from npcs.ini file
  * @story_dir: Path to story directory
+ * @arena: Arena for the NPC array and dialog and combat text
+ * @lazy_text: Record where descriptions, dialog and combat text are
+ *             instead of copying them
  * @npcs_out: Pointer to store allocated NPC array
  *
- * Parses npcs.ini file using two-pass approach: first counts
- * NPCs, then allocates and fills the array.
+ * Parses npcs.ini file in a single pass, growing the NPC array
+ * as sections appear and trimming it at end of file. Everything
+ * returned is freed along with @arena.
  *
  * Return: Number of NPCs loaded, 0 on error or empty
  */
-int load_npcs(const char *story_dir, NPC **npcs_out);
+int load_npcs(const char *story_dir, Arena *arena, bool lazy_text,
+              NPC **npcs_out);
 
 /**
  * find_npc_by_id() - Find NPC by ID
- * @npcs: Array of NPCs
- * @count: Number of NPCs
+ * @story: Story holding the NPCs
  * @id: NPC ID to search for
  *
+ * Uses the story's NPC index; cost does not grow with the NPC count.
+ *
  * Return: Pointer to NPC if found, NULL otherwise
  */
-NPC *find_npc_by_id(NPC *npcs, int count, const char *id);
+NPC *find_npc_by_id(Story *story, const char *id);
+
+/**
+ * npc_description() - Get an NPC's description
+ * @story: Story holding the NPC
+ * @npc: NPC to describe
+ *
+ * Reads the text back from npcs.ini on first use when the story was
+ * loaded with lazy text. The same goes for the two functions below.
+ *
+ * Return: Description, valid until more lazy text is read
+ */
+const char *npc_description(Story *story, const NPC *npc);
+
+/**
+ * npc_dialog_line() - Get one of an NPC's dialog lines
+ * @story: Story holding the NPC
+ * @npc: NPC speaking
+ * @index: Line number, 0 to dialog_count - 1
+ *
+ * Return: The line ("" for a missing one), valid until more lazy text
+ * is read
+ */
+const char *npc_dialog_line(Story *story, const NPC *npc, int index);
+
+/**
+ * npc_combat_text() - Get one of an NPC's combat messages
+ * @story: Story holding the NPC
+ * @npc: NPC fighting
+ * @index: Message number, 0 to combat_text_count - 1
+ *
+ * Return: The message ("" for a missing one), valid until more lazy
+ * text is read
+ */
+const char *npc_combat_text(Story *story, const NPC *npc, int index);
 
 #endif /* WORLD_NPCS_H */
\ No newline at end of file
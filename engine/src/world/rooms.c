@@ -1,6 +1,223 @@
 /*
- * Room system - not yet implemented
+ * rooms.c - Room exits, direction vocabulary and descriptions
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
-// Prevent empty translation unit warning
-typedef int prevent_empty_translation_unit_warning_rooms;
\ No newline at end of file
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/logger.h"
+#include "core/verbs.h"
+#include "rooms.h"
+
+
+/*
+ * To add a direction, extend the Direction enum in story.h, name it here
+ * and list its spellings in core/verbs.def.
+ */
+static const char *const direction_names[DIR_COUNT] = {
+	[DIR_NORTH]	= "north",
+	[DIR_SOUTH]	= "south",
+	[DIR_EAST]	= "east",
+	[DIR_WEST]	= "west",
+	[DIR_NORTHEAST]	= "northeast",
+	[DIR_NORTHWEST]	= "northwest",
+	[DIR_SOUTHEAST]	= "southeast",
+	[DIR_SOUTHWEST]	= "southwest",
+	[DIR_UP]	= "up",
+	[DIR_DOWN]	= "down",
+	[DIR_IN]	= "in",
+	[DIR_OUT]	= "out",
+};
+
+
+/**
+ * direction_from_string() - Map a direction word to a Direction
+ * @word: Word to look up
+ *
+ * Return: Direction, DIR_NONE if @word is not a direction
+ */
+
+Direction direction_from_string(const char *word)
+{
+	char lower[PARSER_VERB_SIZE];
+	const VerbEntry *entry;
+	size_t i;
+
+	if (!word)
+		return DIR_NONE;
+
+	/* Direction words are GO verbs in the generated verb table */
+	for (i = 0; word[i] && i < sizeof(lower) - 1; i++)
+		lower[i] = (char)tolower((unsigned char)word[i]);
+	if (word[i])
+		return DIR_NONE;
+	lower[i] = '\0';
+
+	entry = verb_builtin(lower);
+	return entry ? entry->dir : DIR_NONE;
+}
+
+
+/**
+ * direction_name() - Full name of a direction
+ * @dir: Direction
+ *
+ * Return: Lowercase name, "" for DIR_NONE
+ */
+
+const char *direction_name(Direction dir)
+{
+	if (dir < 0 || dir >= DIR_COUNT)
+		return "";
+
+	return direction_names[dir];
+}
+
+
+/**
+ * room_parse_exit() - Add one "direction:room_id" exit to a room
+ * @room: Room being loaded
+ * @exit: Exit string, rewritten in place to the room ID
+ *
+ * Return: 0 on success, -EINVAL if malformed or a repeated direction
+ */
+
+int room_parse_exit(Room *room, char *exit)
+{
+	char *colon = strchr(exit, ':');
+	Direction dir;
+
+	if (!colon) {
+		add_log_entry("Room %s: exit '%s' has no ':'", room->id, exit);
+		return -EINVAL;
+	}
+
+	*colon = '\0';
+	dir = direction_from_string(exit);
+	if (dir == DIR_NONE || room->exit_ids[dir]) {
+		add_log_entry("Room %s: %s exit '%s'", room->id,
+			      dir == DIR_NONE ? "unknown" : "duplicate", exit);
+		*colon = ':';
+		return -EINVAL;
+	}
+
+	/* Keep only the room ID so the string can be stored as is */
+	memmove(exit, colon + 1, strlen(colon + 1) + 1);
+	room->exit_ids[dir] = exit;
+	room->exit_count++;
+
+	return 0;
+}
+
+
+/**
+ * room_description() - Get a room's description
+ * @story: Story holding the room
+ * @room: Room to describe
+ *
+ * Return: Description, valid until more lazy text is read
+ */
+
+const char *room_description(Story *story, const Room *room)
+{
+	if (room->description)
+		return room->description;
+
+	return text_cache_get(&story->text, TEXT_FILE_ROOMS,
+			      room->description_ref);
+}
+
+
+/**
+ * room_exit() - Follow one of a room's exits
+ * @story: Story holding the room
+ * @room: Room in the active region (the player's room)
+ * @dir: Direction to follow
+ *
+ * Return: Destination room, NULL if there is none or it cannot be loaded
+ */
+
+Room *room_exit(Story *story, Room *room, Direction dir)
+{
+	int number;
+
+	if ((unsigned int)dir >= DIR_COUNT)
+		return NULL;
+
+	if (room->exits[dir] || !room->exit_ids[dir] || !story->stream.enabled)
+		return room->exits[dir];
+
+	/* Streamed: resolve it now and keep it until its region is evicted */
+	number = story_index_find(&story->room_index, room->exit_ids[dir]);
+	room->exits[dir] = story_room(story, number);
+	return room->exits[dir];
+}
+
+
+/**
+ * room_view_valid() - Check whether a room's rendered view can be reused
+ * @story: Story holding the room
+ * @room: Room about to be shown
+ * @lit: The player can see in the room
+ *
+ * Return: true if @room->view is what looking at it would print now
+ */
+
+bool room_view_valid(const Story *story, const Room *room, bool lit)
+{
+	return room->view_length > 0 &&
+	       room->view_generation == story->view_generation &&
+	       room->view_lit == lit;
+}
+
+
+/**
+ * room_view_invalidate() - Mark a room's rendered view stale
+ * @room: Room whose items, NPCs or locks changed
+ */
+
+void room_view_invalidate(Room *room)
+{
+	room->view_length = 0;
+}
+
+
+/**
+ * room_views_invalidate_all() - Mark every room's rendered view stale
+ * @story: Story that changed in a way any room may show
+ *
+ * Bumping the generation reaches rooms in evicted regions too, without
+ * visiting any room.
+ */
+
+void room_views_invalidate_all(Story *story)
+{
+	story->view_generation++;
+}
+
+
+/**
+ * room_views_free() - Free the rendered views of an array of rooms
+ * @rooms: Rooms about to be freed, NULL for none
+ * @count: Number of rooms
+ */
+
+void room_views_free(Room *rooms, int count)
+{
+	int i;
+
+	if (!rooms)
+		return;
+
+	for (i = 0; i < count; i++) {
+		free(rooms[i].view);
+		rooms[i].view = NULL;
+		rooms[i].view_length = 0;
+		rooms[i].view_capacity = 0;
+	}
+}
@@ -0,0 +1,126 @@
+/*
+ * rooms.h - Room exits and direction vocabulary
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef WORLD_ROOMS_H
+#define WORLD_ROOMS_H
+
+#include "story/story.h"
+
+
+/**
+ * direction_from_string() - Map a direction word to a Direction
+ * @word: Word as typed or written in rooms.ini ("north", "ne", "up"...)
+ *
+ * Matching is case-insensitive and accepts each direction's full name,
+ * its abbreviation and any alias listed in rooms.c.
+ *
+ * Return: Direction, DIR_NONE if @word is not a direction
+ */
+
+Direction direction_from_string(const char *word);
+
+
+/**
+ * direction_name() - Full name of a direction
+ * @dir: Direction
+ *
+ * Return: Lowercase name ("north", "up"...), "" for DIR_NONE
+ */
+
+const char *direction_name(Direction dir);
+
+
+/**
+ * room_parse_exit() - Add one "direction:room_id" exit to a room
+ * @room: Room being loaded
+ * @exit: Exit as written in rooms.ini; rewritten in place to the room ID
+ *
+ * On success @room->exit_ids[dir] takes over @exit, otherwise the
+ * caller still owns it.
+ *
+ * Return: 0 on success, -EINVAL if the exit is malformed or repeats a
+ * direction the room already has
+ */
+
+int room_parse_exit(Room *room, char *exit);
+
+
+/**
+ * room_description() - Get a room's description
+ * @story: Story holding the room
+ * @room: Room to describe
+ *
+ * Reads the text back from rooms.ini on first use when the story was
+ * loaded with lazy text.
+ *
+ * Return: Description, valid until more lazy text is read
+ */
+
+const char *room_description(Story *story, const Room *room);
+
+
+/**
+ * room_exit() - Follow one of a room's exits
+ * @story: Story holding the room
+ * @room: Room the player is in
+ * @dir: Direction to follow
+ *
+ * Returns the linked destination. In a streamed story a destination
+ * outside the loaded regions is fetched here, loading its region, so
+ * @room must be in the active region or it could be evicted under the
+ * caller.
+ *
+ * Return: Destination room, NULL if there is no exit that way or the
+ * destination does not exist
+ */
+
+Room *room_exit(Story *story, Room *room, Direction dir);
+
+
+/**
+ * room_view_valid() - Check whether a room's rendered view can be reused
+ * @story: Story holding the room
+ * @room: Room about to be shown
+ * @lit: The player can see in the room
+ *
+ * Return: true if @room->view is what looking at it would print now
+ */
+
+bool room_view_valid(const Story *story, const Room *room, bool lit);
+
+
+/**
+ * room_view_invalidate() - Mark a room's rendered view stale
+ * @room: Room whose items, NPCs or locks changed
+ *
+ * The buffer is kept for the next render to write into.
+ */
+
+void room_view_invalidate(Room *room);
+
+
+/**
+ * room_views_invalidate_all() - Mark every room's rendered view stale
+ * @story: Story that changed in a way any room may show
+ *
+ * For changes not tied to one room: a reloaded item or NPC can be
+ * listed anywhere, and a loaded save replaces the game's state.
+ */
+
+void room_views_invalidate_all(Story *story);
+
+
+/**
+ * room_views_free() - Free the rendered views of an array of rooms
+ * @rooms: Rooms about to be freed, NULL for none
+ * @count: Number of rooms
+ */
+
+void room_views_free(Room *rooms, int count);
+
+
+#endif /* WORLD_ROOMS_H */
@@ -0,0 +1,259 @@
+/*
+ * run_tests.c - Run the engine test suites
+ *
+ * Usage: run_tests [suite...]
+ *
+ * With no arguments every suite runs. ctest runs each suite on its
+ * own so a failure points at the suite that broke.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "tests.h"
+
+
+int test_failures;
+
+
+/**
+ * struct TestSuite - One named suite
+ * @name: Name given on the command line and to ctest
+ * @run: Runs the suite, returns the number of failed checks
+ */
+
+typedef struct {
+	const char *name;
+	int (*run)(void);
+} TestSuite;
+
+
+static const TestSuite test_suites[] = {
+	{ "index", test_index },
+	{ "parser", test_parser },
+	{ "reload", test_reload },
+	{ "scripts", test_scripts },
+	{ "stream", test_stream },
+	{ "validator", test_validator },
+};
+
+#define TEST_SUITE_COUNT (int)(sizeof(test_suites) / sizeof(test_suites[0]))
+
+
+/**
+ * test_capture_begin() - Collect what the engine prints in a buffer
+ * @out: Buffer to collect into
+ */
+
+void test_capture_begin(Output *out)
+{
+	output_init(out, -1);
+	output_select(out);
+}
+
+
+/**
+ * test_capture_end() - Stop collecting and NUL-terminate the text
+ * @out: Buffer passed to test_capture_begin()
+ *
+ * Return: The collected text, "" if nothing was printed
+ */
+
+const char *test_capture_end(Output *out)
+{
+	output_select(NULL);
+	if (!out->data)
+		return "";
+
+	/* The buffer always keeps room for a NUL after its text */
+	out->data[out->length] = '\0';
+	return out->data;
+}
+
+
+/**
+ * test_read_file() - Read a whole file into memory
+ * @path: File to read
+ * @size: Set to its size
+ *
+ * Return: NUL terminated contents to free(), NULL on failure
+ */
+
+static char *test_read_file(const char *path, size_t *size)
+{
+	FILE *file = fopen(path, "rb");
+	char *data = NULL;
+	long length;
+
+	if (!file)
+		return NULL;
+	if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 &&
+	    fseek(file, 0, SEEK_SET) == 0) {
+		data = malloc((size_t)length + 1);
+		if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+			free(data);
+			data = NULL;
+		}
+		if (data) {
+			data[length] = '\0';
+			*size = (size_t)length;
+		}
+	}
+	fclose(file);
+	return data;
+}
+
+
+static int test_write_file(const char *path, const char *data, size_t size)
+{
+	FILE *file = fopen(path, "wb");
+	size_t written;
+
+	if (!file)
+		return -errno;
+	written = fwrite(data, 1, size, file);
+	if (fclose(file) != 0 || written != size)
+		return -EIO;
+	return 0;
+}
+
+
+/**
+ * test_story_copy() - Copy a fixture story somewhere it can be edited
+ * @fixture: Directory under fixtures/
+ * @dir: Set to the copy's directory
+ * @dir_size: Size of @dir
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int test_story_copy(const char *fixture, char *dir, size_t dir_size)
+{
+	static const char *const files[] = {
+		"story.ini", "rooms.ini", "items.ini", "npcs.ini",
+		"quests.ini", "dialogs.ini", "scripts.ini",
+	};
+	char from[512];
+	char to[512];
+
+	if (mkdir(TEST_SCRATCH_DIR, 0755) != 0 && errno != EEXIST)
+		return -errno;
+	snprintf(dir, dir_size, "%s/%s", TEST_SCRATCH_DIR, fixture);
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+		return -errno;
+
+	for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+		char *data;
+		size_t size;
+		int ret;
+
+		snprintf(from, sizeof(from), "%s/%s/%s", TEST_FIXTURE_DIR,
+			 fixture, files[i]);
+		snprintf(to, sizeof(to), "%s/%s", dir, files[i]);
+		remove(to);
+
+		/* Stories leave out the files they do not need */
+		data = test_read_file(from, &size);
+		if (!data)
+			continue;
+		ret = test_write_file(to, data, size);
+		free(data);
+		if (ret != 0)
+			return ret;
+	}
+	return 0;
+}
+
+
+/**
+ * test_file_replace() - Replace the first occurrence of a string in a file
+ * @path: File to edit
+ * @from: Text to find
+ * @to: Text to put in its place
+ *
+ * Return: 0 on success, -ENOENT if @from is not in the file, other
+ * negative errno on failure
+ */
+
+int test_file_replace(const char *path, const char *from, const char *to)
+{
+	size_t from_len = strlen(from);
+	size_t to_len = strlen(to);
+	size_t size;
+	char *data;
+	char *edited;
+	char *at;
+	int ret;
+
+	data = test_read_file(path, &size);
+	if (!data)
+		return -ENOENT;
+	at = strstr(data, from);
+	edited = at ? malloc(size - from_len + to_len) : NULL;
+	if (!edited) {
+		free(data);
+		return at ? -ENOMEM : -ENOENT;
+	}
+
+	memcpy(edited, data, (size_t)(at - data));
+	memcpy(edited + (at - data), to, to_len);
+	memcpy(edited + (at - data) + to_len, at + from_len,
+	       size - (size_t)(at - data) - from_len);
+	ret = test_write_file(path, edited, size - from_len + to_len);
+	free(edited);
+	free(data);
+	return ret;
+}
+
+
+/**
+ * run_suite() - Run one suite and report the result
+ * @suite: Suite to run
+ *
+ * Return: Number of failed checks
+ */
+
+static int run_suite(const TestSuite *suite)
+{
+	int failures;
+
+	test_failures = 0;
+	failures = suite->run();
+	printf("%-12s %s (%d failed checks)\n", suite->name,
+	       failures == 0 ? "PASS" : "FAIL", failures);
+	return failures;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int failures = 0;
+	int i, s;
+
+	if (argc < 2) {
+		for (s = 0; s < TEST_SUITE_COUNT; s++)
+			failures += run_suite(&test_suites[s]);
+		return failures == 0 ? 0 : 1;
+	}
+
+	for (i = 1; i < argc; i++) {
+		for (s = 0; s < TEST_SUITE_COUNT; s++) {
+			if (strcmp(argv[i], test_suites[s].name) == 0)
+				break;
+		}
+		if (s == TEST_SUITE_COUNT) {
+			fprintf(stderr, "run_tests: unknown suite '%s'\n",
+				argv[i]);
+			return 1;
+		}
+		failures += run_suite(&test_suites[s]);
+	}
+
+	return failures == 0 ? 0 : 1;
+}
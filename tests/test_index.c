@@ -0,0 +1,133 @@
+/*
+ * test_index.c - story_index_build() and story_index_find() on ID sets
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "core/constants.h"
+#include "story/index.h"
+
+
+/* Distinct IDs in the large set; each appears once more as a duplicate */
+#define INDEX_TEST_IDS		300
+#define INDEX_TEST_ENTRIES	(INDEX_TEST_IDS + INDEX_TEST_IDS / 3)
+
+
+/**
+ * struct IndexEntry - An entity with an ID, laid out like the story's
+ * @value: Something before the ID, so its offset is not 0
+ * @id: Identifier
+ */
+
+typedef struct {
+	int value;
+	const char *id;
+} IndexEntry;
+
+
+/**
+ * index_build() - Build an index over some entries
+ * @index: Index to fill in
+ * @arena: Arena for the index tables
+ * @entries: Entries to index
+ * @count: Number of entries
+ *
+ * Return: What story_index_build() returned
+ */
+
+static int index_build(StoryIndex *index, Arena *arena,
+		       const IndexEntry *entries, int count)
+{
+	return story_index_build(index, arena, entries, count,
+				 sizeof(IndexEntry), offsetof(IndexEntry, id),
+				 "entry");
+}
+
+
+/* A few IDs defined twice: the first definition is the one found */
+static void test_index_duplicates(Arena *arena)
+{
+	static const IndexEntry entries[] = {
+		{ 0, "hall" }, { 1, "cellar" }, { 2, "hall" }, { 3, "attic" },
+		{ 4, "cellar" }, { 5, "hall" }, { 6, "garden" },
+	};
+	StoryIndex index;
+
+	CHECK(index_build(&index, arena, entries, 7) == 0);
+	CHECK(story_index_find(&index, "hall") == 0);
+	CHECK(story_index_find(&index, "cellar") == 1);
+	CHECK(story_index_find(&index, "attic") == 3);
+	CHECK(story_index_find(&index, "garden") == 6);
+	CHECK(story_index_find(&index, "Hall") == -1);
+	CHECK(story_index_find(&index, "hal") == -1);
+	CHECK(story_index_find(&index, "") == -1);
+}
+
+
+/* Enough IDs to need many buckets, with every third one repeated */
+static void test_index_many(Arena *arena)
+{
+	static char ids[INDEX_TEST_IDS][16];
+	static IndexEntry entries[INDEX_TEST_ENTRIES];
+	StoryIndex index;
+	int count = 0;
+
+	for (int i = 0; i < INDEX_TEST_IDS; i++) {
+		snprintf(ids[i], sizeof(ids[i]), "room_%d", i);
+		entries[count].value = i;
+		entries[count++].id = ids[i];
+		if (i % 3 == 2) {
+			entries[count].value = -1;
+			entries[count++].id = ids[i - 1];
+		}
+	}
+
+	CHECK(index_build(&index, arena, entries, count) == 0);
+	for (int i = 0; i < count; i++) {
+		int found = story_index_find(&index, entries[i].id);
+
+		CHECK_MSG(found >= 0 && found < count, entries[i].id);
+		if (found < 0 || found >= count)
+			continue;
+		CHECK_MSG(entries[found].value >= 0, entries[i].id);
+		CHECK_MSG(found <= i, entries[i].id);
+		CHECK_MSG(strcmp(entries[found].id, entries[i].id) == 0,
+			  entries[i].id);
+	}
+	CHECK(story_index_find(&index, "room_300") == -1);
+	CHECK(story_index_find(&index, "room_") == -1);
+}
+
+
+/* Nothing, and a single entry defined twice */
+static void test_index_small(Arena *arena)
+{
+	static const IndexEntry entries[] = { { 0, "hall" }, { 1, "hall" } };
+	StoryIndex index;
+
+	CHECK(index_build(&index, arena, entries, 0) == 0);
+	CHECK(story_index_find(&index, "hall") == -1);
+
+	CHECK(index_build(&index, arena, entries, 2) == 0);
+	CHECK(story_index_find(&index, "hall") == 0);
+	CHECK(story_index_find(&index, "cellar") == -1);
+}
+
+
+int test_index(void)
+{
+	Arena arena;
+
+	arena_init(&arena, ARENA_BLOCK_SIZE);
+	test_index_duplicates(&arena);
+	test_index_many(&arena);
+	test_index_small(&arena);
+	arena_free(&arena);
+	return test_failures;
+}
@@ -0,0 +1,163 @@
+/*
+ * test_parser.c - parse_command() on typed commands
+ *
+ * Cases run against the fixture story in fixtures/parser/, whose
+ * grammar is the built-in patterns plus a few the story declares.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "core/parser.h"
+#include "story/loader.h"
+
+
+/**
+ * struct ParserCase - One command line and how it must parse
+ * @input: What the player typed
+ * @type: Command it must mean
+ * @verb: Verb word, as typed
+ * @noun: Direct object, articles dropped
+ * @preposition: Preposition
+ * @noun2: Indirect object
+ * @all: The noun is "all" or "everything"
+ */
+
+typedef struct {
+	const char *input;
+	CommandType type;
+	const char *verb;
+	const char *noun;
+	const char *preposition;
+	const char *noun2;
+	bool all;
+} ParserCase;
+
+
+static const ParserCase parser_cases[] = {
+	/* Plain verbs and movement */
+	{ "look",			CMD_LOOK,      "look", "", "", "", false },
+	{ "i",				CMD_INVENTORY, "i", "", "", "", false },
+	{ "go north",			CMD_GO,        "go", "north", "", "", false },
+	{ "n",				CMD_GO,        "n", "north", "", "", false },
+	{ "go n",			CMD_GO,        "go", "north", "", "", false },
+	{ "xyzzy",			CMD_UNKNOWN,   "xyzzy", "", "", "", false },
+
+	/* "look at X" and "look in X" examine */
+	{ "look at lamp",		CMD_EXAMINE, "look", "lamp", "at", "", false },
+	{ "look in the chest",		CMD_EXAMINE, "look", "chest", "in", "", false },
+	{ "LOOK AT THE OLD LAMP",	CMD_EXAMINE, "look", "old lamp", "at", "", false },
+	{ "look at",			CMD_LOOK,    "look", "", "at", "", false },
+
+	/* The particle of "pick up" goes before or after the noun */
+	{ "pick up lamp",		CMD_TAKE, "pick", "lamp", "up", "", false },
+	{ "pick lamp up",		CMD_TAKE, "pick", "lamp", "up", "", false },
+	{ "pick up the rusty sword",	CMD_TAKE, "pick", "rusty sword", "up", "", false },
+	{ "pick the rusty sword up",	CMD_TAKE, "pick", "rusty sword", "up", "", false },
+	{ "put lamp down",		CMD_DROP, "put", "lamp", "down", "", false },
+	{ "put down the lamp",		CMD_DROP, "put", "lamp", "down", "", false },
+	{ "pick up",			CMD_TAKE, "pick", "", "up", "", false },
+
+	/* A preposition ends the first noun and starts the second */
+	{ "use key on door",		CMD_USE, "use", "key", "on", "door", false },
+	{ "use the iron key on the heavy door",
+					CMD_USE, "use", "iron key", "on", "heavy door", false },
+	{ "talk to old wizard",		CMD_TALK, "talk", "old wizard", "to", "", false },
+	{ "look at key with lens",	CMD_EXAMINE, "look", "key", "with", "lens", false },
+	{ "pick up the key from the box",
+					CMD_TAKE, "pick", "key", "from", "box", false },
+
+	/* Articles are dropped; "all" and "everything" are marked */
+	{ "take the lamp",		CMD_TAKE, "take", "lamp", "", "", false },
+	{ "take a lamp",		CMD_TAKE, "take", "lamp", "", "", false },
+	{ "take an apple",		CMD_TAKE, "take", "apple", "", "", false },
+	{ "take all",			CMD_TAKE, "take", "all", "", "", true },
+	{ "take everything",		CMD_TAKE, "take", "everything", "", "", true },
+	{ "drop all",			CMD_DROP, "drop", "all", "", "", true },
+	{ "take all from chest",	CMD_TAKE, "take", "all", "from", "chest", true },
+
+	/* Nouns of several words, and extra spaces */
+	{ "take rusty sword",		CMD_TAKE, "take", "rusty sword", "", "", false },
+	{ "examine old wizard",		CMD_EXAMINE, "examine", "old wizard", "", "", false },
+	{ "  take   the   lamp  ",	CMD_TAKE, "take", "lamp", "", "", false },
+
+	/* Verb and direction synonyms from [SYNONYMS] */
+	{ "grab lamp",			CMD_TAKE, "grab", "lamp", "", "", false },
+	{ "ascend",			CMD_GO,   "ascend", "up", "", "", false },
+	{ "go ascend",			CMD_GO,   "go", "up", "", "", false },
+
+	/* Patterns from [GRAMMAR], which may put {noun2} first */
+	{ "unlock door with key",	CMD_USE, "unlock", "key", "with", "door", false },
+	{ "unlock the door with the key",
+					CMD_USE, "unlock", "key", "with", "door", false },
+	{ "light torch",		CMD_USE, "light", "torch", "", "", false },
+	{ "light torch with match",	CMD_USE, "light", "torch", "with", "match", false },
+	{ "unlock door with key on box",
+					CMD_UNKNOWN, "unlock", "key", "with", "door", false },
+	{ "ask wizard about gravy boat",
+					CMD_TALK, "ask", "wizard", "about", "gravy boat", false },
+};
+
+#define PARSER_CASE_COUNT (int)(sizeof(parser_cases) / sizeof(parser_cases[0]))
+
+
+/**
+ * run_parser_case() - Parse one line and compare every part
+ * @story: Story whose grammar applies, NULL for the built-in one
+ * @test: Case to run
+ */
+
+static void run_parser_case(const struct Story *story, const ParserCase *test)
+{
+	char line[PARSER_INPUT_BUFFER_SIZE];
+	Command cmd;
+
+	snprintf(line, sizeof(line), "%s", test->input);
+	cmd = parse_command(story, line);
+
+	CHECK_MSG(cmd.type == test->type, test->input);
+	CHECK_MSG(strcmp(cmd.verb, test->verb) == 0, test->input);
+	CHECK_MSG(strcmp(cmd.noun, test->noun) == 0, test->input);
+	CHECK_MSG(strcmp(cmd.preposition, test->preposition) == 0, test->input);
+	CHECK_MSG(strcmp(cmd.noun2, test->noun2) == 0, test->input);
+	CHECK_MSG(cmd.all == test->all, test->input);
+}
+
+
+int test_parser(void)
+{
+	static const ParserCase builtin_cases[] = {
+		/* Without a story only the built-in verbs are known */
+		{ "take the lamp",	CMD_TAKE, "take", "lamp", "", "", false },
+		{ "use key on door",	CMD_USE, "use", "key", "on", "door", false },
+		{ "light torch",	CMD_UNKNOWN, "light", "torch", "", "", false },
+		{ "ascend",		CMD_UNKNOWN, "ascend", "", "", "", false },
+		{ "",			CMD_UNKNOWN, "", "", "", "", false },
+	};
+	char story_dir[512];
+	Output out;
+	Story *story;
+
+	snprintf(story_dir, sizeof(story_dir), "%s/parser", TEST_FIXTURE_DIR);
+	test_capture_begin(&out);
+	story = load_story(story_dir);
+	test_capture_end(&out);
+	output_free(&out);
+
+	CHECK(story != NULL);
+	if (story) {
+		for (int i = 0; i < PARSER_CASE_COUNT; i++)
+			run_parser_case(story, &parser_cases[i]);
+		free_story(story);
+	}
+
+	for (size_t i = 0; i < sizeof(builtin_cases) / sizeof(builtin_cases[0]); i++)
+		run_parser_case(NULL, &builtin_cases[i]);
+
+	return test_failures;
+}
@@ -0,0 +1,251 @@
+/*
+ * test_reload.c - story_reload_file() on edited story files
+ *
+ * Each case copies the fixture story in fixtures/reload/ to a scratch
+ * directory, loads the copy, edits one of its files and reloads it.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "core/game.h"
+#include "story/loader.h"
+#include "story/reload.h"
+#include "world/npcs.h"
+
+
+/**
+ * reload_load() - Load the scratch copy of the fixture story
+ * @dir: Set to the copy's directory
+ * @dir_size: Size of @dir
+ * @lazy_text: Leave text on disk, as --lazy-text does
+ *
+ * Return: The story, NULL on failure
+ */
+
+static Story *reload_load(char *dir, size_t dir_size, bool lazy_text)
+{
+	Output out;
+	Story *story;
+
+	if (test_story_copy("reload", dir, dir_size) != 0)
+		return NULL;
+
+	loader_set_lazy_text(lazy_text);
+	test_capture_begin(&out);
+	story = load_story(dir);
+	test_capture_end(&out);
+	output_free(&out);
+	loader_set_lazy_text(false);
+	return story;
+}
+
+
+/**
+ * reload_edit() - Edit one file of the copy and reload it
+ * @story: Story loaded from @dir
+ * @dir: Directory of the copy
+ * @file: File to edit
+ * @from: Text to find
+ * @to: Text to put in its place
+ * @result: Set to what the reload changed
+ *
+ * Return: What story_reload_file() returned, or the edit's error
+ */
+
+static int reload_edit(Story *story, const char *dir, TextFile file,
+		       const char *from, const char *to, StoryReload *result)
+{
+	char path[512];
+	Output out;
+	int ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, text_file_name(file));
+	ret = test_file_replace(path, from, to);
+	if (ret != 0)
+		return ret;
+
+	test_capture_begin(&out);
+	ret = story_reload_file(story, file, result);
+	test_capture_end(&out);
+	output_free(&out);
+	return ret;
+}
+
+
+/**
+ * reload_look() - Look at the player's room
+ * @game: Game to look in
+ * @out: Capture buffer, output_free() it when done
+ *
+ * Return: What looking printed
+ */
+
+static const char *reload_look(GameState *game, Output *out)
+{
+	test_capture_begin(out);
+	look_at_current_room(game);
+	return test_capture_end(out);
+}
+
+
+/*
+ * Lazy text edited in place, same length: the reload cannot tell it
+ * changed, but the cached view of the room must still go
+ */
+static void test_reload_same_length(void)
+{
+	char dir[512];
+	Output out;
+	const char *text;
+	StoryReload result;
+	GameState *game;
+	Story *story;
+
+	story = reload_load(dir, sizeof(dir), true);
+	CHECK(story != NULL);
+	if (!story)
+		return;
+
+	game = init_game_state(story);
+	CHECK(game != NULL);
+	if (game) {
+		CHECK(strstr(reload_look(game, &out), "Light filters in") != NULL);
+		output_free(&out);
+
+		CHECK(reload_edit(story, dir, TEXT_FILE_ROOMS, "filters",
+				  "FILTERS", &result) == 0);
+
+		text = reload_look(game, &out);
+		CHECK(strstr(text, "Light FILTERS in") != NULL);
+		CHECK(strstr(text, "Light filters in") == NULL);
+		output_free(&out);
+
+		test_capture_begin(&out);
+		free_game_state(game);
+		test_capture_end(&out);
+		output_free(&out);
+	}
+	free_story(story);
+}
+
+
+/**
+ * reload_find() - Find a room or NPC by ID
+ * @index: Story index to search
+ * @base: Array the index covers
+ * @stride: Size of one entry
+ * @id: ID to find
+ *
+ * Return: The entry, NULL if there is none
+ */
+
+static void *reload_find(const StoryIndex *index, void *base, size_t stride,
+			 const char *id)
+{
+	int i = story_index_find(index, id);
+
+	return i >= 0 ? (char *)base + (size_t)i * stride : NULL;
+}
+
+
+/**
+ * reload_check_items() - Check a room's items, in order
+ * @room: Room to check
+ * @ids: Item IDs it must hold
+ * @count: Number of entries in @ids
+ */
+
+static void reload_check_items(const Room *room, const char *const *ids,
+			       int count)
+{
+	CHECK(room->item_count == count);
+	CHECK(room->item_id_count == count);
+	for (int i = 0; i < count && i < room->item_count; i++)
+		CHECK_MSG(strcmp(room->items[i]->id, ids[i]) == 0, ids[i]);
+}
+
+
+/*
+ * Lists that grow and shrink: a room's items and exits, and lazy NPC
+ * dialog whose lines are only refs into npcs.ini
+ */
+static void test_reload_lists(void)
+{
+	static const char *const grown[] = { "lamp", "coin", "rope" };
+	static const char *const shrunk[] = { "rope" };
+	char dir[512];
+	StoryReload result;
+	Story *story;
+	Room *hall;
+	Room *cellar;
+	NPC *hermit;
+
+	story = reload_load(dir, sizeof(dir), true);
+	CHECK(story != NULL);
+	if (!story)
+		return;
+
+	hall = reload_find(&story->room_index, story->rooms, sizeof(Room),
+			   "hall");
+	cellar = reload_find(&story->room_index, story->rooms, sizeof(Room),
+			     "cellar");
+	hermit = reload_find(&story->npc_index, story->npcs, sizeof(NPC),
+			     "hermit");
+	CHECK(hall && cellar && hermit);
+	if (!hall || !cellar || !hermit) {
+		free_story(story);
+		return;
+	}
+
+	/* Grow */
+	CHECK(reload_edit(story, dir, TEXT_FILE_ROOMS, "items=lamp",
+			  "items=lamp,coin,rope", &result) == 0);
+	reload_check_items(hall, grown, 3);
+	CHECK(reload_edit(story, dir, TEXT_FILE_ROOMS, "exits=north:cellar",
+			  "exits=north:cellar,east:cellar", &result) == 0);
+	CHECK(hall->exit_count == 2);
+	CHECK(hall->exits[DIR_NORTH] == cellar);
+	CHECK(hall->exits[DIR_EAST] == cellar);
+	reload_check_items(hall, grown, 3);
+
+	CHECK(reload_edit(story, dir, TEXT_FILE_NPCS, "dialog_1=I said go away.",
+			  "dialog_1=I said go away.\ndialog_2=Suit yourself.",
+			  &result) == 0);
+	CHECK(result.changed == 1);
+	CHECK(hermit->dialog_count == 3);
+	CHECK(strcmp(npc_dialog_line(story, hermit, 0), "Go away.") == 0);
+	CHECK(strcmp(npc_dialog_line(story, hermit, 1), "I said go away.") == 0);
+	CHECK(strcmp(npc_dialog_line(story, hermit, 2), "Suit yourself.") == 0);
+
+	/* Shrink */
+	CHECK(reload_edit(story, dir, TEXT_FILE_ROOMS,
+			  "exits=north:cellar,east:cellar\nitems=lamp,coin,rope",
+			  "exits=north:cellar\nitems=rope", &result) == 0);
+	CHECK(hall->exit_count == 1);
+	CHECK(hall->exits[DIR_NORTH] == cellar);
+	CHECK(hall->exits[DIR_EAST] == NULL);
+	reload_check_items(hall, shrunk, 1);
+
+	CHECK(reload_edit(story, dir, TEXT_FILE_NPCS,
+			  "\ndialog_1=I said go away.\ndialog_2=Suit yourself.",
+			  "", &result) == 0);
+	CHECK(result.changed == 1);
+	CHECK(hermit->dialog_count == 1);
+	CHECK(strcmp(npc_dialog_line(story, hermit, 0), "Go away.") == 0);
+
+	free_story(story);
+}
+
+
+int test_reload(void)
+{
+	test_reload_same_length();
+	test_reload_lists();
+	return test_failures;
+}
@@ -0,0 +1,310 @@
+/*
+ * test_scripts.c - Compile and evaluate script expressions
+ *
+ * Every case is compiled as a script of the fixture story in
+ * fixtures/scripts/ and evaluated against a small game state: the
+ * player stands in the hall carrying the lamp, on turn 10, with a
+ * score of INT32_MIN so division can overflow.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "core/constants.h"
+#include "story/loader.h"
+#include "story/scripts.h"
+
+
+/**
+ * struct ScriptCase - One expression and what it must produce
+ * @source: Expression, or "script:id"
+ * @value: Value script_eval() must return
+ * @length: Instructions it must compile to, counting the return (0 to
+ *          skip the check)
+ * @compiles: False if it must be reported and replaced by "push 0"
+ */
+
+typedef struct {
+	const char *source;
+	int32_t value;
+	int length;
+	bool compiles;
+} ScriptCase;
+
+
+static const ScriptCase script_cases[] = {
+	/* && and || fold a constant side away or into the result */
+	{ "true && true",			1,  2, true },
+	{ "true && false",			0,  2, true },
+	{ "false && has(lamp)",			0,  2, true },
+	{ "has(lamp) && false",			0,  2, true },
+	{ "true && has(lamp)",			1,  3, true },
+	{ "has(lamp) && true",			1,  3, true },
+	{ "7 && has(lamp)",			1,  3, true },
+	{ "has(lamp) && 7",			1,  3, true },
+	{ "true || has(key)",			1,  2, true },
+	{ "has(key) || true",			1,  2, true },
+	{ "false || has(key)",			0,  3, true },
+	{ "has(key) || false",			0,  3, true },
+	{ "has(key) || 0 || has(lamp)",		1,  6, true },
+	{ "turns && 0 || 1",			1,  2, true },
+	{ "has(lamp) && in(hall)",		1,  5, true },
+	{ "has(key) && in(hall)",		0,  5, true },
+	{ "has(lamp) || in(cellar)",		1,  5, true },
+	{ "has(key) or here(cat) and turns",	1,  0, true },
+
+	/* script(id) compiles the called condition inline */
+	{ "script(lit)",			1,  2, true },
+	{ "script(ready)",			1,  5, true },
+	{ "script(deep)",			1,  0, true },
+	{ "!script(ready)",			0,  0, true },
+	{ "script(ready) && turns > 5",		1,  0, true },
+	{ "script(lit) && script(lit)",		1,  5, true },
+
+	/* Division by 0 gives 0; by -1 it wraps instead of trapping */
+	{ "7 / 0",				0,  2, true },
+	{ "7 % 0",				0,  2, true },
+	{ "turns / 0",				0,  4, true },
+	{ "turns % 0",				0,  4, true },
+	{ "-7 / -1",				7,  2, true },
+	{ "7 % -1",				0,  2, true },
+	{ "turns / -1",				-10, 0, true },
+	{ "turns % -1",				0,  0, true },
+	{ "turns / 3 * 3 + turns % 3",		10, 0, true },
+	{ "score / -1",				INT32_MIN, 0, true },
+	{ "score % -1",				0,  0, true },
+
+	/* Anything that does not compile never holds */
+	{ "has(nothing)",			0,  2, false },
+	{ "!has(nothing)",			0,  2, false },
+	{ "has(lamp) ||",			0,  2, false },
+	{ "(has(lamp)",				0,  2, false },
+	{ "has(lamp) )",			0,  2, false },
+	{ "turns ~ 2",				0,  2, false },
+	{ "nothing",				0,  2, false },
+	{ "script(missing)",			0,  2, false },
+	{ "!script(loop)",			0,  2, false },
+	{ "script:empty",			0,  2, false },
+	{ "script:missing",			0,  2, false },
+};
+
+#define SCRIPT_CASE_COUNT (int)(sizeof(script_cases) / sizeof(script_cases[0]))
+
+/* Scripts in fixtures/scripts/scripts.ini that do not compile */
+#define SCRIPT_FIXTURE_ERRORS	1
+
+
+/**
+ * script_length() - Count the instructions of a compiled expression
+ * @story: Story holding the bytecode
+ * @code: Offset of the expression
+ *
+ * Jumps only go forward, so the first return ends the expression.
+ * The return is opcode 0 (see enum ScriptOpcode).
+ *
+ * Return: Number of instructions, the return included
+ */
+
+static int script_length(const Story *story, int code)
+{
+	int length = 1;
+
+	while (story->script_code[code++].op != 0)
+		length++;
+	return length;
+}
+
+
+/**
+ * script_chain() - Build "turns + (turns + (...))" with @terms terms
+ * @buf: Buffer for the expression
+ * @size: Size of @buf
+ * @terms: Number of terms; the expression needs that many stack slots
+ *
+ * Return: @buf
+ */
+
+static const char *script_chain(char *buf, size_t size, int terms)
+{
+	size_t len = 0;
+
+	for (int i = 0; i < terms; i++)
+		len += (size_t)snprintf(buf + len, size - len,
+					i + 1 < terms ? "turns + (" : "turns");
+	for (int i = 1; i < terms; i++)
+		len += (size_t)snprintf(buf + len, size - len, ")");
+	return buf;
+}
+
+
+/**
+ * script_find() - Find a script by ID
+ * @story: Story to search
+ * @id: Script ID
+ *
+ * Return: The script, NULL if there is none
+ */
+
+static const Script *script_find(const Story *story, const char *id)
+{
+	int i = story_index_find(&story->script_index, id);
+
+	return i >= 0 ? &story->scripts[i] : NULL;
+}
+
+
+int test_scripts(void)
+{
+	char story_dir[512];
+	char deepest[SCRIPT_MAX_STACK * 16];
+	char too_deep[SCRIPT_MAX_STACK * 16];
+	char message[96];
+	Output out;
+	Output again;
+	const char *text;
+	GameState game;
+	Item *inventory[1];
+	Script *scripts;
+	Story *story;
+	int fixture_count;
+	int count;
+	int errors;
+
+	snprintf(story_dir, sizeof(story_dir), "%s/scripts", TEST_FIXTURE_DIR);
+	test_capture_begin(&out);
+	story = load_story(story_dir);
+	test_capture_end(&out);
+	output_free(&out);
+
+	CHECK(story != NULL);
+	if (!story)
+		return test_failures;
+
+	/* Append one script per case, plus two for the stack limit */
+	fixture_count = story->script_count;
+	count = fixture_count + SCRIPT_CASE_COUNT + 2;
+	scripts = arena_calloc(&story->arena, (size_t)count, sizeof(Script));
+	CHECK(scripts != NULL);
+	if (!scripts) {
+		free_story(story);
+		return test_failures;
+	}
+	memcpy(scripts, story->scripts, (size_t)fixture_count * sizeof(Script));
+
+	for (int i = 0; i < count - fixture_count; i++) {
+		char id[32];
+		Script *script = &scripts[fixture_count + i];
+
+		snprintf(id, sizeof(id), "case_%d", i);
+		script->id = arena_strndup(&story->arena, id, strlen(id));
+		script->type = "";
+		script->description = "";
+		if (i < SCRIPT_CASE_COUNT)
+			script->condition = script_cases[i].source;
+	}
+	scripts[count - 2].condition = script_chain(deepest, sizeof(deepest),
+						    SCRIPT_MAX_STACK);
+	scripts[count - 1].condition = script_chain(too_deep, sizeof(too_deep),
+						    SCRIPT_MAX_STACK + 1);
+
+	story->scripts = scripts;
+	story->script_count = count;
+	CHECK(story_index_build(&story->script_index, &story->arena, scripts,
+				count, sizeof(Script), offsetof(Script, id),
+				"script") == 0);
+
+	test_capture_begin(&out);
+	errors = compile_scripts(story);
+	text = test_capture_end(&out);
+
+	memset(&game, 0, sizeof(game));
+	game.story = story;
+	game.current_room = &story->rooms[0];
+	inventory[0] = &story->items[0];
+	game.inventory = inventory;
+	game.inventory_count = 1;
+	game.turn_count = 10;
+	game.score = INT32_MIN;
+
+	for (int i = 0; i < SCRIPT_CASE_COUNT; i++) {
+		const ScriptCase *test = &script_cases[i];
+		const Script *script = &scripts[fixture_count + i];
+		bool reported;
+
+		snprintf(message, sizeof(message), "script '%s' ", script->id);
+		reported = strstr(text, message) != NULL;
+
+		CHECK_MSG(reported == !test->compiles, test->source);
+		CHECK_MSG(script->code != SCRIPT_NONE, test->source);
+		if (script->code == SCRIPT_NONE)
+			continue;
+
+		CHECK_MSG(script_eval(&game, script->code) == test->value,
+			  test->source);
+		if (test->length > 0)
+			CHECK_MSG(script_length(story, script->code) ==
+				  test->length, test->source);
+	}
+
+	/* The stack limit is checked at compile time, not while running */
+	snprintf(message, sizeof(message), "script '%s' condition: nested "
+		 "too deeply", scripts[count - 1].id);
+	CHECK(strstr(text, message) != NULL);
+	CHECK(script_eval(&game, scripts[count - 1].code) == 0);
+	CHECK(script_length(story, scripts[count - 1].code) == 2);
+	snprintf(message, sizeof(message), "script '%s' ",
+		 scripts[count - 2].id);
+	CHECK(strstr(text, message) == NULL);
+	CHECK(script_eval(&game, scripts[count - 2].code) ==
+	      10 * SCRIPT_MAX_STACK);
+
+	/* script(id) nested past SCRIPT_MAX_NESTING is an error */
+	CHECK(strstr(text, "script 'loop' condition: scripts call each "
+		      "other too deeply") != NULL);
+
+	/* "script:id" shares the script's code rather than copying it */
+	CHECK(script_find(story, "ready") != NULL);
+	if (script_find(story, "ready")) {
+		CHECK(story->quests[0].completion_code ==
+		      script_find(story, "ready")->code);
+	}
+	CHECK(script_find(story, "lit") != NULL);
+	if (script_find(story, "lit")) {
+		char source[] = "script:lit";
+		Script *shared = &scripts[count - 2];
+		int length = story->script_code_length;
+
+		/* Compile once more with one case pointing at "lit" */
+		shared->condition = source;
+		test_capture_begin(&again);
+		compile_scripts(story);
+		test_capture_end(&again);
+		output_free(&again);
+		CHECK(shared->code == script_find(story, "lit")->code);
+		CHECK(story->script_code_length < length);
+	}
+
+	/* One error per failing case, the fixture's and the deepest chain */
+	CHECK(errors >= 0);
+	if (errors >= 0) {
+		int expected = SCRIPT_FIXTURE_ERRORS + 1;
+
+		for (int i = 0; i < SCRIPT_CASE_COUNT; i++)
+			expected += !script_cases[i].compiles;
+		CHECK(errors == expected);
+	}
+
+	if (test_failures > 0)
+		fprintf(stderr, "compile_scripts() printed:\n%s\n", text);
+
+	output_free(&out);
+	free_story(story);
+	return test_failures;
+}
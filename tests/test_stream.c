@@ -0,0 +1,148 @@
+/*
+ * test_stream.c - Room regions loaded and evicted on demand
+ *
+ * The fixture story in fixtures/stream/ puts each room of a line of
+ * four in a region of its own and keeps two regions loaded, so every
+ * fetch past the second has to evict or go over the budget.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "tests.h"
+#include "story/loader.h"
+#include "story/stream.h"
+
+
+/**
+ * stream_number() - Room number of a room ID
+ * @story: Streamed story
+ * @id: Room ID
+ *
+ * Return: The number, -1 if there is no such room
+ */
+
+static int stream_number(const Story *story, const char *id)
+{
+	return story_index_find(&story->room_index, id);
+}
+
+
+/**
+ * stream_resident() - Check whether a room's region is loaded
+ * @story: Streamed story
+ * @number: Room number
+ *
+ * Return: true if the room is loaded
+ */
+
+static bool stream_resident(const Story *story, int number)
+{
+	return story->stream.slots[number].room != NULL;
+}
+
+
+/**
+ * stream_pinned() - Check whether a room's region is pinned
+ * @story: Streamed story
+ * @number: Room number
+ *
+ * Return: true if the region is never evicted
+ */
+
+static bool stream_pinned(const Story *story, int number)
+{
+	const RoomStream *stream = &story->stream;
+
+	return stream->regions[stream->slots[number].region].pinned;
+}
+
+
+int test_stream(void)
+{
+	char story_dir[512];
+	Output out;
+	Story *story;
+	Room *town;
+	Room *field;
+	Room *forest;
+	Room *cave;
+	int n_town;
+	int n_field;
+	int n_forest;
+	int n_cave;
+
+	snprintf(story_dir, sizeof(story_dir), "%s/stream", TEST_FIXTURE_DIR);
+	test_capture_begin(&out);
+	story = load_story(story_dir);
+	test_capture_end(&out);
+	output_free(&out);
+
+	CHECK(story != NULL);
+	if (!story)
+		return test_failures;
+	CHECK(story->stream.enabled);
+	CHECK(story->stream.region_count == 4);
+	CHECK(story->stream.resident_limit == 2);
+
+	n_town = stream_number(story, "town");
+	n_field = stream_number(story, "field");
+	n_forest = stream_number(story, "forest");
+	n_cave = stream_number(story, "cave");
+	CHECK(n_town >= 0 && n_field >= 0 && n_forest >= 0 && n_cave >= 0);
+	if (!story->stream.enabled || n_town < 0 || n_field < 0 ||
+	    n_forest < 0 || n_cave < 0) {
+		free_story(story);
+		return test_failures;
+	}
+
+	/* The start region is pinned from the first */
+	CHECK(stream_pinned(story, n_town));
+	town = story_room(story, n_town);
+	field = story_room(story, n_field);
+	CHECK(town != NULL && field != NULL);
+	if (!town || !field) {
+		free_story(story);
+		return test_failures;
+	}
+
+	/* A region the player changed is pinned once it would be evicted */
+	field->changed = true;
+	forest = story_room(story, n_forest);
+	CHECK(forest != NULL);
+	CHECK(stream_pinned(story, n_field));
+	CHECK(story->stream.evictions == 0);
+	CHECK(story->stream.resident == 3);
+	if (forest)
+		forest->visited = true;
+
+	/* So the only region left to evict is the forest */
+	cave = story_room(story, n_cave);
+	CHECK(cave != NULL);
+	CHECK(story->stream.evictions == 1);
+	CHECK(!stream_resident(story, n_forest));
+	CHECK(stream_resident(story, n_town));
+	CHECK(stream_resident(story, n_field));
+	CHECK(story->stream.slots[n_town].room == town);
+	CHECK(story->stream.slots[n_field].room == field);
+	CHECK(field->changed);
+	CHECK(field->exits[DIR_EAST] == NULL);
+	CHECK(town->exits[DIR_EAST] == NULL || town->exits[DIR_EAST] == field);
+
+	/* Coming back evicts the cave and remembers the forest was visited */
+	forest = story_room(story, n_forest);
+	CHECK(forest != NULL);
+	CHECK(story->stream.evictions == 2);
+	CHECK(!stream_resident(story, n_cave));
+	CHECK(stream_resident(story, n_town));
+	CHECK(stream_resident(story, n_field));
+	CHECK(story->stream.resident == 3);
+	if (forest)
+		CHECK(forest->visited);
+
+	free_story(story);
+	return test_failures;
+}
@@ -0,0 +1,176 @@
+/*
+ * test_validator.c - validate_story() against small broken stories
+ *
+ * Each fixture under fixtures/validator/ has one kind of problem. A
+ * case lists the messages validate_story() must print for it and how
+ * many errors and warnings it reports in total.
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tests.h"
+#include "story/loader.h"
+#include "story/validator.h"
+
+
+#define VALIDATOR_MAX_EXPECTED	10
+
+
+/**
+ * struct ValidatorCase - One fixture story and what validating it says
+ * @story: Directory under fixtures/validator/
+ * @valid: Expected return value of validate_story()
+ * @errors: Number of errors printed
+ * @warnings: Number of warnings printed
+ * @expected: Messages that must appear, NULL terminated
+ */
+
+typedef struct {
+	const char *story;
+	bool valid;
+	int errors;
+	int warnings;
+	const char *expected[VALIDATOR_MAX_EXPECTED];
+} ValidatorCase;
+
+
+static const ValidatorCase validator_cases[] = {
+	{ "valid", true, 0, 0, { NULL } },
+	{ "dangling", false, 5, 0, {
+		"room 'hall' exit north leads to unknown room 'nowhere'",
+		"room 'hall' lists unknown item 'ghost_item'",
+		"room 'hall' lists unknown NPC 'ghost_npc'",
+		"NPC 'guard' is located in unknown room 'void'",
+		"NPC 'guard' requires unknown item 'nothing'",
+		NULL } },
+	{ "duplicates", false, 4, 1, {
+		"room 'hall' is defined more than once",
+		"item 'lamp' is defined more than once",
+		"NPC 'cat' is defined more than once",
+		"quest 'find_lamp' is defined more than once",
+		/* Every exit leads to the first 'hall' */
+		"WARNING: 1 of 2 rooms cannot be reached from 'hall'",
+		NULL } },
+	{ "no_start", false, 1, 0, {
+		"story has no start_room",
+		NULL } },
+	{ "bad_start", false, 1, 0, {
+		"start_room 'attic' does not exist",
+		NULL } },
+	{ "unreachable", true, 0, 2, {
+		"WARNING: 1 of 2 rooms cannot be reached from 'hall'",
+		"WARNING: optional quest 'visit_island' can never complete: "
+		"it needs a room that cannot be reached",
+		NULL } },
+	{ "quests", false, 8, 1, {
+		"quest 'two_targets' can never complete: "
+		"it names more than one target",
+		"quest 'unknown_item' can never complete: "
+		"it needs an unknown item",
+		"quest 'heavy_item' can never complete: "
+		"it needs an item that cannot be taken",
+		"quest 'far_item' can never complete: "
+		"it needs an item no reachable room holds",
+		"quest 'unknown_npc' can never complete: "
+		"it needs an unknown NPC",
+		"quest 'far_npc' can never complete: "
+		"it needs an NPC no reachable room holds",
+		"quest 'unknown_room' can never complete: "
+		"it needs an unknown room",
+		"quest 'far_room' can never complete: "
+		"it needs a room that cannot be reached",
+		NULL } },
+};
+
+#define VALIDATOR_CASE_COUNT \
+	(int)(sizeof(validator_cases) / sizeof(validator_cases[0]))
+
+
+/**
+ * count_matches() - Count how often a string occurs in text
+ * @text: Text to search
+ * @needle: String to count
+ *
+ * Return: Number of occurrences
+ */
+
+static int count_matches(const char *text, const char *needle)
+{
+	int count = 0;
+
+	while ((text = strstr(text, needle)) != NULL) {
+		count++;
+		text += strlen(needle);
+	}
+	return count;
+}
+
+
+/**
+ * run_validator_case() - Load one fixture and check its report
+ * @test: Case to run
+ */
+
+static void run_validator_case(const ValidatorCase *test)
+{
+	char story_dir[512];
+	Output load_output;
+	Output out;
+	const char *text;
+	Story *story;
+	int failures = test_failures;
+	bool valid;
+
+	snprintf(story_dir, sizeof(story_dir), "%s/validator/%s",
+		 TEST_FIXTURE_DIR, test->story);
+
+	/* Linking reports dangling references too; keep those out */
+	test_capture_begin(&load_output);
+	story = load_story(story_dir);
+	test_capture_end(&load_output);
+	output_free(&load_output);
+
+	CHECK_MSG(story != NULL, test->story);
+	if (!story)
+		return;
+
+	test_capture_begin(&out);
+	valid = validate_story(story);
+	text = test_capture_end(&out);
+
+	CHECK_MSG(valid == test->valid, test->story);
+	CHECK_MSG(count_matches(text, "ERROR: ") == test->errors, test->story);
+	CHECK_MSG(count_matches(text, "WARNING: ") == test->warnings,
+		  test->story);
+	for (int i = 0; test->expected[i]; i++) {
+		if (!strstr(text, test->expected[i])) {
+			fprintf(stderr, "[%s] missing: %s\n", test->story,
+				test->expected[i]);
+			test_failures++;
+		}
+	}
+
+	if (test_failures > failures)
+		fprintf(stderr, "[%s] validate_story() printed:\n%s\n",
+			test->story, text);
+
+	output_free(&out);
+	free_story(story);
+}
+
+
+int test_validator(void)
+{
+	for (int i = 0; i < VALIDATOR_CASE_COUNT; i++)
+		run_validator_case(&validator_cases[i]);
+
+	/* A NULL story is an error, not a crash */
+	CHECK(!validate_story(NULL));
+
+	return test_failures;
+}
@@ -0,0 +1,108 @@
+/*
+ * tests.h - Minimal test harness shared by the engine test suites
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "ui/output.h"
+
+
+/* Checks failed so far in the running suite */
+extern int test_failures;
+
+
+/**
+ * CHECK() - Record a failure unless a condition holds
+ * @cond: Condition that must be true
+ *
+ * The suite carries on after a failed check so one run reports every
+ * broken case.
+ */
+
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__FILE__, __LINE__, #cond);		\
+			test_failures++;				\
+		}							\
+	} while (0)
+
+
+/**
+ * CHECK_MSG() - CHECK() that also names the case being run
+ * @cond: Condition that must be true
+ * @name: Case name printed on failure
+ */
+
+#define CHECK_MSG(cond, name)						\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: [%s] check failed: %s\n",	\
+				__FILE__, __LINE__, (name), #cond);	\
+			test_failures++;				\
+		}							\
+	} while (0)
+
+
+/**
+ * test_capture_begin() - Collect what the engine prints in a buffer
+ * @out: Buffer to collect into
+ *
+ * Everything the engine prints through the output buffer (messages,
+ * warnings, errors) lands in @out until test_capture_end().
+ */
+
+void test_capture_begin(Output *out);
+
+
+/**
+ * test_capture_end() - Stop collecting and NUL-terminate the text
+ * @out: Buffer passed to test_capture_begin()
+ *
+ * Return: The collected text, "" if nothing was printed
+ */
+
+const char *test_capture_end(Output *out);
+
+
+/**
+ * test_story_copy() - Copy a fixture story somewhere it can be edited
+ * @fixture: Directory under fixtures/
+ * @dir: Set to the copy's directory
+ * @dir_size: Size of @dir
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int test_story_copy(const char *fixture, char *dir, size_t dir_size);
+
+
+/**
+ * test_file_replace() - Replace the first occurrence of a string in a file
+ * @path: File to edit
+ * @from: Text to find
+ * @to: Text to put in its place
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+int test_file_replace(const char *path, const char *from, const char *to);
+
+
+/* Suites, one per test_*.c file */
+int test_index(void);
+int test_parser(void);
+int test_reload(void);
+int test_scripts(void);
+int test_stream(void);
+int test_validator(void);
+
+#endif /* TESTS_H */
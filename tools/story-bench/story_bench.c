@@ -0,0 +1,872 @@
+/*
+ * story_bench.c - Story loading benchmark
+ *
+ * Times each loader against a bare tokenizer walk of the same file.
+ * The tokenizer walk is exactly the work the old count-then-rewind
+ * loaders spent on their first pass, so it shows what single-pass
+ * loading saves on a given story.
+ *
+ * Second, loads the whole story and times the flag scans the game does
+ * over its entity arrays (dark rooms, takeable items, live hostile
+ * NPCs), which is what the layout of Room, Item and NPC decides, and
+ * reports how much memory the loaded story keeps resident.
+ *
+ * Third, loads the story again with lazy text and compares load time
+ * and resident size with the eager load, then times reading text back
+ * through the text cache.
+ *
+ * Fourth, compares loading every room with streaming them region by
+ * region while a walk crosses the world, for load time, time per move
+ * and resident size.
+ *
+ * Last, reports tokenizer and loader throughput in MB/s for each scan
+ * kernel the CPU supports, against the memchr() line walk the
+ * tokenizer used before the kernels.
+ *
+ * With --phases, only times each phase of load_story() and reports the
+ * process's peak resident memory, appending one JSON object per run to
+ * a results file so load scaling can be tracked over time. The
+ * bench-scaling build target runs this on generated stories of 1k, 100k
+ * and 1M rooms.
+ *
+ * Usage: story-bench <story_dir> [iterations]
+ *        story-bench --phases <story_dir> <results.jsonl> [iterations]
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "core/arena.h"
+#include "core/game.h"
+#include "gameplay/quests.h"
+#include "story/ini_parser.h"
+#include "story/ini_scan.h"
+#include "story/loader.h"
+#include "system/platform.h"
+#include "world/items.h"
+#include "world/npcs.h"
+#include "world/rooms.h"
+
+#define BENCH_DEFAULT_ITERATIONS  5
+#define BENCH_PATH_SIZE           512
+#define BENCH_SCAN_REPEATS        20
+#define BENCH_TEXT_FETCHES        1000
+#define BENCH_STREAM_MOVES        20000
+
+/* Story files whose sizes are summed for the phase report */
+static const char *const bench_story_files[] = {
+	"story.ini", "rooms.ini", "items.ini", "npcs.ini", "quests.ini",
+	"dialogs.ini", "scripts.ini"
+};
+
+
+/**
+ * struct BenchResult - Accumulated timings for one story file
+ * @file: File name inside the story directory
+ * @bytes: File size in bytes
+ * @tokens: Tokens produced by one walk
+ * @walk_ms: Total time spent in bare tokenizer walks
+ * @load_ms: Total time spent in the real loader
+ */
+
+typedef struct {
+	const char *file;
+	size_t bytes;
+	long tokens;
+	double walk_ms;
+	double load_ms;
+} BenchResult;
+
+
+/**
+ * walk_file() - Tokenize a file without building anything
+ * @path: File to walk
+ * @result: Result to update with size and token count
+ *
+ * Return: Time taken in milliseconds, negative if the file is missing
+ */
+
+static double walk_file(const char *path, BenchResult *result)
+{
+	IniFile ini;
+	IniToken token;
+	double start = platform_time_ms();
+	long tokens = 0;
+
+	if (ini_open(&ini, path) != 0)
+		return -1.0;
+
+	while (ini_next(&ini, &token))
+		tokens++;
+
+	result->bytes = ini.size;
+	result->tokens = tokens;
+	ini_close(&ini);
+
+	return platform_time_ms() - start;
+}
+
+
+/**
+ * walk_file_memchr() - Tokenize a file the way ini_next() did before
+ * @path: File to walk
+ * @result: Result to update with size and token count
+ *
+ * Finds each line's end and its '=' with two memchr() calls and builds
+ * the same views, which is the baseline the scan kernels are measured
+ * against.
+ *
+ * Return: Time taken in milliseconds, negative if the file is missing
+ */
+
+static double walk_file_memchr(const char *path, BenchResult *result)
+{
+	IniFile ini;
+	IniToken token;
+	double start = platform_time_ms();
+	long tokens = 0;
+
+	if (ini_open(&ini, path) != 0)
+		return -1.0;
+
+	while (ini.pos < ini.size) {
+		const char *line = ini.data + ini.pos;
+		const char *limit = ini.data + ini.size;
+		const char *eol = memchr(line, '\n', (size_t)(limit - line));
+		const char *mark;
+		IniView view;
+
+		if (!eol)
+			eol = limit;
+		ini.pos = (size_t)(eol - ini.data) + (eol < limit ? 1 : 0);
+		ini.line++;
+
+		view.ptr = line;
+		view.len = (size_t)(eol - line);
+		view = ini_view_trim(view);
+		if (view.len == 0 || view.ptr[0] == '#' || view.ptr[0] == ';')
+			continue;
+
+		if (view.ptr[0] == '[') {
+			mark = memchr(view.ptr + 1, ']', view.len - 1);
+			if (!mark)
+				continue;
+			token.section.ptr = view.ptr + 1;
+			token.section.len = (size_t)(mark - view.ptr - 1);
+			token.section = ini_view_trim(token.section);
+			tokens++;
+			continue;
+		}
+
+		mark = memchr(view.ptr, '=', view.len);
+		if (!mark)
+			continue;
+		token.key.ptr = view.ptr;
+		token.key.len = (size_t)(mark - view.ptr);
+		token.key = ini_view_trim(token.key);
+		token.value.ptr = mark + 1;
+		token.value.len = (size_t)(view.ptr + view.len - mark - 1);
+		token.value = ini_view_trim(token.value);
+		tokens++;
+	}
+
+	result->bytes = ini.size;
+	result->tokens = tokens;
+	ini_close(&ini);
+	return platform_time_ms() - start;
+}
+
+
+/**
+ * load_file() - Run the loader for one story file
+ * @story_dir: Story directory
+ * @index: Which loader to run (matches the results table)
+ *
+ * Loads into a private arena and frees it outside the timed region.
+ *
+ * Return: Time taken in milliseconds
+ */
+
+static double load_file(const char *story_dir, int index)
+{
+	double start = platform_time_ms();
+	double elapsed;
+	Arena arena;
+	Room *rooms;
+	Item *items;
+	NPC *npcs;
+	Quest *quests;
+
+	arena_init(&arena, 0);
+
+	switch (index) {
+	case 0:
+		load_rooms(story_dir, &arena, false, &rooms);
+		break;
+	case 1:
+		load_items(story_dir, &arena, false, &items);
+		break;
+	case 2:
+		load_npcs(story_dir, &arena, false, &npcs);
+		break;
+	default:
+		load_quests(story_dir, &arena, &quests);
+		break;
+	}
+
+	elapsed = platform_time_ms() - start;
+	arena_free(&arena);
+	return elapsed;
+}
+
+
+/**
+ * scan_world() - Walk every entity array once, reading only flags
+ * @story: Loaded story
+ *
+ * The flags live inside each Room, Item and NPC, so the cost tracks
+ * the struct sizes rather than the number of flags read.
+ *
+ * Return: Number of matches, so the loops cannot be optimised away
+ */
+
+static long scan_world(const Story *story)
+{
+	long hits = 0;
+	int i;
+
+	for (i = 0; i < story->room_count; i++)
+		hits += story->rooms[i].dark;
+
+	for (i = 0; i < story->item_count; i++)
+		hits += story->items[i].takeable && !story->items[i].unlocks;
+
+	for (i = 0; i < story->npc_count; i++)
+		hits += story->npcs[i].hostile && !story->npcs[i].defeated;
+
+	return hits;
+}
+
+
+/**
+ * print_footprint() - Report what a loaded story keeps resident
+ * @story: Loaded story
+ *
+ * Return: void
+ */
+
+static void print_footprint(const Story *story)
+{
+	StoryFootprint footprint;
+
+	story_footprint(story, &footprint);
+
+	printf("\n%-12s %12s %12s %10s %12s %12s\n", "memory", "resident KB",
+	       "entities KB", "strings", "text KB", "arena KB");
+	printf("%-12s %12.1f %12.1f %10ld %12.1f %12.1f\n", "story",
+	       footprint.resident_bytes / 1024.0,
+	       footprint.entity_bytes / 1024.0, footprint.string_count,
+	       footprint.text_bytes / 1024.0,
+	       footprint.arena.reserved / 1024.0);
+	printf("%-12s %.1f bytes/string, arena %.1f%% used in %d blocks\n", "",
+	       footprint.string_count > 0 ?
+	       (double)footprint.text_bytes / footprint.string_count : 0.0,
+	       footprint.arena.reserved > 0 ?
+	       100.0 * footprint.arena.used / footprint.arena.reserved : 0.0,
+	       footprint.arena.block_count);
+}
+
+
+/**
+ * bench_scan_kernels() - Compare tokenizer and loader throughput per kernel
+ * @story_dir: Story directory
+ * @iterations: Number of timed rounds
+ *
+ * Every story file is walked and loaded with each kernel in turn; the
+ * first row is the memchr() walk the kernels replaced, which has no
+ * loader of its own to time.
+ *
+ * Return: void
+ */
+
+static void bench_scan_kernels(const char *story_dir, int iterations)
+{
+	static const char *const files[] = {
+		"rooms.ini", "items.ini", "npcs.ini", "quests.ini"
+	};
+	int file_count = (int)(sizeof(files) / sizeof(files[0]));
+	IniScanKernel chosen = ini_scan_kernel();
+	char path[BENCH_PATH_SIZE];
+	BenchResult result;
+	double megabytes = 0.0;
+	double walk_ms = 0.0;
+
+	for (int i = 0; i < file_count; i++) {
+		snprintf(path, sizeof(path), "%s/%s", story_dir, files[i]);
+		if (walk_file(path, &result) >= 0.0)
+			megabytes += result.bytes / (1024.0 * 1024.0);
+	}
+
+	printf("\n%-12s %12s %12s %12s\n", "scan kernel", "MB",
+	       "tokenize MB/s", "load MB/s");
+
+	for (int n = 0; n < iterations; n++) {
+		for (int i = 0; i < file_count; i++) {
+			snprintf(path, sizeof(path), "%s/%s", story_dir, files[i]);
+			double ms = walk_file_memchr(path, &result);
+
+			if (ms > 0.0)
+				walk_ms += ms;
+		}
+	}
+	printf("%-12s %12.1f %12.1f %12s\n", "memchr", megabytes,
+	       walk_ms > 0.0 ? megabytes * iterations * 1000.0 / walk_ms : 0.0,
+	       "-");
+
+	for (int k = 0; k < INI_SCAN_KERNEL_COUNT; k++) {
+		double load_ms = 0.0;
+
+		if (!ini_scan_set_kernel((IniScanKernel)k))
+			continue;
+
+		walk_ms = 0.0;
+		for (int n = 0; n < iterations; n++) {
+			for (int i = 0; i < file_count; i++) {
+				snprintf(path, sizeof(path), "%s/%s", story_dir,
+					 files[i]);
+				double ms = walk_file(path, &result);
+
+				if (ms < 0.0)
+					continue;
+				walk_ms += ms;
+				load_ms += load_file(story_dir, i);
+			}
+		}
+
+		printf("%-12s %12.1f %12.1f %12.1f%s\n",
+		       ini_scan_kernel_name((IniScanKernel)k), megabytes,
+		       walk_ms > 0.0 ?
+		       megabytes * iterations * 1000.0 / walk_ms : 0.0,
+		       load_ms > 0.0 ?
+		       megabytes * iterations * 1000.0 / load_ms : 0.0,
+		       (IniScanKernel)k == chosen ? "  (default)" : "");
+	}
+
+	ini_scan_set_kernel(chosen);
+}
+
+
+/**
+ * bench_world_scan() - Time scan_world() on a fully loaded story
+ * @story_dir: Story directory
+ * @iterations: Number of timed rounds
+ *
+ * Return: void
+ */
+
+static void bench_world_scan(const char *story_dir, int iterations)
+{
+	Story *story = load_story_from_ini(story_dir);
+	long entities;
+	long hits = 0;
+	double start;
+	double scan_ms;
+	int n;
+
+	if (!story)
+		return;
+
+	entities = (long)story->room_count + story->item_count + story->npc_count;
+
+	/* One untimed pass so every round sees the same cache state */
+	hits += scan_world(story);
+
+	start = platform_time_ms();
+	for (n = 0; n < iterations * BENCH_SCAN_REPEATS; n++) {
+		/* Stop the compiler reusing the previous round's result */
+		__asm__ __volatile__("" ::: "memory");
+		hits += scan_world(story);
+	}
+	scan_ms = (platform_time_ms() - start) / (iterations * BENCH_SCAN_REPEATS);
+
+	printf("\n%-12s %10s %10s %10s %12s %12s\n", "world scan", "entities",
+	       "Room bytes", "Item bytes", "NPC bytes", "ms/scan");
+	printf("%-12s %10ld %10zu %10zu %12zu %12.3f\n", "flags", entities,
+	       sizeof(Room), sizeof(Item), sizeof(NPC), scan_ms);
+	printf("%-12s %.2f ns/entity (%ld hits)\n", "",
+	       entities > 0 ? scan_ms * 1e6 / entities : 0.0, hits);
+
+	print_footprint(story);
+
+	free_story(story);
+}
+
+
+/**
+ * bench_text_mode() - Load a story with or without lazy text
+ * @story_dir: Story directory
+ * @lazy: Leave text on disk
+ * @load_ms: Set to the time the load took
+ *
+ * Return: Loaded story, NULL on failure
+ */
+
+static Story *bench_text_mode(const char *story_dir, bool lazy,
+			      double *load_ms)
+{
+	double start;
+	Story *story;
+
+	loader_set_lazy_text(lazy);
+	start = platform_time_ms();
+	story = load_story_from_ini(story_dir);
+	*load_ms = platform_time_ms() - start;
+	loader_set_lazy_text(false);
+
+	return story;
+}
+
+
+/**
+ * bench_lazy_text() - Compare eager and lazy text loading
+ * @story_dir: Story directory
+ *
+ * Return: void
+ */
+
+static void bench_lazy_text(const char *story_dir)
+{
+	const char *modes[] = { "eager", "lazy" };
+	StoryFootprint footprint[2];
+	double load_ms[2];
+	double fetch_ms = 0.0;
+	double start;
+	Story *story;
+	size_t chars = 0;
+	int fetches = 0;
+	int mode;
+
+	for (mode = 0; mode < 2; mode++) {
+		story = bench_text_mode(story_dir, mode == 1, &load_ms[mode]);
+		if (!story)
+			return;
+
+		story_footprint(story, &footprint[mode]);
+
+		if (mode == 1) {
+			/* Distinct rooms, so every read misses the cache */
+			start = platform_time_ms();
+			for (; fetches < story->room_count &&
+			       fetches < BENCH_TEXT_FETCHES; fetches++)
+				chars += strlen(room_description(story,
+								 &story->rooms[fetches]));
+			fetch_ms = platform_time_ms() - start;
+		}
+
+		free_story(story);
+	}
+
+	printf("\n%-12s %10s %12s %12s %12s\n", "text", "load ms",
+	       "resident KB", "text KB", "on disk KB");
+	for (mode = 0; mode < 2; mode++)
+		printf("%-12s %10.2f %12.1f %12.1f %12.1f\n", modes[mode],
+		       load_ms[mode], footprint[mode].resident_bytes / 1024.0,
+		       footprint[mode].text_bytes / 1024.0,
+		       footprint[mode].lazy_bytes / 1024.0);
+	printf("%-12s %.2f us per description read back (%d reads, %zu chars)\n",
+	       "", fetches > 0 ? fetch_ms * 1000.0 / fetches : 0.0, fetches,
+	       chars);
+}
+
+
+/**
+ * bench_walk() - Walk a story without turning straight back
+ * @story: Loaded story
+ * @moves: Moves to make
+ *
+ * Takes the first exit of each room that does not lead back to the
+ * room just left, so the walk keeps reaching new rooms and, when
+ * streaming, new regions.
+ *
+ * Return: Number of moves made before the walk got stuck
+ */
+
+static long bench_walk(Story *story, long moves)
+{
+	Room *room = find_room_by_id(story, story->metadata.start_room);
+	const char *previous = "";
+	long made;
+
+	room_stream_enter(story, room);
+
+	for (made = 0; room && made < moves; made++) {
+		Room *next = NULL;
+		int d;
+
+		for (d = 0; d < DIR_COUNT && !next; d++) {
+			if (room->exit_ids[d] &&
+			    strcmp(room->exit_ids[d], previous) != 0)
+				next = room_exit(story, room, (Direction)d);
+		}
+		if (!next)
+			break;
+
+		previous = room->id;
+		room = next;
+		room_stream_enter(story, room);
+	}
+
+	return made;
+}
+
+
+/**
+ * bench_room_streaming() - Compare loading every room with streaming
+ * @story_dir: Story directory
+ *
+ * Return: void
+ */
+
+static void bench_room_streaming(const char *story_dir)
+{
+	const char *modes[] = { "all rooms", "streamed" };
+	StoryFootprint footprint[2];
+	double load_ms[2];
+	double walk_ms[2];
+	long moves[2];
+	long loads = 0;
+	double start;
+	Story *story;
+	int mode;
+
+	for (mode = 0; mode < 2; mode++) {
+		loader_set_room_streaming(mode == 1 ? ROOM_STREAMING_ON :
+					  ROOM_STREAMING_OFF);
+		start = platform_time_ms();
+		story = load_story(story_dir);
+		load_ms[mode] = platform_time_ms() - start;
+		loader_set_room_streaming(ROOM_STREAMING_OFF);
+		if (!story)
+			return;
+
+		start = platform_time_ms();
+		moves[mode] = bench_walk(story, BENCH_STREAM_MOVES);
+		walk_ms[mode] = platform_time_ms() - start;
+
+		story_footprint(story, &footprint[mode]);
+		if (mode == 1)
+			loads = story->stream.loads;
+		free_story(story);
+	}
+
+	printf("\n%-12s %10s %12s %12s %12s\n", "rooms", "load ms",
+	       "us/move", "rooms held", "resident KB");
+	for (mode = 0; mode < 2; mode++)
+		printf("%-12s %10.2f %12.2f %12d %12.1f\n", modes[mode],
+		       load_ms[mode],
+		       moves[mode] > 0 ? walk_ms[mode] * 1000.0 / moves[mode] : 0.0,
+		       footprint[mode].rooms_loaded,
+		       footprint[mode].resident_bytes / 1024.0);
+	printf("%-12s %ld moves, %ld regions loaded while streaming\n", "",
+	       moves[1], loads);
+}
+
+
+/**
+ * bench_min() - Keep the fastest of several timings
+ * @best: Fastest so far, negative before the first
+ * @ms: New timing
+ *
+ * Return: void
+ */
+
+static void bench_min(double *best, double ms)
+{
+	if (*best < 0.0 || ms < *best)
+		*best = ms;
+}
+
+
+/**
+ * print_json_string() - Write a JSON string literal
+ * @fp: Output
+ * @text: Text to quote
+ *
+ * Return: void
+ */
+
+static void print_json_string(FILE *fp, const char *text)
+{
+	fputc('"', fp);
+	for (; *text; text++) {
+		if (*text == '"' || *text == '\\')
+			fprintf(fp, "\\%c", *text);
+		else if ((unsigned char)*text < 0x20)
+			fprintf(fp, "\\u%04x", (unsigned char)*text);
+		else
+			fputc(*text, fp);
+	}
+	fputc('"', fp);
+}
+
+
+/**
+ * print_phase_record() - Write one phase report as a line of JSON
+ * @fp: Output
+ * @story_dir: Story directory
+ * @story: Last story loaded
+ * @best: Fastest time of each phase over the runs
+ * @iterations: Number of runs
+ * @bytes: Size of the story files
+ * @resident: Resident footprint of the loaded story
+ *
+ * Return: void
+ */
+
+static void print_phase_record(FILE *fp, const char *story_dir,
+			       const Story *story,
+			       const StoryLoadTimings *best, int iterations,
+			       size_t bytes, size_t resident)
+{
+	fprintf(fp, "{\"story\":");
+	print_json_string(fp, story_dir);
+	fprintf(fp, ",\"rooms\":%d,\"items\":%d,\"npcs\":%d,\"quests\":%d",
+		story->room_count, story->item_count, story->npc_count,
+		story->quest_count);
+	fprintf(fp, ",\"bytes\":%zu,\"iterations\":%d", bytes, iterations);
+	fprintf(fp, ",\"from_image\":%s,\"streamed\":%s",
+		best->from_image ? "true" : "false",
+		story->stream.enabled ? "true" : "false");
+	fprintf(fp, ",\"image_ms\":%.3f,\"metadata_ms\":%.3f", best->image_ms,
+		best->metadata_ms);
+	fprintf(fp, ",\"rooms_ms\":%.3f,\"items_ms\":%.3f,\"npcs_ms\":%.3f,"
+		"\"quests_ms\":%.3f", best->rooms_ms, best->items_ms,
+		best->npcs_ms, best->quests_ms);
+	fprintf(fp, ",\"parse_wall_ms\":%.3f,\"dialogs_ms\":%.3f,"
+		"\"scripts_ms\":%.3f", best->parse_wall_ms, best->dialogs_ms,
+		best->scripts_ms);
+	fprintf(fp, ",\"index_ms\":%.3f,\"link_ms\":%.3f,\"total_ms\":%.3f",
+		best->index_ms, best->link_ms, best->total_ms);
+	fprintf(fp, ",\"resident_bytes\":%zu,\"peak_rss_bytes\":%zu}\n",
+		resident, platform_peak_rss());
+}
+
+
+/**
+ * bench_phases() - Time each phase of load_story() for a results file
+ * @story_dir: Story directory
+ * @results_path: JSON Lines file the report is appended to
+ * @iterations: Number of loads; the fastest time of each phase is kept
+ *
+ * Loads the story the way the game does, so a current compiled image
+ * is used and story.ini decides whether rooms stream. Peak RSS is the
+ * whole process's, so run one story per process to compare sizes.
+ *
+ * Return: 0 on success, 1 if the story does not load or the results
+ * file cannot be written
+ */
+
+static int bench_phases(const char *story_dir, const char *results_path,
+			int iterations)
+{
+	StoryLoadTimings best = {
+		.image_ms = -1.0, .metadata_ms = -1.0, .rooms_ms = -1.0,
+		.items_ms = -1.0, .npcs_ms = -1.0, .quests_ms = -1.0,
+		.parse_wall_ms = -1.0, .dialogs_ms = -1.0, .scripts_ms = -1.0,
+		.index_ms = -1.0, .link_ms = -1.0, .total_ms = -1.0,
+	};
+	char path[BENCH_PATH_SIZE];
+	Story *story = NULL;
+	size_t resident = 0;
+	size_t bytes = 0;
+	FILE *fp;
+	int n;
+
+	for (size_t i = 0; i < sizeof(bench_story_files) /
+			   sizeof(bench_story_files[0]); i++) {
+		struct stat st;
+
+		snprintf(path, sizeof(path), "%s/%s", story_dir,
+			 bench_story_files[i]);
+		if (stat(path, &st) == 0)
+			bytes += (size_t)st.st_size;
+	}
+
+	for (n = 0; n < iterations; n++) {
+		StoryLoadTimings timings;
+		StoryFootprint footprint;
+
+		if (story)
+			free_story(story);
+		story = load_story(story_dir);
+		if (!story) {
+			fprintf(stderr, "story-bench: cannot load %s\n", story_dir);
+			return 1;
+		}
+
+		story_load_timings(&timings);
+		best.from_image = timings.from_image;
+		bench_min(&best.image_ms, timings.image_ms);
+		bench_min(&best.metadata_ms, timings.metadata_ms);
+		bench_min(&best.rooms_ms, timings.rooms_ms);
+		bench_min(&best.items_ms, timings.items_ms);
+		bench_min(&best.npcs_ms, timings.npcs_ms);
+		bench_min(&best.quests_ms, timings.quests_ms);
+		bench_min(&best.parse_wall_ms, timings.parse_wall_ms);
+		bench_min(&best.dialogs_ms, timings.dialogs_ms);
+		bench_min(&best.scripts_ms, timings.scripts_ms);
+		bench_min(&best.index_ms, timings.index_ms);
+		bench_min(&best.link_ms, timings.link_ms);
+		bench_min(&best.total_ms, timings.total_ms);
+
+		story_footprint(story, &footprint);
+		resident = footprint.resident_bytes;
+	}
+
+	fp = fopen(results_path, "a");
+	if (!fp) {
+		fprintf(stderr, "story-bench: cannot write %s\n", results_path);
+		free_story(story);
+		return 1;
+	}
+
+	print_phase_record(fp, story_dir, story, &best, iterations, bytes,
+			   resident);
+	fclose(fp);
+
+	printf("\n");
+	print_phase_record(stdout, story_dir, story, &best, iterations, bytes,
+			   resident);
+
+	free_story(story);
+	return 0;
+}
+
+
+/**
+ * bench_usage() - Print how to run the benchmark
+ * @prog: Name the program was run as
+ *
+ * Return: 1, the exit status for a usage error
+ */
+
+static int bench_usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s <story_dir> [iterations]\n"
+		"       %s --phases <story_dir> <results.jsonl> "
+		"[iterations]\n", prog, prog);
+	return 1;
+}
+
+
+/**
+ * bench_is_story() - Check that a directory holds a story
+ * @story_dir: Directory named on the command line
+ *
+ * Return: true if @story_dir has a story.ini to load
+ */
+
+static bool bench_is_story(const char *story_dir)
+{
+	char path[BENCH_PATH_SIZE];
+	struct stat st;
+
+	snprintf(path, sizeof(path), "%s/story.ini", story_dir);
+	return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+
+/**
+ * main() - Benchmark entry point
+ * @argc: Argument count
+ * @argv: Story directory and optional iteration count, or --phases
+ *
+ * Return: 0 on success, 1 on usage error or a failed phase report
+ */
+
+int main(int argc, char **argv)
+{
+	BenchResult results[] = {
+		{ "rooms.ini", 0, 0, 0.0, 0.0 },
+		{ "items.ini", 0, 0, 0.0, 0.0 },
+		{ "npcs.ini", 0, 0, 0.0, 0.0 },
+		{ "quests.ini", 0, 0, 0.0, 0.0 },
+	};
+	int count = (int)(sizeof(results) / sizeof(results[0]));
+	char path[BENCH_PATH_SIZE];
+	int iterations = BENCH_DEFAULT_ITERATIONS;
+	double walk_total = 0.0;
+	double load_total = 0.0;
+	int i;
+	int n;
+
+	if (argc > 1 && strcmp(argv[1], "--phases") == 0) {
+		if (argc < 4)
+			return bench_usage(argv[0]);
+		if (argc > 4 && atoi(argv[4]) > 0)
+			iterations = atoi(argv[4]);
+		return bench_phases(argv[2], argv[3], iterations);
+	}
+
+	if (argc < 2 || argv[1][0] == '-')
+		return bench_usage(argv[0]);
+
+	/* Benchmarking nothing would print tables of zeros */
+	if (!bench_is_story(argv[1])) {
+		fprintf(stderr, "story-bench: no story.ini in %s\n", argv[1]);
+		return bench_usage(argv[0]);
+	}
+
+	if (argc > 2 && atoi(argv[2]) > 0)
+		iterations = atoi(argv[2]);
+
+	/* Whatever story.ini asks, only the last comparison streams rooms */
+	loader_set_room_streaming(ROOM_STREAMING_OFF);
+
+	for (n = 0; n < iterations; n++) {
+		for (i = 0; i < count; i++) {
+			double walk;
+
+			snprintf(path, sizeof(path), "%s/%s", argv[1], results[i].file);
+			walk = walk_file(path, &results[i]);
+			if (walk < 0.0)
+				continue;
+
+			results[i].walk_ms += walk;
+			results[i].load_ms += load_file(argv[1], i);
+		}
+	}
+
+	printf("\n%-12s %12s %10s %14s %12s %10s\n", "file", "bytes", "tokens",
+	       "count-pass ms", "load ms", "saved");
+
+	for (i = 0; i < count; i++) {
+		double walk = results[i].walk_ms / iterations;
+		double load = results[i].load_ms / iterations;
+
+		walk_total += walk;
+		load_total += load;
+
+		printf("%-12s %12zu %10ld %14.2f %12.2f %9.1f%%\n",
+		       results[i].file, results[i].bytes, results[i].tokens,
+		       walk, load, load + walk > 0.0 ? 100.0 * walk / (load + walk) : 0.0);
+	}
+
+	printf("%-12s %12s %10s %14.2f %12.2f %9.1f%%\n", "total", "", "",
+	       walk_total, load_total,
+	       load_total + walk_total > 0.0 ?
+	       100.0 * walk_total / (load_total + walk_total) : 0.0);
+
+	bench_world_scan(argv[1], iterations);
+	bench_lazy_text(argv[1]);
+	bench_room_streaming(argv[1]);
+	bench_scan_kernels(argv[1], iterations);
+
+	return 0;
+}
@@ -0,0 +1,749 @@
+/*
+ * story_gen.c - Synthetic story generator
+ *
+ * Writes a complete, valid story directory of any size, so the loader,
+ * validator and lookups can be measured on worlds far larger than the
+ * stories that ship with the engine.
+ *
+ * Rooms are laid out on a square grid. Each row is joined east to west
+ * and the rows are joined north to south down the first column, so
+ * every room can be reached from the start room. Further north-south
+ * and diagonal exits are added at random until rooms average the
+ * requested number of exits. Locks only ever go on those extra exits,
+ * and the first item, which lies in the start room, is a key, so the
+ * world can always be crossed.
+ *
+ * Every exit, item, NPC and quest is derived from its own number and
+ * the seed, so files are written in one pass without holding the world
+ * in memory, and the same options always give the same story.
+ *
+ * Usage: story-gen [options] <output_dir>
+ *
+ * Copyright (C) 2025 Marty
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#define GEN_DEFAULT_ROOMS       1000
+#define GEN_DEFAULT_BRANCHING   3.0
+#define GEN_DEFAULT_LOCKED      5
+#define GEN_DEFAULT_HOSTILE     20
+#define GEN_MAX_EXITS           8
+#define GEN_PATH_SIZE           512
+#define GEN_WRITE_BUFFER        (1 << 20)
+
+/* Salts keeping each random decision independent of the others */
+#define GEN_SALT_EXIT           0x45584954u
+#define GEN_SALT_LOCK           0x4c4f434bu
+#define GEN_SALT_ITEM           0x4954454du
+#define GEN_SALT_NPC            0x4e504321u
+
+
+/**
+ * struct GenOptions - What to generate
+ * @rooms: Number of rooms
+ * @items: Number of items, spread evenly over the rooms
+ * @npcs: Number of NPCs, spread evenly over the rooms
+ * @quests: Number of quests
+ * @branching: Average exits per room, from 2 (a tree) to 8
+ * @locked: Percentage of rooms with extra exits that lock one of them
+ * @hostile: Percentage of NPCs that fight
+ * @stream: Ask the engine to stream rooms region by region
+ * @seed: Seed for every random decision
+ * @width: Rooms per grid row, worked out from @rooms
+ * @extra: Chance, out of 2^32, of each optional exit being present
+ */
+
+typedef struct {
+	long rooms;
+	long items;
+	long npcs;
+	long quests;
+	double branching;
+	int locked;
+	int hostile;
+	bool stream;
+	uint64_t seed;
+	long width;
+	uint64_t extra;
+} GenOptions;
+
+
+/**
+ * enum GenLink - Optional links from a room to the row below
+ */
+
+typedef enum {
+	GEN_LINK_SOUTH,
+	GEN_LINK_SOUTHEAST,
+	GEN_LINK_SOUTHWEST,
+	GEN_LINK_COUNT
+} GenLink;
+
+
+/**
+ * struct GenExit - One exit of a room being written
+ * @dir: Direction name as written in rooms.ini
+ * @to: Destination room number
+ * @optional: Exit is not part of the spanning tree, so it may be locked
+ */
+
+typedef struct {
+	const char *dir;
+	long to;
+	bool optional;
+} GenExit;
+
+
+/**
+ * gen_hash() - Mix a number, a salt and the seed into 32 random bits
+ * @opts: Options holding the seed
+ * @n: Number of the thing being decided
+ * @salt: Which decision it is
+ *
+ * Return: Pseudo-random 32-bit value
+ */
+
+static uint32_t gen_hash(const GenOptions *opts, uint64_t n, uint32_t salt)
+{
+	uint64_t z = opts->seed + n * 0x9e3779b97f4a7c15ull + salt;
+
+	/* splitmix64 finaliser */
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+
+/**
+ * gen_chance() - Decide something with a given percentage
+ * @opts: Options holding the seed
+ * @n: Number of the thing being decided
+ * @salt: Which decision it is
+ * @percent: Chance of true, 0 to 100
+ *
+ * Return: True @percent of the time
+ */
+
+static bool gen_chance(const GenOptions *opts, uint64_t n, uint32_t salt,
+		       int percent)
+{
+	return gen_hash(opts, n, salt) % 100 < (uint32_t)percent;
+}
+
+
+/**
+ * gen_link() - Is an optional link from a room to the row below present
+ * @opts: Options
+ * @room: Room in the upper row
+ * @link: Which link
+ * @to: Set to the room below it leads to
+ *
+ * Return: True if the link exists
+ */
+
+static bool gen_link(const GenOptions *opts, long room, GenLink link,
+		     long *to)
+{
+	long x = room % opts->width;
+	long below = room + opts->width;
+
+	switch (link) {
+	case GEN_LINK_SOUTH:
+		/* The first column is always joined, as part of the tree */
+		if (x == 0)
+			return false;
+		*to = below;
+		break;
+	case GEN_LINK_SOUTHEAST:
+		if (x + 1 >= opts->width)
+			return false;
+		*to = below + 1;
+		break;
+	default:
+		if (x == 0)
+			return false;
+		*to = below - 1;
+		break;
+	}
+
+	if (*to >= opts->rooms)
+		return false;
+	return gen_hash(opts, (uint64_t)room * GEN_LINK_COUNT + link,
+			GEN_SALT_EXIT) < opts->extra;
+}
+
+
+/**
+ * gen_room_exits() - Work out every exit of one room
+ * @opts: Options
+ * @room: Room number
+ * @exits: Filled in, GEN_MAX_EXITS long
+ *
+ * A link between two rooms is decided once, from the upper room, so
+ * both ends agree on it without either being stored.
+ *
+ * Return: Number of exits
+ */
+
+static int gen_room_exits(const GenOptions *opts, long room, GenExit *exits)
+{
+	long width = opts->width;
+	long x = room % width;
+	long to;
+	int count = 0;
+
+	/* Spanning tree: along every row, and down the first column */
+	if (x == 0 && room >= width)
+		exits[count++] = (GenExit){ "north", room - width, false };
+	if (x == 0 && room + width < opts->rooms)
+		exits[count++] = (GenExit){ "south", room + width, false };
+	if (x + 1 < width && room + 1 < opts->rooms)
+		exits[count++] = (GenExit){ "east", room + 1, false };
+	if (x > 0)
+		exits[count++] = (GenExit){ "west", room - 1, false };
+
+	/* Optional links down to the next row */
+	if (gen_link(opts, room, GEN_LINK_SOUTH, &to))
+		exits[count++] = (GenExit){ "south", to, true };
+	if (gen_link(opts, room, GEN_LINK_SOUTHEAST, &to))
+		exits[count++] = (GenExit){ "southeast", to, true };
+	if (gen_link(opts, room, GEN_LINK_SOUTHWEST, &to))
+		exits[count++] = (GenExit){ "southwest", to, true };
+
+	/* The same links seen from the row below */
+	if (room >= width) {
+		long above = room - width;
+
+		if (gen_link(opts, above, GEN_LINK_SOUTH, &to) && to == room)
+			exits[count++] = (GenExit){ "north", above, true };
+		if (x > 0 && gen_link(opts, above - 1, GEN_LINK_SOUTHEAST, &to) &&
+		    to == room)
+			exits[count++] = (GenExit){ "northwest", above - 1, true };
+		if (x + 1 < width && above + 1 < opts->rooms &&
+		    gen_link(opts, above + 1, GEN_LINK_SOUTHWEST, &to) &&
+		    to == room)
+			exits[count++] = (GenExit){ "northeast", above + 1, true };
+	}
+
+	return count;
+}
+
+
+/**
+ * gen_first() - First of a run of things spread evenly over the rooms
+ * @count: How many things there are
+ * @rooms: How many rooms there are
+ * @room: Room number
+ *
+ * Thing n lies in room n * rooms / count, so room r holds the things
+ * from gen_first(r) up to gen_first(r + 1).
+ *
+ * Return: Number of the first thing in @room
+ */
+
+static long gen_first(long count, long rooms, long room)
+{
+	return (long)(((unsigned long long)room * (unsigned long long)count +
+		       (unsigned long long)rooms - 1) / (unsigned long long)rooms);
+}
+
+
+/**
+ * gen_home() - Room a thing spread evenly over the rooms lies in
+ * @n: Number of the thing
+ * @count: How many things there are
+ * @rooms: How many rooms there are
+ *
+ * Return: Room number
+ */
+
+static long gen_home(long n, long count, long rooms)
+{
+	return (long)((unsigned long long)n * (unsigned long long)rooms /
+		      (unsigned long long)count);
+}
+
+
+/**
+ * gen_item_takeable() - Can an item be picked up
+ * @n: Item number
+ *
+ * Every tenth item is scenery.
+ *
+ * Return: True if takeable
+ */
+
+static bool gen_item_takeable(long n)
+{
+	return n % 10 != 9;
+}
+
+
+/**
+ * gen_open() - Create one story file with a large write buffer
+ * @dir: Story directory
+ * @name: File name
+ *
+ * Return: Open file, NULL on failure (reported)
+ */
+
+static FILE *gen_open(const char *dir, const char *name)
+{
+	char path[GEN_PATH_SIZE];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fp = fopen(path, "w");
+	if (!fp) {
+		fprintf(stderr, "story-gen: cannot create %s: %s\n", path,
+			strerror(errno));
+		return NULL;
+	}
+
+	setvbuf(fp, NULL, _IOFBF, GEN_WRITE_BUFFER);
+	return fp;
+}
+
+
+/**
+ * gen_close() - Finish a story file
+ * @fp: File from gen_open()
+ * @name: File name, for the error message
+ *
+ * Return: 0 on success, -EIO if any write failed
+ */
+
+static int gen_close(FILE *fp, const char *name)
+{
+	bool failed = ferror(fp) != 0;
+
+	if (fclose(fp) != 0 || failed) {
+		fprintf(stderr, "story-gen: failed writing %s\n", name);
+		return -EIO;
+	}
+	return 0;
+}
+
+
+/**
+ * gen_story() - Write story.ini
+ * @opts: Options
+ * @dir: Story directory
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_story(const GenOptions *opts, const char *dir)
+{
+	FILE *fp = gen_open(dir, "story.ini");
+
+	if (!fp)
+		return -EIO;
+
+	fprintf(fp, "# Generated by story-gen\n\n");
+	fprintf(fp, "[STORY]\n");
+	fprintf(fp, "title=Generated World (%ld rooms)\n", opts->rooms);
+	fprintf(fp, "author=story-gen\n");
+	fprintf(fp, "version=1.0.0\n");
+	fprintf(fp, "description=%ld rooms, %ld items, %ld NPCs and %ld quests; "
+		"%.1f exits per room, %d%% locked, seed %llu.\n",
+		opts->rooms, opts->items, opts->npcs, opts->quests,
+		opts->branching, opts->locked, (unsigned long long)opts->seed);
+	fprintf(fp, "start_room=room_0\n\n");
+	fprintf(fp, "[SETTINGS]\n");
+	fprintf(fp, "max_inventory_weight=50\n");
+	if (opts->stream)
+		fprintf(fp, "stream_rooms=true\n");
+
+	return gen_close(fp, "story.ini");
+}
+
+
+/**
+ * gen_rooms() - Write rooms.ini
+ * @opts: Options
+ * @dir: Story directory
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_rooms(const GenOptions *opts, const char *dir)
+{
+	FILE *fp = gen_open(dir, "rooms.ini");
+	GenExit exits[GEN_MAX_EXITS];
+
+	if (!fp)
+		return -EIO;
+
+	for (long r = 0; r < opts->rooms; r++) {
+		int count = gen_room_exits(opts, r, exits);
+		const char *locked_exit = NULL;
+		long first;
+		long last;
+
+		fprintf(fp, "[ROOM:room_%ld]\n", r);
+		fprintf(fp, "name=Room %ld\n", r);
+		fprintf(fp, "description=Room %ld of a generated world, in "
+			"column %ld of row %ld.\n", r, r % opts->width,
+			r / opts->width);
+
+		fprintf(fp, "exits=");
+		for (int e = 0; e < count; e++) {
+			fprintf(fp, "%s%s:room_%ld", e ? "," : "", exits[e].dir,
+				exits[e].to);
+			if (exits[e].optional && !locked_exit &&
+			    gen_chance(opts, (uint64_t)r, GEN_SALT_LOCK,
+				       opts->locked))
+				locked_exit = exits[e].dir;
+		}
+		fputc('\n', fp);
+
+		fprintf(fp, "items=");
+		first = gen_first(opts->items, opts->rooms, r);
+		last = gen_first(opts->items, opts->rooms, r + 1);
+		for (long n = first; n < last; n++)
+			fprintf(fp, "%sitem_%ld", n > first ? "," : "", n);
+		fputc('\n', fp);
+
+		fprintf(fp, "npcs=");
+		first = gen_first(opts->npcs, opts->rooms, r);
+		last = gen_first(opts->npcs, opts->rooms, r + 1);
+		for (long n = first; n < last; n++)
+			fprintf(fp, "%snpc_%ld", n > first ? "," : "", n);
+		fputc('\n', fp);
+
+		fprintf(fp, "dark=false\n");
+		fprintf(fp, "locked=%s\n", locked_exit ? "true" : "false");
+		fprintf(fp, "locked_exit=%s\n\n", locked_exit ? locked_exit : "");
+	}
+
+	return gen_close(fp, "rooms.ini");
+}
+
+
+/**
+ * gen_items() - Write items.ini
+ * @opts: Options
+ * @dir: Story directory
+ *
+ * Item 0 lies in the start room and unlocks exits whenever rooms may be
+ * locked; after that a further --locked percent of the items are keys.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_items(const GenOptions *opts, const char *dir)
+{
+	FILE *fp = gen_open(dir, "items.ini");
+
+	if (!fp)
+		return -EIO;
+
+	for (long n = 0; n < opts->items; n++) {
+		bool key = opts->locked > 0 &&
+			   (n == 0 || gen_chance(opts, (uint64_t)n, GEN_SALT_ITEM,
+						 opts->locked));
+		bool takeable = gen_item_takeable(n);
+
+		fprintf(fp, "[ITEM:item_%ld]\n", n);
+		fprintf(fp, "name=%s %ld\n", key ? "Key" : "Trinket", n);
+		fprintf(fp, "description=Generated item %ld, found in room %ld.\n",
+			n, gen_home(n, opts->items, opts->rooms));
+		fprintf(fp, "weight=%d\n", takeable ? 1 + (int)(n % 5) : 500);
+		fprintf(fp, "takeable=%s\n", takeable ? "true" : "false");
+		fprintf(fp, "useable=%s\n", key ? "true" : "false");
+		fprintf(fp, "illuminates=false\n");
+		fprintf(fp, "unlocks=%s\n\n", key ? "true" : "false");
+	}
+
+	return gen_close(fp, "items.ini");
+}
+
+
+/**
+ * gen_npcs() - Write npcs.ini
+ * @opts: Options
+ * @dir: Story directory
+ *
+ * Hostile NPCs are beaten more easily with the first item in their own
+ * room when it can be taken, so the item helping a fight is never far.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_npcs(const GenOptions *opts, const char *dir)
+{
+	FILE *fp = gen_open(dir, "npcs.ini");
+
+	if (!fp)
+		return -EIO;
+
+	for (long n = 0; n < opts->npcs; n++) {
+		long room = gen_home(n, opts->npcs, opts->rooms);
+		long weapon = gen_first(opts->items, opts->rooms, room);
+		bool hostile = gen_chance(opts, (uint64_t)n, GEN_SALT_NPC,
+					  opts->hostile);
+
+		fprintf(fp, "[NPC:npc_%ld]\n", n);
+		fprintf(fp, "name=Wanderer %ld\n", n);
+		fprintf(fp, "description=A generated character who keeps to "
+			"room %ld.\n", room);
+		fprintf(fp, "location=room_%ld\n", room);
+		fprintf(fp, "dialog_0=Hello, I am wanderer %ld.\n", n);
+		fprintf(fp, "dialog_1=This world goes on for %ld rooms.\n",
+			opts->rooms);
+		fprintf(fp, "dialog_2=Safe travels.\n");
+		fprintf(fp, "hostile=%s\n", hostile ? "true" : "false");
+		if (hostile) {
+			fprintf(fp, "combat_hp=%d\n", 2 + (int)(n % 4));
+			fprintf(fp, "combat_damage=1\n");
+			if (weapon < gen_first(opts->items, opts->rooms, room + 1) &&
+			    gen_item_takeable(weapon))
+				fprintf(fp, "required_item=item_%ld\n", weapon);
+			fprintf(fp, "base_win_chance=0.50\n");
+			fprintf(fp, "item_win_chance=0.90\n");
+			fprintf(fp, "combat_text_0=Wanderer %ld lunges!\n", n);
+			fprintf(fp, "combat_text_1=Wanderer %ld stands firm.\n", n);
+		}
+		fputc('\n', fp);
+	}
+
+	return gen_close(fp, "npcs.ini");
+}
+
+
+/**
+ * gen_quests() - Write quests.ini
+ * @opts: Options
+ * @dir: Story directory
+ *
+ * Quests take turns asking for a room, an item and an NPC, spread
+ * across the world; every other quest is required.
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_quests(const GenOptions *opts, const char *dir)
+{
+	FILE *fp = gen_open(dir, "quests.ini");
+
+	if (!fp)
+		return -EIO;
+
+	for (long n = 0; n < opts->quests; n++) {
+		int kind = (int)(n % 3);
+
+		fprintf(fp, "[QUEST:quest_%ld]\n", n);
+		fprintf(fp, "name=Errand %ld\n", n);
+		fprintf(fp, "required=%s\n", n % 2 == 0 ? "true" : "false");
+
+		if (kind == 1 && opts->items > 0) {
+			long item = gen_home(n, opts->quests, opts->items);
+
+			if (!gen_item_takeable(item))
+				item--;
+			fprintf(fp, "description=Find item %ld.\n", item);
+			fprintf(fp, "completion_item=item_%ld\n", item);
+		} else if (kind == 2 && opts->npcs > 0) {
+			long npc = gen_home(n, opts->quests, opts->npcs);
+
+			fprintf(fp, "description=Speak with wanderer %ld.\n", npc);
+			fprintf(fp, "completion_npc=npc_%ld\n", npc);
+		} else {
+			long room = gen_home(n, opts->quests, opts->rooms);
+
+			fprintf(fp, "description=Reach room %ld.\n", room);
+			fprintf(fp, "completion_room=room_%ld\n", room);
+		}
+		fprintf(fp, "completion_message=Errand %ld done.\n\n", n);
+	}
+
+	return gen_close(fp, "quests.ini");
+}
+
+
+/**
+ * gen_setup() - Fill in defaults and the derived layout
+ * @opts: Options as given; missing counts are negative
+ *
+ * Return: 0 on success, -EINVAL if an option is out of range
+ */
+
+static int gen_setup(GenOptions *opts)
+{
+	double tree_edges;
+	double wanted_edges;
+	double optional_edges;
+	double chance;
+
+	if (opts->rooms < 1 || opts->branching < 2.0 ||
+	    opts->branching > GEN_MAX_EXITS || opts->locked < 0 ||
+	    opts->locked > 100 || opts->hostile < 0 || opts->hostile > 100)
+		return -EINVAL;
+
+	if (opts->items < 0)
+		opts->items = opts->rooms / 2;
+	if (opts->npcs < 0)
+		opts->npcs = opts->rooms / 10;
+	if (opts->quests < 0)
+		opts->quests = opts->rooms / 100 > 0 ? opts->rooms / 100 : 1;
+
+	opts->width = 1;
+	while (opts->width * opts->width < opts->rooms)
+		opts->width++;
+
+	/* Enough optional links, out of about three per room, to bring the
+	 * average up to the branching asked for */
+	tree_edges = (double)opts->rooms - 1.0;
+	wanted_edges = opts->branching * (double)opts->rooms / 2.0;
+	optional_edges = 3.0 * (double)(opts->rooms - opts->width);
+	chance = optional_edges > 0.0 ?
+		 (wanted_edges - tree_edges) / optional_edges : 0.0;
+	if (chance < 0.0)
+		chance = 0.0;
+	if (chance > 1.0)
+		chance = 1.0;
+	opts->extra = (uint64_t)(chance * 4294967296.0);
+
+	return 0;
+}
+
+
+/**
+ * gen_mkdir() - Create the output directory if it is missing
+ * @dir: Directory
+ *
+ * Return: 0 on success, negative errno on failure
+ */
+
+static int gen_mkdir(const char *dir)
+{
+	int err;
+
+#ifdef _WIN32
+	if (_mkdir(dir) == 0 || errno == EEXIST)
+		return 0;
+#else
+	if (mkdir(dir, 0755) == 0 || errno == EEXIST)
+		return 0;
+#endif
+	err = errno;
+	fprintf(stderr, "story-gen: cannot create %s: %s\n", dir, strerror(err));
+	return -err;
+}
+
+
+/**
+ * usage() - Print the options
+ * @name: Program name
+ *
+ * Return: void
+ */
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [options] <output_dir>\n"
+		"  --rooms N        rooms to generate (default %d)\n"
+		"  --items N        items (default rooms / 2)\n"
+		"  --npcs N         NPCs (default rooms / 10)\n"
+		"  --quests N       quests (default rooms / 100, at least 1)\n"
+		"  --branching N    average exits per room, 2 to %d (default %.0f)\n"
+		"  --locked PCT     rooms with extra exits that lock one (default %d)\n"
+		"  --hostile PCT    NPCs that fight (default %d)\n"
+		"  --stream         stream rooms region by region\n"
+		"  --seed N         seed for the random layout (default 1)\n",
+		name, GEN_DEFAULT_ROOMS, GEN_MAX_EXITS, GEN_DEFAULT_BRANCHING,
+		GEN_DEFAULT_LOCKED, GEN_DEFAULT_HOSTILE);
+}
+
+
+/**
+ * main() - Generator entry point
+ * @argc: Argument count
+ * @argv: Options and output directory
+ *
+ * Return: 0 on success, 1 on usage error, 2 if writing failed
+ */
+
+int main(int argc, char **argv)
+{
+	GenOptions opts = {
+		.rooms = GEN_DEFAULT_ROOMS,
+		.items = -1,
+		.npcs = -1,
+		.quests = -1,
+		.branching = GEN_DEFAULT_BRANCHING,
+		.locked = GEN_DEFAULT_LOCKED,
+		.hostile = GEN_DEFAULT_HOSTILE,
+		.stream = false,
+		.seed = 1,
+	};
+	const char *dir = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (strcmp(argv[i], "--stream") == 0) {
+			opts.stream = true;
+			continue;
+		}
+		if (argv[i][0] != '-') {
+			dir = argv[i];
+			continue;
+		}
+		if (!value) {
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (strcmp(argv[i], "--rooms") == 0)
+			opts.rooms = atol(value);
+		else if (strcmp(argv[i], "--items") == 0)
+			opts.items = atol(value);
+		else if (strcmp(argv[i], "--npcs") == 0)
+			opts.npcs = atol(value);
+		else if (strcmp(argv[i], "--quests") == 0)
+			opts.quests = atol(value);
+		else if (strcmp(argv[i], "--branching") == 0)
+			opts.branching = atof(value);
+		else if (strcmp(argv[i], "--locked") == 0)
+			opts.locked = atoi(value);
+		else if (strcmp(argv[i], "--hostile") == 0)
+			opts.hostile = atoi(value);
+		else if (strcmp(argv[i], "--seed") == 0)
+			opts.seed = strtoull(value, NULL, 10);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+		i++;
+	}
+
+	if (!dir || gen_setup(&opts) != 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (gen_mkdir(dir) != 0 || gen_story(&opts, dir) != 0 ||
+	    gen_rooms(&opts, dir) != 0 || gen_items(&opts, dir) != 0 ||
+	    gen_npcs(&opts, dir) != 0 || gen_quests(&opts, dir) != 0)
+		return 2;
+
+	printf("Wrote %s: %ld rooms (%ld wide), %ld items, %ld NPCs, "
+	       "%ld quests\n", dir, opts.rooms, opts.width, opts.items,
+	       opts.npcs, opts.quests);
+	return 0;
+}